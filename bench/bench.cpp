@@ -0,0 +1,348 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <win32pe/file.h>
+#include <win32pe/buildcomparator.h>
+#include <win32pe/corpusquery.h>
+#include <win32pe/corpusstore.h>
+#include <win32pe/digests.h>
+#include <win32pe/emitter.h>
+#include <win32pe/fileheader.h>
+#include <win32pe/imagehash.h>
+#include <win32pe/importindex.h>
+#include <win32pe/importtable.h>
+#include <win32pe/metadatacache.h>
+#include <win32pe/pagehashes.h>
+#include <win32pe/probe.h>
+#include <win32pe/section.h>
+#include <win32pe/sectiondiff.h>
+#include <win32pe/stringscanner.h>
+
+#include "generator.h"
+
+// Every allocation in the process (including those made by the library) is
+// counted by replacing the global allocation functions
+
+namespace
+{
+
+std::atomic<uint64_t> gAllocations(0);
+std::atomic<uint64_t> gAllocatedBytes(0);
+
+}
+
+void *operator new(size_t size)
+{
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    gAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    void *p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+
+const char *MappedFilename = "win32pe_bench.bin";
+const char *CacheFilename = "win32pe_bench.cache";
+
+// Number of files in the corpus benchmark
+const int CorpusSize = 1 << 16;
+
+// Minimum time spent running each benchmark
+const double MinimumSeconds = 0.5;
+
+struct Benchmark
+{
+    std::string name;
+
+    /// bytes processed by each iteration (for throughput)
+    uint64_t bytes;
+
+    std::function<void()> run;
+};
+
+// Prevent the compiler from discarding results
+volatile uint64_t gSink;
+
+void runBenchmark(const Benchmark &benchmark)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // Warm up and find an iteration count that takes a measurable time
+    uint64_t iterations = 1;
+    double seconds = 0;
+    uint64_t allocations = 0, allocatedBytes = 0;
+    for (;;) {
+        uint64_t startAllocations = gAllocations.load();
+        uint64_t startAllocatedBytes = gAllocatedBytes.load();
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) {
+            benchmark.run();
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        allocations = gAllocations.load() - startAllocations;
+        allocatedBytes = gAllocatedBytes.load() - startAllocatedBytes;
+        if (seconds >= MinimumSeconds || iterations >= (1ULL << 40)) {
+            break;
+        }
+        iterations *= seconds > 0.01 ? static_cast<uint64_t>(MinimumSeconds / seconds * 1.2) + 1 : 10;
+    }
+
+    double perSecond = iterations / seconds;
+    printf("%-28s %12llu %12.1f %12.0f %10.1f %10.1f %12.0f\n",
+           benchmark.name.c_str(),
+           static_cast<unsigned long long>(iterations),
+           seconds / iterations * 1e9,
+           perSecond,
+           benchmark.bytes * perSecond / (1024 * 1024),
+           static_cast<double>(allocations) / iterations,
+           static_cast<double>(allocatedBytes) / iterations);
+}
+
+void writeFile(const char *filename, const std::string &data)
+{
+    std::ofstream ofstream(filename, std::ios::binary);
+    ofstream.write(data.data(), data.size());
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    // An optional argument selects benchmarks whose names contain it
+    const char *filter = argc > 1 ? argv[1] : "";
+
+    GeneratorOptions options;
+    options.sections = 16;
+    options.importedDLLs = 16;
+    options.importsPerDLL = 64;
+    options.overlaySize = 0x10000;
+    std::string image = generateImage(options);
+
+    options.pe32Plus = false;
+    std::string image32 = generateImage(options);
+
+    writeFile(MappedFilename, image);
+
+    // Most scanned files are not PE at all
+    std::string notPE(win32pe::Probe::ProbeSize, '\x7f');
+
+    win32pe::File file;
+    if (!file.load(image.data(), image.size())) {
+        fprintf(stderr, "unable to load generated image: %s\n", file.errorString().c_str());
+        return 1;
+    }
+
+    // A warm cache holds the mapped file, which must be loaded from its path
+    // to be inserted
+    win32pe::File mapped;
+    win32pe::MetadataCache cache;
+    std::remove(CacheFilename);
+    if (!mapped.map(MappedFilename) || !cache.open(CacheFilename) ||
+            !cache.insert(MappedFilename, mapped) || !cache.save()) {
+        fprintf(stderr, "unable to create cache: %s\n", cache.errorString().c_str());
+        return 1;
+    }
+
+    // A corpus large enough for column scans to dominate; small images keep
+    // the time spent computing entropy while building it down
+    GeneratorOptions corpusOptions;
+    corpusOptions.sections = 2;
+    corpusOptions.sectionSize = 0x200;
+    std::string corpusImage = generateImage(corpusOptions);
+    win32pe::File corpusFile;
+    corpusFile.load(corpusImage.data(), corpusImage.size());
+    win32pe::CorpusStore corpus;
+    for (int i = 0; i < CorpusSize; ++i) {
+        corpus.add(MappedFilename, corpusFile);
+    }
+    win32pe::CorpusQuery query;
+    query.setMachine(win32pe::FileHeader::amd64);
+    query.requireCharacteristics(win32pe::FileHeader::DLL);
+    query.setTimeDateStampRange(0x50000000, 0xffffffff);
+
+    // Every file in the corpus imports the same functions, so each posting
+    // list covers the whole corpus
+    win32pe::ImportIndex index;
+    for (int i = 0; i < CorpusSize; ++i) {
+        index.add(corpusFile);
+    }
+    std::vector<win32pe::ImportIndex::Term> terms(2);
+    terms[0].dll = "LIBRARY0.dll";
+    terms[0].function = "Function0_0";
+    terms[1].dll = "LIBRARY3.dll";
+    terms[1].function = "Function3_15";
+
+    // Records are emitted into a buffer that is reused between iterations
+    win32pe::Emitter ndjson;
+    win32pe::Emitter csv;
+    csv.setFormat(win32pe::Emitter::CSV);
+    std::string records;
+
+    // Collect a spread of RVAs and names to look up
+    std::vector<uint32_t> rvas;
+    for (const win32pe::Section &section : file.sections()) {
+        for (uint32_t i = 0; i < section.virtualSize(); i += 0x1000) {
+            rvas.push_back(section.virtualAddress() + i);
+        }
+    }
+    std::vector<uint32_t> names;
+    for (const win32pe::ImportTable::Item &item : file.importTable().items()) {
+        names.push_back(item.name);
+    }
+
+    std::vector<Benchmark> benchmarks = {
+        {"load/istream", image.size(), [&image]() {
+            std::istringstream istringstream(image);
+            win32pe::File file;
+            gSink += file.load(istringstream);
+        }},
+        {"load/buffer", image.size(), [&image]() {
+            win32pe::File file;
+            gSink += file.load(image.data(), image.size());
+        }},
+        {"load/buffer-pe32", image32.size(), [&image32]() {
+            win32pe::File file;
+            gSink += file.load(image32.data(), image32.size());
+        }},
+        {"load/mmap", image.size(), []() {
+            win32pe::File file;
+            gSink += file.map(MappedFilename);
+        }},
+        {"load/digests", image.size(), [&image]() {
+            win32pe::File file;
+            file.setDigestAlgorithms(win32pe::Digests::AllAlgorithms);
+            gSink += file.load(image.data(), image.size());
+        }},
+        {"imagehash/compute", 0, [&file]() {
+            win32pe::ImageHash hash;
+            gSink += hash.compute(file);
+        }},
+        {"pagehashes/compute", image.size(), [&image]() {
+            win32pe::PageHashes hashes;
+            gSink += hashes.compute(image.data(), image.size());
+        }},
+        {"probe/pe", 0, [&image]() {
+            gSink += win32pe::Probe::probe(image.data(), image.size()).format();
+        }},
+        {"probe/reject", 0, [&notPE]() {
+            gSink += win32pe::Probe::probe(notPE.data(), notPE.size()).format();
+        }},
+        {"compare/builds", image.size(), [&file]() {
+            win32pe::BuildComparator comparator;
+            gSink += comparator.compare(file, file) + comparator.differences().size();
+        }},
+        {"cache/lookup", image.size(), [&cache]() {
+            win32pe::File file;
+            gSink += cache.lookup(MappedFilename, file);
+        }},
+        {"corpus/query", 0, [&corpus, &query]() {
+            gSink += query.count(corpus);
+        }},
+        {"index/query", 0, [&index, &terms]() {
+            gSink += index.query(terms).size();
+        }},
+        {"diff/sections", image.size(), [&file]() {
+            win32pe::SectionDiff diff;
+            gSink += diff.diff(file, file) + diff.changes().size();
+        }},
+        {"emit/ndjson", 0, [&file, &ndjson, &records]() {
+            records.clear();
+            ndjson.emit(records, MappedFilename, file);
+            gSink += records.size();
+        }},
+        {"emit/csv", 0, [&file, &csv, &records]() {
+            records.clear();
+            csv.emit(records, MappedFilename, file);
+            gSink += records.size();
+        }},
+        {"rvaToSection", 0, [&file, &rvas]() {
+            for (uint32_t rva : rvas) {
+                gSink += file.rvaToSection(rva) != nullptr;
+            }
+        }},
+        {"string", 0, [&file, &names]() {
+            for (uint32_t name : names) {
+                gSink += file.string(name).size();
+            }
+        }},
+        {"imports/walk", 0, [&file]() {
+            for (const win32pe::ImportTable::Item &item : file.importTable().items()) {
+                gSink += file.string(item.name).size() + item.firstThunk;
+            }
+        }},
+        {"sections/copy", 0, [&file]() {
+            std::vector<win32pe::Section> sections(file.sections());
+            gSink += sections.size();
+        }},
+        {"strings/scan", image.size(), [&image]() {
+            win32pe::StringScanner scanner;
+            scanner.scan(image.data(), image.size(), 0, [](const win32pe::StringScanner::Item &item) {
+                gSink += item.value.size();
+                return true;
+            });
+        }},
+        {"save/ostream", image.size(), [&file]() {
+            std::ostringstream ostringstream;
+            gSink += file.save(ostringstream);
+        }},
+    };
+
+    printf("%-28s %12s %12s %12s %10s %10s %12s\n",
+           "benchmark", "iterations", "ns/op", "ops/s", "MB/s", "allocs/op", "bytes/op");
+    for (const Benchmark &benchmark : benchmarks) {
+        if (benchmark.name.find(filter) != std::string::npos) {
+            runBenchmark(benchmark);
+        }
+    }
+
+    std::remove(MappedFilename);
+    std::remove(CacheFilename);
+    return 0;
+}
@@ -0,0 +1,316 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <boost/endian/conversion.hpp>
+
+#include "generator.h"
+
+namespace
+{
+
+const uint32_t PEOffset = 0x80;
+const uint32_t FileAlignment = 0x200;
+const uint32_t SectionAlignment = 0x1000;
+const uint32_t DescriptorSize = 20;
+const uint32_t SectionHeaderSize = 40;
+
+// NumberOfSections is 16 bits wide
+const unsigned int MaxSections = 0xffff;
+
+const char DOSStub[] = "This program cannot be run in DOS mode.\r\r\n$";
+
+// Small, fast and - most importantly - deterministic across platforms
+class Random
+{
+public:
+
+    Random(uint32_t seed) : mState(seed * 0x9e3779b97f4a7c15ULL + 1) {}
+
+    uint64_t next()
+    {
+        mState ^= mState >> 12;
+        mState ^= mState << 25;
+        mState ^= mState >> 27;
+        return mState * 0x2545f4914f6cdd1dULL;
+    }
+
+private:
+
+    uint64_t mState;
+};
+
+uint32_t alignUp(uint32_t value, uint32_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+template<typename T>
+void put(std::string &buffer, size_t offset, T value)
+{
+    boost::endian::native_to_little_inplace(value);
+    memcpy(&buffer[offset], &value, sizeof(value));
+}
+
+struct SectionInfo
+{
+    std::string name;
+    uint32_t characteristics;
+    std::string data;
+    uint32_t virtualSize;
+    uint32_t virtualAddress;
+    uint32_t pointerToRawData;
+};
+
+std::string randomBytes(Random &random, size_t size)
+{
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<char>(random.next() >> 56);
+    }
+    return data;
+}
+
+std::string stringData(Random &random, unsigned int count, size_t size)
+{
+    std::string data;
+    data.reserve(count * (size + 1));
+    for (unsigned int i = 0; i < count; ++i) {
+        for (size_t j = 0; j < size; ++j) {
+            data.append(1, static_cast<char>(0x20 + random.next() % 0x5f));
+        }
+        data.append(1, '\0');
+    }
+    return data;
+}
+
+// Build the import directory, lookup tables, address tables, hint/name
+// entries and DLL names for a section at the specified address
+
+std::string importData(const GeneratorOptions &options, uint32_t virtualAddress)
+{
+    const uint32_t thunkSize = options.pe32Plus ? 8 : 4;
+    const uint32_t dlls = options.importedDLLs;
+    const uint32_t functions = options.importsPerDLL;
+
+    uint32_t lookupOffset = (dlls + 1) * DescriptorSize;
+    uint32_t tableSize = dlls * (functions + 1) * thunkSize;
+    uint32_t addressOffset = lookupOffset + tableSize;
+    uint32_t namesOffset = addressOffset + tableSize;
+
+    std::string names;
+    std::vector<uint32_t> functionNames, dllNames;
+    for (uint32_t d = 0; d < dlls; ++d) {
+        for (uint32_t f = 0; f < functions; ++f) {
+            char name[32];
+            snprintf(name, sizeof(name), "Function%u_%u", d, f);
+            functionNames.push_back(namesOffset + static_cast<uint32_t>(names.size()));
+            names.append(2, '\0');
+            names.append(name);
+            names.append(names.size() % 2 ? 1 : 2, '\0');
+        }
+    }
+    for (uint32_t d = 0; d < dlls; ++d) {
+        char name[32];
+        snprintf(name, sizeof(name), "LIBRARY%u.dll", d);
+        dllNames.push_back(namesOffset + static_cast<uint32_t>(names.size()));
+        names.append(name);
+        names.append(1, '\0');
+    }
+
+    std::string data(namesOffset, '\0');
+    data.append(names);
+
+    for (uint32_t d = 0; d < dlls; ++d) {
+        size_t descriptor = d * DescriptorSize;
+        uint32_t table = d * (functions + 1) * thunkSize;
+        put<uint32_t>(data, descriptor, virtualAddress + lookupOffset + table);
+        put<uint32_t>(data, descriptor + 12, virtualAddress + dllNames[d]);
+        put<uint32_t>(data, descriptor + 16, virtualAddress + addressOffset + table);
+
+        for (uint32_t f = 0; f < functions; ++f) {
+            uint32_t thunk = virtualAddress + functionNames[d * functions + f];
+            size_t offset = table + f * thunkSize;
+            if (options.pe32Plus) {
+                put<uint64_t>(data, lookupOffset + offset, thunk);
+                put<uint64_t>(data, addressOffset + offset, thunk);
+            } else {
+                put<uint32_t>(data, lookupOffset + offset, thunk);
+                put<uint32_t>(data, addressOffset + offset, thunk);
+            }
+        }
+    }
+
+    return data;
+}
+
+}
+
+GeneratorOptions::GeneratorOptions()
+    : pe32Plus(true),
+      sections(4),
+      sectionSize(0x10000),
+      importedDLLs(4),
+      importsPerDLL(16),
+      strings(256),
+      stringSize(24),
+      overlaySize(0),
+      seed(1)
+{
+}
+
+std::string generateImage(const GeneratorOptions &options)
+{
+    Random random(options.seed);
+
+    const unsigned int sectionCount = std::min(std::max(options.sections, 3u), MaxSections);
+    const uint32_t optionalHeaderSize = options.pe32Plus ? 240 : 224;
+    const uint32_t headersSize = alignUp(
+        PEOffset + 4 + 20 + optionalHeaderSize + sectionCount * SectionHeaderSize,
+        FileAlignment
+    );
+
+    // Lay out the sections; .idata goes last since its contents depend on its
+    // own address
+    std::vector<SectionInfo> sections(sectionCount);
+    sections[0].name = ".text";
+    sections[0].characteristics = 0x60000020;
+    sections[0].data = randomBytes(random, options.sectionSize);
+    sections[1].name = ".rdata";
+    sections[1].characteristics = 0x40000040;
+    sections[1].data = stringData(random, options.strings, options.stringSize);
+    for (unsigned int i = 2; i + 1 < sectionCount; ++i) {
+        // Names are limited to eight characters, so larger indices drop
+        // the rest of ".data" to stay unique
+        char name[16];
+        if (i - 1 < 1000) {
+            snprintf(name, sizeof(name), ".data%u", i - 1);
+        } else {
+            snprintf(name, sizeof(name), ".d%u", i - 1);
+        }
+        sections[i].name = name;
+        sections[i].characteristics = 0xc0000040;
+        sections[i].data = randomBytes(random, options.sectionSize);
+    }
+    sections.back().name = ".idata";
+    sections.back().characteristics = 0xc0000040;
+
+    uint32_t virtualAddress = alignUp(headersSize, SectionAlignment);
+    uint32_t pointerToRawData = headersSize;
+    for (auto &section : sections) {
+        if (&section == &sections.back()) {
+            section.data = importData(options, virtualAddress);
+        }
+        section.virtualSize = static_cast<uint32_t>(section.data.size());
+        section.virtualAddress = virtualAddress;
+        section.pointerToRawData = pointerToRawData;
+        section.data.resize(alignUp(section.virtualSize, FileAlignment));
+        virtualAddress += alignUp(section.virtualSize ? section.virtualSize : 1, SectionAlignment);
+        pointerToRawData += static_cast<uint32_t>(section.data.size());
+    }
+
+    std::string image(headersSize, '\0');
+
+    // DOS header and stub
+    image[0] = 'M';
+    image[1] = 'Z';
+    put<uint32_t>(image, 0x3c, PEOffset);
+    memcpy(&image[0x4e], DOSStub, sizeof(DOSStub) - 1);
+
+    // File header
+    size_t offset = PEOffset;
+    put<uint32_t>(image, offset, 0x4550);
+    offset += 4;
+    put<uint16_t>(image, offset, options.pe32Plus ? 0x8664 : 0x014c);
+    put<uint16_t>(image, offset + 2, static_cast<uint16_t>(sectionCount));
+    put<uint32_t>(image, offset + 4, 0x50000000 + (options.seed & 0xffffff));
+    put<uint16_t>(image, offset + 16, static_cast<uint16_t>(optionalHeaderSize));
+    put<uint16_t>(image, offset + 18, options.pe32Plus ? 0x0022 : 0x0102);
+    offset += 20;
+
+    // Optional header
+    size_t optionalHeader = offset;
+    put<uint16_t>(image, offset, options.pe32Plus ? 0x020b : 0x010b);
+    image[offset + 2] = 14;
+    put<uint32_t>(image, offset + 4, static_cast<uint32_t>(sections[0].data.size()));
+    put<uint32_t>(image, offset + 16, sections[0].virtualAddress);
+    put<uint32_t>(image, offset + 20, sections[0].virtualAddress);
+    if (options.pe32Plus) {
+        put<uint64_t>(image, offset + 24, 0x140000000ULL);
+    } else {
+        put<uint32_t>(image, offset + 24, sections[1].virtualAddress);
+        put<uint32_t>(image, offset + 28, 0x400000);
+    }
+    put<uint32_t>(image, offset + 32, SectionAlignment);
+    put<uint32_t>(image, offset + 36, FileAlignment);
+    put<uint16_t>(image, offset + 40, 6);
+    put<uint16_t>(image, offset + 48, 6);
+    put<uint32_t>(image, offset + 56, virtualAddress);
+    put<uint32_t>(image, offset + 60, headersSize);
+    put<uint16_t>(image, offset + 68, 3);
+    put<uint16_t>(image, offset + 70, options.pe32Plus ? 0x8160 : 0x8140);
+    if (options.pe32Plus) {
+        put<uint64_t>(image, offset + 72, 0x100000);
+        put<uint64_t>(image, offset + 80, 0x1000);
+        put<uint64_t>(image, offset + 88, 0x100000);
+        put<uint64_t>(image, offset + 96, 0x1000);
+        offset += 108;
+    } else {
+        put<uint32_t>(image, offset + 72, 0x100000);
+        put<uint32_t>(image, offset + 76, 0x1000);
+        put<uint32_t>(image, offset + 80, 0x100000);
+        put<uint32_t>(image, offset + 84, 0x1000);
+        offset += 92;
+    }
+    put<uint32_t>(image, offset, 16);
+    offset += 4;
+
+    // Data directory - only the import directory is present
+    const SectionInfo &idata = sections.back();
+    put<uint32_t>(image, offset + 8, idata.virtualAddress);
+    put<uint32_t>(image, offset + 12, (options.importedDLLs + 1) * DescriptorSize);
+    offset = optionalHeader + optionalHeaderSize;
+
+    // Section table
+    for (auto &section : sections) {
+        memcpy(&image[offset], section.name.data(), section.name.size());
+        put<uint32_t>(image, offset + 8, section.virtualSize);
+        put<uint32_t>(image, offset + 12, section.virtualAddress);
+        put<uint32_t>(image, offset + 16, static_cast<uint32_t>(section.data.size()));
+        put<uint32_t>(image, offset + 20, section.pointerToRawData);
+        put<uint32_t>(image, offset + 36, section.characteristics);
+        offset += SectionHeaderSize;
+    }
+
+    for (auto &section : sections) {
+        image.append(section.data);
+    }
+    image.append(randomBytes(random, options.overlaySize));
+
+    return image;
+}
@@ -0,0 +1,72 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Parameters for a synthetic PE image
+ *
+ * The same parameters (including the seed) always produce the same image.
+ */
+struct GeneratorOptions
+{
+    GeneratorOptions();
+
+    /// produce a PE32+ (amd64) image instead of PE32 (i386)
+    bool pe32Plus;
+
+    /// total number of sections (from three - .text, .rdata and .idata - up
+    /// to 65535)
+    unsigned int sections;
+
+    /// size of the raw data of .text and each additional section
+    size_t sectionSize;
+
+    /// number of imported DLLs and functions imported from each
+    unsigned int importedDLLs;
+    unsigned int importsPerDLL;
+
+    /// number and length of the printable strings placed in .rdata
+    unsigned int strings;
+    size_t stringSize;
+
+    /// number of bytes appended after the last section
+    size_t overlaySize;
+
+    uint32_t seed;
+};
+
+/**
+ * @brief Build a synthetic PE image
+ * @param options parameters for the image
+ * @return contents of the file
+ */
+std::string generateImage(const GeneratorOptions &options);
+
+#endif // GENERATOR_H
@@ -22,6 +22,9 @@
  * IN THE SOFTWARE.
  */
 
+#include <fstream>
+#include <iterator>
+
 #include "sample.h"
 
 const char *gSample =
@@ -141,3 +144,51 @@ const char *gSample =
     "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00";
 
 const unsigned int gSampleSize = 2048;
+
+std::string patched(size_t offset, const char *value, size_t size)
+{
+    std::string data(gSample, gSampleSize);
+    memcpy(&data[offset], value, size);
+    return data;
+}
+
+void patchString(std::string &data, size_t offset, const std::string &value)
+{
+    memcpy(&data[offset], value.c_str(), value.size() + 1);
+}
+
+std::string makeDll(const std::string &name, const std::string &function, const std::string &forwarder)
+{
+    std::string data(gSample, gSampleSize);
+    patch<uint32_t>(data, RDataVirtualSizeOffset, 0x200);
+    patch<uint32_t>(data, ExportTableOffset, RDataRVA);
+    patch<uint32_t>(data, ExportTableOffset + 4, 0x100);
+
+    patch<uint32_t>(data, RDataOffset + 12, RDataRVA + 0x60);
+    patch<uint32_t>(data, RDataOffset + 16, 1);
+    patch<uint32_t>(data, RDataOffset + 20, 1);
+    patch<uint32_t>(data, RDataOffset + 24, 1);
+    patch<uint32_t>(data, RDataOffset + 28, RDataRVA + 0x28);
+    patch<uint32_t>(data, RDataOffset + 32, RDataRVA + 0x2c);
+    patch<uint32_t>(data, RDataOffset + 36, RDataRVA + 0x30);
+
+    patch<uint32_t>(data, RDataOffset + 0x28, forwarder.empty() ? TextRVA : RDataRVA + 0x40);
+    patch<uint32_t>(data, RDataOffset + 0x2c, RDataRVA + 0x80);
+    patch<uint16_t>(data, RDataOffset + 0x30, 0);
+    patchString(data, RDataOffset + 0x40, forwarder);
+    patchString(data, RDataOffset + 0x60, name);
+    patchString(data, RDataOffset + 0x80, function);
+    return data;
+}
+
+void writeFile(const std::string &filename, const std::string &data)
+{
+    std::ofstream ofstream(filename, std::ios::binary);
+    ofstream.write(data.data(), data.size());
+}
+
+std::string readFile(const std::string &filename)
+{
+    std::ifstream ifstream(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(ifstream), std::istreambuf_iterator<char>());
+}
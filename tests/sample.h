@@ -22,10 +22,81 @@
  * IN THE SOFTWARE.
  */
 
+
 #ifndef SAMPLE_H
 #define SAMPLE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
 extern const char *gSample;
 extern const unsigned int gSampleSize;
 
+// Location of fields in the sample, a PE32+ image with .text, .rdata and
+// .idata sections
+
+const size_t PEOffsetOffset = 0x3c;
+const size_t PEHeaderOffset = 0x80;
+const size_t MachineOffset = 0x84;
+const size_t NumberOfSectionsOffset = 0x86;
+const size_t TimeDateStampOffset = 0x88;
+const size_t PointerToSymbolTableOffset = 0x8c;
+const size_t CharacteristicsOffset = 0x96;
+const size_t ImageBaseOffset = 0xb0;
+const size_t SizeOfImageOffset = 0xd0;
+const size_t CheckSumOffset = 0xd8;
+const size_t DllCharacteristicsOffset = 0xde;
+
+// Data directory entries
+const size_t ExportTableOffset = 0x108;
+const size_t CertificateTableOffset = 0x128;
+const size_t BaseRelocationTableOffset = 0x130;
+const size_t DebugDirectoryOffset = 0x138;
+const size_t ImportAddressTableOffset = 0x168;
+const size_t CLRHeaderOffset = 0x178;
+
+// Section headers
+const size_t TextSizeOfRawDataOffset = 0x198;
+const size_t RDataNameOffset = 0x1b0;
+const size_t RDataVirtualSizeOffset = 0x1b8;
+const size_t IDataVirtualSizeOffset = 0x1e0;
+const size_t IDataSizeOfRawDataOffset = 0x1e8;
+
+// Raw data of each section and its RVA
+const size_t TextOffset = 0x200;
+const size_t RDataOffset = 0x400;
+const size_t IDataOffset = 0x600;
+const uint32_t TextRVA = 0x1000;
+const uint32_t RDataRVA = 0x2000;
+const uint32_t IDataRVA = 0x3000;
+
+// Overwrite a value in a copy of a file
+template<typename T>
+void patch(std::string &data, size_t offset, T value)
+{
+    memcpy(&data[offset], &value, sizeof(value));
+}
+
+// Copy of the sample with a value overwritten
+template<typename T>
+std::string patched(size_t offset, T value)
+{
+    std::string data(gSample, gSampleSize);
+    patch(data, offset, value);
+    return data;
+}
+
+std::string patched(size_t offset, const char *value, size_t size);
+
+void patchString(std::string &data, size_t offset, const std::string &value);
+
+// Create a DLL exporting a single function (forwarded if a forwarder is
+// provided) at ordinal 1; like the sample, it imports USER32.dll itself
+std::string makeDll(const std::string &name, const std::string &function, const std::string &forwarder);
+
+void writeFile(const std::string &filename, const std::string &data);
+std::string readFile(const std::string &filename);
+
 #endif // SAMPLE_H
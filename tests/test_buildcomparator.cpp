@@ -0,0 +1,141 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE buildcomparator
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <win32pe/buildcomparator.h>
+#include <win32pe/file.h>
+
+#include "sample.h"
+
+namespace
+{
+
+// Location of the Rich header written over the DOS stub
+const size_t RichOffset = 0x50;
+
+// The sample as produced by a build with the given non-deterministic values
+std::string build(uint32_t timeDateStamp, uint32_t key, uint32_t count, uint32_t age)
+{
+    std::string data(gSample, gSampleSize);
+    patch<uint32_t>(data, TimeDateStampOffset, timeDateStamp);
+    patch<uint32_t>(data, CheckSumOffset, timeDateStamp ^ 0x5555);
+
+    // Rich header with two tools
+    const uint32_t rich[] = {
+        0x536e6144, 0, 0, 0,
+        0x00e1520d, count, 0x00ff6030, count + 3
+    };
+    for (size_t i = 0; i < sizeof(rich) / sizeof(*rich); ++i) {
+        patch<uint32_t>(data, RichOffset + i * 4, rich[i] ^ key);
+    }
+    memcpy(&data[RichOffset + 32], "Rich", 4);
+    patch<uint32_t>(data, RichOffset + 36, key);
+
+    // Debug directory with a CodeView entry in .rdata
+    patch<uint32_t>(data, RDataVirtualSizeOffset, 0x100);
+    patch<uint32_t>(data, DebugDirectoryOffset, RDataRVA);
+    patch<uint32_t>(data, DebugDirectoryOffset + 4, 28);
+    patch<uint32_t>(data, RDataOffset + 4, timeDateStamp);
+    patch<uint32_t>(data, RDataOffset + 12, 2);
+    patch<uint32_t>(data, RDataOffset + 16, 30);
+    patch<uint32_t>(data, RDataOffset + 20, RDataRVA + 0x20);
+    patch<uint32_t>(data, RDataOffset + 24, RDataOffset + 0x20);
+    memcpy(&data[RDataOffset + 0x20], "RSDS", 4);
+    for (size_t i = 0; i < 16; ++i) {
+        data[RDataOffset + 0x24 + i] = static_cast<char>(timeDateStamp * (i + 1));
+    }
+    patch<uint32_t>(data, RDataOffset + 0x34, age);
+    memcpy(&data[RDataOffset + 0x38], "a.pdb", 6);
+
+    return data;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_reproducible)
+{
+    std::string first = build(0x5a222e0e, 0x1234abcd, 7, 1);
+    std::string second = build(0x61000000, 0x0badf00d, 9, 3);
+    BOOST_REQUIRE(first != second);
+
+    win32pe::File a, b;
+    BOOST_REQUIRE(a.load(first.data(), first.size()));
+    BOOST_REQUIRE(b.load(second.data(), second.size()));
+
+    win32pe::BuildComparator comparator;
+    BOOST_REQUIRE(comparator.compare(a, b));
+    BOOST_TEST(comparator.differences().empty());
+
+    // A file loaded from a stream compares the same way
+    std::istringstream istringstream(second);
+    BOOST_REQUIRE(b.load(istringstream));
+    comparator.setChunkSize(256);
+    BOOST_REQUIRE(comparator.compare(a, b));
+    BOOST_TEST(comparator.differences().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_differences)
+{
+    std::string first = build(0x5a222e0e, 0x1234abcd, 7, 1);
+    std::string second = build(0x61000000, 0x0badf00d, 9, 3);
+
+    // Two adjacent bytes of code, a byte of the PDB path and a tool ID
+    second[TextOffset + 0x10] ^= '\x01';
+    second[TextOffset + 0x11] ^= '\x01';
+    second[RDataOffset + 0x38] = 'b';
+    patch<uint32_t>(second, RichOffset + 16, 0x00e1520e ^ 0x0badf00d);
+
+    win32pe::File a, b;
+    BOOST_REQUIRE(a.load(first.data(), first.size()));
+    BOOST_REQUIRE(b.load(second.data(), second.size()));
+
+    win32pe::BuildComparator comparator;
+    BOOST_REQUIRE(comparator.compare(a, b));
+    const std::vector<win32pe::BuildComparator::Difference> &differences = comparator.differences();
+    BOOST_REQUIRE(differences.size() == 3);
+    BOOST_TEST(differences.at(0).rva == RichOffset + 16);
+    BOOST_TEST(differences.at(0).size == 1);
+    BOOST_TEST(differences.at(1).rva == TextRVA + 0x10);
+    BOOST_TEST(differences.at(1).size == 2);
+    BOOST_TEST(differences.at(2).rva == RDataRVA + 0x38);
+    BOOST_TEST(differences.at(2).size == 1);
+
+    // Differences that span chunks are reported as one range
+    comparator.setChunkSize(9);
+    BOOST_REQUIRE(comparator.compare(a, b));
+    BOOST_TEST(comparator.differences().size() == 3);
+    BOOST_TEST(comparator.differences().at(1).size == 2);
+
+    BOOST_TEST(!comparator.compare(a, win32pe::File()));
+    BOOST_TEST(!comparator.errorString().empty());
+}
@@ -0,0 +1,111 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE concurrency
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <win32pe/file.h>
+#include <win32pe/importtable.h>
+#include <win32pe/section.h>
+
+#include "sample.h"
+
+// Build with -DWIN32PE_SANITIZE_THREAD=ON to have ThreadSanitizer check for
+// races; otherwise this only verifies that the results are consistent
+
+BOOST_AUTO_TEST_CASE(test_shared_file)
+{
+    const int Threads = 16;
+    const int Rounds = 20;
+
+    std::atomic<int> failures(0);
+
+    for (int round = 0; round < Rounds; ++round) {
+
+        // A fresh file each round so that the threads race to build the
+        // lazily initialized data
+        win32pe::File file;
+        BOOST_REQUIRE(file.load(gSample, gSampleSize));
+
+        std::atomic<bool> start(false);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < Threads; ++i) {
+            threads.push_back(std::thread([&file, &start, &failures, i]() {
+                while (!start) {
+                    std::this_thread::yield();
+                }
+
+                // Alternate which lazy structure each thread touches first
+                bool ok = true;
+                if (i % 2) {
+                    ok = ok && file.sections().size() == 3;
+                }
+                const win32pe::Section *section = file.rvaToSection(0x3000);
+                ok = ok && section && section->name() == ".idata";
+                ok = ok && file.rvaToSectionRef(0x1000).name() == ".text";
+                ok = ok && file.sections().at(2).data().size() == 0x200;
+
+                const win32pe::ImportTable::Item &item = file.importTable().items().at(0);
+                ok = ok && file.string(item.name) == "USER32.dll";
+                std::vector<win32pe::ImportTable::Function> functions = file.importedFunctions(item);
+                ok = ok && functions.size() == 1 && functions.at(0).name == "MessageBoxA";
+
+                if (!ok) {
+                    ++failures;
+                }
+            }));
+        }
+
+        start = true;
+        for (auto it = threads.begin(); it != threads.end(); ++it) {
+            (*it).join();
+        }
+    }
+
+    BOOST_TEST(failures == 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_modify_after_use)
+{
+    // Editing replaces the lazily built data rather than reusing it
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+    BOOST_REQUIRE(file.rvaToSection(0x2008)->name() == ".rdata");
+    BOOST_REQUIRE(file.removeSection(1));
+
+    // The previous section is extended to close the hole
+    BOOST_TEST(file.rvaToSection(0x2008)->name() == ".text");
+    BOOST_TEST(file.sections().size() == 2);
+
+    // Copies build their own
+    win32pe::File copy(file);
+    BOOST_TEST(copy.sections().size() == 2);
+    BOOST_TEST(copy.rvaToSectionRef(0x3000).name() == ".idata");
+}
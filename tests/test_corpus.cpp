@@ -0,0 +1,178 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE corpus
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <win32pe/corpusquery.h>
+#include <win32pe/corpusstore.h>
+#include <win32pe/file.h>
+#include <win32pe/fileheader.h>
+#include <win32pe/optionalheader.h>
+
+#include "sample.h"
+
+namespace
+{
+
+const char *Filename = "test_corpus.store";
+
+// Enough files to cover both full 64-row blocks and a partial one
+const uint32_t Count = 300;
+
+void fill(win32pe::CorpusStore &store, uint32_t first, uint32_t count)
+{
+    for (uint32_t i = first; i < first + count; ++i) {
+        std::string data(gSample, gSampleSize);
+        patch<uint16_t>(data, MachineOffset, i % 3 ? win32pe::FileHeader::amd64 : win32pe::FileHeader::i386);
+        patch<uint32_t>(data, TimeDateStampOffset, 0x50000000 + i * 0x100000);
+        patch<uint16_t>(data, CharacteristicsOffset,
+                        win32pe::FileHeader::ExecutableImage | (i % 2 ? win32pe::FileHeader::DLL : 0));
+        patch<uint16_t>(data, DllCharacteristicsOffset, i % 5 ? win32pe::OptionalHeader::NXCompat : 0);
+
+        win32pe::File file;
+        BOOST_REQUIRE(file.load(data.data(), data.size()));
+        store.add("file" + std::to_string(i), file);
+    }
+}
+
+// Evaluate the query in the example one row at a time
+std::vector<uint32_t> expected(const win32pe::CorpusStore &store, uint32_t date)
+{
+    std::vector<uint32_t> rows;
+    for (uint32_t i = 0; i < store.size(); ++i) {
+        if (store.value(win32pe::CorpusStore::Machine, i) == win32pe::FileHeader::amd64 &&
+                (store.value(win32pe::CorpusStore::Characteristics, i) & win32pe::FileHeader::DLL) &&
+                !(store.value(win32pe::CorpusStore::DllCharacteristics, i) & win32pe::OptionalHeader::NXCompat) &&
+                store.value(win32pe::CorpusStore::TimeDateStamp, i) >= date) {
+            rows.push_back(i);
+        }
+    }
+    return rows;
+}
+
+win32pe::CorpusQuery exampleQuery(uint32_t date)
+{
+    win32pe::CorpusQuery query;
+    query.setMachine(win32pe::FileHeader::amd64);
+    query.requireCharacteristics(win32pe::FileHeader::DLL);
+    query.excludeDllCharacteristics(win32pe::OptionalHeader::NXCompat);
+    query.setTimeDateStampRange(date, 0xffffffff);
+    return query;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_query)
+{
+    win32pe::CorpusStore store;
+    fill(store, 0, Count);
+    BOOST_TEST(store.size() == Count);
+    BOOST_TEST(store.path(7) == "file7");
+    BOOST_TEST(store.value(win32pe::CorpusStore::NumberOfSections, 0) == 3);
+    BOOST_TEST(store.value(win32pe::CorpusStore::FileSize, 0) == gSampleSize);
+    BOOST_TEST(store.entropy(0) > 0.0f);
+    BOOST_TEST(store.entropy(0) <= 8.0f);
+
+    uint32_t date = 0x50000000 + 100 * 0x100000;
+    std::vector<uint32_t> rows = exampleQuery(date).run(store);
+    BOOST_TEST(!rows.empty());
+    BOOST_TEST(rows == expected(store, date));
+    BOOST_TEST(exampleQuery(date).count(store) == rows.size());
+
+    // An empty query matches everything
+    BOOST_TEST(win32pe::CorpusQuery().count(store) == Count);
+
+    win32pe::CorpusQuery query;
+    query.setSectionCountRange(4, 10);
+    BOOST_TEST(query.count(store) == 0);
+    query.setSectionCountRange(3, 3);
+    BOOST_TEST(query.count(store) == Count);
+
+    query = win32pe::CorpusQuery();
+    query.setEntropyRange(store.entropy(0), store.entropy(0));
+    BOOST_TEST(query.count(store) == Count);
+
+    query = win32pe::CorpusQuery();
+    query.setImportHash(store.value(win32pe::CorpusStore::ImportHash, 0));
+    query.setFileSizeRange(0, gSampleSize);
+    BOOST_TEST(query.count(store) == Count);
+}
+
+BOOST_AUTO_TEST_CASE(test_import_hash)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+    uint64_t hash = win32pe::CorpusStore::importHash(file);
+
+    // The DLL name is case-insensitive but the function name is not
+    std::string data(gSample, gSampleSize);
+    size_t dll = data.find("USER32.dll");
+    BOOST_REQUIRE(dll != std::string::npos);
+    patchString(data, dll, "user32.DLL");
+    BOOST_REQUIRE(file.load(data.data(), data.size()));
+    BOOST_TEST(win32pe::CorpusStore::importHash(file) == hash);
+
+    size_t function = data.find("MessageBoxA");
+    BOOST_REQUIRE(function != std::string::npos);
+    patchString(data, function, "MessageBoxW");
+    BOOST_REQUIRE(file.load(data.data(), data.size()));
+    BOOST_TEST(win32pe::CorpusStore::importHash(file) != hash);
+}
+
+BOOST_AUTO_TEST_CASE(test_save)
+{
+    {
+        win32pe::CorpusStore store;
+        fill(store, 0, Count);
+        BOOST_TEST(store.save(Filename));
+    }
+
+    uint32_t date = 0x50000000;
+
+    win32pe::CorpusStore store;
+    BOOST_TEST(store.open(Filename));
+    BOOST_TEST(store.size() == Count);
+    BOOST_TEST(store.path(Count - 1) == "file299");
+    BOOST_TEST(exampleQuery(date).run(store) == expected(store, date));
+
+    // Adding to a mapped store copies it into memory
+    fill(store, Count, 10);
+    BOOST_TEST(store.size() == Count + 10);
+    BOOST_TEST(store.path(Count) == "file300");
+    BOOST_TEST(exampleQuery(date).run(store) == expected(store, date));
+
+    BOOST_TEST(store.save(Filename));
+    BOOST_TEST(store.open(Filename));
+    BOOST_TEST(store.size() == Count + 10);
+
+    std::remove(Filename);
+    BOOST_TEST(!store.open(Filename));
+}
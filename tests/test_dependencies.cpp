@@ -0,0 +1,188 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE dependencies
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <win32pe/dependencyresolver.h>
+#include <win32pe/file.h>
+
+#include "sample.h"
+
+namespace
+{
+
+const char *RootFilename = "test_dependencies.exe";
+const char *User32Filename = "USER32.dll";
+const char *Kernel32Filename = "kernel32.dll";
+
+}
+
+BOOST_AUTO_TEST_CASE(test_exports)
+{
+    std::string data = makeDll(User32Filename, "MessageBoxA", "KERNEL32.MessageBoxW");
+
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(data.data(), data.size()));
+    std::vector<win32pe::File::Export> exports = file.exports();
+    BOOST_REQUIRE(exports.size() == 1);
+    BOOST_TEST(exports.at(0).ordinal == 1);
+    BOOST_TEST(exports.at(0).rva == 0);
+    BOOST_TEST(exports.at(0).name == "MessageBoxA");
+    BOOST_TEST(exports.at(0).forwarder == "KERNEL32.MessageBoxW");
+
+    // The sample itself has no exports
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+    BOOST_TEST(file.exports().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_resolve)
+{
+    writeFile(RootFilename, std::string(gSample, gSampleSize));
+
+    win32pe::DependencyResolver resolver;
+    resolver.addSearchDirectory(".");
+    win32pe::DependencyResolver::Result result;
+
+    // Without USER32.dll
+    std::remove(User32Filename);
+    BOOST_REQUIRE(resolver.resolve(RootFilename, result));
+    BOOST_REQUIRE(result.modules.size() == 2);
+    BOOST_REQUIRE(result.missingModules.size() == 1);
+    BOOST_TEST(result.missingModules.at(0) == User32Filename);
+    BOOST_TEST(result.missingFunctions.empty());
+    BOOST_TEST(result.modules.at(0).imports.at(0).provider.empty());
+
+    // With USER32.dll exporting the function directly - the cache must be
+    // cleared since the missing DLL was cached
+    writeFile(User32Filename, makeDll(User32Filename, "MessageBoxA", ""));
+    resolver.clearCache();
+    BOOST_REQUIRE(resolver.resolve(RootFilename, result));
+    BOOST_REQUIRE(result.modules.size() == 2);
+    BOOST_TEST(result.missingModules.empty());
+    BOOST_TEST(result.missingFunctions.empty());
+    BOOST_TEST(result.modules.at(1).path == std::string("./") + User32Filename);
+    const win32pe::DependencyResolver::Import &import = result.modules.at(0).imports.at(0);
+    BOOST_TEST(import.name == "MessageBoxA");
+    BOOST_TEST(import.provider == User32Filename);
+    BOOST_TEST(import.rva == TextRVA);
+    BOOST_TEST(resolver.cacheSize() == 1);
+
+    // Forwarded to a DLL found by its lower-case name
+    writeFile(User32Filename, makeDll(User32Filename, "MessageBoxA", "KERNEL32.MessageBoxW"));
+    writeFile(Kernel32Filename, makeDll("KERNEL32.dll", "MessageBoxW", ""));
+    resolver.clearCache();
+    BOOST_REQUIRE(resolver.resolve(RootFilename, result));
+    BOOST_REQUIRE(result.modules.size() == 3);
+    BOOST_TEST(result.modules.at(2).name == "KERNEL32.dll");
+    BOOST_TEST(result.modules.at(2).path == std::string("./") + Kernel32Filename);
+    BOOST_TEST(result.modules.at(0).imports.at(0).provider == "KERNEL32.dll");
+    BOOST_TEST(result.missingFunctions.empty());
+
+    // Forwarded to a function that does not exist
+    writeFile(Kernel32Filename, makeDll("KERNEL32.dll", "MessageBoxExW", ""));
+    resolver.clearCache();
+    BOOST_REQUIRE(resolver.resolve(RootFilename, result));
+    BOOST_TEST(result.missingModules.empty());
+    BOOST_REQUIRE(!result.missingFunctions.empty());
+    BOOST_TEST(result.missingFunctions.at(0).importer == RootFilename);
+    BOOST_TEST(result.missingFunctions.at(0).name == "MessageBoxA");
+
+    std::remove(Kernel32Filename);
+    std::remove(User32Filename);
+    std::remove(RootFilename);
+}
+
+BOOST_AUTO_TEST_CASE(test_shared_cache)
+{
+    writeFile(RootFilename, std::string(gSample, gSampleSize));
+    writeFile(User32Filename, makeDll(User32Filename, "MessageBoxA", ""));
+
+    // Resolve the same root many times concurrently; the DLL is parsed once
+    win32pe::DependencyResolver resolver;
+    resolver.addSearchDirectory(".");
+    std::vector<win32pe::DependencyResolver::Result> results(32);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 4; ++i) {
+        threads.emplace_back([&resolver, &results, i]() {
+            for (size_t j = i; j < results.size(); j += 4) {
+                resolver.resolve(RootFilename, results[j]);
+            }
+        });
+    }
+    for (auto it = threads.begin(); it != threads.end(); ++it) {
+        (*it).join();
+    }
+
+    BOOST_TEST(resolver.cacheSize() == 1);
+    for (auto it = results.begin(); it != results.end(); ++it) {
+        BOOST_REQUIRE((*it).modules.size() == 2);
+        BOOST_TEST((*it).modules.at(0).imports.at(0).provider == User32Filename);
+    }
+
+    BOOST_TEST(!resolver.resolve("test_dependencies_missing.exe", results[0]));
+    BOOST_TEST(!resolver.errorString().empty());
+
+    std::remove(User32Filename);
+    std::remove(RootFilename);
+}
+
+BOOST_AUTO_TEST_CASE(test_clear_while_resolving)
+{
+    writeFile(RootFilename, std::string(gSample, gSampleSize));
+    writeFile(User32Filename, makeDll(User32Filename, "MessageBoxA", ""));
+
+    // Resolutions reuse the same workers and stay complete while another
+    // thread keeps discarding the cache
+    win32pe::DependencyResolver resolver;
+    resolver.addSearchDirectory(".");
+    resolver.setThreadCount(4);
+    std::vector<win32pe::DependencyResolver::Result> results(32);
+    std::thread clearer([&resolver]() {
+        for (int i = 0; i < 100; ++i) {
+            resolver.clearCache();
+            std::this_thread::yield();
+        }
+    });
+    for (auto it = results.begin(); it != results.end(); ++it) {
+        BOOST_TEST(resolver.resolve(RootFilename, *it));
+    }
+    clearer.join();
+
+    for (auto it = results.begin(); it != results.end(); ++it) {
+        BOOST_REQUIRE((*it).modules.size() == 2);
+        BOOST_TEST((*it).modules.at(0).imports.at(0).provider == User32Filename);
+        BOOST_TEST((*it).missingFunctions.empty());
+    }
+
+    std::remove(User32Filename);
+    std::remove(RootFilename);
+}
@@ -0,0 +1,200 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE digests
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include <win32pe/digests.h>
+#include <win32pe/file.h>
+
+#include "sample.h"
+
+namespace
+{
+
+// The sample followed by an overlay spanning more than one chunk
+std::string sampleWithOverlay()
+{
+    std::string data(gSample, gSampleSize);
+    for (int i = 0; i < 100000; ++i) {
+        data.push_back(static_cast<char>((i * 7) % 251));
+    }
+    return data;
+}
+
+void check(const win32pe::File &file)
+{
+    const win32pe::Digests &digests = file.fileDigests();
+    BOOST_TEST(win32pe::Digests::toHex(digests.md5) == "e0b0704c404b251f7ad70f806a028cdd");
+    BOOST_TEST(win32pe::Digests::toHex(digests.sha1) == "fad53dbadcb0a1d4fe2215a64e18696e87e08b5e");
+    BOOST_TEST(win32pe::Digests::toHex(digests.sha256) ==
+               "949e31b1678e734ad7d12c6c320fc6051750026512968b342687ff5389d22969");
+    BOOST_TEST(win32pe::Digests::toHex(digests.xxh64) == "3fc35d136ba403e7");
+
+    const win32pe::Digests &text = file.sectionDigests(0);
+    BOOST_TEST(win32pe::Digests::toHex(text.md5) == "4b68e94a854e9878a2c6ae3a2e2a0961");
+    BOOST_TEST(win32pe::Digests::toHex(text.sha1) == "a41dafc67a8003d8a2965f630d95682f7b198d72");
+    BOOST_TEST(win32pe::Digests::toHex(text.sha256) ==
+               "7c4ddf0b78ccc6301c4bb11879d29aa0201264a071b4bbc011b68c2980c44f30");
+    BOOST_TEST(win32pe::Digests::toHex(text.xxh64) == "ecdb38b7a08642a8");
+
+    const win32pe::Digests &overlay = file.overlayDigests();
+    BOOST_TEST(win32pe::Digests::toHex(overlay.md5) == "c260642229888763c0fa2a4843f50a36");
+    BOOST_TEST(win32pe::Digests::toHex(overlay.sha1) == "a21056bb4b3ec44dc5b44c7718fd99109047e400");
+    BOOST_TEST(win32pe::Digests::toHex(overlay.sha256) ==
+               "96ad0ddabe9c733d4550fde750255a94806811029be67504bd9bd68e556686b9");
+    BOOST_TEST(win32pe::Digests::toHex(overlay.xxh64) == "38257cc2053a1729");
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_memory)
+{
+    std::string data = sampleWithOverlay();
+
+    win32pe::File file;
+    file.setDigestAlgorithms(win32pe::Digests::AllAlgorithms);
+    BOOST_REQUIRE(file.load(data.data(), data.size()));
+    check(file);
+    BOOST_TEST(file.sectionDigests(file.sectionCount()).md5.empty());
+
+    // Copies keep the digests
+    win32pe::File copy(file);
+    check(copy);
+}
+
+BOOST_AUTO_TEST_CASE(test_stream)
+{
+    std::istringstream istringstream(sampleWithOverlay());
+
+    win32pe::File file;
+    file.setDigestAlgorithms(win32pe::Digests::AllAlgorithms);
+    BOOST_REQUIRE(file.load(istringstream));
+    check(file);
+}
+
+BOOST_AUTO_TEST_CASE(test_selection)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+    BOOST_TEST(file.fileDigests().md5.empty());
+    BOOST_TEST(file.fileDigests().xxh64.empty());
+
+    file.setDigestAlgorithms(win32pe::Digests::SHA256);
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+    BOOST_TEST(file.fileDigests().md5.empty());
+    BOOST_TEST(file.fileDigests().sha256.size() == 32);
+
+    // An empty overlay has the digest of no data
+    BOOST_TEST(win32pe::Digests::toHex(file.overlayDigests().sha256) ==
+               "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+}
+
+BOOST_AUTO_TEST_CASE(test_modified)
+{
+    win32pe::File file;
+    file.setDigestAlgorithms(win32pe::Digests::AllAlgorithms);
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+    BOOST_REQUIRE(file.removeSection(0));
+    BOOST_TEST(file.fileDigests().md5.empty());
+    BOOST_TEST(file.sectionDigests(0).md5.empty());
+    BOOST_TEST(file.overlayDigests().md5.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_reference)
+{
+    // Test vectors from RFC 1321 and FIPS 180-2
+    struct Vector {
+        std::string data;
+        const char *md5;
+        const char *sha1;
+        const char *sha256;
+    };
+    const Vector vectors[] = {
+        {
+            "abc",
+            "900150983cd24fb0d6963f7d28e17f72",
+            "a9993e364706816aba3e25717850c26c9cd0d89d",
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"
+        },
+        {
+            "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+            "8215ef0796a20bcaaae116d3876c664a",
+            "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+            "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"
+        },
+        {
+            std::string(1000000, 'a'),
+            "7707d6ae4e027c70eea2a935c2296f21",
+            "34aa973cd4c4daa4f61eeb2bdbad27316534016f",
+            "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"
+        }
+    };
+    for (const Vector &vector : vectors) {
+        win32pe::Digests digests = win32pe::Digests::compute(
+            vector.data.data(), vector.data.size(), win32pe::Digests::AllAlgorithms
+        );
+        BOOST_TEST(win32pe::Digests::toHex(digests.md5) == vector.md5);
+        BOOST_TEST(win32pe::Digests::toHex(digests.sha1) == vector.sha1);
+        BOOST_TEST(win32pe::Digests::toHex(digests.sha256) == vector.sha256);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_xxh64)
+{
+    // The sanity buffer and results from the xxHash test suite (seed 0)
+    std::string buffer(222, '\0');
+    uint64_t generator = 2654435761U;
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        buffer[i] = static_cast<char>(generator >> 56);
+        generator *= 11400714785074694797ULL;
+    }
+    struct Vector {
+        size_t size;
+        const char *xxh64;
+    };
+    const Vector vectors[] = {
+        {0, "ef46db3751d8e999"},
+        {1, "e934a84adb052768"},
+        {14, "8282dcc4994e35c8"},
+        {222, "b641ae8cb691c174"}
+    };
+    for (const Vector &vector : vectors) {
+        win32pe::Digests digests = win32pe::Digests::compute(
+            buffer.data(), vector.size, win32pe::Digests::XXH64
+        );
+        BOOST_TEST(win32pe::Digests::toHex(digests.xxh64) == vector.xxh64);
+    }
+
+    std::string data(1000000, 'a');
+    BOOST_TEST(win32pe::Digests::toHex(
+        win32pe::Digests::compute("abc", 3, win32pe::Digests::XXH64).xxh64) == "44bc2cf5ad770999");
+    BOOST_TEST(win32pe::Digests::toHex(
+        win32pe::Digests::compute(data.data(), data.size(), win32pe::Digests::XXH64).xxh64) == "dc483aaa9b4fdc40");
+}
@@ -0,0 +1,143 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE editor
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <win32pe/editor.h>
+#include <win32pe/file.h>
+#include <win32pe/fileheader.h>
+#include <win32pe/optionalheader.h>
+#include <win32pe/section.h>
+
+#include "sample.h"
+
+namespace
+{
+
+const char *Filename = "test_editor.bin";
+
+// Straightforward implementation of the checksum algorithm
+uint32_t referenceChecksum(const std::string &data)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < data.size(); i += 2) {
+        if (i == CheckSumOffset || i == CheckSumOffset + 2) {
+            continue;
+        }
+        uint32_t word = static_cast<unsigned char>(data[i]);
+        if (i + 1 < data.size()) {
+            word |= static_cast<unsigned char>(data[i + 1]) << 8;
+        }
+        sum += word;
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return sum + static_cast<uint32_t>(data.size());
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_headers)
+{
+    writeFile(Filename, std::string(gSample, gSampleSize));
+
+    win32pe::Editor editor;
+    BOOST_TEST(editor.open(Filename));
+    BOOST_TEST(editor.checkSum() == 0x436e);
+    BOOST_TEST(editor.sectionCount() == 3);
+
+    BOOST_TEST(editor.setTimeDateStamp(0x5a000000));
+    BOOST_TEST(editor.setDllCharacteristics(win32pe::OptionalHeader::NXCompat));
+    BOOST_TEST(editor.setSubsystemVersion(6, 1));
+    BOOST_TEST(editor.setDataDirectory(win32pe::OptionalHeader::DebuggingInformation, 0x2000, 0x1c));
+    BOOST_TEST(!editor.setDataDirectory(win32pe::OptionalHeader::DataDirectoryCount, 0, 0));
+
+    // The incremental checksum must match a full computation
+    uint32_t checkSum = editor.checkSum();
+    BOOST_TEST(editor.recomputeChecksum() == checkSum);
+    BOOST_TEST(editor.close());
+    BOOST_TEST(referenceChecksum(readFile(Filename)) == checkSum);
+
+    win32pe::File file;
+    BOOST_TEST(file.load(std::string(Filename)));
+    BOOST_TEST(file.fileHeader().timeDateStamp() == 0x5a000000);
+    BOOST_TEST(file.optionalHeader().dllCharacteristics() == win32pe::OptionalHeader::NXCompat);
+    BOOST_TEST(file.optionalHeader().dataDirectory()[win32pe::OptionalHeader::DebuggingInformation].size == 0x1c);
+
+    std::remove(Filename);
+}
+
+BOOST_AUTO_TEST_CASE(test_data)
+{
+    // Use an odd-sized file so that the final byte is padded
+    std::string data(gSample, gSampleSize);
+    data.append(1, '\x7f');
+    writeFile(Filename, data);
+
+    win32pe::Editor editor;
+    BOOST_TEST(editor.open(Filename));
+    BOOST_TEST(editor.recomputeChecksum() == referenceChecksum(data));
+
+    BOOST_TEST(editor.patchRVA(0x1001, "\x90\x90\x90", 3));
+    BOOST_TEST(editor.patchSection(2, 0x1ff, "\xcc", 1));
+    BOOST_TEST(!editor.patchSection(2, 0x1ff, "\xcc\xcc", 2));
+    BOOST_TEST(!editor.patchRVA(0x9000, "\xcc", 1));
+    BOOST_TEST(!editor.patch(CheckSumOffset + 2, "\0", 1));
+    BOOST_TEST(!editor.patch(data.size() - 1, "\0\0", 2));
+
+    // Random patches at odd and even offsets
+    std::srand(1);
+    for (int i = 0; i < 100; ++i) {
+        char bytes[7];
+        for (size_t j = 0; j < sizeof(bytes); ++j) {
+            bytes[j] = static_cast<char>(std::rand());
+        }
+        uint64_t offset = 0x200 + std::rand() % (data.size() - 0x200 - sizeof(bytes));
+        BOOST_TEST(editor.patch(offset, bytes, sizeof(bytes)));
+    }
+    BOOST_TEST(editor.patch(data.size() - 1, "\x01", 1));
+
+    uint32_t checkSum = editor.checkSum();
+    BOOST_TEST(editor.close());
+    BOOST_TEST(referenceChecksum(readFile(Filename)) == checkSum);
+
+    std::remove(Filename);
+}
+
+BOOST_AUTO_TEST_CASE(test_invalid)
+{
+    writeFile(Filename, "MZ not a PE file");
+
+    win32pe::Editor editor;
+    BOOST_TEST(!editor.open(Filename));
+    BOOST_TEST(!editor.setTimeDateStamp(0));
+
+    std::remove(Filename);
+}
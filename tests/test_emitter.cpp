@@ -0,0 +1,135 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE emitter
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <string>
+
+#include <win32pe/emitter.h>
+#include <win32pe/file.h>
+#include <win32pe/importtable.h>
+
+#include "sample.h"
+
+namespace
+{
+
+size_t countOf(const std::string &str, char c)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < str.size(); ++i) {
+        count += str[i] == c;
+    }
+    return count;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_ndjson)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+
+    win32pe::Emitter emitter;
+    std::string buffer;
+    emitter.header(buffer);
+    BOOST_TEST(buffer.empty());
+
+    emitter.emit(buffer, "sample.exe", file);
+    BOOST_TEST(buffer.find("{\"path\":\"sample.exe\",\"machine\":\"0x8664\"") == 0);
+    BOOST_TEST(buffer.find("\"magic\":\"0x20b\"") != std::string::npos);
+    BOOST_TEST(buffer.find("{\"name\":\".text\",\"virtualAddress\":\"0x1000\"") != std::string::npos);
+    BOOST_TEST(buffer.find("\"pointerToRawData\":\"0x200\",\"sizeOfRawData\":512") != std::string::npos);
+    BOOST_TEST(buffer.find("\"fileSize\":2048") != std::string::npos);
+    BOOST_TEST(buffer.back() == '\n');
+    BOOST_TEST(countOf(buffer, '\n') == 1);
+    BOOST_TEST(countOf(buffer, '{') == countOf(buffer, '}'));
+    BOOST_TEST(countOf(buffer, '[') == countOf(buffer, ']'));
+
+    // Every import is emitted by name, along with its functions
+    for (const win32pe::ImportTable::Item &item : file.importTable().items()) {
+        BOOST_TEST(buffer.find("{\"name\":\"" + file.string(item.name) + "\"") != std::string::npos);
+    }
+    BOOST_TEST(buffer.find("\"functions\":[\"MessageBoxA\"]}") != std::string::npos);
+
+    // The buffer is appended to
+    size_t size = buffer.size();
+    emitter.emit(buffer, "sample.exe", file);
+    BOOST_TEST(buffer.size() == 2 * size);
+}
+
+BOOST_AUTO_TEST_CASE(test_fields)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+
+    win32pe::Emitter emitter;
+    emitter.setFields(win32pe::Emitter::Derived);
+
+    std::string buffer;
+    emitter.emit(buffer, "sample.exe", file);
+    BOOST_TEST(buffer.find("{\"path\":\"sample.exe\",\"fileSize\":2048,") == 0);
+    BOOST_TEST(buffer.find("sections") == std::string::npos);
+    BOOST_TEST(buffer.find("machine") == std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_escaping)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+
+    win32pe::Emitter emitter;
+    emitter.setFields(0);
+
+    std::string buffer;
+    emitter.emit(buffer, boost::string_ref("a\"b\\c\n\xe9", 7), file);
+    BOOST_TEST(buffer == "{\"path\":\"a\\\"b\\\\c\\u000a\\u00e9\"}\n");
+
+    emitter.setFormat(win32pe::Emitter::CSV);
+    buffer.clear();
+    emitter.emit(buffer, "a,\"b\"", file);
+    BOOST_TEST(buffer == "\"a,\"\"b\"\"\"\n");
+}
+
+BOOST_AUTO_TEST_CASE(test_csv)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+
+    win32pe::Emitter emitter;
+    emitter.setFormat(win32pe::Emitter::CSV);
+
+    std::string buffer;
+    emitter.header(buffer);
+    BOOST_TEST(buffer == "path,machine,timeDateStamp,characteristics,magic,subsystem,dllCharacteristics,"
+                         "numberOfSections,sections,imports,importedFunctions,fileSize,overlayOffset,overlaySize,importHash\n");
+
+    std::string row;
+    emitter.emit(row, "sample.exe", file);
+    BOOST_TEST(row.find("sample.exe,0x8664,") == 0);
+    BOOST_TEST(row.find(",3,.text;.rdata;.idata,USER32.dll,USER32.dll!MessageBoxA,") != std::string::npos);
+    BOOST_TEST(countOf(row, ',') == countOf(buffer, ','));
+}
@@ -0,0 +1,192 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE imagehash
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <win32pe/digests.h>
+#include <win32pe/file.h>
+#include <win32pe/imagehash.h>
+#include <win32pe/optionalheader.h>
+#include <win32pe/sectionref.h>
+
+#include "sample.h"
+
+namespace
+{
+
+// Location of the import address table in the sample
+const uint32_t IATRVA = 0x3038;
+const uint64_t ImageBase = 0x400000;
+
+template<typename T>
+T read(const std::string &data, size_t offset)
+{
+    T value;
+    memcpy(&value, &data[offset], sizeof(value));
+    return value;
+}
+
+// The sample with two pointers in .text and DIR64 fixups for them in .rdata
+std::string sample()
+{
+    std::string data(gSample, gSampleSize);
+    patch<uint32_t>(data, BaseRelocationTableOffset, RDataRVA);
+    patch<uint32_t>(data, BaseRelocationTableOffset + 4, 12);
+    patch<uint32_t>(data, RDataOffset, TextRVA);
+    patch<uint32_t>(data, RDataOffset + 4, 12);
+    patch<uint16_t>(data, RDataOffset + 8, 0xa010);
+    patch<uint16_t>(data, RDataOffset + 10, 0xa040);
+    patch<uint64_t>(data, TextOffset + 0x10, ImageBase + 0x1020);
+    patch<uint64_t>(data, TextOffset + 0x40, ImageBase + 0x2008);
+    return data;
+}
+
+// Map a file as the loader would at a different base address
+std::string load(const std::string &data, uint64_t imageBase)
+{
+    win32pe::File file;
+    file.load(data.data(), data.size());
+
+    std::string image(file.optionalHeader().sizeOfImage(), '\0');
+    memcpy(&image[0], data.data(), file.optionalHeader().sizeOfHeaders());
+    for (const win32pe::SectionRef &section : file.sectionRefs()) {
+        memcpy(&image[section.virtualAddress()], section.data().data(), section.data().size());
+    }
+
+    uint64_t delta = imageBase - ImageBase;
+    patch<uint64_t>(image, ImageBaseOffset, imageBase);
+    std::vector<win32pe::File::Relocation> relocations = file.relocations();
+    for (auto it = relocations.begin(); it != relocations.end(); ++it) {
+        patch<uint64_t>(image, (*it).rva, read<uint64_t>(image, (*it).rva) + delta);
+    }
+    patch<uint64_t>(image, IATRVA, 0x7ff812345678);
+    return image;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_load_image)
+{
+    std::string data = sample();
+    std::string image = load(data, 0x140000000);
+
+    win32pe::File file;
+    BOOST_REQUIRE(file.loadImage(image.data(), image.size()));
+    BOOST_TEST(file.isImage());
+    BOOST_TEST(file.optionalHeader().imageBase() == 0x140000000);
+    BOOST_TEST(file.overlaySize() == 0);
+    BOOST_REQUIRE(file.sectionCount() == 3);
+    BOOST_TEST(file.section(0).data().data() == image.data() + TextRVA);
+    BOOST_TEST(file.section(0).data().size() == 0x200);
+    BOOST_TEST(file.relocations().size() == 2);
+    BOOST_REQUIRE(file.importTable().items().size() == 1);
+    BOOST_TEST(file.string(file.importTable().items().at(0).name) == "USER32.dll");
+
+    // A truncated image has truncated sections
+    BOOST_REQUIRE(file.loadImage(image.data(), 0x3100));
+    BOOST_TEST(file.section(2).data().size() == 0x100);
+
+    BOOST_REQUIRE(file.load(data.data(), data.size()));
+    BOOST_TEST(!file.isImage());
+    BOOST_TEST(file.optionalHeader().imageBase() == ImageBase);
+}
+
+BOOST_AUTO_TEST_CASE(test_normalized)
+{
+    std::string data = sample();
+    std::string image = load(data, 0x140000000);
+
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(data.data(), data.size()));
+    win32pe::ImageHash diskHash;
+    diskHash.setAlgorithms(win32pe::Digests::XXH64 | win32pe::Digests::SHA256);
+    BOOST_REQUIRE(diskHash.compute(file));
+    BOOST_TEST(diskHash.imageSize() == 0x4000);
+    BOOST_TEST(diskHash.digests().sha256.size() == 32);
+
+    // The masks are merged and ordered
+    const std::vector<win32pe::ImageHash::Mask> &masks = diskHash.masks();
+    BOOST_REQUIRE(masks.size() == 6);
+    BOOST_TEST(masks.at(0).rva == 0x88);
+    BOOST_TEST(masks.at(3).rva == TextRVA + 0x10);
+    BOOST_TEST(masks.at(3).size == 8);
+    BOOST_TEST(masks.at(5).rva == IATRVA);
+    BOOST_TEST(masks.at(5).size == 0x10);
+
+    // A rebased image hashes the same as the file
+    win32pe::File dump;
+    BOOST_REQUIRE(dump.loadImage(image.data(), image.size()));
+    win32pe::ImageHash dumpHash(diskHash);
+    BOOST_REQUIRE(dumpHash.compute(dump));
+    BOOST_TEST(dumpHash.digests().xxh64 == diskHash.digests().xxh64);
+    BOOST_TEST(dumpHash.digests().sha256 == diskHash.digests().sha256);
+
+    // So does the file loaded from a stream
+    std::istringstream istringstream(data);
+    BOOST_REQUIRE(file.load(istringstream));
+    BOOST_REQUIRE(dumpHash.compute(file));
+    BOOST_TEST(dumpHash.digests().sha256 == diskHash.digests().sha256);
+
+    // But code that differs does not
+    image[TextRVA + 0x20] ^= '\xff';
+    BOOST_REQUIRE(dump.loadImage(image.data(), image.size()));
+    BOOST_REQUIRE(dumpHash.compute(dump));
+    BOOST_TEST(dumpHash.digests().sha256 != diskHash.digests().sha256);
+}
+
+BOOST_AUTO_TEST_CASE(test_import_thunks)
+{
+    // Without an IAT directory entry, each descriptor's thunks are masked
+    std::string data = sample();
+    patch<uint64_t>(data, ImportAddressTableOffset, 0);
+    std::string image = load(data, 0x180000000);
+
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(data.data(), data.size()));
+    win32pe::ImageHash diskHash;
+    BOOST_REQUIRE(diskHash.compute(file));
+    const std::vector<win32pe::ImageHash::Mask> &masks = diskHash.masks();
+    BOOST_REQUIRE(!masks.empty());
+    BOOST_TEST(masks.back().rva == IATRVA);
+    BOOST_TEST(masks.back().size == 8);
+
+    win32pe::File dump;
+    BOOST_REQUIRE(dump.loadImage(image.data(), image.size()));
+    win32pe::ImageHash dumpHash;
+    BOOST_REQUIRE(dumpHash.compute(dump));
+    BOOST_TEST(dumpHash.digests().xxh64 == diskHash.digests().xxh64);
+
+    win32pe::ImageHash empty;
+    BOOST_TEST(!empty.compute(win32pe::File()));
+    BOOST_TEST(!empty.errorString().empty());
+}
@@ -0,0 +1,213 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE importindex
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <win32pe/file.h>
+#include <win32pe/importindex.h>
+
+#include "sample.h"
+
+namespace
+{
+
+const char *Filename = "test_importindex.index";
+
+// The import lookup table is moved to .rdata (whose virtual size is
+// increased) to make room for more functions
+const size_t ImportDescriptorOffset = IDataOffset;
+const size_t ImportNameOffset = 0x65c;
+
+const uint32_t Count = 200;
+
+// Functions beginning with "#" are imported by ordinal
+std::vector<std::string> functions(uint32_t i)
+{
+    std::vector<std::string> functions;
+    functions.push_back("MessageBoxA");
+    if (i % 3 == 0) {
+        functions.push_back("CreateRemoteThread");
+    }
+    if (i % 4 == 0) {
+        functions.push_back("NtMapViewOfSection");
+    }
+    if (i % 5 == 0) {
+        functions.push_back("#5");
+    }
+    return functions;
+}
+
+void add(win32pe::ImportIndex &index, uint32_t i)
+{
+    std::string data(gSample, gSampleSize);
+    patch<uint32_t>(data, RDataVirtualSizeOffset, 0x200);
+    patch<uint32_t>(data, ImportDescriptorOffset, RDataRVA);
+    memcpy(&data[ImportNameOffset], i % 2 ? "user32.dll" : "USER32.dll", 10);
+
+    std::vector<std::string> names = functions(i);
+    for (size_t j = 0; j < names.size(); ++j) {
+        uint64_t thunk;
+        if (names[j][0] == '#') {
+            thunk = 0x8000000000000000ULL | std::stoul(names[j].substr(1));
+        } else {
+            uint32_t rva = RDataRVA + 0x80 + static_cast<uint32_t>(j) * 0x20;
+            memcpy(&data[RDataOffset + rva - RDataRVA + 2], names[j].c_str(), names[j].size() + 1);
+            thunk = rva;
+        }
+        patch<uint64_t>(data, RDataOffset + j * sizeof(uint64_t), thunk);
+    }
+
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(data.data(), data.size()));
+    BOOST_REQUIRE(index.add(file) == i);
+}
+
+win32pe::ImportIndex::Term term(const std::string &dll, const std::string &function)
+{
+    win32pe::ImportIndex::Term term;
+    term.dll = dll;
+    term.function = function;
+    return term;
+}
+
+void check(const win32pe::ImportIndex &index)
+{
+    BOOST_TEST(index.fileCount() == Count);
+    BOOST_TEST(index.termCount() == 4);
+    BOOST_TEST(index.frequency(term("USER32.dll", "MessageBoxA")) == Count);
+    BOOST_TEST(index.frequency(term("user32.DLL", "#5")) == Count / 5);
+    BOOST_TEST(index.frequency(term("USER32.dll", "messageboxa")) == 0);
+
+    std::vector<win32pe::ImportIndex::Term> terms;
+    terms.push_back(term("USER32.dll", "NtMapViewOfSection"));
+    terms.push_back(term("user32.dll", "CreateRemoteThread"));
+    std::vector<uint32_t> ids = index.query(terms);
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < Count; i += 12) {
+        expected.push_back(i);
+    }
+    BOOST_TEST(ids == expected, boost::test_tools::per_element());
+
+    terms.push_back(term("USER32.dll", "#5"));
+    ids = index.query(terms);
+    BOOST_REQUIRE(ids.size() == 4);
+    BOOST_TEST(ids.at(1) == 60);
+
+    terms.push_back(term("KERNEL32.dll", "CreateRemoteThread"));
+    BOOST_TEST(index.query(terms).empty());
+    BOOST_TEST(index.query(std::vector<win32pe::ImportIndex::Term>()).empty());
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_query)
+{
+    win32pe::ImportIndex index;
+    for (uint32_t i = 0; i < Count; ++i) {
+        add(index, i);
+    }
+    check(index);
+
+    BOOST_REQUIRE(index.save(Filename));
+    win32pe::ImportIndex mapped;
+    BOOST_REQUIRE(mapped.open(Filename));
+    check(mapped);
+
+    std::remove(Filename);
+}
+
+BOOST_AUTO_TEST_CASE(test_append)
+{
+    // Files added to an opened index continue from where it left off
+    {
+        win32pe::ImportIndex index;
+        for (uint32_t i = 0; i < Count / 2; ++i) {
+            add(index, i);
+        }
+        BOOST_REQUIRE(index.save(Filename));
+    }
+
+    win32pe::ImportIndex index;
+    BOOST_REQUIRE(index.open(Filename));
+    for (uint32_t i = Count / 2; i < Count; ++i) {
+        add(index, i);
+    }
+    check(index);
+
+    std::remove(Filename);
+}
+
+BOOST_AUTO_TEST_CASE(test_invalid)
+{
+    {
+        std::ofstream ofstream(Filename, std::ios::binary);
+        ofstream << "W32PEII1\x01\x00\x00\x00\xff\xff\xff\xff\x18\x00\x00\x00\x00\x00\x00\x00";
+    }
+
+    win32pe::ImportIndex index;
+    BOOST_TEST(!index.open(Filename));
+    BOOST_TEST(!index.errorString().empty());
+
+    std::remove(Filename);
+}
+
+BOOST_AUTO_TEST_CASE(test_corrupt_count)
+{
+    {
+        win32pe::ImportIndex index;
+        for (uint32_t i = 0; i < Count; ++i) {
+            add(index, i);
+        }
+        BOOST_REQUIRE(index.save(Filename));
+    }
+
+    // A posting count larger than the list itself is treated as empty
+    // rather than trusted
+    const size_t HeaderSize = 24;
+    const size_t EntrySize = 40;
+    const size_t CountOffset = 24;
+    std::string data = readFile(Filename);
+    for (size_t i = 0; i < 4; ++i) {
+        patch<uint32_t>(data, HeaderSize + i * EntrySize + CountOffset, 0xffffffff);
+    }
+    writeFile(Filename, data);
+
+    win32pe::ImportIndex index;
+    BOOST_REQUIRE(index.open(Filename));
+    BOOST_TEST(index.frequency(term("USER32.dll", "MessageBoxA")) == 0);
+    std::vector<win32pe::ImportIndex::Term> terms;
+    terms.push_back(term("USER32.dll", "MessageBoxA"));
+    BOOST_TEST(index.query(terms).empty());
+
+    std::remove(Filename);
+}
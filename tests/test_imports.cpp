@@ -0,0 +1,88 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE imports
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <win32pe/file.h>
+#include <win32pe/importtable.h>
+
+#include "sample.h"
+
+BOOST_AUTO_TEST_CASE(test_imported_functions)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+    BOOST_REQUIRE(file.importTable().items().size() == 1);
+
+    std::vector<win32pe::ImportTable::Function> functions =
+        file.importedFunctions(file.importTable().items().at(0));
+    BOOST_REQUIRE(functions.size() == 1);
+    BOOST_TEST(!functions.at(0).byOrdinal);
+    BOOST_TEST(functions.at(0).hint == 0x1ec);
+    BOOST_TEST(functions.at(0).name == "MessageBoxA");
+}
+
+BOOST_AUTO_TEST_CASE(test_relocations)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+    BOOST_TEST(file.relocations().empty());
+
+    // Add a block with two DIR64 fixups and a padding entry to .rdata
+    std::string data(gSample, gSampleSize);
+    patch<uint32_t>(data, BaseRelocationTableOffset, RDataRVA);
+    patch<uint32_t>(data, BaseRelocationTableOffset + 4, 14);
+    patch<uint32_t>(data, RDataOffset, 0x1000);
+    patch<uint32_t>(data, RDataOffset + 4, 14);
+    patch<uint16_t>(data, RDataOffset + 8, 0xa010);
+    patch<uint16_t>(data, RDataOffset + 10, 0xa0f8);
+    patch<uint16_t>(data, RDataOffset + 12, 0);
+
+    BOOST_REQUIRE(file.load(data.data(), data.size()));
+    std::vector<win32pe::File::Relocation> relocations = file.relocations();
+    BOOST_REQUIRE(relocations.size() == 2);
+    BOOST_TEST(relocations.at(0).rva == 0x1010);
+    BOOST_TEST(relocations.at(0).type == 10);
+    BOOST_TEST(relocations.at(1).rva == 0x10f8);
+
+    // The slot after a HIGHADJ fixup is its parameter, not another fixup
+    patch<uint16_t>(data, RDataOffset + 8, 0x4010);
+    patch<uint16_t>(data, RDataOffset + 10, 0xa0f8);
+    BOOST_REQUIRE(file.load(data.data(), data.size()));
+    relocations = file.relocations();
+    BOOST_REQUIRE(relocations.size() == 1);
+    BOOST_TEST(relocations.at(0).rva == 0x1010);
+    BOOST_TEST(relocations.at(0).type == 4);
+
+    // A block claiming to extend past the directory ends the walk
+    patch<uint32_t>(data, RDataOffset + 4, 0x100);
+    BOOST_REQUIRE(file.load(data.data(), data.size()));
+    BOOST_TEST(file.relocations().empty());
+}
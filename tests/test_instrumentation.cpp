@@ -0,0 +1,137 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE instrumentation
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <win32pe/file.h>
+#include <win32pe/instrumentation.h>
+
+#include "sample.h"
+
+namespace
+{
+
+size_t countOf(const std::string &str, const std::string &needle)
+{
+    size_t count = 0;
+    for (size_t pos = str.find(needle); pos != std::string::npos; pos = str.find(needle, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_load)
+{
+    win32pe::Instrumentation instrumentation;
+
+    std::istringstream istream(std::string(gSample, gSampleSize));
+    win32pe::File file;
+    file.setInstrumentation(&instrumentation);
+    BOOST_TEST(file.instrumentation() == &instrumentation);
+    BOOST_TEST(file.load(istream));
+
+    if (!win32pe::Instrumentation::isAvailable()) {
+        // Nothing is recorded when the hooks are compiled out
+        BOOST_TEST(instrumentation.counter(win32pe::Instrumentation::Loads) == 0);
+        BOOST_TEST(instrumentation.phaseCount(win32pe::Instrumentation::Sections) == 0);
+        return;
+    }
+
+    BOOST_TEST(instrumentation.counter(win32pe::Instrumentation::Loads) == 1);
+    for (int i = 0; i < win32pe::Instrumentation::PhaseCount; ++i) {
+        BOOST_TEST(instrumentation.phaseCount(static_cast<win32pe::Instrumentation::Phase>(i)) == 1);
+    }
+
+    // Every byte of the headers and section data is read exactly once
+    BOOST_TEST(instrumentation.counter(win32pe::Instrumentation::BytesRead) == gSampleSize);
+    BOOST_TEST(instrumentation.counter(win32pe::Instrumentation::ReadCalls) > 0);
+    BOOST_TEST(instrumentation.counter(win32pe::Instrumentation::SeekCalls) > 0);
+    BOOST_TEST(instrumentation.counter(win32pe::Instrumentation::LoaderBuffers) > 0);
+    BOOST_TEST(instrumentation.counter(win32pe::Instrumentation::LoaderBufferBytes) >= 0x600);
+
+    instrumentation.reset();
+    BOOST_TEST(instrumentation.counter(win32pe::Instrumentation::Loads) == 0);
+    BOOST_TEST(instrumentation.phaseTime(win32pe::Instrumentation::Sections) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_threads)
+{
+    const int Threads = 4;
+    const int Loads = 50;
+
+    win32pe::Instrumentation instrumentation;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < Threads; ++i) {
+        threads.push_back(std::thread([&instrumentation]() {
+            for (int j = 0; j < Loads; ++j) {
+                win32pe::File file;
+                file.setInstrumentation(&instrumentation);
+                file.load(gSample, gSampleSize);
+            }
+        }));
+    }
+    for (auto it = threads.begin(); it != threads.end(); ++it) {
+        (*it).join();
+    }
+
+    uint64_t expected = win32pe::Instrumentation::isAvailable() ? Threads * Loads : 0;
+    BOOST_TEST(instrumentation.counter(win32pe::Instrumentation::Loads) == expected);
+    BOOST_TEST(instrumentation.phaseCount(win32pe::Instrumentation::DOSHeader) == expected);
+    BOOST_TEST(instrumentation.phaseCount(win32pe::Instrumentation::Overlay) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_export)
+{
+    win32pe::Instrumentation instrumentation;
+    instrumentation.setEventCapacity(3);
+
+    for (int i = 0; i < 2; ++i) {
+        win32pe::File file;
+        file.setInstrumentation(&instrumentation);
+        BOOST_TEST(file.load(gSample, gSampleSize));
+    }
+
+    std::string trace = instrumentation.chromeTrace();
+    BOOST_TEST(trace.find("{\"traceEvents\":[") == 0);
+    BOOST_TEST(countOf(trace, "\"ph\":\"C\"") == 1);
+    BOOST_TEST(countOf(trace, "\"ph\":\"X\"") ==
+               (win32pe::Instrumentation::isAvailable() ? 3 : 0));
+
+    std::string summary = instrumentation.summary();
+    for (int i = 0; i < win32pe::Instrumentation::PhaseCount; ++i) {
+        BOOST_TEST(summary.find(win32pe::Instrumentation::phaseName(
+            static_cast<win32pe::Instrumentation::Phase>(i))) != std::string::npos);
+    }
+    BOOST_TEST(summary.find("bytes-read") != std::string::npos);
+}
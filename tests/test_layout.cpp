@@ -0,0 +1,190 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE layout
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <sstream>
+#include <string>
+
+#include <win32pe/file.h>
+#include <win32pe/fileheader.h>
+#include <win32pe/importtable.h>
+#include <win32pe/optionalheader.h>
+#include <win32pe/section.h>
+
+#include "sample.h"
+
+namespace
+{
+
+// Save a file and load the result
+void reload(const win32pe::File &file, win32pe::File &saved)
+{
+    std::stringstream stringstream;
+    BOOST_TEST(file.save(stringstream));
+    BOOST_TEST(saved.load(stringstream));
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_add)
+{
+    win32pe::File file;
+    BOOST_TEST(file.load(gSample, gSampleSize));
+    std::string text = file.sections().at(0).data();
+
+    // The sample's section table fills its headers exactly, so adding a
+    // section requires the headers to grow
+    BOOST_TEST(file.addSection(".meta", win32pe::Section::ContainsInitializedData |
+                                        win32pe::Section::MemoryRead, "metadata"));
+    BOOST_TEST(!file.addSection(".toolongname", 0, ""));
+
+    win32pe::File saved;
+    reload(file, saved);
+    BOOST_TEST(saved.sections().size() == 4);
+    BOOST_TEST(saved.fileSize() == gSampleSize + 0x400);
+    BOOST_TEST(saved.optionalHeader().dataDirectory()[win32pe::OptionalHeader::ImportTable].virtualAddress == 0x3000);
+
+    const win32pe::Section &text2 = saved.sections().at(0);
+    BOOST_TEST(text2.pointerToRawData() == 0x400);
+    BOOST_TEST(text2.virtualAddress() == 0x1000);
+    BOOST_TEST(text2.data() == text);
+
+    const win32pe::Section &meta = saved.sections().at(3);
+    BOOST_TEST(meta.name() == ".meta");
+    BOOST_TEST(meta.virtualAddress() == 0x4000);
+    BOOST_TEST(meta.virtualSize() == 8);
+    BOOST_TEST(meta.pointerToRawData() == 0xa00);
+    BOOST_TEST(meta.data().size() == 0x200);
+    BOOST_TEST(meta.data().substr(0, 8) == "metadata");
+    BOOST_TEST(saved.string(0x4000) == "metadata");
+
+    // The import table still resolves
+    BOOST_TEST(saved.string(saved.importTable().items().at(0).name) == "USER32.dll");
+}
+
+BOOST_AUTO_TEST_CASE(test_resize)
+{
+    win32pe::File file;
+    BOOST_TEST(file.load(gSample, gSampleSize));
+
+    // Growing .text past the start of .rdata pushes the later sections along
+    // in memory and in the file, and the import directory with them
+    BOOST_TEST(file.resizeSection(0, 0x1800));
+
+    win32pe::File saved;
+    reload(file, saved);
+    BOOST_TEST(saved.sections().at(0).virtualSize() == 0x1800);
+    BOOST_TEST(saved.sections().at(0).data().size() == 0x1800);
+    BOOST_TEST(saved.sections().at(1).virtualAddress() == 0x3000);
+    BOOST_TEST(saved.sections().at(1).pointerToRawData() == 0x1a00);
+    BOOST_TEST(saved.sections().at(2).virtualAddress() == 0x4000);
+    BOOST_TEST(saved.optionalHeader().dataDirectory()[win32pe::OptionalHeader::ImportTable].virtualAddress == 0x4000);
+    BOOST_TEST(saved.optionalHeader().dataDirectory()[win32pe::OptionalHeader::ImportAddressTable].virtualAddress == 0x4038);
+
+    // Growing the last section moves nothing else
+    win32pe::File other;
+    BOOST_TEST(other.load(gSample, gSampleSize));
+    BOOST_TEST(other.resizeSection(2, 0x300));
+    reload(other, saved);
+    BOOST_TEST(saved.sections().at(1).pointerToRawData() == 0x400);
+    BOOST_TEST(saved.sections().at(2).pointerToRawData() == 0x600);
+    BOOST_TEST(saved.sections().at(2).data().size() == 0x400);
+    BOOST_TEST(saved.fileSize() == 0xa00);
+}
+
+BOOST_AUTO_TEST_CASE(test_remove)
+{
+    win32pe::File file;
+    BOOST_TEST(file.load(gSample, gSampleSize));
+    BOOST_TEST(!file.removeSection(3));
+
+    // Removing .rdata extends .text to cover the hole
+    BOOST_TEST(file.removeSection(1));
+
+    win32pe::File saved;
+    reload(file, saved);
+    BOOST_TEST(saved.sections().size() == 2);
+    BOOST_TEST(saved.sections().at(0).virtualSize() == 0x2000);
+    BOOST_TEST(saved.sections().at(1).name() == ".idata");
+    BOOST_TEST(saved.sections().at(1).virtualAddress() == 0x3000);
+
+    // Removing the last section shrinks the image and clears the import
+    // directory that referred to it
+    BOOST_TEST(file.removeSection(1));
+    reload(file, saved);
+    BOOST_TEST(saved.sections().size() == 1);
+    BOOST_TEST(saved.optionalHeader().dataDirectory()[win32pe::OptionalHeader::ImportTable].virtualAddress == 0);
+    BOOST_TEST(file.importTable().items().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_remove_first)
+{
+    win32pe::File file;
+    BOOST_TEST(file.load(gSample, gSampleSize));
+
+    // Removing .text enlarges the headers to reach .rdata in memory, which
+    // pushes the remaining section data along in the file
+    BOOST_TEST(file.removeSection(0));
+    BOOST_TEST(file.optionalHeader().sizeOfHeaders() == RDataRVA);
+
+    win32pe::File saved;
+    reload(file, saved);
+    BOOST_TEST(saved.optionalHeader().sizeOfHeaders() == RDataRVA);
+    BOOST_TEST(saved.sections().size() == 2);
+    BOOST_TEST(saved.sections().at(0).virtualAddress() == RDataRVA);
+    BOOST_TEST(saved.sections().at(0).pointerToRawData() == RDataRVA);
+    BOOST_TEST(saved.sections().at(1).virtualAddress() == IDataRVA);
+    BOOST_TEST(saved.string(saved.importTable().items().at(0).name) == "USER32.dll");
+}
+
+BOOST_AUTO_TEST_CASE(test_overlay)
+{
+    std::string data(gSample, gSampleSize);
+    data.append("overlay");
+    patch<uint32_t>(data, CertificateTableOffset, static_cast<uint32_t>(gSampleSize));
+    patch<uint32_t>(data, CertificateTableOffset + 4, 7);
+
+    // Growing .idata moves the overlay along with the certificate table in
+    // it, and the import table is read from the new data
+    win32pe::File file;
+    BOOST_TEST(file.load(data.data(), data.size()));
+    BOOST_TEST(file.resizeSection(2, 0x300));
+    BOOST_TEST(file.overlayOffset() == 0xa00);
+    BOOST_TEST(file.overlay() == "overlay");
+    BOOST_TEST(file.optionalHeader().dataDirectory()[win32pe::OptionalHeader::CertificateTable].virtualAddress == 0xa00);
+    BOOST_TEST(file.overlayOverlapsCertificateTable());
+    BOOST_TEST(file.string(file.importTable().items().at(0).name) == "USER32.dll");
+
+    std::stringstream stringstream;
+    BOOST_TEST(file.save(stringstream));
+    std::string saved = stringstream.str();
+    win32pe::File other;
+    BOOST_TEST(other.load(saved.data(), saved.size()));
+    BOOST_TEST(other.overlayOffset() == 0xa00);
+    BOOST_TEST(other.overlay() == "overlay");
+    BOOST_TEST(other.optionalHeader().dataDirectory()[win32pe::OptionalHeader::CertificateTable].virtualAddress == 0xa00);
+}
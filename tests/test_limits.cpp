@@ -0,0 +1,123 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE limits
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include <win32pe/file.h>
+#include <win32pe/importtable.h>
+#include <win32pe/limits.h>
+#include <win32pe/symboltable.h>
+
+#include "sample.h"
+
+namespace
+{
+
+// Load from a stream so that everything is copied and thus bounded
+std::string loadError(const std::string &data, const win32pe::Limits &limits = win32pe::Limits())
+{
+    std::istringstream istream(data);
+    win32pe::File file;
+    file.setLimits(limits);
+    if (file.load(istream)) {
+        return std::string();
+    }
+    return file.errorString();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_defaults)
+{
+    BOOST_TEST(loadError(std::string(gSample, gSampleSize)) == "");
+}
+
+BOOST_AUTO_TEST_CASE(test_header_offset)
+{
+    BOOST_TEST(loadError(patched<uint32_t>(PEOffsetOffset, 0x10)) == "PE header offset is out of range");
+    BOOST_TEST(loadError(patched<uint32_t>(PEOffsetOffset, 0x7fffffff)) == "PE header offset is out of range");
+
+    win32pe::Limits limits;
+    limits.setMaxHeaderSize(0x40);
+    BOOST_TEST(loadError(std::string(gSample, gSampleSize), limits) == "PE header offset is out of range");
+}
+
+BOOST_AUTO_TEST_CASE(test_sections)
+{
+    // Within the default limits but far beyond the end of the file
+    BOOST_TEST(loadError(patched<uint16_t>(NumberOfSectionsOffset, 0x1000)) ==
+               "section table is out of range");
+
+    win32pe::Limits limits;
+    limits.setMaxSections(2);
+    BOOST_TEST(loadError(std::string(gSample, gSampleSize), limits) == "too many sections");
+}
+
+BOOST_AUTO_TEST_CASE(test_section_size)
+{
+    BOOST_TEST(loadError(patched<uint32_t>(TextSizeOfRawDataOffset, 0xfffffff0)) == "section exceeds size limit");
+    BOOST_TEST(loadError(patched<uint32_t>(TextSizeOfRawDataOffset, 0x1000)) == "section data is out of range");
+
+    win32pe::Limits limits;
+    limits.setMaxSectionSize(0x100);
+    BOOST_TEST(loadError(std::string(gSample, gSampleSize), limits) == "section exceeds size limit");
+
+    limits = win32pe::Limits();
+    limits.setMaxTotalSize(0x400);
+    BOOST_TEST(loadError(std::string(gSample, gSampleSize), limits) == "file data exceeds size limit");
+}
+
+BOOST_AUTO_TEST_CASE(test_imports)
+{
+    win32pe::Limits limits;
+    limits.setMaxImportDescriptors(0);
+    BOOST_TEST(loadError(std::string(gSample, gSampleSize), limits) == "unable to read import table");
+}
+
+BOOST_AUTO_TEST_CASE(test_symbols)
+{
+    // A symbol table far larger than the file is treated as absent
+    std::string data(gSample, gSampleSize);
+    uint32_t header[] = {0x100, 0x10000000};
+    memcpy(&data[PointerToSymbolTableOffset], header, sizeof(header));
+
+    std::istringstream istream(data);
+    win32pe::File file;
+    BOOST_TEST(file.load(istream));
+    BOOST_TEST(file.symbolTable().size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_time_budget)
+{
+    win32pe::Limits limits;
+    limits.setTimeBudget(10000);
+    BOOST_TEST(loadError(std::string(gSample, gSampleSize), limits) == "");
+}
@@ -71,3 +71,22 @@ BOOST_AUTO_TEST_CASE(test_load)
     BOOST_TEST(file.importTable().items().size() == 1);
     BOOST_TEST(file.string(file.importTable().items().at(0).name) == "USER32.dll");
 }
+
+BOOST_AUTO_TEST_CASE(test_load_memory_released)
+{
+    // The data passed to load() may be released once it returns, even when
+    // the File has been copied
+    win32pe::File copy;
+    {
+        std::string data(gSample, gSampleSize);
+        win32pe::File file;
+        BOOST_REQUIRE(file.load(data.data(), data.size()));
+        copy = file;
+        data.assign(data.size(), '\0');
+    }
+
+    BOOST_TEST(copy.sections().size() == 3);
+    BOOST_TEST(copy.section(0).data().size() == 512);
+    BOOST_TEST(copy.string(copy.importTable().items().at(0).name) == "USER32.dll");
+    BOOST_TEST(copy.overlay().size() == copy.overlaySize());
+}
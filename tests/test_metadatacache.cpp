@@ -0,0 +1,259 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE metadatacache
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <win32pe/corpusstore.h>
+#include <win32pe/digests.h>
+#include <win32pe/file.h>
+#include <win32pe/fileheader.h>
+#include <win32pe/importtable.h>
+#include <win32pe/metadatacache.h>
+#include <win32pe/optionalheader.h>
+#include <win32pe/section.h>
+
+#include "sample.h"
+
+namespace
+{
+
+const char *Filename = "test_metadatacache.bin";
+const char *CacheFilename = "test_metadatacache.cache";
+
+void checkRestored(const win32pe::File &original, const win32pe::File &restored)
+{
+    BOOST_TEST(restored.fileHeader().machine() == original.fileHeader().machine());
+    BOOST_TEST(restored.fileHeader().timeDateStamp() == original.fileHeader().timeDateStamp());
+    BOOST_TEST(restored.optionalHeader().magic() == original.optionalHeader().magic());
+    BOOST_TEST(restored.optionalHeader().subsystem() == original.optionalHeader().subsystem());
+    BOOST_TEST(restored.optionalHeader().dataDirectory()[win32pe::OptionalHeader::ImportTable].virtualAddress ==
+               original.optionalHeader().dataDirectory()[win32pe::OptionalHeader::ImportTable].virtualAddress);
+    BOOST_TEST(restored.fileSize() == original.fileSize());
+    BOOST_TEST(restored.overlayOffset() == original.overlayOffset());
+    BOOST_TEST(restored.overlaySize() == original.overlaySize());
+
+    BOOST_REQUIRE(restored.sections().size() == original.sections().size());
+    for (size_t i = 0; i < original.sections().size(); ++i) {
+        BOOST_TEST(restored.sections()[i].name() == original.sections()[i].name());
+        BOOST_TEST(restored.sections()[i].virtualAddress() == original.sections()[i].virtualAddress());
+        BOOST_TEST(restored.sections()[i].pointerToRawData() == original.sections()[i].pointerToRawData());
+
+        // Section data is not cached
+        BOOST_TEST(restored.sections()[i].data().empty());
+    }
+
+    const std::vector<win32pe::ImportTable::Item> &items = original.importTable().items();
+    BOOST_REQUIRE(restored.importTable().items().size() == items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        BOOST_TEST(restored.importTable().items()[i].name == items[i].name);
+        BOOST_TEST(restored.importTable().items()[i].firstThunk == items[i].firstThunk);
+        BOOST_TEST(restored.string(items[i].name) == original.string(items[i].name));
+
+        std::vector<win32pe::ImportTable::Function> functions = original.importedFunctions(items[i]);
+        BOOST_TEST(!functions.empty());
+        std::vector<win32pe::ImportTable::Function> restoredFunctions = restored.importedFunctions(items[i]);
+        BOOST_REQUIRE(restoredFunctions.size() == functions.size());
+        size_t count = 0;
+        for (const win32pe::ImportTable::FunctionRef &function : restored.importedFunctionRefs(items[i])) {
+            BOOST_REQUIRE(count < functions.size());
+            BOOST_TEST(function.byOrdinal == functions[count].byOrdinal);
+            BOOST_TEST(function.hint == functions[count].hint);
+            BOOST_TEST(function.name == functions[count].name);
+            BOOST_TEST(restoredFunctions[count].name == functions[count].name);
+            ++count;
+        }
+        BOOST_TEST(count == functions.size());
+    }
+
+    // Anything derived from the imports is the same as for the original
+    BOOST_TEST(std::distance(restored.importDescriptors().begin(), restored.importDescriptors().end()) ==
+               static_cast<std::ptrdiff_t>(items.size()));
+    BOOST_TEST(win32pe::CorpusStore::importHash(restored) == win32pe::CorpusStore::importHash(original));
+
+    std::vector<win32pe::File::Export> exports = original.exports();
+    BOOST_REQUIRE(restored.exports().size() == exports.size());
+    for (size_t i = 0; i < exports.size(); ++i) {
+        BOOST_TEST(restored.exports()[i].ordinal == exports[i].ordinal);
+        BOOST_TEST(restored.exports()[i].rva == exports[i].rva);
+        BOOST_TEST(restored.exports()[i].name == exports[i].name);
+        BOOST_TEST(restored.exports()[i].forwarder == exports[i].forwarder);
+    }
+
+    BOOST_TEST(restored.fileDigests().sha256 == original.fileDigests().sha256);
+    BOOST_TEST(restored.fileDigests().xxh64 == original.fileDigests().xxh64);
+    BOOST_TEST(restored.overlayDigests().sha256 == original.overlayDigests().sha256);
+    for (size_t i = 0; i < original.sectionCount(); ++i) {
+        BOOST_TEST(restored.sectionDigests(i).md5 == original.sectionDigests(i).md5);
+    }
+
+    // Without the section data, the file cannot be written back
+    std::ostringstream ostringstream;
+    BOOST_TEST(!restored.save(ostringstream));
+    BOOST_TEST(!restored.errorString().empty());
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_cache)
+{
+    std::remove(CacheFilename);
+    writeFile(Filename, std::string(gSample, gSampleSize) + "overlay");
+
+    win32pe::File original;
+    original.setDigestAlgorithms(win32pe::Digests::AllAlgorithms);
+    BOOST_REQUIRE(original.load(std::string(Filename)));
+    BOOST_REQUIRE(!original.importTable().items().empty());
+
+    {
+        win32pe::MetadataCache cache;
+        BOOST_TEST(cache.open(CacheFilename));
+        BOOST_TEST(cache.size() == 0);
+
+        win32pe::File file;
+        BOOST_TEST(!cache.lookup(Filename, file));
+        BOOST_TEST(cache.insert(Filename, original));
+        BOOST_TEST(cache.size() == 1);
+
+        // Pending entries can be looked up before the cache is saved
+        BOOST_TEST(cache.lookup(Filename, file));
+        checkRestored(original, file);
+
+        BOOST_TEST(cache.save());
+        BOOST_TEST(cache.size() == 1);
+    }
+
+    {
+        win32pe::MetadataCache cache;
+        BOOST_TEST(cache.open(CacheFilename));
+        BOOST_TEST(cache.size() == 1);
+
+        win32pe::File file;
+        BOOST_TEST(cache.lookup(Filename, file));
+        checkRestored(original, file);
+
+        // A copy of the restored file keeps the cached strings
+        win32pe::File copy(file);
+        checkRestored(original, copy);
+    }
+
+    // Changing the file invalidates the entry
+    writeFile(Filename, std::string(gSample, gSampleSize) + "a longer overlay");
+    {
+        win32pe::MetadataCache cache;
+        BOOST_TEST(cache.open(CacheFilename));
+
+        win32pe::File file;
+        BOOST_TEST(!cache.lookup(Filename, file));
+        BOOST_TEST(!cache.insert(Filename, original));
+
+        // The stale entry is dropped when unused entries are pruned
+        BOOST_TEST(cache.save(true));
+        BOOST_TEST(cache.size() == 0);
+    }
+
+    std::remove(CacheFilename);
+    std::remove(Filename);
+}
+
+BOOST_AUTO_TEST_CASE(test_rewritten)
+{
+    std::remove(CacheFilename);
+    std::string data(gSample, gSampleSize);
+    writeFile(Filename, data);
+
+    win32pe::File original;
+    BOOST_REQUIRE(original.load(std::string(Filename)));
+
+    // A file loaded from memory has no identity to check
+    win32pe::File memory;
+    BOOST_REQUIRE(memory.load(data.data(), data.size()));
+    win32pe::MetadataCache cache;
+    BOOST_TEST(cache.open(CacheFilename));
+    BOOST_TEST(!cache.insert(Filename, memory));
+
+    // Replacing the file with one of the same size after it was loaded
+    // still prevents the stale metadata from being cached (the replacement
+    // is written alongside first so that it cannot reuse the inode, since
+    // the modification time may not have advanced)
+    std::string replacement = std::string(Filename) + ".new";
+    data[TimeDateStampOffset] ^= 1;
+    writeFile(replacement, data);
+    BOOST_REQUIRE(!std::rename(replacement.c_str(), Filename));
+    BOOST_TEST(!cache.insert(Filename, original));
+    BOOST_TEST(cache.errorString() == "file has changed since it was loaded");
+
+    std::remove(Filename);
+}
+
+BOOST_AUTO_TEST_CASE(test_corrupt)
+{
+    {
+        std::ofstream ofstream(CacheFilename, std::ios::binary);
+        ofstream << "W32PEMC3\xff\xff\xff\xff";
+    }
+
+    win32pe::MetadataCache cache;
+    BOOST_TEST(cache.open(CacheFilename));
+    BOOST_TEST(cache.size() == 0);
+
+    std::remove(CacheFilename);
+}
+
+BOOST_AUTO_TEST_CASE(test_exports)
+{
+    std::remove(CacheFilename);
+    writeFile(Filename, makeDll("USER32.dll", "MessageBoxA", "KERNEL32.MessageBoxW"));
+
+    win32pe::File original;
+    BOOST_REQUIRE(original.load(std::string(Filename)));
+    BOOST_REQUIRE(original.exports().size() == 1);
+
+    win32pe::MetadataCache cache;
+    BOOST_TEST(cache.open(CacheFilename));
+    BOOST_TEST(cache.insert(Filename, original));
+    BOOST_TEST(cache.save());
+
+    // Digests from an earlier load do not survive the restore
+    win32pe::File file;
+    file.setDigestAlgorithms(win32pe::Digests::SHA256);
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+    BOOST_REQUIRE(!file.fileDigests().sha256.empty());
+    BOOST_TEST(cache.lookup(Filename, file));
+    checkRestored(original, file);
+    BOOST_TEST(file.fileDigests().sha256.empty());
+    BOOST_TEST(file.sectionDigests(0).sha256.empty());
+
+    std::remove(CacheFilename);
+    std::remove(Filename);
+}
@@ -0,0 +1,136 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE overlay
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include <win32pe/file.h>
+
+#include "sample.h"
+
+namespace
+{
+
+std::string sampleWithOverlay(size_t size)
+{
+    std::string data(gSample, gSampleSize);
+    for (size_t i = 0; i < size; ++i) {
+        data.append(1, static_cast<char>(i));
+    }
+    return data;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_none)
+{
+    win32pe::File file;
+    BOOST_TEST(file.load(gSample, gSampleSize));
+    BOOST_TEST(file.fileSize() == gSampleSize);
+    BOOST_TEST(file.overlayOffset() == gSampleSize);
+    BOOST_TEST(file.overlaySize() == 0);
+    BOOST_TEST(file.overlay().empty());
+    BOOST_TEST(!file.overlayOverlapsCertificateTable());
+}
+
+BOOST_AUTO_TEST_CASE(test_memory)
+{
+    std::string data = sampleWithOverlay(1000);
+
+    win32pe::File file;
+    BOOST_TEST(file.load(data.data(), data.size()));
+    BOOST_TEST(file.overlayOffset() == gSampleSize);
+    BOOST_TEST(file.overlaySize() == 1000);
+
+    // The view refers to the File's own copy of the buffer
+    BOOST_TEST(file.overlay() == data.substr(gSampleSize));
+    BOOST_TEST(static_cast<const void*>(file.overlay().data()) !=
+               static_cast<const void*>(data.data() + gSampleSize));
+
+    std::string chunks;
+    BOOST_TEST(file.readOverlay([&chunks](uint64_t offset, boost::string_ref chunk) {
+        BOOST_TEST(offset == gSampleSize + chunks.size());
+        BOOST_TEST(chunk.size() <= 300);
+        chunks.append(chunk.data(), chunk.size());
+        return true;
+    }, 300));
+    BOOST_TEST(chunks == data.substr(gSampleSize));
+}
+
+BOOST_AUTO_TEST_CASE(test_stream)
+{
+    std::stringstream stringstream(sampleWithOverlay(1000));
+
+    win32pe::File file;
+    BOOST_TEST(file.load(stringstream));
+    BOOST_TEST(file.overlaySize() == 1000);
+    BOOST_TEST(file.overlay().empty());
+    BOOST_TEST(!file.readOverlay([](uint64_t, boost::string_ref) { return true; }));
+
+    std::string chunks;
+    BOOST_TEST(file.readOverlay(stringstream, [&chunks](uint64_t, boost::string_ref chunk) {
+        chunks.append(chunk.data(), chunk.size());
+        return true;
+    }, 256));
+    BOOST_TEST(chunks == stringstream.str().substr(gSampleSize));
+}
+
+BOOST_AUTO_TEST_CASE(test_certificate)
+{
+    // Point the certificate table at the start of the overlay
+    std::string data = sampleWithOverlay(16);
+    uint32_t entry[] = {static_cast<uint32_t>(gSampleSize), 16};
+    data.replace(CertificateTableOffset, sizeof(entry), reinterpret_cast<char*>(entry), sizeof(entry));
+
+    win32pe::File file;
+    BOOST_TEST(file.load(data.data(), data.size()));
+    BOOST_TEST(file.overlayOverlapsCertificateTable());
+}
+
+BOOST_AUTO_TEST_CASE(test_map)
+{
+    const char *filename = "test_overlay.bin";
+    std::string data = sampleWithOverlay(100);
+    writeFile(filename, data);
+
+    win32pe::File file;
+    BOOST_TEST(file.map(filename));
+    BOOST_TEST(file.overlay() == data.substr(gSampleSize));
+
+    // The mapping must outlive the original object
+    win32pe::File copy(file);
+    file = win32pe::File();
+    BOOST_TEST(copy.overlay() == data.substr(gSampleSize));
+
+    BOOST_TEST(!file.map("nonexistent.bin"));
+    BOOST_TEST(file.errorString() == "unable to map file");
+
+    std::remove(filename);
+}
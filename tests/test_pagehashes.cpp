@@ -0,0 +1,148 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE pagehashes
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <win32pe/digests.h>
+#include <win32pe/pagehashes.h>
+
+#include "sample.h"
+
+namespace
+{
+
+// The sample with .idata extended by a full page, giving five pages in all
+// (so that the tree has a node without a sibling)
+std::string sample()
+{
+    std::string data(gSample, gSampleSize);
+    for (int i = 0; i < 0x1000; ++i) {
+        data.push_back(static_cast<char>((i * 13) % 256));
+    }
+    patch<uint32_t>(data, IDataSizeOfRawDataOffset, 0x1200);
+    return data;
+}
+
+std::string hex(const std::string &digest)
+{
+    return win32pe::Digests::toHex(digest);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_compute)
+{
+    std::string data = sample();
+
+    win32pe::PageHashes hashes;
+    hashes.setThreadCount(3);
+    BOOST_REQUIRE(hashes.compute(data.data(), data.size()));
+    BOOST_REQUIRE(hashes.pageCount() == 5);
+    BOOST_TEST(hashes.pageOffset(0) == 0);
+    BOOST_TEST(hashes.pageOffset(1) == 0x200);
+    BOOST_TEST(hashes.pageOffset(3) == 0x600);
+    BOOST_TEST(hashes.pageOffset(4) == 0x1600);
+    BOOST_TEST(hex(hashes.pageHash(0)) == "13e9deedbb801e305b5423365d1704c81f6847712622df5012acd1c53ea43b04");
+    BOOST_TEST(hex(hashes.pageHash(1)) == "e6bb7b90ae9c851d8f9e856933ef4aa9716608d9f45e2a34ec7f84129e554761");
+    BOOST_TEST(hex(hashes.rootHash()) == "499c527a505d08c98b49b5b36d3f93de5327631c0719e646f774924c57bd8599");
+
+    // Offsets and hashes, terminated by the end of the last section
+    std::string table = hashes.authenticodeTable();
+    BOOST_REQUIRE(table.size() == 6 * 36);
+    uint32_t end;
+    memcpy(&end, &table[5 * 36], sizeof(end));
+    BOOST_TEST(end == 0x1800);
+    BOOST_TEST(table.substr(5 * 36 + 4) == std::string(32, '\0'));
+
+    // Signing changes neither the header page nor the root
+    std::string root = hashes.rootHash();
+    data[CheckSumOffset] = '\x12';
+    data[CertificateTableOffset] = '\x34';
+    BOOST_REQUIRE(hashes.compute(data.data(), data.size()));
+    BOOST_TEST(hashes.rootHash() == root);
+
+    win32pe::PageHashes sha1;
+    sha1.setAlgorithm(win32pe::PageHashes::SHA1);
+    BOOST_REQUIRE(sha1.compute(data.data(), data.size()));
+    BOOST_TEST(sha1.pageHash(0).size() == 20);
+    BOOST_TEST(sha1.authenticodeTable().size() == 6 * 24);
+}
+
+BOOST_AUTO_TEST_CASE(test_update)
+{
+    std::string data = sample();
+
+    win32pe::PageHashes hashes;
+    BOOST_REQUIRE(hashes.compute(data.data(), data.size()));
+    std::string page3 = hashes.pageHash(3);
+
+    data[0x1610] ^= '\xff';
+    BOOST_REQUIRE(hashes.update(data.data(), data.size(), 0x1610, 1));
+    BOOST_TEST(hashes.pageHash(3) == page3);
+    BOOST_TEST(hex(hashes.rootHash()) == "c600ba1e7ffbe2ea38a3f0c9fe3de21e4b73ea0e4870e1049970e92dcdc4a789");
+
+    win32pe::PageHashes fresh;
+    BOOST_REQUIRE(fresh.compute(data.data(), data.size()));
+    BOOST_TEST(fresh.save() == hashes.save());
+
+    // Moving a page falls back to hashing everything
+    std::string shorter = sample();
+    uint32_t size = 0x600;
+    memcpy(&shorter[IDataSizeOfRawDataOffset], &size, sizeof(size));
+    BOOST_REQUIRE(hashes.update(shorter.data(), shorter.size(), IDataSizeOfRawDataOffset, sizeof(size)));
+    BOOST_TEST(hashes.pageCount() == 4);
+    BOOST_REQUIRE(fresh.compute(shorter.data(), shorter.size()));
+    BOOST_TEST(hashes.rootHash() == fresh.rootHash());
+}
+
+BOOST_AUTO_TEST_CASE(test_save)
+{
+    std::string data = sample();
+
+    win32pe::PageHashes hashes;
+    BOOST_REQUIRE(hashes.compute(data.data(), data.size()));
+    std::string saved = hashes.save();
+
+    win32pe::PageHashes loaded;
+    BOOST_REQUIRE(loaded.load(saved));
+    BOOST_TEST(loaded.pageCount() == hashes.pageCount());
+    BOOST_TEST(loaded.rootHash() == hashes.rootHash());
+    BOOST_TEST(loaded.authenticodeTable() == hashes.authenticodeTable());
+
+    // A loaded tree can be updated incrementally
+    data[0x210] ^= '\xff';
+    BOOST_REQUIRE(loaded.update(data.data(), data.size(), 0x210, 1));
+    BOOST_REQUIRE(hashes.compute(data.data(), data.size()));
+    BOOST_TEST(loaded.rootHash() == hashes.rootHash());
+
+    BOOST_TEST(!loaded.load(saved.substr(0, saved.size() - 1)));
+    BOOST_TEST(!loaded.load("W32PEPH1"));
+    BOOST_TEST(!loaded.errorString().empty());
+}
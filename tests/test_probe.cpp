@@ -0,0 +1,95 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE probe
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include <win32pe/file.h>
+#include <win32pe/fileheader.h>
+#include <win32pe/optionalheader.h>
+#include <win32pe/probe.h>
+
+#include "sample.h"
+
+namespace
+{
+
+win32pe::Probe probe(const std::string &data)
+{
+    return win32pe::Probe::probe(data.data(), data.size());
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_pe)
+{
+    win32pe::File file;
+    BOOST_TEST(file.load(gSample, gSampleSize));
+
+    win32pe::Probe result = win32pe::Probe::probe(gSample, gSampleSize);
+    BOOST_TEST(result.format() == win32pe::Probe::PE32Plus);
+    BOOST_TEST(result.isPE());
+    BOOST_TEST(!result.isDotNet());
+    BOOST_TEST(result.headerOffset() == PEHeaderOffset);
+    BOOST_TEST(result.machine() == win32pe::FileHeader::amd64);
+    BOOST_TEST(result.subsystem() == file.optionalHeader().subsystem());
+
+    std::istringstream istream(std::string(gSample, gSampleSize));
+    BOOST_TEST(win32pe::Probe::probe(istream).format() == win32pe::Probe::PE32Plus);
+}
+
+BOOST_AUTO_TEST_CASE(test_dotnet)
+{
+    uint32_t clrHeader[] = {0x2000, 0x48};
+    win32pe::Probe result = probe(patched(CLRHeaderOffset, reinterpret_cast<char*>(clrHeader),
+                                          sizeof(clrHeader)));
+    BOOST_TEST(result.format() == win32pe::Probe::PE32Plus);
+    BOOST_TEST(result.isDotNet());
+}
+
+BOOST_AUTO_TEST_CASE(test_other)
+{
+    BOOST_TEST(probe("").format() == win32pe::Probe::NotMZ);
+    BOOST_TEST(probe("\x7f" "ELF").format() == win32pe::Probe::NotMZ);
+
+    // An MZ signature with nothing following it
+    BOOST_TEST(probe("MZ").format() == win32pe::Probe::Truncated);
+    BOOST_TEST(probe(std::string(gSample, PEHeaderOffset + 8)).format() == win32pe::Probe::Truncated);
+
+    uint32_t zero = 0;
+    BOOST_TEST(probe(patched(PEOffsetOffset, reinterpret_cast<char*>(&zero), sizeof(zero))).format() ==
+               win32pe::Probe::DOS);
+    BOOST_TEST(probe(patched(PEHeaderOffset, "XX", 2)).format() == win32pe::Probe::DOS);
+
+    win32pe::Probe result = probe(patched(PEHeaderOffset, "NE", 2));
+    BOOST_TEST(result.format() == win32pe::Probe::NE);
+    BOOST_TEST(result.headerOffset() == PEHeaderOffset);
+    BOOST_TEST(probe(patched(PEHeaderOffset, "LE", 2)).format() == win32pe::Probe::LE);
+    BOOST_TEST(probe(patched(PEHeaderOffset, "LX", 2)).format() == win32pe::Probe::LE);
+}
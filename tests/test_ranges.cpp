@@ -0,0 +1,103 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE ranges
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <string>
+
+#include <win32pe/file.h>
+#include <win32pe/ranges.h>
+
+#include "sample.h"
+
+BOOST_AUTO_TEST_CASE(test_section_refs)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+
+    size_t count = 0;
+    for (win32pe::SectionRef section : file.sectionRefs()) {
+        BOOST_TEST(section.name() == file.section(count).name());
+        ++count;
+    }
+    BOOST_TEST(count == file.sectionCount());
+}
+
+BOOST_AUTO_TEST_CASE(test_import_descriptors)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+
+    size_t count = 0;
+    for (const win32pe::ImportTable::Item &item : file.importDescriptors()) {
+        BOOST_TEST(item.firstThunk == file.importTable().items().at(count).firstThunk);
+        BOOST_TEST(file.string(item.name) == "USER32.dll");
+        ++count;
+    }
+    BOOST_TEST(count == file.importTable().items().size());
+
+    // Reloading must not accumulate items
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+    BOOST_TEST(file.importTable().items().size() == count);
+}
+
+BOOST_AUTO_TEST_CASE(test_imported_function_refs)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+
+    win32pe::Range<win32pe::ImportDescriptorIterator> descriptors = file.importDescriptors();
+    BOOST_REQUIRE(!descriptors.empty());
+
+    win32pe::Range<win32pe::ImportFunctionIterator> functions =
+        file.importedFunctionRefs(*descriptors.begin());
+    win32pe::ImportFunctionIterator it = functions.begin();
+    BOOST_REQUIRE(!functions.empty());
+    BOOST_TEST(!it->byOrdinal);
+    BOOST_TEST(it->hint == 0x1ec);
+    BOOST_TEST(it->name == "MessageBoxA");
+    BOOST_TEST((++it == functions.end()));
+}
+
+BOOST_AUTO_TEST_CASE(test_early_exit)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+
+    // Find out whether a function is imported, stopping at the first match
+    auto imports = [&file](const std::string &name) {
+        for (const win32pe::ImportTable::Item &item : file.importDescriptors()) {
+            for (const win32pe::ImportTable::FunctionRef &function : file.importedFunctionRefs(item)) {
+                if (function.name == name) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+    BOOST_TEST(imports("MessageBoxA"));
+    BOOST_TEST(!imports("VirtualAllocEx"));
+}
@@ -0,0 +1,124 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE save
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#ifndef _WIN32
+#  include <sys/stat.h>
+#endif
+
+#include <win32pe/file.h>
+#include <win32pe/section.h>
+
+#include "sample.h"
+
+BOOST_AUTO_TEST_CASE(test_round_trip)
+{
+    // Saving an unmodified file must reproduce it exactly
+    win32pe::File file;
+    std::stringstream stringstream(std::string(gSample, gSampleSize));
+    BOOST_TEST(file.load(stringstream));
+
+    std::ostringstream ostringstream;
+    BOOST_TEST(file.save(ostringstream));
+    BOOST_TEST(ostringstream.str() == std::string(gSample, gSampleSize));
+}
+
+BOOST_AUTO_TEST_CASE(test_overlay)
+{
+    std::string data(gSample, gSampleSize);
+    data.append("overlay data");
+
+    // The overlay is kept when the file was loaded from memory...
+    win32pe::File file;
+    BOOST_TEST(file.load(data.data(), data.size()));
+    std::ostringstream withOverlay;
+    BOOST_TEST(file.save(withOverlay));
+    BOOST_TEST(withOverlay.str() == data);
+
+    // ...but is not available when it was loaded from a stream, so saving
+    // fails rather than losing it
+    std::stringstream stringstream(data);
+    BOOST_TEST(file.load(stringstream));
+    std::ostringstream withoutOverlay;
+    BOOST_TEST(!file.save(withoutOverlay));
+    BOOST_TEST(file.errorString() == "overlay is not in memory");
+}
+
+BOOST_AUTO_TEST_CASE(test_save_mapped)
+{
+    const char *filename = "test_save.bin";
+    std::string data(gSample, gSampleSize);
+    data.append(5000, '\x42');
+    writeFile(filename, data);
+
+    // Save over the file that is currently mapped
+    win32pe::File file;
+    BOOST_TEST(file.map(filename));
+    BOOST_TEST(file.save(filename));
+    BOOST_TEST(readFile(filename) == data);
+
+    win32pe::File saved;
+    BOOST_TEST(saved.map(filename));
+    BOOST_TEST(saved.sections().size() == 3);
+    BOOST_TEST(saved.overlaySize() == 5000);
+
+    std::remove(filename);
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(test_save_mode)
+{
+    // The replacement keeps the permissions of the file it replaces
+    const char *filename = "test_save_mode.bin";
+    std::string data(gSample, gSampleSize);
+    writeFile(filename, data);
+    BOOST_REQUIRE(!::chmod(filename, 0640));
+
+    win32pe::File file;
+    BOOST_TEST(file.load(data.data(), data.size()));
+    BOOST_TEST(file.save(filename));
+    BOOST_TEST(readFile(filename) == data);
+
+    struct stat st;
+    BOOST_REQUIRE(!::stat(filename, &st));
+    BOOST_TEST((st.st_mode & 07777) == 0640u);
+
+    std::remove(filename);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(test_not_loaded)
+{
+    win32pe::File file;
+    std::ostringstream ostringstream;
+    BOOST_TEST(!file.save(ostringstream));
+    BOOST_TEST(!file.errorString().empty());
+}
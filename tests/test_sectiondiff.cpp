@@ -0,0 +1,209 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE sectiondiff
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <win32pe/file.h>
+#include <win32pe/sectiondiff.h>
+#include <win32pe/sectionref.h>
+
+#include "sample.h"
+
+namespace
+{
+
+// Pseudo-random data appended to .idata after the import table
+const size_t DataOffset = 0x800;
+const uint32_t DataRVA = 0x3200;
+const size_t DataSize = 0x1000;
+
+std::string sample()
+{
+    std::string data(gSample, gSampleSize);
+    uint32_t state = 1;
+    for (size_t i = 0; i < DataSize; ++i) {
+        state = state * 1103515245 + 12345;
+        data.push_back(static_cast<char>(state >> 16));
+    }
+    patch<uint32_t>(data, SizeOfImageOffset, 0x5000);
+    patch<uint32_t>(data, IDataVirtualSizeOffset, 0x1200);
+    patch<uint32_t>(data, IDataSizeOfRawDataOffset, 0x1200);
+    return data;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_chunks)
+{
+    std::string data = sample();
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(data.data(), data.size()));
+
+    win32pe::SectionDiff diff;
+    diff.setAverageChunkSize(100);
+    BOOST_TEST(diff.averageChunkSize() == 64);
+    diff.setAverageChunkSize(0);
+    BOOST_TEST(diff.averageChunkSize() == 64);
+
+    std::vector<win32pe::SectionDiff::Chunk> chunks = diff.chunks(file.section(2));
+    BOOST_REQUIRE(chunks.size() > 1);
+    uint32_t rva = 0x3000;
+    for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+        BOOST_TEST((*it).rva == rva);
+        BOOST_TEST((*it).size <= 256);
+        rva += (*it).size;
+    }
+    BOOST_TEST(rva == 0x4200);
+
+    // Boundaries depend on content, so they resynchronize after an insertion
+    std::string shifted = sample();
+    shifted.insert(DataOffset + 0x100, 40, '\x5a');
+    shifted.resize(data.size());
+    BOOST_REQUIRE(file.load(shifted.data(), shifted.size()));
+    std::set<uint64_t> hashes;
+    for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+        hashes.insert((*it).hash);
+    }
+    size_t shared = 0;
+    std::vector<win32pe::SectionDiff::Chunk> shiftedChunks = diff.chunks(file.section(2));
+    for (auto it = shiftedChunks.begin(); it != shiftedChunks.end(); ++it) {
+        shared += hashes.count((*it).hash);
+    }
+    BOOST_TEST(shared * 4 >= shiftedChunks.size() * 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_diff)
+{
+    std::string oldData = sample();
+    std::string newData = sample();
+    newData.insert(DataOffset + 0x400, 40, '\x5a');
+    newData.resize(oldData.size());
+
+    win32pe::File oldFile, newFile;
+    BOOST_REQUIRE(oldFile.load(oldData.data(), oldData.size()));
+    BOOST_REQUIRE(newFile.load(newData.data(), newData.size()));
+
+    win32pe::SectionDiff diff;
+    diff.setAverageChunkSize(64);
+    diff.setThreadCount(2);
+    BOOST_REQUIRE(diff.diff(oldFile, oldFile));
+    BOOST_TEST(diff.changes().empty());
+
+    BOOST_REQUIRE(diff.diff(oldFile, newFile));
+    const std::vector<win32pe::SectionDiff::Change> &changes = diff.changes();
+    BOOST_REQUIRE(!changes.empty());
+    bool inserted = false, moved = false, deleted = false;
+    for (auto it = changes.begin(); it != changes.end(); ++it) {
+        BOOST_TEST((*it).section == ".idata");
+        switch ((*it).kind) {
+        case win32pe::SectionDiff::Inserted:
+            // The inserted bytes are covered, along with the rest of the
+            // chunks they landed in
+            if ((*it).newRva <= DataRVA + 0x400 && (*it).newRva + (*it).size >= DataRVA + 0x428) {
+                inserted = true;
+            }
+            break;
+        case win32pe::SectionDiff::Moved:
+            BOOST_TEST((*it).newRva - (*it).oldRva == 40u);
+            moved = true;
+            break;
+        case win32pe::SectionDiff::Deleted:
+            // Including the bytes pushed off the end of the section
+            if ((*it).oldRva + (*it).size == 0x4200) {
+                deleted = true;
+            }
+            break;
+        }
+    }
+    BOOST_TEST(inserted);
+    BOOST_TEST(moved);
+    BOOST_TEST(deleted);
+}
+
+BOOST_AUTO_TEST_CASE(test_pairing)
+{
+    std::string oldData = sample();
+    std::string newData = sample();
+    memcpy(&newData[RDataNameOffset], ".rdat2", 6);
+
+    win32pe::File oldFile, newFile;
+    BOOST_REQUIRE(oldFile.load(oldData.data(), oldData.size()));
+    BOOST_REQUIRE(newFile.load(newData.data(), newData.size()));
+
+    win32pe::SectionDiff diff;
+    BOOST_REQUIRE(diff.diff(oldFile, newFile));
+    const std::vector<win32pe::SectionDiff::Change> &changes = diff.changes();
+    BOOST_REQUIRE(changes.size() == 2);
+    BOOST_TEST(changes.at(0).kind == win32pe::SectionDiff::Inserted);
+    BOOST_TEST(changes.at(0).section == ".rdat2");
+    BOOST_TEST(changes.at(0).newRva == 0x2000);
+    BOOST_TEST(changes.at(0).size == 0x10);
+    BOOST_TEST(changes.at(1).kind == win32pe::SectionDiff::Deleted);
+    BOOST_TEST(changes.at(1).section == ".rdata");
+    BOOST_TEST(changes.at(1).oldRva == 0x2000);
+
+    BOOST_TEST(!diff.diff(win32pe::File(), win32pe::File()));
+    BOOST_TEST(!diff.errorString().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_padding)
+{
+    // A long run of zeros splits into many chunks sharing a single hash
+    const uint32_t PaddingSize = 0x400000;
+    std::string oldData(gSample, gSampleSize);
+    oldData.append(PaddingSize, '\0');
+    patch<uint32_t>(oldData, SizeOfImageOffset, 0x4000 + PaddingSize);
+    patch<uint32_t>(oldData, IDataVirtualSizeOffset, 0x200 + PaddingSize);
+    patch<uint32_t>(oldData, IDataSizeOfRawDataOffset, 0x200 + PaddingSize);
+    std::string newData = oldData;
+    newData[DataOffset + PaddingSize / 2] = 1;
+
+    win32pe::File oldFile, newFile;
+    BOOST_REQUIRE(oldFile.load(oldData.data(), oldData.size()));
+    BOOST_REQUIRE(newFile.load(newData.data(), newData.size()));
+
+    win32pe::SectionDiff diff;
+    diff.setAverageChunkSize(64);
+    BOOST_REQUIRE(diff.diff(oldFile, oldFile));
+    BOOST_TEST(diff.changes().empty());
+
+    BOOST_REQUIRE(diff.diff(oldFile, newFile));
+    const std::vector<win32pe::SectionDiff::Change> &changes = diff.changes();
+    BOOST_REQUIRE(!changes.empty());
+    uint32_t changed = 0;
+    for (auto it = changes.begin(); it != changes.end(); ++it) {
+        if ((*it).kind != win32pe::SectionDiff::Moved) {
+            changed += (*it).size;
+        }
+    }
+    BOOST_TEST(changed < PaddingSize / 16);
+}
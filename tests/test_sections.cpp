@@ -0,0 +1,119 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE sections
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <sstream>
+#include <string>
+
+#include <win32pe/file.h>
+#include <win32pe/section.h>
+#include <win32pe/sectionref.h>
+
+#include "sample.h"
+
+BOOST_AUTO_TEST_CASE(test_refs)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+    BOOST_REQUIRE(file.sectionCount() == 3);
+
+    // References agree with the copies
+    const std::vector<win32pe::Section> &sections = file.sections();
+    for (size_t i = 0; i < file.sectionCount(); ++i) {
+        win32pe::SectionRef ref = file.section(i);
+        BOOST_TEST(ref.name() == sections[i].name());
+        BOOST_TEST(ref.virtualAddress() == sections[i].virtualAddress());
+        BOOST_TEST(ref.virtualSize() == sections[i].virtualSize());
+        BOOST_TEST(ref.pointerToRawData() == sections[i].pointerToRawData());
+        BOOST_TEST(ref.sizeOfRawData() == sections[i].sizeOfRawData());
+        BOOST_TEST(ref.characteristics() == sections[i].characteristics());
+        BOOST_TEST(ref.data() == sections[i].data());
+    }
+
+    // Data loaded from memory is copied rather than referred to in place
+    BOOST_TEST(file.section(0).data() == std::string(gSample + file.section(0).pointerToRawData(), 0x200));
+    BOOST_TEST(static_cast<const void*>(file.section(0).data().data()) !=
+               static_cast<const void*>(gSample + file.section(0).pointerToRawData()));
+
+    BOOST_TEST(file.rvaToSectionRef(0x2008).name() == ".rdata");
+    BOOST_TEST(file.rvaToSectionRef(0x2008).rvaToOffset(0x2008) == 8);
+    BOOST_TEST(file.rvaToSectionRef(0x10).isNull());
+}
+
+BOOST_AUTO_TEST_CASE(test_stream)
+{
+    // Data read from a stream is copied into one buffer shared by the sections
+    win32pe::File file;
+    std::istringstream istream(std::string(gSample, gSampleSize));
+    BOOST_REQUIRE(file.load(istream));
+    BOOST_TEST(file.section(1).data().data() ==
+               file.section(0).data().data() + file.section(0).data().size());
+    BOOST_TEST(file.section(2).data() == std::string(gSample + 0x600, 0x200));
+}
+
+BOOST_AUTO_TEST_CASE(test_modify)
+{
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(gSample, gSampleSize));
+    BOOST_REQUIRE(file.sections().size() == 3);
+
+    // Copies are rebuilt once the table changes
+    BOOST_REQUIRE(file.addSection(".new", win32pe::Section::ContainsInitializedData, "data"));
+    BOOST_TEST(file.sectionCount() == 4);
+    BOOST_REQUIRE(file.sections().size() == 4);
+    BOOST_TEST(file.sections().at(3).name() == ".new");
+    BOOST_TEST(file.section(3).data().substr(0, 4) == "data");
+    BOOST_TEST(file.section(0).data() == std::string(gSample + 0x200, 0x200));
+
+    BOOST_REQUIRE(file.removeSection(1));
+    BOOST_TEST(file.sections().size() == 3);
+    BOOST_TEST(file.section(1).name() == ".idata");
+}
+
+BOOST_AUTO_TEST_CASE(test_modify_in_place)
+{
+    // Only the modified section is copied; the rest stay where they were
+    // loaded
+    win32pe::File file;
+    std::istringstream istream(std::string(gSample, gSampleSize));
+    BOOST_REQUIRE(file.load(istream));
+    const char *rdata = file.section(1).data().data();
+    const char *idata = file.section(2).data().data();
+
+    BOOST_REQUIRE(file.setSectionData(0, "code"));
+    BOOST_TEST(file.section(0).data().substr(0, 4) == "code");
+    BOOST_TEST(file.section(1).data().data() == rdata);
+    BOOST_TEST(file.section(2).data().data() == idata);
+
+    BOOST_REQUIRE(file.resizeSection(1, 0x400));
+    BOOST_TEST(file.section(1).data().size() == 0x400);
+    BOOST_TEST(file.section(1).data().substr(0, 0x200) == std::string(gSample + 0x400, 0x200));
+    BOOST_TEST(file.section(2).data().data() == idata);
+
+    BOOST_REQUIRE(file.removeSection(0));
+    BOOST_TEST(file.section(1).data().data() == idata);
+}
@@ -0,0 +1,170 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE strings
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <win32pe/file.h>
+#include <win32pe/section.h>
+#include <win32pe/sectionref.h>
+#include <win32pe/stringscanner.h>
+
+#include "sample.h"
+
+namespace
+{
+
+bool isPrintable(unsigned char c)
+{
+    return (c >= 0x20 && c <= 0x7e) || c == '\t';
+}
+
+// Straightforward implementation used to check the vectorized scanner
+
+std::vector<std::string> reference(const std::string &data, size_t minimumLength)
+{
+    std::vector<std::string> strings;
+
+    for (size_t i = 0; i < data.size();) {
+        size_t j = i;
+        while (j < data.size() && isPrintable(data[j])) {
+            ++j;
+        }
+        if (j - i >= minimumLength) {
+            strings.push_back(data.substr(i, j - i));
+        }
+        i = j == i ? i + 1 : j;
+    }
+
+    for (size_t phase = 0; phase < 2; ++phase) {
+        for (size_t i = phase; i + 1 < data.size();) {
+            size_t j = i;
+            while (j + 1 < data.size() && isPrintable(data[j]) && !data[j + 1]) {
+                j += 2;
+            }
+            if ((j - i) / 2 >= minimumLength) {
+                strings.push_back(data.substr(i, j - i));
+            }
+            i = j == i ? i + 2 : j;
+        }
+    }
+
+    return strings;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_section)
+{
+    win32pe::File file;
+    std::stringstream stringstream(std::string(gSample, gSampleSize));
+    BOOST_TEST(file.load(stringstream));
+
+    // The .idata section contains the imported function and DLL names
+    const win32pe::Section &section = file.sections().at(2);
+    BOOST_TEST(section.name() == ".idata");
+
+    win32pe::StringScanner scanner;
+    scanner.setEncodings(win32pe::StringScanner::ASCII);
+    std::vector<win32pe::StringScanner::Item> items = scanner.scan(section);
+    BOOST_TEST(items.size() == 2);
+    BOOST_TEST(items.at(0).value == "MessageBoxA");
+    BOOST_TEST(items.at(0).offset == 0x64a);
+    BOOST_TEST(items.at(0).rva == 0x304a);
+    BOOST_TEST(items.at(1).value == "USER32.dll");
+    BOOST_TEST(file.string(items.at(1).rva) == "USER32.dll");
+
+    // Scanning through a reference reports the same strings without a copy
+    win32pe::SectionRef ref = file.section(2);
+    std::vector<win32pe::StringScanner::Item> refItems = scanner.scan(ref);
+    BOOST_REQUIRE(refItems.size() == items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        BOOST_TEST(refItems.at(i).value == items.at(i).value);
+        BOOST_TEST(refItems.at(i).offset == items.at(i).offset);
+        BOOST_TEST(refItems.at(i).rva == items.at(i).rva);
+    }
+    BOOST_TEST(static_cast<size_t>(refItems.at(0).value.data() - ref.data().data()) == 0x4au);
+}
+
+BOOST_AUTO_TEST_CASE(test_utf16)
+{
+    // Place a string at an odd offset so that it straddles a block boundary
+    std::string data(61, '\xff');
+    const char wide[] = "w\0i\0d\0e\0";
+    data.append(wide, sizeof(wide) - 1);
+    data.append(3, '\xff');
+
+    win32pe::StringScanner scanner;
+    std::vector<win32pe::StringScanner::Item> items = scanner.scan(data.data(), data.size());
+    BOOST_TEST(items.size() == 1);
+    BOOST_TEST(items.at(0).encoding == win32pe::StringScanner::UTF16LE);
+    BOOST_TEST(items.at(0).offset == 61);
+    BOOST_TEST(items.at(0).value.size() == 8);
+}
+
+BOOST_AUTO_TEST_CASE(test_stop)
+{
+    std::string data("first\0second\0third", 18);
+
+    win32pe::StringScanner scanner;
+    int count = 0;
+    BOOST_TEST(!scanner.scan(data.data(), data.size(), 0, [&count](const win32pe::StringScanner::Item &) {
+        return ++count < 2;
+    }));
+    BOOST_TEST(count == 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_reference)
+{
+    // Compare against the reference implementation using data biased towards
+    // printable characters and NUL bytes so that plenty of runs occur
+    std::srand(1);
+    std::string data;
+    for (int i = 0; i < 10000; ++i) {
+        int r = std::rand() % 8;
+        data.append(1, r < 4 ? static_cast<char>('a' + r) : r < 6 ? '\0' : r == 6 ? '\t' : '\x90');
+    }
+
+    for (size_t minimumLength = 1; minimumLength < 6; ++minimumLength) {
+        win32pe::StringScanner scanner;
+        scanner.setMinimumLength(minimumLength);
+
+        std::vector<std::string> expected = reference(data, minimumLength);
+        std::vector<std::string> actual;
+        for (auto &item : scanner.scan(data.data(), data.size())) {
+            actual.push_back(item.value.to_string());
+        }
+
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        BOOST_TEST(actual == expected, boost::test_tools::per_element());
+    }
+}
@@ -0,0 +1,200 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define BOOST_TEST_MODULE symbols
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <win32pe/file.h>
+#include <win32pe/symbolindex.h>
+#include <win32pe/symboltable.h>
+
+#include "sample.h"
+
+namespace
+{
+
+const char LongName[] = "a_very_long_symbol_name";
+
+void appendRecord(std::string &data, const char *name, uint32_t value,
+                  int16_t sectionNumber, uint8_t storageClass, uint8_t numberOfAuxSymbols)
+{
+    char record[win32pe::SymbolTable::RecordSize] = {};
+    strncpy(record, name, 8);
+    memcpy(record + 8, &value, sizeof(value));
+    memcpy(record + 12, &sectionNumber, sizeof(sectionNumber));
+    record[16] = static_cast<char>(storageClass);
+    record[17] = static_cast<char>(numberOfAuxSymbols);
+    data.append(record, sizeof(record));
+}
+
+// Append a symbol table to the sample with a file record (and auxiliary
+// record), three defined symbols (one with a long name) and an undefined one
+
+std::string sampleWithSymbols()
+{
+    std::string data(gSample, gSampleSize);
+
+    uint32_t header[] = {static_cast<uint32_t>(data.size()), 6};
+    data.replace(PointerToSymbolTableOffset, sizeof(header), reinterpret_cast<char*>(header), sizeof(header));
+
+    appendRecord(data, ".file", 0, win32pe::SymbolTable::Debug, win32pe::SymbolTable::FileName, 1);
+    data.append("test.c");
+    data.append(win32pe::SymbolTable::RecordSize - 6, '\0');
+    appendRecord(data, "main", 0x10, 1, win32pe::SymbolTable::External, 0);
+    appendRecord(data, "", 0x20, 1, win32pe::SymbolTable::Static, 0);
+    uint32_t longNameOffset = 4;
+    memcpy(&data[data.size() - win32pe::SymbolTable::RecordSize + 4], &longNameOffset, sizeof(longNameOffset));
+    appendRecord(data, "data", 0x8, 2, win32pe::SymbolTable::External, 0);
+    appendRecord(data, "undef", 0, win32pe::SymbolTable::Undefined, win32pe::SymbolTable::External, 0);
+
+    uint32_t stringTableSize = 4 + sizeof(LongName);
+    data.append(reinterpret_cast<char*>(&stringTableSize), sizeof(stringTableSize));
+    data.append(LongName, sizeof(LongName));
+
+    return data;
+}
+
+void checkSymbols(const win32pe::File &file)
+{
+    win32pe::SymbolTable symbolTable = file.symbolTable();
+    BOOST_TEST(symbolTable.size() == 6);
+
+    std::vector<std::string> names;
+    for (auto &symbol : symbolTable) {
+        names.push_back(symbol.name().to_string());
+    }
+    BOOST_TEST(names == std::vector<std::string>({".file", "main", LongName, "data", "undef"}),
+               boost::test_tools::per_element());
+
+    win32pe::SymbolTable::Symbol symbol = *symbolTable.begin();
+    BOOST_TEST(symbol.numberOfAuxSymbols() == 1);
+    BOOST_TEST(symbol.auxRecord(0).substr(0, 6) == "test.c");
+
+    win32pe::SymbolIndex index;
+    index.build(file);
+    BOOST_TEST(index.size() == 3);
+
+    uint32_t displacement;
+    BOOST_TEST(!index.lookup(0x1000, symbol, displacement));
+    BOOST_TEST(index.lookup(0x1015, symbol, displacement));
+    BOOST_TEST(symbol.name() == "main");
+    BOOST_TEST(displacement == 5);
+    BOOST_TEST(index.lookup(0x1020, symbol, displacement));
+    BOOST_TEST(symbol.name() == LongName);
+    BOOST_TEST(displacement == 0);
+    BOOST_TEST(index.lookup(0x3000, symbol, displacement));
+    BOOST_TEST(symbol.name() == "data");
+    BOOST_TEST(displacement == 0xff8);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_none)
+{
+    win32pe::File file;
+    BOOST_TEST(file.load(gSample, gSampleSize));
+    BOOST_TEST(file.symbolTable().empty());
+    BOOST_TEST((file.symbolTable().begin() == file.symbolTable().end()));
+}
+
+BOOST_AUTO_TEST_CASE(test_memory)
+{
+    std::string data = sampleWithSymbols();
+
+    win32pe::File file;
+    BOOST_TEST(file.load(data.data(), data.size()));
+    BOOST_TEST(file.symbolTable().strings() == data.substr(gSampleSize + 6 * 18));
+    checkSymbols(file);
+}
+
+BOOST_AUTO_TEST_CASE(test_stream)
+{
+    std::stringstream stringstream(sampleWithSymbols());
+
+    win32pe::File file;
+    BOOST_TEST(file.load(stringstream));
+    checkSymbols(file);
+}
+
+BOOST_AUTO_TEST_CASE(test_stream_save)
+{
+    // The symbol and string tables copied from a stream are written back
+    std::string data = sampleWithSymbols();
+    std::stringstream stringstream(data);
+
+    win32pe::File file;
+    BOOST_REQUIRE(file.load(stringstream));
+    std::ostringstream ostringstream;
+    BOOST_TEST(file.save(ostringstream));
+    BOOST_TEST(ostringstream.str() == data);
+}
+
+BOOST_AUTO_TEST_CASE(test_truncated)
+{
+    // A symbol table that extends past the end of the file is ignored
+    std::string data = sampleWithSymbols();
+    data.resize(gSampleSize + 2 * win32pe::SymbolTable::RecordSize);
+
+    win32pe::File file;
+    BOOST_TEST(file.load(data.data(), data.size()));
+    BOOST_TEST(file.symbolTable().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_object)
+{
+    // An object file is a bare file header followed by its sections, with
+    // the symbol table after them
+    std::string image = sampleWithSymbols();
+    std::string object(20, '\0');
+    uint16_t machine = 0x8664;
+    memcpy(&object[0], &machine, sizeof(machine));
+    uint32_t header[] = {static_cast<uint32_t>(object.size()), 6};
+    memcpy(&object[8], header, sizeof(header));
+    object.append(image.substr(gSampleSize));
+
+    win32pe::File file;
+    BOOST_TEST(!file.load(object.data(), object.size()));
+
+    win32pe::SymbolTable symbolTable;
+    BOOST_REQUIRE(win32pe::SymbolTable::fromObject(object, symbolTable));
+    BOOST_TEST(symbolTable.size() == 6);
+    BOOST_TEST(symbolTable.at(2).name() == "main");
+    BOOST_TEST(symbolTable.at(3).name() == LongName);
+    BOOST_TEST(symbolTable.strings() == object.substr(20 + 6 * 18));
+
+    // The symbols must lie within the data and import libraries are rejected
+    BOOST_TEST(!win32pe::SymbolTable::fromObject(object.substr(0, 20 + 18), symbolTable));
+    std::string anonymous(object);
+    anonymous[0] = anonymous[1] = '\0';
+    anonymous[2] = anonymous[3] = '\xff';
+    BOOST_TEST(!win32pe::SymbolTable::fromObject(anonymous, symbolTable));
+    BOOST_TEST(!win32pe::SymbolTable::fromObject(boost::string_ref(), symbolTable));
+}
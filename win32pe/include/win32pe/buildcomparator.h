@@ -0,0 +1,113 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_BUILDCOMPARATOR_H
+#define WIN32PE_BUILDCOMPARATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class File;
+
+class WIN32PE_EXPORT BuildComparatorPrivate;
+
+/**
+ * @brief Compare two builds of a PE file, ignoring non-deterministic data
+ *
+ * Both files are compared as mapped images (the headers followed by each
+ * section at its RVA) after normalizing the fields that differ between
+ * otherwise identical builds:
+ *
+ *  - TimeDateStamp and CheckSum in the headers
+ *  - the timestamp of each debug directory entry
+ *  - the GUID and age in CodeView (PDB) debug information
+ *  - the Rich header, which is decoded and has its counts cleared
+ *
+ * The images are compared a chunk at a time. Chunks that lie within a
+ * section's data and contain none of the fields above are compared in place,
+ * so files loaded from memory or memory-mapped are not copied. The overlay
+ * (including any signature) is not compared.
+ */
+class WIN32PE_EXPORT BuildComparator
+{
+public:
+
+    struct Difference
+    {
+        /// RVA of the first byte that differs
+        uint32_t rva;
+
+        /// number of consecutive bytes that differ
+        uint32_t size;
+    };
+
+    BuildComparator();
+    BuildComparator(const BuildComparator &other);
+    virtual ~BuildComparator();
+
+    BuildComparator &operator=(const BuildComparator &other);
+
+    /**
+     * @brief Set the number of bytes compared at a time
+     * @param size size of each chunk (default is 4096)
+     */
+    void setChunkSize(uint32_t size);
+    uint32_t chunkSize() const;
+
+    /**
+     * @brief Compare two files
+     * @param file first file
+     * @param other second file
+     * @return true if the files could be compared
+     *
+     * Use differences() to determine whether the files match.
+     */
+    bool compare(const File &file, const File &other);
+
+    /**
+     * @brief Retrieve the ranges that differ
+     * @return ranges ordered by RVA or an empty vector if the builds match
+     */
+    const std::vector<Difference> &differences() const;
+
+    /**
+     * @brief Retrieve a description of the last error
+     * @return description or empty string if no error has occurred
+     */
+    std::string errorString() const;
+
+private:
+
+    BuildComparatorPrivate *const d;
+};
+
+}
+
+#endif // WIN32PE_BUILDCOMPARATOR_H
@@ -0,0 +1,110 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_CORPUSQUERY_H
+#define WIN32PE_CORPUSQUERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class CorpusStore;
+
+class WIN32PE_EXPORT CorpusQueryPrivate;
+
+/**
+ * @brief Filter over the files in a CorpusStore
+ *
+ * Every condition that is set must match. Each condition is evaluated over
+ * an entire column at a time (using SSE2 where available) and the results
+ * are combined in a bitmap, so the cost depends on the number of conditions
+ * and not the number of matches.
+ *
+ * For example, amd64 DLLs without NXCompat built after a date:
+ *
+ *     query.setMachine(FileHeader::amd64);
+ *     query.requireCharacteristics(FileHeader::DLL);
+ *     query.excludeDllCharacteristics(OptionalHeader::NXCompat);
+ *     query.setTimeDateStampRange(date, 0xffffffff);
+ */
+class WIN32PE_EXPORT CorpusQuery
+{
+public:
+
+    CorpusQuery();
+    CorpusQuery(const CorpusQuery &other);
+    virtual ~CorpusQuery();
+
+    CorpusQuery &operator=(const CorpusQuery &other);
+
+    void setMachine(uint16_t machine);
+    void setSubsystem(uint16_t subsystem);
+
+    /**
+     * @brief Require (or exclude) all of the specified file characteristics
+     */
+    void requireCharacteristics(uint16_t flags);
+    void excludeCharacteristics(uint16_t flags);
+
+    /**
+     * @brief Require (or exclude) all of the specified DLL characteristics
+     */
+    void requireDllCharacteristics(uint16_t flags);
+    void excludeDllCharacteristics(uint16_t flags);
+
+    /**
+     * @brief Set inclusive bounds for a value
+     */
+    void setTimeDateStampRange(uint32_t min, uint32_t max);
+    void setSectionCountRange(uint16_t min, uint16_t max);
+    void setEntropyRange(float min, float max);
+    void setFileSizeRange(uint64_t min, uint64_t max);
+
+    void setImportHash(uint64_t hash);
+
+    /**
+     * @brief Find the matching files
+     * @param store store to search
+     * @return indices of the matching files in ascending order
+     */
+    std::vector<uint32_t> run(const CorpusStore &store) const;
+
+    /**
+     * @brief Count the matching files
+     */
+    size_t count(const CorpusStore &store) const;
+
+private:
+
+    CorpusQueryPrivate *const d;
+};
+
+}
+
+#endif // WIN32PE_CORPUSQUERY_H
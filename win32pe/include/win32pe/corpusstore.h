@@ -0,0 +1,142 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_CORPUSSTORE_H
+#define WIN32PE_CORPUSSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <boost/utility/string_ref.hpp>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class File;
+
+class WIN32PE_EXPORT CorpusStorePrivate;
+
+/**
+ * @brief Per-file metadata for a corpus, stored as columns
+ *
+ * Each field is kept in its own contiguous array (with one entry per file)
+ * so that CorpusQuery can filter millions of files by scanning only the
+ * columns it needs. The store is written to a single file which is
+ * memory-mapped when opened; adding files to an opened store copies its
+ * columns into memory first.
+ *
+ * Instances are not thread-safe, although any number of queries may run
+ * against a store concurrently once it is no longer being modified.
+ */
+class WIN32PE_EXPORT CorpusStore
+{
+public:
+
+    enum Column {
+        Machine,
+        Characteristics,
+        Subsystem,
+        DllCharacteristics,
+        TimeDateStamp,
+        NumberOfSections,
+
+        /// Shannon entropy (in bits per byte) of the section data
+        Entropy,
+
+        /// FNV-1a hash of the imported functions, each qualified by the
+        /// lower-case name of its DLL
+        ImportHash,
+
+        FileSize,
+
+        ColumnCount
+    };
+
+    CorpusStore();
+    virtual ~CorpusStore();
+
+    /**
+     * @brief Append a file to the store
+     * @param path path to identify the file by
+     * @param file loaded file
+     */
+    void add(const std::string &path, const File &file);
+
+    /**
+     * @brief Write the store to disk
+     * @param filename path to the store
+     * @return true if the store was written
+     */
+    bool save(const std::string &filename);
+
+    /**
+     * @brief Map a store written by save()
+     * @param filename path to the store
+     * @return true if the store was opened
+     */
+    bool open(const std::string &filename);
+
+    /**
+     * @brief Retrieve the number of files in the store
+     */
+    size_t size() const;
+
+    boost::string_ref path(size_t row) const;
+
+    /**
+     * @brief Retrieve the value of an integer column for a file
+     * @param column any column except Entropy
+     * @param row index of the file
+     */
+    uint64_t value(Column column, size_t row) const;
+
+    float entropy(size_t row) const;
+
+    /**
+     * @brief Compute the import hash for a file
+     */
+    static uint64_t importHash(const File &file);
+
+    /**
+     * @brief Retrieve a description of the last error
+     * @return description or empty string if no error has occurred
+     */
+    std::string errorString() const;
+
+private:
+
+    CorpusStore(const CorpusStore &);
+    CorpusStore &operator=(const CorpusStore &);
+
+    CorpusStorePrivate *const d;
+
+    friend class CorpusQuery;
+};
+
+}
+
+#endif // WIN32PE_CORPUSSTORE_H
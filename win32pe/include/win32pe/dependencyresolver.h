@@ -0,0 +1,176 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_DEPENDENCYRESOLVER_H
+#define WIN32PE_DEPENDENCYRESOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class WIN32PE_EXPORT DependencyResolverPrivate;
+
+/**
+ * @brief Resolve the DLLs and functions imported by a PE file
+ *
+ * Starting from a root file, the resolver locates each imported DLL in the
+ * search directories, follows their imports in turn and binds every
+ * imported function to the export that provides it (following forwarders
+ * to other DLLs). DLL names are matched case-insensitively; API set names
+ * (api-ms-win-*) are not mapped and are only found if a file by that name
+ * exists.
+ *
+ * Each DLL is parsed once and kept in a cache shared by every call to
+ * resolve(), so checking many files against the same system DLLs reuses
+ * the parsed images. The DLLs at each level of the graph are parsed in
+ * parallel, as are the imports of each module. Any number of threads may
+ * call resolve() concurrently once the search directories are set.
+ */
+class WIN32PE_EXPORT DependencyResolver
+{
+public:
+
+    struct Import
+    {
+        /// name of the module importing the function
+        std::string importer;
+
+        /// name of the DLL the function is imported from
+        std::string module;
+
+        /// true if the function is imported by ordinal
+        bool byOrdinal;
+
+        /// ordinal (if imported by ordinal)
+        uint16_t ordinal;
+
+        /// name (if imported by name)
+        std::string name;
+
+        /// DLL that ultimately exports the function or empty if unresolved
+        std::string provider;
+
+        /// RVA of the function within the provider
+        uint32_t rva;
+    };
+
+    struct Module
+    {
+        /// name as imported (or the filename for the root)
+        std::string name;
+
+        /// path to the file or empty if it could not be found or loaded
+        std::string path;
+
+        /// names of the DLLs imported by the module
+        std::vector<std::string> dependencies;
+
+        /// functions imported by the module
+        std::vector<Import> imports;
+    };
+
+    struct Result
+    {
+        /// modules in breadth-first order, starting with the root
+        std::vector<Module> modules;
+
+        /// names of modules that could not be found or loaded
+        std::vector<std::string> missingModules;
+
+        /// imports from modules that were found but do not provide them
+        std::vector<Import> missingFunctions;
+    };
+
+    DependencyResolver();
+    virtual ~DependencyResolver();
+
+    /**
+     * @brief Add a directory to search for DLLs
+     * @param directory path to the directory
+     *
+     * Directories are searched in the order they were added.
+     */
+    void addSearchDirectory(const std::string &directory);
+    std::vector<std::string> searchDirectories() const;
+
+    /**
+     * @brief Set the number of threads used by each call to resolve()
+     * @param threads number of threads (0 for one per core, the default)
+     *
+     * Worker threads are started on first use and kept until the resolver
+     * is destroyed.
+     */
+    void setThreadCount(size_t threads);
+    size_t threadCount() const;
+
+    /**
+     * @brief Compute the dependency graph of a file
+     * @param filename path to the root file
+     * @param result graph and unresolved imports
+     * @return true if the root file was loaded
+     *
+     * Missing DLLs and functions are reported in the result rather than
+     * causing the call to fail.
+     */
+    bool resolve(const std::string &filename, Result &result);
+
+    /**
+     * @brief Discard all parsed DLLs
+     *
+     * This may be called while resolve() is running: a resolution in
+     * progress keeps the DLLs it has already parsed and parses any others
+     * again.
+     */
+    void clearCache();
+
+    /**
+     * @brief Retrieve the number of DLLs in the cache
+     *
+     * DLLs that could not be found are cached (and counted) too.
+     */
+    size_t cacheSize() const;
+
+    /**
+     * @brief Retrieve a description of the last error
+     * @return description or empty string if no error has occurred
+     */
+    std::string errorString() const;
+
+private:
+
+    DependencyResolver(const DependencyResolver &);
+    DependencyResolver &operator=(const DependencyResolver &);
+
+    DependencyResolverPrivate *const d;
+};
+
+}
+
+#endif // WIN32PE_DEPENDENCYRESOLVER_H
@@ -0,0 +1,78 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_DIGESTS_H
+#define WIN32PE_DIGESTS_H
+
+#include <cstddef>
+#include <string>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+/**
+ * @brief Message digests of a range of bytes
+ *
+ * Each digest is kept as raw bytes in the order they are conventionally
+ * printed (XXH64 in its big-endian canonical form). Digests that were not
+ * requested are empty.
+ */
+struct WIN32PE_EXPORT Digests
+{
+    enum Algorithm {
+        MD5    = 0x1,
+        SHA1   = 0x2,
+        SHA256 = 0x4,
+
+        /// 64-bit xxHash with a seed of zero (not cryptographic)
+        XXH64  = 0x8,
+
+        AllAlgorithms = 0xf
+    };
+
+    std::string md5;
+    std::string sha1;
+    std::string sha256;
+    std::string xxh64;
+
+    /**
+     * @brief Compute digests of a buffer
+     * @param data pointer to the data
+     * @param size size of the data in bytes
+     * @param algorithms combination of Algorithm values
+     * @return digests of the data
+     */
+    static Digests compute(const char *data, size_t size, int algorithms);
+
+    /**
+     * @brief Convert a digest to lower-case hexadecimal
+     */
+    static std::string toHex(const std::string &digest);
+};
+
+}
+
+#endif // WIN32PE_DIGESTS_H
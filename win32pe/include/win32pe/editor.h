@@ -0,0 +1,155 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_EDITOR_H
+#define WIN32PE_EDITOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class WIN32PE_EXPORT EditorPrivate;
+
+/**
+ * @brief In-place editor for PE files
+ *
+ * The file is mapped writable and only the headers are parsed, so opening and
+ * patching a file costs the same regardless of its size. Every patch updates
+ * the CheckSum field incrementally from the words that changed. Changes are
+ * written back by the operating system; flush() forces this to happen.
+ */
+class WIN32PE_EXPORT Editor
+{
+public:
+
+    Editor();
+    virtual ~Editor();
+
+    /**
+     * @brief Map a file for editing
+     * @param filename path to file
+     * @return true if the file was mapped and its headers are valid
+     *
+     * If the file has a non-zero checksum it is assumed to be correct and is
+     * used as the starting point for incremental updates; otherwise the
+     * checksum is computed over the entire file. Use recomputeChecksum() if
+     * the stored checksum cannot be trusted.
+     */
+    bool open(const std::string &filename);
+
+    /**
+     * @brief Flush changes and unmap the file
+     * @return true if the changes were flushed
+     */
+    bool close();
+
+    /**
+     * @brief Force changes to be written to disk
+     * @return true if the changes were flushed
+     */
+    bool flush();
+
+    uint64_t fileSize() const;
+    size_t sectionCount() const;
+
+    bool setTimeDateStamp(uint32_t timeDateStamp);
+    bool setDllCharacteristics(uint16_t dllCharacteristics);
+    bool setSubsystemVersion(uint16_t major, uint16_t minor);
+
+    /**
+     * @brief Replace an entry in the data directory
+     * @param index entry (for example, OptionalHeader::CertificateTable)
+     * @param virtualAddress RVA (or file offset for the certificate table)
+     * @param size size of the table
+     * @return true if the entry was patched
+     */
+    bool setDataDirectory(int index, uint32_t virtualAddress, uint32_t size);
+
+    /**
+     * @brief Overwrite bytes at a file offset
+     * @param offset file offset
+     * @param data replacement bytes
+     * @param size number of bytes
+     * @return true if the bytes were patched
+     *
+     * The CheckSum field cannot be patched directly since it is maintained by
+     * the editor.
+     */
+    bool patch(uint64_t offset, const char *data, size_t size);
+
+    /**
+     * @brief Overwrite bytes within a section's raw data
+     * @param index index of the section
+     * @param offset offset within the section's raw data
+     * @param data replacement bytes
+     * @param size number of bytes
+     * @return true if the bytes were patched
+     */
+    bool patchSection(size_t index, uint32_t offset, const char *data, size_t size);
+
+    /**
+     * @brief Overwrite bytes at an RVA
+     * @param rva relative virtual address
+     * @param data replacement bytes
+     * @param size number of bytes
+     * @return true if the bytes were patched
+     *
+     * All of the bytes must lie within the raw data of a single section.
+     */
+    bool patchRVA(uint32_t rva, const char *data, size_t size);
+
+    /**
+     * @brief Retrieve the current checksum
+     * @return value stored in the CheckSum field
+     */
+    uint32_t checkSum() const;
+
+    /**
+     * @brief Recompute the checksum over the entire file
+     * @return new checksum
+     */
+    uint32_t recomputeChecksum();
+
+    /**
+     * @brief Retrieve a description of the last error
+     * @return description or empty string if no error has occurred
+     */
+    std::string errorString() const;
+
+private:
+
+    Editor(const Editor &);
+    Editor &operator=(const Editor &);
+
+    EditorPrivate *const d;
+};
+
+}
+
+#endif // WIN32PE_EDITOR_H
@@ -0,0 +1,125 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_EMITTER_H
+#define WIN32PE_EMITTER_H
+
+#include <string>
+
+#include <boost/utility/string_ref.hpp>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class File;
+
+class WIN32PE_EXPORT EmitterPrivate;
+
+/**
+ * @brief Serialize files as NDJSON or CSV records
+ *
+ * Records are appended directly to a caller-supplied buffer, which can be
+ * cleared and reused between files to avoid allocating. Only the selected
+ * fields are read from the File, so unneeded data (such as import names) is
+ * never decoded.
+ *
+ * In NDJSON records, flags and addresses are strings in hexadecimal while
+ * sizes and counts are numbers. CSV records have one row per file; lists
+ * (section, import and imported function names) are joined with semicolons.
+ * Functions imported by ordinal are named "#<ordinal>".
+ */
+class WIN32PE_EXPORT Emitter
+{
+public:
+
+    enum Format {
+        NDJSON,
+        CSV
+    };
+
+    enum {
+        /// machine, timestamp, characteristics, magic, subsystem, DLL characteristics
+        Headers  = 0x1,
+
+        /// section table (names only in CSV)
+        Sections = 0x2,
+
+        /// imported DLLs and their functions (names only in CSV, with
+        /// functions as "<dll>!<function>" in a separate column)
+        Imports  = 0x4,
+
+        /// file size, overlay bounds and import hash
+        Derived  = 0x8,
+
+        All      = 0xf
+    };
+
+    Emitter();
+    Emitter(const Emitter &other);
+    virtual ~Emitter();
+
+    Emitter &operator=(const Emitter &other);
+
+    /**
+     * @brief Set the format of the records
+     * @param format NDJSON (the default) or CSV
+     */
+    void setFormat(Format format);
+    Format format() const;
+
+    /**
+     * @brief Set the fields to emit
+     * @param fields combination of Headers, Sections, Imports and Derived
+     *
+     * The path is always emitted first. The default is All.
+     */
+    void setFields(int fields);
+    int fields() const;
+
+    /**
+     * @brief Append the CSV header row for the selected fields
+     * @param buffer output buffer
+     *
+     * Nothing is appended for NDJSON.
+     */
+    void header(std::string &buffer) const;
+
+    /**
+     * @brief Append a record (including the trailing newline) for a file
+     * @param buffer output buffer
+     * @param path path to identify the file by
+     * @param file file to emit
+     */
+    void emit(std::string &buffer, boost::string_ref path, const File &file) const;
+
+private:
+
+    EmitterPrivate *const d;
+};
+
+}
+
+#endif // WIN32PE_EMITTER_H
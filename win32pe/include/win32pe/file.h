@@ -25,29 +25,80 @@
 #ifndef WIN32PE_FILE_H
 #define WIN32PE_FILE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <istream>
+#include <ostream>
 #include <string>
 #include <vector>
 
+#include <boost/utility/string_ref.hpp>
+
+#include <win32pe/digests.h>
+#include <win32pe/importtable.h>
+#include <win32pe/ranges.h>
+#include <win32pe/sectionref.h>
 #include <win32pe/win32pe.h>
 
 namespace win32pe
 {
 
 class FileHeader;
-class ImportTable;
+class Instrumentation;
+class Limits;
 class OptionalHeader;
 class Section;
+class SymbolTable;
 
 class WIN32PE_EXPORT FilePrivate;
 
 /**
  * @brief PE file
+ *
+ * Once a file is loaded, any number of threads may call its const member
+ * functions concurrently; anything built on demand (such as the Section
+ * copies or the RVA index) is initialized exactly once. The exception is
+ * save(), which records its errors for errorString(). Saving, loading,
+ * editing and assignment require exclusive access.
  */
 class WIN32PE_EXPORT File
 {
 public:
 
+    /**
+     * @brief Callback invoked for each chunk of data read
+     *
+     * The offset is the file offset of the first byte in the chunk and the
+     * chunk is only valid for the duration of the call. Returning false stops
+     * the read.
+     */
+    typedef std::function<bool(uint64_t offset, boost::string_ref chunk)> ChunkCallback;
+
+    struct Relocation
+    {
+        /// RVA of the location to be fixed up
+        uint32_t rva;
+
+        /// type of fixup (such as IMAGE_REL_BASED_DIR64)
+        uint16_t type;
+    };
+
+    struct Export
+    {
+        /// ordinal (including the ordinal base)
+        uint16_t ordinal;
+
+        /// RVA of the exported item or 0 if it is forwarded
+        uint32_t rva;
+
+        /// name or empty string if the item is only exported by ordinal
+        std::string name;
+
+        /// "DLL.Name" or "DLL.#Ordinal" for forwarded items, else empty
+        std::string forwarder;
+    };
+
     File();
     File(const File &other);
     virtual ~File();
@@ -68,6 +119,157 @@ public:
      */
     bool load(const std::string &filename);
 
+    /**
+     * @brief Load a PE file from memory
+     * @param data pointer to the contents of the file
+     * @param size size of the contents in bytes
+     * @return true if the file was loaded
+     *
+     * The data is copied, so it may be released as soon as this returns;
+     * use map() to load a file from disk without copying it.
+     */
+    bool load(const char *data, size_t size);
+
+    /**
+     * @brief Memory-map a PE file from disk and load it
+     * @param filename path to file
+     * @return true if the file was loaded
+     *
+     * The mapping is kept alive for as long as the File (or any copy of it)
+     * exists, allowing the overlay to be accessed without copying it.
+     */
+    bool map(const std::string &filename);
+
+    /**
+     * @brief Load a PE image from memory as laid out by the loader
+     * @param data pointer to the image (such as a dump of a loaded module)
+     * @param size size of the image in bytes
+     * @return true if the image was loaded
+     *
+     * Each section's data is read from its RVA rather than its file offset
+     * and is truncated if the image is. The data is referred to in place and
+     * must remain valid for as long as the File (or any copy of it) is in
+     * use. There is no overlay and the COFF symbol table, which is not
+     * mapped, is ignored.
+     */
+    bool loadImage(const char *data, size_t size);
+
+    /**
+     * @brief Determine if the file was loaded with loadImage()
+     */
+    bool isImage() const;
+
+    /**
+     * @brief Record timings and counters for subsequent loads
+     * @param instrumentation instance to record to or nullptr to stop
+     *
+     * The instance is not owned by the File and may be shared between Files
+     * loaded on different threads. Nothing is recorded unless the library
+     * was built with instrumentation (see Instrumentation::isAvailable()).
+     */
+    void setInstrumentation(Instrumentation *instrumentation);
+    Instrumentation *instrumentation() const;
+
+    /**
+     * @brief Set the resource limits applied to subsequent loads
+     * @param limits limits to apply
+     */
+    void setLimits(const Limits &limits);
+    const Limits &limits() const;
+
+    /**
+     * @brief Set the digests computed by subsequent loads
+     * @param algorithms combination of Digests::Algorithm values (default is none)
+     *
+     * Every digest of the file, each section's raw data and the overlay is
+     * computed in a single pass over the file at the end of the load. A file
+     * loaded from memory or memory-mapped is hashed in place. When loading
+     * from a stream each section is hashed as it is read, and only the
+     * headers, any gaps between sections and the overlay are read again, so
+     * the stream must be seekable.
+     */
+    void setDigestAlgorithms(int algorithms);
+    int digestAlgorithms() const;
+
+    /**
+     * @brief Write the PE file to a stream
+     * @param ostream reference to an output stream
+     * @return true if the file was written
+     *
+     * Section data is placed at its original offset where possible and padded
+     * to the file alignment; SizeOfHeaders, SizeOfImage and the number of
+     * sections are recomputed. The overlay is written if the file was loaded
+     * from memory or memory-mapped. A file loaded from a stream only keeps
+     * the symbol and string tables, so saving it fails if its overlay holds
+     * anything else (such as a certificate table).
+     *
+     * Unlike the other const member functions, this may not be called
+     * concurrently with any other member function since it records errors.
+     */
+    bool save(std::ostream &ostream) const;
+
+    /**
+     * @brief Write the PE file to disk
+     * @param filename path to file
+     * @return true if the file was written
+     *
+     * Section data and the overlay are written directly from memory with a
+     * single gathered write where the platform supports it. The file is
+     * written to a temporary file in the same directory, flushed to disk and
+     * renamed over the target, keeping its permissions, so it is safe to save
+     * over a mapped file and the target is never left half written. As
+     * with the stream overload, this requires exclusive access.
+     */
+    bool save(const std::string &filename) const;
+
+    /**
+     * @brief Append a section
+     * @param name name of up to eight characters
+     * @param characteristics section flags (see Section)
+     * @param data raw data for the section
+     * @return true if the section was added
+     *
+     * The section is placed after the last section both in memory and in the
+     * file. If the section table no longer fits in the headers, the headers
+     * are enlarged (moving the data of every section in the file but not in
+     * memory) or, failing that, the DOS stub is discarded to make room.
+     */
+    bool addSection(const std::string &name, uint32_t characteristics, const std::string &data);
+
+    /**
+     * @brief Remove a section
+     * @param index index of the section
+     * @return true if the section was removed
+     *
+     * To keep the image contiguous, the preceding section's virtual size is
+     * extended to cover the space the section occupied in memory; if the
+     * first section is removed, the headers are enlarged to reach the next
+     * one instead, moving the data of every section in the file but not in
+     * memory. Data directory entries referring to the section are cleared.
+     */
+    bool removeSection(size_t index);
+
+    /**
+     * @brief Change the size of a section's data
+     * @param index index of the section
+     * @param size new size of the data
+     * @return true if the section was resized
+     *
+     * Growing a section pads it with zeroes and enlarges its virtual size;
+     * shrinking it leaves the virtual size unchanged.
+     */
+    bool resizeSection(size_t index, uint32_t size);
+
+    /**
+     * @brief Replace a section's data
+     * @param index index of the section
+     * @param data new raw data for the section
+     * @return true if the data was replaced
+     *
+     * The virtual size is enlarged if necessary to cover the new data.
+     */
+    bool setSectionData(size_t index, const std::string &data);
+
     /**
      * @brief Access the PE file's file header
      * @return reference to the file header
@@ -83,15 +285,99 @@ public:
     /**
      * @brief Access the PE file's sections
      * @return reference to a vector containing the sections
+     *
+     * The vector (including a copy of each section's data) is built the first
+     * time it is requested after the file is loaded or modified.
      */
     const std::vector<Section> &sections() const;
 
+    /**
+     * @brief Retrieve the number of sections
+     */
+    size_t sectionCount() const;
+
+    /**
+     * @brief Access a section without copying it
+     * @param index index of the section (less than sectionCount())
+     * @return reference to the section
+     *
+     * Unlike sections(), this does not allocate - prefer it for scanning the
+     * section table.
+     */
+    SectionRef section(size_t index) const;
+
+    /**
+     * @brief Iterate over the sections without copying them
+     * @return range of section references
+     */
+    Range<SectionIterator> sectionRefs() const;
+
     /**
      * @brief Access the PE file's import table
      * @return reference to the import table
+     *
+     * The table is read again whenever the sections change.
      */
     const ImportTable &importTable() const;
 
+    /**
+     * @brief Decode the functions imported by an import table item
+     * @param item item from importTable()
+     * @return vector containing the functions
+     *
+     * The import lookup table is used if present; otherwise the import
+     * address table is read instead (which is only correct if the image is
+     * not bound).
+     */
+    std::vector<ImportTable::Function> importedFunctions(const ImportTable::Item &item) const;
+
+    /**
+     * @brief Iterate over the import descriptors in the file's data
+     * @return range of import table items
+     *
+     * Unlike importTable(), descriptors are decoded as the range is walked,
+     * which makes it cheap to stop at the first one of interest.
+     */
+    Range<ImportDescriptorIterator> importDescriptors() const;
+
+    /**
+     * @brief Iterate over the functions imported by an import table item
+     * @param item item from importTable() or importDescriptors()
+     * @return range of functions whose names refer to the file's data
+     *
+     * This is the non-allocating equivalent of importedFunctions().
+     */
+    Range<ImportFunctionIterator> importedFunctionRefs(const ImportTable::Item &item) const;
+
+    /**
+     * @brief Decode the base relocation table
+     * @return vector containing the fixups, excluding padding entries
+     */
+    std::vector<Relocation> relocations() const;
+
+    /**
+     * @brief Decode the export table
+     * @return vector containing the exports in ordinal order
+     *
+     * Unused entries in the export address table are skipped. An item
+     * exported under more than one name appears once per name.
+     */
+    std::vector<Export> exports() const;
+
+    /**
+     * @brief Access the PE file's COFF symbol table
+     * @return view of the symbol and string tables
+     *
+     * The table is empty if the file has no symbols or if they could not be
+     * read. When the file was loaded from memory or memory-mapped, the view
+     * refers directly to that data; otherwise it refers to a copy made while
+     * loading. Either way, it is only valid for as long as the File.
+     *
+     * Object files (.obj) have no MZ or PE headers and cannot be loaded;
+     * their symbols are read with SymbolTable::fromObject().
+     */
+    SymbolTable symbolTable() const;
+
     /**
      * @brief Convert an RVA to the section containing it
      * @param rva relative virtual address
@@ -99,6 +385,13 @@ public:
      */
     const Section *rvaToSection(uint32_t rva) const;
 
+    /**
+     * @brief Convert an RVA to a reference to the section containing it
+     * @param rva relative virtual address
+     * @return reference to the section (null if there is none)
+     */
+    SectionRef rvaToSectionRef(uint32_t rva) const;
+
     /**
      * @brief Access a string value at an RVA
      * @param rva relative virtual address
@@ -106,6 +399,90 @@ public:
      */
     std::string string(uint32_t rva) const;
 
+    /**
+     * @brief Retrieve the size of the file
+     * @return size in bytes
+     */
+    uint64_t fileSize() const;
+
+    /**
+     * @brief Retrieve the offset of the overlay
+     * @return file offset of the first byte past the last section's data
+     *
+     * Once sections have been added, removed or resized this is where save()
+     * will write the overlay, and the certificate table and symbol table
+     * pointers in the headers are moved to match.
+     */
+    uint64_t overlayOffset() const;
+
+    /**
+     * @brief Retrieve the size of the overlay
+     * @return size in bytes or 0 if there is no overlay
+     */
+    uint64_t overlaySize() const;
+
+    /**
+     * @brief Retrieve the digests of the whole file
+     * @return digests computed during the last load
+     *
+     * Digests describe the file as it was loaded; they are all cleared when
+     * a section is added, removed or changed.
+     */
+    const Digests &fileDigests() const;
+
+    /**
+     * @brief Retrieve the digests of a section's raw data
+     * @param index index of the section (less than sectionCount())
+     * @return digests computed during the last load
+     */
+    const Digests &sectionDigests(size_t index) const;
+
+    /**
+     * @brief Retrieve the digests of the overlay
+     * @return digests computed during the last load
+     */
+    const Digests &overlayDigests() const;
+
+    /**
+     * @brief Determine if the certificate table lies within the overlay
+     * @return true if any part of the certificate table is in the overlay
+     *
+     * Signed files store their certificates at the end of the file, making
+     * them indistinguishable from other overlay data by position alone.
+     */
+    bool overlayOverlapsCertificateTable() const;
+
+    /**
+     * @brief Access the overlay without copying it
+     * @return view of the overlay
+     *
+     * The view is only available if the file was loaded from memory or
+     * memory-mapped; otherwise it is empty and readOverlay() must be used.
+     */
+    boost::string_ref overlay() const;
+
+    /**
+     * @brief Read the overlay in chunks from memory
+     * @param callback function invoked for each chunk
+     * @param chunkSize maximum size of each chunk
+     * @return true if the entire overlay was read
+     *
+     * This fails if the file was not loaded from memory or memory-mapped.
+     */
+    bool readOverlay(const ChunkCallback &callback, size_t chunkSize = 1 << 20) const;
+
+    /**
+     * @brief Read the overlay in chunks from a stream
+     * @param istream stream the file was loaded from
+     * @param callback function invoked for each chunk
+     * @param chunkSize maximum size of each chunk
+     * @return true if the entire overlay was read
+     *
+     * A single buffer of chunkSize bytes is reused for every chunk.
+     */
+    bool readOverlay(std::istream &istream, const ChunkCallback &callback,
+                     size_t chunkSize = 1 << 20) const;
+
     /**
      * @brief Retrieve a description of the last error
      * @return description or empty string if no error has occurred
@@ -115,6 +492,11 @@ public:
 private:
 
     FilePrivate *const d;
+
+    friend class BuildComparator;
+    friend class ImageHash;
+    friend class ImportFunctionIterator;
+    friend class MetadataCache;
 };
 
 }
@@ -76,6 +76,8 @@ private:
     FileHeaderPrivate *const d;
 
     friend class FilePrivate;
+    friend class Layout;
+    friend class Writer;
 };
 
 }
@@ -0,0 +1,120 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_IMAGEHASH_H
+#define WIN32PE_IMAGEHASH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <win32pe/digests.h>
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class File;
+
+class WIN32PE_EXPORT ImageHashPrivate;
+
+/**
+ * @brief Hash of a PE image that is independent of where it was loaded
+ *
+ * The image is laid out as the loader would map it - the headers followed
+ * by each section at its RVA, zero-filled up to SizeOfImage - and every
+ * byte that the loader or linker may change is zeroed before hashing:
+ *
+ *  - each location fixed up by the base relocation table
+ *  - the import address table
+ *  - TimeDateStamp, CheckSum and ImageBase in the headers
+ *
+ * A file on disk and a dump of the same module loaded at any address
+ * (loaded with File::loadImage()) therefore produce the same digests. The
+ * image is normalized and hashed in fixed-size chunks, so it is never
+ * copied in full.
+ */
+class WIN32PE_EXPORT ImageHash
+{
+public:
+
+    struct Mask
+    {
+        /// RVA of the first byte zeroed
+        uint32_t rva;
+
+        /// number of bytes zeroed
+        uint32_t size;
+    };
+
+    ImageHash();
+    ImageHash(const ImageHash &other);
+    virtual ~ImageHash();
+
+    ImageHash &operator=(const ImageHash &other);
+
+    /**
+     * @brief Set the digests computed by subsequent calls to compute()
+     * @param algorithms combination of Digests::Algorithm values (default is XXH64)
+     */
+    void setAlgorithms(int algorithms);
+    int algorithms() const;
+
+    /**
+     * @brief Normalize and hash an image
+     * @param file file or image to hash
+     * @return true if the image was hashed
+     */
+    bool compute(const File &file);
+
+    /**
+     * @brief Retrieve the digests of the normalized image
+     */
+    const Digests &digests() const;
+
+    /**
+     * @brief Retrieve the ranges zeroed before hashing
+     * @return masks ordered by RVA, with overlapping ranges merged
+     */
+    const std::vector<Mask> &masks() const;
+
+    /**
+     * @brief Retrieve the number of bytes hashed (SizeOfImage)
+     */
+    uint32_t imageSize() const;
+
+    /**
+     * @brief Retrieve a description of the last error
+     * @return description or empty string if no error has occurred
+     */
+    std::string errorString() const;
+
+private:
+
+    ImageHashPrivate *const d;
+};
+
+}
+
+#endif // WIN32PE_IMAGEHASH_H
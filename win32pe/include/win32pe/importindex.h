@@ -0,0 +1,134 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_IMPORTINDEX_H
+#define WIN32PE_IMPORTINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class File;
+
+class WIN32PE_EXPORT ImportIndexPrivate;
+
+/**
+ * @brief Inverted index from imported functions to the files importing them
+ *
+ * Each (DLL, function) pair imported by a file in the corpus maps to a list
+ * of file IDs, stored as varint-encoded deltas. The index is written to a
+ * single file which is memory-mapped when opened, with the pairs sorted so
+ * that a lookup is a binary search; finding the files that import several
+ * functions intersects their lists starting with the shortest. Adding files
+ * to an opened index copies it into memory first.
+ *
+ * Files are numbered in the order they are added, which matches the rows of
+ * a CorpusStore built from the same files in the same order.
+ *
+ * Instances are not thread-safe, although any number of queries may run
+ * against an index concurrently once it is no longer being modified.
+ */
+class WIN32PE_EXPORT ImportIndex
+{
+public:
+
+    struct Term
+    {
+        /// name of the DLL (matched case-insensitively)
+        std::string dll;
+
+        /// name of the function or "#" followed by the ordinal in decimal
+        std::string function;
+    };
+
+    ImportIndex();
+    virtual ~ImportIndex();
+
+    /**
+     * @brief Add a file to the index
+     * @param file loaded file
+     * @return ID of the file
+     */
+    uint32_t add(const File &file);
+
+    /**
+     * @brief Write the index to disk
+     * @param filename path to the index
+     * @return true if the index was written
+     */
+    bool save(const std::string &filename);
+
+    /**
+     * @brief Map an index written by save()
+     * @param filename path to the index
+     * @return true if the index was opened
+     */
+    bool open(const std::string &filename);
+
+    /**
+     * @brief Retrieve the number of files in the index
+     */
+    size_t fileCount() const;
+
+    /**
+     * @brief Retrieve the number of distinct (DLL, function) pairs
+     */
+    size_t termCount() const;
+
+    /**
+     * @brief Retrieve the number of files importing a function
+     * @param term DLL and function
+     */
+    size_t frequency(const Term &term) const;
+
+    /**
+     * @brief Find the files importing every one of a set of functions
+     * @param terms DLLs and functions
+     * @return IDs of the files in ascending order
+     */
+    std::vector<uint32_t> query(const std::vector<Term> &terms) const;
+
+    /**
+     * @brief Retrieve a description of the last error
+     * @return description or empty string if no error has occurred
+     */
+    std::string errorString() const;
+
+private:
+
+    ImportIndex(const ImportIndex &);
+    ImportIndex &operator=(const ImportIndex &);
+
+    ImportIndexPrivate *const d;
+};
+
+}
+
+#endif // WIN32PE_IMPORTINDEX_H
@@ -25,10 +25,13 @@
 #ifndef WIN32PE_IMPORTTABLE_H
 #define WIN32PE_IMPORTTABLE_H
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
 
+#include <boost/utility/string_ref.hpp>
+
 #include <win32pe/win32pe.h>
 
 namespace win32pe
@@ -52,6 +55,35 @@ public:
         uint32_t firstThunk;
     };
 
+    struct Function
+    {
+        /// true if the function is imported by ordinal rather than name
+        bool byOrdinal;
+
+        /// ordinal (only valid if byOrdinal is set)
+        uint16_t ordinal;
+
+        /// index into the export name table to try first
+        uint16_t hint;
+
+        /// name of the function (empty if byOrdinal is set)
+        std::string name;
+    };
+
+    /**
+     * @brief Imported function decoded in place
+     *
+     * The same as Function except that the name refers to the section data
+     * and is only valid for as long as the File.
+     */
+    struct FunctionRef
+    {
+        bool byOrdinal;
+        uint16_t ordinal;
+        uint16_t hint;
+        boost::string_ref name;
+    };
+
     ImportTable();
     ImportTable(const ImportTable &other);
     virtual ~ImportTable();
@@ -61,9 +93,21 @@ public:
     /**
      * @brief Load an import table from a string
      * @param data raw data
+     * @param maxItems maximum number of descriptors to accept
+     * @return true if the table was loaded
+     *
+     * Any items previously loaded are discarded.
+     */
+    bool load(const std::string &data, size_t maxItems = SIZE_MAX);
+
+    /**
+     * @brief Load an import table from a buffer
+     * @param data pointer to the raw data
+     * @param size size of the raw data
+     * @param maxItems maximum number of descriptors to accept
      * @return true if the table was loaded
      */
-    bool load(const std::string &data);
+    bool load(const char *data, size_t size, size_t maxItems = SIZE_MAX);
 
     /**
      * @brief Access the items in the import table
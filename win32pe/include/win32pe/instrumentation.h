@@ -0,0 +1,145 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_INSTRUMENTATION_H
+#define WIN32PE_INSTRUMENTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class WIN32PE_EXPORT InstrumentationPrivate;
+
+/**
+ * @brief Timings and counters collected while loading files
+ *
+ * Attach an instance to one or more Files with File::setInstrumentation();
+ * a single instance may be shared by Files loaded on different threads and
+ * accumulates the totals for all of them.
+ *
+ * Recording is only compiled in when the library is built with the
+ * WIN32PE_INSTRUMENTATION option; otherwise the hooks in the loader compile
+ * to nothing and every value remains zero (see isAvailable()).
+ */
+class WIN32PE_EXPORT Instrumentation
+{
+public:
+
+    enum Phase {
+        DOSHeader,
+        PEHeaders,
+        Sections,
+        ImportTable,
+        SymbolTable,
+        Overlay,
+        Digests,
+
+        PhaseCount
+    };
+
+    enum Counter {
+        Loads,
+        BytesRead,
+        ReadCalls,
+        SeekCalls,
+
+        /// buffers the loader sizes to hold file data and their total size;
+        /// these are counted where the loader creates or grows them, not by
+        /// hooking the allocator, so container overhead is not included
+        LoaderBuffers,
+        LoaderBufferBytes,
+
+        CounterCount
+    };
+
+    Instrumentation();
+    virtual ~Instrumentation();
+
+    /**
+     * @brief Determine if instrumentation was compiled into the library
+     * @return true if values are recorded
+     */
+    static bool isAvailable();
+
+    /**
+     * @brief Set the maximum number of individual phase events to keep
+     * @param capacity number of events (default is 0)
+     *
+     * Events are only needed for chromeTrace(); totals are always kept.
+     */
+    void setEventCapacity(size_t capacity);
+
+    /**
+     * @brief Retrieve the total time spent in a phase
+     * @param phase phase of loading
+     * @return time in nanoseconds
+     */
+    uint64_t phaseTime(Phase phase) const;
+
+    /**
+     * @brief Retrieve the number of times a phase was entered
+     */
+    uint64_t phaseCount(Phase phase) const;
+
+    uint64_t counter(Counter counter) const;
+
+    /**
+     * @brief Clear all totals and events
+     */
+    void reset();
+
+    /**
+     * @brief Format the totals as a human-readable summary
+     * @return text with one line per phase and counter
+     */
+    std::string summary() const;
+
+    /**
+     * @brief Format the recorded events in the Chrome trace event format
+     * @return JSON that can be opened with chrome://tracing or Perfetto
+     */
+    std::string chromeTrace() const;
+
+    static const char *phaseName(Phase phase);
+    static const char *counterName(Counter counter);
+
+private:
+
+    Instrumentation(const Instrumentation &);
+    Instrumentation &operator=(const Instrumentation &);
+
+    InstrumentationPrivate *const d;
+
+    friend class PhaseTimer;
+    friend class FilePrivate;
+};
+
+}
+
+#endif // WIN32PE_INSTRUMENTATION_H
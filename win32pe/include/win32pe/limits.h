@@ -0,0 +1,116 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_LIMITS_H
+#define WIN32PE_LIMITS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class WIN32PE_EXPORT LimitsPrivate;
+
+/**
+ * @brief Bounds on the resources used to load a file
+ *
+ * Sizes taken from the headers are validated against the actual size of the
+ * file and these limits before anything is allocated, so that the cost of
+ * loading a malformed or hostile file is bounded. The defaults accept any
+ * reasonable image; lower them when scanning untrusted input in bulk.
+ */
+class WIN32PE_EXPORT Limits
+{
+public:
+
+    Limits();
+    Limits(const Limits &other);
+    virtual ~Limits();
+
+    Limits &operator=(const Limits &other);
+
+    /**
+     * @brief Set the maximum size of the headers
+     * @param size bytes from the start of the file (default is 1 MiB)
+     *
+     * This bounds both the offset of the PE headers (e_lfanew) and the end
+     * of the section table. Header data beyond the limit is not kept.
+     */
+    void setMaxHeaderSize(uint32_t size);
+    uint32_t maxHeaderSize() const;
+
+    /**
+     * @brief Set the maximum number of sections
+     * @param count number of sections (default is 4096)
+     */
+    void setMaxSections(uint32_t count);
+    uint32_t maxSections() const;
+
+    /**
+     * @brief Set the maximum size of the raw data of a single section
+     * @param size size in bytes (default is 256 MiB)
+     */
+    void setMaxSectionSize(uint32_t size);
+    uint32_t maxSectionSize() const;
+
+    /**
+     * @brief Set the maximum number of bytes copied from the file
+     * @param size size in bytes (default is 1 GiB)
+     *
+     * This includes the headers, section data and symbol table. A symbol
+     * table that does not fit is treated as absent.
+     */
+    void setMaxTotalSize(uint64_t size);
+    uint64_t maxTotalSize() const;
+
+    /**
+     * @brief Set the maximum number of import descriptors
+     * @param count number of descriptors (default is 65536)
+     */
+    void setMaxImportDescriptors(uint32_t count);
+    uint32_t maxImportDescriptors() const;
+
+    /**
+     * @brief Set the maximum time allowed for loading
+     * @param milliseconds time in milliseconds or 0 for no limit (the default)
+     *
+     * The budget is checked between phases and after each section, so a
+     * load may overrun it by the time taken to read one section.
+     */
+    void setTimeBudget(uint32_t milliseconds);
+    uint32_t timeBudget() const;
+
+private:
+
+    LimitsPrivate *const d;
+
+    friend class FilePrivate;
+};
+
+}
+
+#endif // WIN32PE_LIMITS_H
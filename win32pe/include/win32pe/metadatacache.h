@@ -0,0 +1,126 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_METADATACACHE_H
+#define WIN32PE_METADATACACHE_H
+
+#include <cstddef>
+#include <string>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class File;
+
+class WIN32PE_EXPORT MetadataCachePrivate;
+
+/**
+ * @brief On-disk cache of parsed files keyed by file identity
+ *
+ * Entries are keyed by device, inode (on Windows, the volume serial number
+ * and file index), size and modification time, so a file that has not
+ * changed since it was cached can be restored with a single stat() and no
+ * access to the file itself. The cache file is memory-mapped and its index
+ * is searched in place.
+ *
+ * A restored File has the headers, section table, import table, imported
+ * functions, exports, digests and overlay bounds of the original but no
+ * section data; strings referred to by the import table are still available
+ * through File::string(). Without its section data, a restored File cannot
+ * be saved.
+ *
+ * Instances are not thread-safe.
+ */
+class WIN32PE_EXPORT MetadataCache
+{
+public:
+
+    MetadataCache();
+    virtual ~MetadataCache();
+
+    /**
+     * @brief Open a cache file
+     * @param filename path to the cache
+     * @return true if the cache was opened
+     *
+     * A cache that does not exist yet is treated as empty. A cache that is
+     * corrupt or from another version is discarded.
+     */
+    bool open(const std::string &filename);
+
+    /**
+     * @brief Restore a file from the cache
+     * @param path path to the original file
+     * @param file file to restore
+     * @return true if the file was found and is unchanged
+     */
+    bool lookup(const std::string &path, File &file);
+
+    /**
+     * @brief Add (or replace) the entry for a file
+     * @param path path the file was loaded from
+     * @param file loaded file
+     * @return true if the entry was added
+     *
+     * The file must have been loaded or mapped from the path (or restored by
+     * lookup()), and the path must still have the device, inode, size and
+     * modification time it had then. Entries are only written to disk by
+     * save().
+     */
+    bool insert(const std::string &path, const File &file);
+
+    /**
+     * @brief Write the cache to disk
+     * @param pruneUnused drop entries that were not looked up or inserted
+     * @return true if the cache was written
+     *
+     * The cache is written to a temporary file which then replaces the
+     * original, so readers never see a partially written cache.
+     */
+    bool save(bool pruneUnused = false);
+
+    /**
+     * @brief Retrieve the number of entries
+     */
+    size_t size() const;
+
+    /**
+     * @brief Retrieve a description of the last error
+     * @return description or empty string if no error has occurred
+     */
+    std::string errorString() const;
+
+private:
+
+    MetadataCache(const MetadataCache &);
+    MetadataCache &operator=(const MetadataCache &);
+
+    MetadataCachePrivate *const d;
+};
+
+}
+
+#endif // WIN32PE_METADATACACHE_H
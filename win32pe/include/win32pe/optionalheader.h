@@ -96,8 +96,12 @@ public:
     OptionalHeader &operator=(const OptionalHeader &other);
 
     uint16_t magic() const;
+    uint64_t imageBase() const;
     uint16_t majorOperatingSystemVersion() const;
     uint16_t minorOperatingSystemVersion() const;
+    uint32_t sizeOfImage() const;
+    uint32_t sizeOfHeaders() const;
+    uint32_t checkSum() const;
     uint16_t subsystem() const;
     uint16_t dllCharacteristics() const;
 
@@ -108,6 +112,8 @@ private:
     OptionalHeaderPrivate *const d;
 
     friend class FilePrivate;
+    friend class Layout;
+    friend class Writer;
 };
 
 }
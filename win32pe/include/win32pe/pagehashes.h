@@ -0,0 +1,164 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_PAGEHASHES_H
+#define WIN32PE_PAGEHASHES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class WIN32PE_EXPORT PageHashesPrivate;
+
+/**
+ * @brief Hashes of each 4 KB page of a PE file and a Merkle tree over them
+ *
+ * Pages are laid out as for Authenticode page hashes: the headers form the
+ * first page (excluding the CheckSum field and the certificate table entry)
+ * followed by each page of every section's raw data in file order, with
+ * partial pages padded with zeroes. The page hashes are the leaves of a
+ * binary Merkle tree whose nodes hash the concatenation of their children
+ * (a node without a sibling is carried up unchanged).
+ *
+ * Pages are hashed in parallel. After a small patch, update() rehashes only
+ * the pages containing the change and the nodes on their paths to the root.
+ */
+class WIN32PE_EXPORT PageHashes
+{
+public:
+
+    enum Algorithm {
+        SHA1,
+        SHA256
+    };
+
+    /// size of a page in bytes
+    static const uint32_t PageSize = 4096;
+
+    PageHashes();
+    PageHashes(const PageHashes &other);
+    virtual ~PageHashes();
+
+    PageHashes &operator=(const PageHashes &other);
+
+    /**
+     * @brief Set the hash algorithm for subsequent calls to compute()
+     * @param algorithm algorithm to use (default is SHA256)
+     */
+    void setAlgorithm(Algorithm algorithm);
+    Algorithm algorithm() const;
+
+    /**
+     * @brief Set the number of threads used to hash pages
+     * @param threads number of threads (0 for one per core, the default)
+     */
+    void setThreadCount(size_t threads);
+    size_t threadCount() const;
+
+    /**
+     * @brief Hash every page of a file
+     * @param data pointer to the contents of the file
+     * @param size size of the contents in bytes
+     * @return true if the file could be parsed
+     */
+    bool compute(const char *data, size_t size);
+
+    /**
+     * @brief Rehash the pages affected by a change to the file
+     * @param data pointer to the new contents of the file
+     * @param size size of the contents in bytes
+     * @param offset file offset of the first byte that changed
+     * @param length number of bytes that changed
+     * @return true if the file could be parsed
+     *
+     * If the change moved any page (by altering the section table, for
+     * example), every page is hashed again.
+     */
+    bool update(const char *data, size_t size, uint64_t offset, uint64_t length);
+
+    /**
+     * @brief Retrieve the number of pages
+     */
+    size_t pageCount() const;
+
+    /**
+     * @brief Retrieve the file offset of a page
+     * @param index index of the page (less than pageCount())
+     */
+    uint32_t pageOffset(size_t index) const;
+
+    /**
+     * @brief Retrieve the hash of a page
+     * @param index index of the page (less than pageCount())
+     * @return raw digest
+     */
+    std::string pageHash(size_t index) const;
+
+    /**
+     * @brief Retrieve the root of the Merkle tree
+     * @return raw digest or empty string if there are no pages
+     */
+    std::string rootHash() const;
+
+    /**
+     * @brief Build the Authenticode page hash table
+     * @return table of 32-bit file offsets each followed by a page hash
+     *
+     * The table ends with the offset of the end of the last section and a
+     * zero hash, as expected in SpcPeImagePageHashes.
+     */
+    std::string authenticodeTable() const;
+
+    /**
+     * @brief Serialize the pages and the whole tree
+     * @return serialized data
+     */
+    std::string save() const;
+
+    /**
+     * @brief Restore pages and a tree serialized by save()
+     * @param data serialized data
+     * @return true if the data was valid
+     */
+    bool load(const std::string &data);
+
+    /**
+     * @brief Retrieve a description of the last error
+     * @return description or empty string if no error has occurred
+     */
+    std::string errorString() const;
+
+private:
+
+    PageHashesPrivate *const d;
+};
+
+}
+
+#endif // WIN32PE_PAGEHASHES_H
@@ -0,0 +1,130 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_PROBE_H
+#define WIN32PE_PROBE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+/**
+ * @brief Cheap classification of a file from its first bytes
+ *
+ * Probing only examines a prefix of the file (ProbeSize bytes is enough for
+ * virtually every image) and never allocates, so non-PE input can be
+ * rejected far more cheaply than by attempting a full load.
+ */
+class WIN32PE_EXPORT Probe
+{
+public:
+
+    enum Format {
+        /// no MZ signature
+        NotMZ,
+
+        /// the prefix ended before the format could be determined
+        Truncated,
+
+        /// MZ executable without a valid extended header
+        DOS,
+
+        /// 16-bit Windows / OS/2 executable
+        NE,
+
+        /// OS/2 or VxD linear executable (LE or LX)
+        LE,
+
+        PE32,
+        PE32Plus
+    };
+
+    enum {
+        ProbeSize = 4096
+    };
+
+    Probe();
+
+    /**
+     * @brief Classify a file from a prefix of its contents
+     * @param data pointer to the first bytes of the file
+     * @param size number of bytes available
+     * @return result of the probe
+     */
+    static Probe probe(const char *data, size_t size);
+
+    /**
+     * @brief Classify a file from the first ProbeSize bytes of a stream
+     * @param istream stream positioned at the start of the file
+     * @return result of the probe
+     *
+     * The bytes are read into a buffer on the stack.
+     */
+    static Probe probe(std::istream &istream);
+
+    Format format() const;
+
+    /**
+     * @brief Determine if the file is a PE32 or PE32+ image
+     */
+    bool isPE() const;
+
+    /**
+     * @brief Determine if the image contains a CLR header (.NET assembly)
+     */
+    bool isDotNet() const;
+
+    /**
+     * @brief Retrieve the offset of the extended (NE, LE or PE) header
+     * @return offset or 0 if not present
+     */
+    uint32_t headerOffset() const;
+
+    /**
+     * @brief Retrieve the machine type (see FileHeader) of a PE image
+     */
+    uint16_t machine() const;
+
+    /**
+     * @brief Retrieve the subsystem (see OptionalHeader) of a PE image
+     */
+    uint16_t subsystem() const;
+
+private:
+
+    Format mFormat;
+    bool mDotNet;
+    uint32_t mHeaderOffset;
+    uint16_t mMachine;
+    uint16_t mSubsystem;
+};
+
+}
+
+#endif // WIN32PE_PROBE_H
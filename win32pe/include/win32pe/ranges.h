@@ -0,0 +1,188 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_RANGES_H
+#define WIN32PE_RANGES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include <win32pe/importtable.h>
+#include <win32pe/sectionref.h>
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class File;
+class SectionTable;
+struct ImageClass;
+
+/**
+ * @brief Pair of iterators usable with range-based for
+ */
+template<typename Iterator>
+class Range
+{
+public:
+
+    Range(const Iterator &begin, const Iterator &end)
+        : mBegin(begin),
+          mEnd(end)
+    {
+    }
+
+    Iterator begin() const { return mBegin; }
+    Iterator end() const { return mEnd; }
+    bool empty() const { return mBegin == mEnd; }
+
+private:
+
+    Iterator mBegin;
+    Iterator mEnd;
+};
+
+// Each of the iterators below decodes one entry at a time directly from the
+// file's data, so iterating allocates nothing and stopping early costs only
+// the entries visited. Like SectionRef, they are only valid until the file
+// is modified, reloaded, or destroyed.
+
+/**
+ * @brief Iterator over the sections of a file
+ */
+class WIN32PE_EXPORT SectionIterator
+{
+public:
+
+    typedef std::forward_iterator_tag iterator_category;
+    typedef SectionRef value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const SectionRef *pointer;
+    typedef SectionRef reference;
+
+    SectionIterator();
+
+    SectionRef operator*() const;
+    SectionIterator &operator++();
+    SectionIterator operator++(int);
+
+    bool operator==(const SectionIterator &other) const;
+    bool operator!=(const SectionIterator &other) const;
+
+private:
+
+    SectionIterator(const SectionTable *table, size_t index);
+
+    const SectionTable *mTable;
+    size_t mIndex;
+
+    friend class File;
+};
+
+/**
+ * @brief Iterator over the import descriptors of a file
+ *
+ * Iteration ends at the null descriptor or the end of the section.
+ */
+class WIN32PE_EXPORT ImportDescriptorIterator
+{
+public:
+
+    typedef std::forward_iterator_tag iterator_category;
+    typedef ImportTable::Item value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const ImportTable::Item *pointer;
+    typedef const ImportTable::Item &reference;
+
+    ImportDescriptorIterator();
+
+    const ImportTable::Item &operator*() const;
+    const ImportTable::Item *operator->() const;
+    ImportDescriptorIterator &operator++();
+    ImportDescriptorIterator operator++(int);
+
+    bool operator==(const ImportDescriptorIterator &other) const;
+    bool operator!=(const ImportDescriptorIterator &other) const;
+
+private:
+
+    ImportDescriptorIterator(const char *data, size_t size);
+
+    void decode();
+
+    const char *mData;
+    size_t mSize;
+    size_t mOffset;
+    ImportTable::Item mItem;
+
+    friend class File;
+};
+
+/**
+ * @brief Iterator over the functions imported by an import descriptor
+ *
+ * Iteration ends at the null thunk or the end of the section.
+ */
+class WIN32PE_EXPORT ImportFunctionIterator
+{
+public:
+
+    typedef std::forward_iterator_tag iterator_category;
+    typedef ImportTable::FunctionRef value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const ImportTable::FunctionRef *pointer;
+    typedef const ImportTable::FunctionRef &reference;
+
+    ImportFunctionIterator();
+
+    const ImportTable::FunctionRef &operator*() const;
+    const ImportTable::FunctionRef *operator->() const;
+    ImportFunctionIterator &operator++();
+    ImportFunctionIterator operator++(int);
+
+    bool operator==(const ImportFunctionIterator &other) const;
+    bool operator!=(const ImportFunctionIterator &other) const;
+
+private:
+
+    ImportFunctionIterator(const File *file, const ImageClass *image, const char *data, size_t size);
+    ImportFunctionIterator(const ImportTable::Function *functions, size_t count);
+
+    void decode();
+
+    const File *mFile;
+    const ImageClass *mImage;
+    const ImportTable::Function *mFunctions;
+    const char *mData;
+    size_t mSize;
+    size_t mOffset;
+    ImportTable::FunctionRef mFunction;
+
+    friend class File;
+};
+
+}
+
+#endif // WIN32PE_RANGES_H
@@ -25,6 +25,7 @@
 #ifndef WIN32PE_SECTION_H
 #define WIN32PE_SECTION_H
 
+#include <cstdint>
 #include <string>
 
 #include <win32pe/win32pe.h>
@@ -41,6 +42,19 @@ class WIN32PE_EXPORT Section
 {
 public:
 
+    enum {
+        ContainsCode              = 0x00000020,
+        ContainsInitializedData   = 0x00000040,
+        ContainsUninitializedData = 0x00000080,
+        MemoryDiscardable         = 0x02000000,
+        MemoryNotCached           = 0x04000000,
+        MemoryNotPaged            = 0x08000000,
+        MemoryShared              = 0x10000000,
+        MemoryExecute             = 0x20000000,
+        MemoryRead                = 0x40000000,
+        MemoryWrite               = 0x80000000
+    };
+
     Section();
     Section(const Section &other);
     virtual ~Section();
@@ -48,6 +62,11 @@ public:
     Section &operator=(const Section &other);
 
     std::string name() const;
+    uint32_t virtualSize() const;
+    uint32_t virtualAddress() const;
+    uint32_t sizeOfRawData() const;
+    uint32_t pointerToRawData() const;
+    uint32_t characteristics() const;
     const std::string &data() const;
 
     /**
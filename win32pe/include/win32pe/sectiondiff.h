@@ -0,0 +1,161 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_SECTIONDIFF_H
+#define WIN32PE_SECTIONDIFF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class File;
+class SectionRef;
+
+class WIN32PE_EXPORT SectionDiffPrivate;
+
+/**
+ * @brief Binary diff of the sections of two versions of a PE file
+ *
+ * Sections are paired by name and characteristics (in table order when a
+ * name repeats). The data of each pair is split into content-defined chunks
+ * with a rolling hash, so that an insertion only changes the chunks around
+ * it, and chunks of the new section are matched against those of the old
+ * one through a hash table. Matched chunks at a different offset within the
+ * section are reported as moved, the rest of the new section as inserted
+ * and any of the old section left unmatched as deleted; sections without a
+ * partner are inserted or deleted as a whole.
+ *
+ * Section data is chunked in place, so mapped files are not copied, and the
+ * pairs are diffed in parallel.
+ */
+class WIN32PE_EXPORT SectionDiff
+{
+public:
+
+    enum Kind {
+        Moved,
+        Inserted,
+        Deleted
+    };
+
+    struct Change
+    {
+        /// type of change
+        Kind kind;
+
+        /// name of the section
+        std::string section;
+
+        /// RVA in the old file (unless the data was inserted)
+        uint32_t oldRva;
+
+        /// RVA in the new file (unless the data was deleted)
+        uint32_t newRva;
+
+        /// number of bytes
+        uint32_t size;
+    };
+
+    struct Chunk
+    {
+        /// RVA of the first byte
+        uint32_t rva;
+
+        /// number of bytes
+        uint32_t size;
+
+        /// XXH64 of the data
+        uint64_t hash;
+    };
+
+    SectionDiff();
+    SectionDiff(const SectionDiff &other);
+    virtual ~SectionDiff();
+
+    SectionDiff &operator=(const SectionDiff &other);
+
+    /**
+     * @brief Set the average size of a chunk
+     * @param size size in bytes, rounded down to a power of two of at least
+     *        64 (default is 4096)
+     *
+     * Chunks are between a quarter of and four times this size.
+     */
+    void setAverageChunkSize(uint32_t size);
+    uint32_t averageChunkSize() const;
+
+    /**
+     * @brief Set the number of threads used to diff sections
+     * @param threads number of threads (0 for one per core, the default)
+     */
+    void setThreadCount(size_t threads);
+    size_t threadCount() const;
+
+    /**
+     * @brief Split a section's data into content-defined chunks
+     * @param section section to split
+     * @return chunks in order
+     *
+     * Identical data produces identical chunks regardless of where it is
+     * found, so the hashes can be used to share storage between versions.
+     */
+    std::vector<Chunk> chunks(const SectionRef &section) const;
+
+    /**
+     * @brief Compute the changes between two files
+     * @param oldFile original file
+     * @param newFile modified file
+     * @return true if the files could be compared
+     */
+    bool diff(const File &oldFile, const File &newFile);
+
+    /**
+     * @brief Retrieve the changes found by the last call to diff()
+     * @return changes grouped by section (in the new file's order, followed
+     *         by deleted sections) - within a section, moved and inserted
+     *         ranges are ordered by new RVA and followed by deleted ranges
+     *         ordered by old RVA
+     */
+    const std::vector<Change> &changes() const;
+
+    /**
+     * @brief Retrieve a description of the last error
+     * @return description or empty string if no error has occurred
+     */
+    std::string errorString() const;
+
+private:
+
+    SectionDiffPrivate *const d;
+};
+
+}
+
+#endif // WIN32PE_SECTIONDIFF_H
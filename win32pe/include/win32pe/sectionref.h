@@ -0,0 +1,107 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_SECTIONREF_H
+#define WIN32PE_SECTIONREF_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/utility/string_ref.hpp>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class SectionTable;
+struct SectionEntry;
+
+/**
+ * @brief Lightweight reference to a section of a loaded file
+ *
+ * Unlike Section, a reference is a pair of pointers into the file's section
+ * table, so obtaining and copying one is free and the data is a view rather
+ * than a copy. A reference is only valid until the file is modified,
+ * reloaded, or destroyed.
+ */
+class WIN32PE_EXPORT SectionRef
+{
+public:
+
+    /**
+     * @brief Create a null reference
+     */
+    SectionRef();
+
+    /**
+     * @brief Determine if the reference does not refer to a section
+     */
+    bool isNull() const;
+
+    /**
+     * @brief Retrieve the section name (without trailing NULs)
+     */
+    boost::string_ref name() const;
+
+    uint32_t virtualSize() const;
+    uint32_t virtualAddress() const;
+    uint32_t sizeOfRawData() const;
+    uint32_t pointerToRawData() const;
+    uint32_t characteristics() const;
+
+    /**
+     * @brief Access the raw data of the section
+     * @return view of the data or an empty view if it was not loaded
+     */
+    boost::string_ref data() const;
+
+    /**
+     * @brief Determine if the section contains the specified RVA
+     * @param rva relative virtual address
+     * @return true if the section contains the RVA
+     */
+    bool containsRVA(uint32_t rva) const;
+
+    /**
+     * @brief Convert an RVA to an offset within the section data
+     * @param rva relative virtual address
+     * @return offset of the RVA
+     */
+    uint32_t rvaToOffset(uint32_t rva) const;
+
+private:
+
+    SectionRef(const SectionTable *table, const SectionEntry *entry);
+
+    const SectionTable *mTable;
+    const SectionEntry *mEntry;
+
+    friend class File;
+    friend class SectionIterator;
+};
+
+}
+
+#endif // WIN32PE_SECTIONREF_H
@@ -0,0 +1,167 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_STRINGSCANNER_H
+#define WIN32PE_STRINGSCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <boost/utility/string_ref.hpp>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class Section;
+class SectionRef;
+
+class WIN32PE_EXPORT StringScannerPrivate;
+
+/**
+ * @brief Extract runs of printable characters from raw data
+ *
+ * This is the equivalent of strings(1) - printable ASCII (including tabs)
+ * and UTF-16LE runs at least minimumLength() characters long are reported.
+ * Values are views into the scanned buffer and are only valid for as long as
+ * the buffer is.
+ */
+class WIN32PE_EXPORT StringScanner
+{
+public:
+
+    enum {
+        ASCII   = 0x1,
+        UTF16LE = 0x2
+    };
+
+    struct Item
+    {
+        /// ASCII or UTF16LE
+        int encoding;
+
+        /// offset of the first byte relative to the scan base
+        uint64_t offset;
+
+        /// RVA of the first byte or 0 if the data is not mapped into the image
+        uint32_t rva;
+
+        /// raw bytes (two per character for UTF16LE)
+        boost::string_ref value;
+    };
+
+    /**
+     * @brief Callback invoked for each string found
+     *
+     * Returning false stops the scan.
+     */
+    typedef std::function<bool(const Item &item)> Callback;
+
+    StringScanner();
+    StringScanner(const StringScanner &other);
+    virtual ~StringScanner();
+
+    StringScanner &operator=(const StringScanner &other);
+
+    /**
+     * @brief Set the minimum length (in characters) of a reported string
+     * @param length minimum length (default is 4)
+     */
+    void setMinimumLength(size_t length);
+    size_t minimumLength() const;
+
+    /**
+     * @brief Set the encodings that should be reported
+     * @param encodings combination of ASCII and UTF16LE (default is both)
+     */
+    void setEncodings(int encodings);
+    int encodings() const;
+
+    /**
+     * @brief Scan a buffer, invoking a callback for each string
+     * @param data pointer to the data
+     * @param size number of bytes to scan
+     * @param offset value added to the offset of each item
+     * @param callback function invoked for each string
+     * @return false if the callback stopped the scan
+     *
+     * No results are accumulated, making this suitable for very large
+     * buffers such as a memory-mapped overlay.
+     */
+    bool scan(const char *data, size_t size, uint64_t offset, const Callback &callback) const;
+
+    /**
+     * @brief Scan a section's data, invoking a callback for each string
+     * @param section section to scan
+     * @param callback function invoked for each string
+     * @return false if the callback stopped the scan
+     *
+     * Offsets are file offsets and RVAs are filled in.
+     */
+    bool scan(const Section &section, const Callback &callback) const;
+
+    /**
+     * @brief Scan a section's data in place, invoking a callback for each string
+     * @param section reference to a section of a loaded file
+     * @param callback function invoked for each string
+     * @return false if the callback stopped the scan
+     *
+     * Unlike the Section overload, the data is not copied out of the file.
+     * Offsets are file offsets and RVAs are filled in.
+     */
+    bool scan(const SectionRef &section, const Callback &callback) const;
+
+    /**
+     * @brief Scan a buffer and collect the strings
+     * @param data pointer to the data
+     * @param size number of bytes to scan
+     * @return vector containing the strings
+     */
+    std::vector<Item> scan(const char *data, size_t size) const;
+
+    /**
+     * @brief Scan a section's data and collect the strings
+     * @param section section to scan
+     * @return vector containing the strings
+     */
+    std::vector<Item> scan(const Section &section) const;
+
+    /**
+     * @brief Scan a section's data in place and collect the strings
+     * @param section reference to a section of a loaded file
+     * @return vector containing the strings
+     */
+    std::vector<Item> scan(const SectionRef &section) const;
+
+private:
+
+    StringScannerPrivate *const d;
+};
+
+}
+
+#endif // WIN32PE_STRINGSCANNER_H
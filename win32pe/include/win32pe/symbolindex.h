@@ -0,0 +1,86 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_SYMBOLINDEX_H
+#define WIN32PE_SYMBOLINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <win32pe/symboltable.h>
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+class File;
+
+class WIN32PE_EXPORT SymbolIndexPrivate;
+
+/**
+ * @brief Address-sorted index of a file's symbols
+ *
+ * Building the index sorts every symbol defined in a section by RVA so that
+ * the nearest symbol for an address can be found with a binary search. The
+ * index refers to the file's data and is only valid for as long as the File.
+ */
+class WIN32PE_EXPORT SymbolIndex
+{
+public:
+
+    SymbolIndex();
+    SymbolIndex(const SymbolIndex &other);
+    virtual ~SymbolIndex();
+
+    SymbolIndex &operator=(const SymbolIndex &other);
+
+    /**
+     * @brief Build the index for a file
+     * @param file file containing the symbol table
+     */
+    void build(const File &file);
+
+    /**
+     * @brief Retrieve the number of indexed symbols
+     * @return number of symbols
+     */
+    size_t size() const;
+
+    /**
+     * @brief Find the symbol at or immediately preceding an RVA
+     * @param rva relative virtual address
+     * @param symbol set to the symbol that was found
+     * @param displacement set to the distance between the symbol and the RVA
+     * @return true if a symbol was found
+     */
+    bool lookup(uint32_t rva, SymbolTable::Symbol &symbol, uint32_t &displacement) const;
+
+private:
+
+    SymbolIndexPrivate *const d;
+};
+
+}
+
+#endif // WIN32PE_SYMBOLINDEX_H
@@ -0,0 +1,196 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_SYMBOLTABLE_H
+#define WIN32PE_SYMBOLTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include <boost/utility/string_ref.hpp>
+
+#include <win32pe/win32pe.h>
+
+namespace win32pe
+{
+
+/**
+ * @brief COFF symbol table
+ *
+ * This is a lightweight view over the raw symbol and string tables - records
+ * are decoded as they are iterated and nothing is allocated. The view is only
+ * valid for as long as the File (or object data) it was obtained from.
+ *
+ * File only loads images, which must begin with MZ and PE headers, so the
+ * symbol table of a COFF object file (.obj) is read with fromObject()
+ * instead. Import libraries and /bigobj objects are not supported.
+ */
+class WIN32PE_EXPORT SymbolTable
+{
+public:
+
+    enum {
+        RecordSize = 18
+    };
+
+    enum {
+        Undefined = 0,
+        Absolute  = -1,
+        Debug     = -2
+    };
+
+    enum {
+        External = 2,
+        Static   = 3,
+        Label    = 6,
+        Function = 101,
+        FileName = 103,
+        Section  = 104
+    };
+
+    /**
+     * @brief Symbol record (excluding auxiliary records)
+     */
+    class WIN32PE_EXPORT Symbol
+    {
+    public:
+
+        Symbol();
+        Symbol(const char *record, boost::string_ref strings, uint32_t index);
+
+        /**
+         * @brief Retrieve the symbol's name
+         * @return short name or long name from the string table
+         */
+        boost::string_ref name() const;
+
+        uint32_t value() const;
+        int16_t sectionNumber() const;
+        uint16_t type() const;
+        uint8_t storageClass() const;
+        uint8_t numberOfAuxSymbols() const;
+
+        /**
+         * @brief Access one of the auxiliary records following the symbol
+         * @param i index of the auxiliary record
+         * @return raw record
+         *
+         * The index must be less than numberOfAuxSymbols().
+         */
+        boost::string_ref auxRecord(uint8_t i) const;
+
+        /**
+         * @brief Retrieve the index of the record in the symbol table
+         * @return index
+         */
+        uint32_t index() const;
+
+    private:
+
+        const char *mRecord;
+        boost::string_ref mStrings;
+        uint32_t mIndex;
+    };
+
+    class WIN32PE_EXPORT const_iterator
+    {
+    public:
+
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Symbol value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Symbol *pointer;
+        typedef const Symbol &reference;
+
+        const_iterator();
+        const_iterator(boost::string_ref symbols, boost::string_ref strings, uint32_t index);
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        const_iterator &operator++();
+        const_iterator operator++(int);
+
+        bool operator==(const const_iterator &other) const;
+        bool operator!=(const const_iterator &other) const;
+
+    private:
+
+        void decode();
+
+        boost::string_ref mSymbols;
+        boost::string_ref mStrings;
+        uint32_t mIndex;
+        Symbol mSymbol;
+    };
+
+    SymbolTable();
+    SymbolTable(boost::string_ref symbols, boost::string_ref strings);
+
+    /**
+     * @brief Create a view over the symbol table of a COFF object file
+     * @param data contents of the object file
+     * @param table view to initialize
+     * @return true if the data has a symbol table
+     *
+     * The symbols must lie within the data; the string table is truncated
+     * to it. The view refers to the data, which must outlive it.
+     */
+    static bool fromObject(boost::string_ref data, SymbolTable &table);
+
+    /**
+     * @brief Retrieve the number of records (including auxiliary records)
+     * @return number of records
+     */
+    uint32_t size() const;
+    bool empty() const;
+
+    /**
+     * @brief Decode the record at the specified index
+     * @param index index of the record
+     * @return symbol
+     *
+     * The index must be less than size().
+     */
+    Symbol at(uint32_t index) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     * @brief Access the raw string table
+     * @return string table including the leading size field
+     */
+    boost::string_ref strings() const;
+
+private:
+
+    boost::string_ref mSymbols;
+    boost::string_ref mStrings;
+};
+
+}
+
+#endif // WIN32PE_SYMBOLTABLE_H
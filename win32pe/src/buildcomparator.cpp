@@ -0,0 +1,339 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include <win32pe/buildcomparator.h>
+#include <win32pe/file.h>
+#include <win32pe/optionalheader.h>
+#include <win32pe/sectionref.h>
+
+#include "buildcomparator_p.h"
+#include "endian_p.h"
+#include "file_p.h"
+#include "structs_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+const uint32_t DefaultChunkSize = 4096;
+
+const uint32_t TimeDateStampOffset = sizeof(uint32_t) + offsetof(RawFileHeader, timeDateStamp);
+const uint32_t CheckSumOffset = sizeof(uint32_t) + sizeof(RawFileHeader) + offsetof(RawOptionalHeader32, checkSum);
+
+// The Rich header is a list of (tool, count) pairs between "DanS" and
+// "Rich" in the DOS stub, each dword XORed with the key following "Rich"
+const uint32_t DanSSignature = 0x536e6144;
+const uint32_t RichSignature = 0x68636952;
+
+const uint32_t CodeViewType = 2;
+const uint32_t RSDSSignature = 0x53445352;
+const uint32_t NB10Signature = 0x3031424e;
+
+typedef BuildComparator::Difference Extent;
+
+void zero(std::string &data, size_t offset, size_t size)
+{
+    if (offset < data.size()) {
+        memset(&data[offset], 0, std::min(size, data.size() - offset));
+    }
+}
+
+void writeDword(std::string &data, size_t offset, uint32_t value)
+{
+    le32 raw;
+    raw = value;
+    memcpy(&data[offset], &raw, sizeof(raw));
+}
+
+// Data at an RVA, up to the end of the section's data
+boost::string_ref rvaData(const File &file, uint32_t rva)
+{
+    SectionRef section = file.rvaToSectionRef(rva);
+    if (section.isNull() || rva - section.virtualAddress() >= section.data().size()) {
+        return boost::string_ref();
+    }
+    return section.data().substr(rva - section.virtualAddress());
+}
+
+// Number of bytes of a section that are mapped from its raw data
+uint32_t mappedSize(const SectionRef &section)
+{
+    uint32_t size = static_cast<uint32_t>(section.data().size());
+    return section.virtualSize() ? std::min(size, section.virtualSize()) : size;
+}
+
+}
+
+BuildComparatorPrivate::BuildComparatorPrivate()
+    : mChunkSize(DefaultChunkSize)
+{
+}
+
+void BuildComparatorPrivate::prepare(Image &image) const
+{
+    const File &file = *image.file;
+
+    image.masks.clear();
+    image.size = file.optionalHeader().sizeOfImage();
+
+    // The section table is part of the headers, so the image must cover them
+    image.size = std::max(image.size, static_cast<uint32_t>(image.headers.size()));
+
+    addDebugMasks(image);
+
+    std::sort(image.masks.begin(), image.masks.end(), [](const Extent &a, const Extent &b) {
+        return a.rva < b.rva;
+    });
+}
+
+void BuildComparatorPrivate::normalizeRichHeader(std::string &headers, uint32_t peOffset) const
+{
+    // Search backwards from the PE header for "Rich" and then for the
+    // encoded "DanS" that starts the list
+    size_t end = std::min<size_t>(peOffset, headers.size()) & ~size_t(3);
+    size_t rich = 0;
+    for (size_t offset = end; offset >= static_cast<size_t>(DOSHeaderSize) + 2 * sizeof(uint32_t); offset -= sizeof(uint32_t)) {
+        if (readLittle<uint32_t>(headers.data() + offset - 2 * sizeof(uint32_t)) == RichSignature) {
+            rich = offset - 2 * sizeof(uint32_t);
+            break;
+        }
+    }
+    if (!rich) {
+        return;
+    }
+
+    uint32_t key = readLittle<uint32_t>(headers.data() + rich + sizeof(uint32_t));
+    size_t start = 0;
+    for (size_t offset = rich; offset >= static_cast<size_t>(DOSHeaderSize) + sizeof(uint32_t); offset -= sizeof(uint32_t)) {
+        if ((readLittle<uint32_t>(headers.data() + offset - sizeof(uint32_t)) ^ key) == DanSSignature) {
+            start = offset - sizeof(uint32_t);
+            break;
+        }
+    }
+    if (!start) {
+        return;
+    }
+
+    // Decode every dword (the signature, three padding dwords and the tool
+    // IDs), clearing the counts and the key, which is a checksum of them
+    for (size_t offset = start; offset < rich; offset += sizeof(uint32_t)) {
+        uint32_t value = readLittle<uint32_t>(headers.data() + offset) ^ key;
+        bool isCount = offset >= start + 4 * sizeof(uint32_t) &&
+                       (offset - start) % (2 * sizeof(uint32_t)) == sizeof(uint32_t);
+        writeDword(headers, offset, isCount ? 0 : value);
+    }
+    writeDword(headers, rich + sizeof(uint32_t), 0);
+}
+
+void BuildComparatorPrivate::addDebugMasks(Image &image) const
+{
+    const File &file = *image.file;
+    const OptionalHeader::DataDirectoryItem &directory =
+        file.optionalHeader().dataDirectory()[OptionalHeader::DebuggingInformation];
+    boost::string_ref data = rvaData(file, directory.virtualAddress);
+    data = data.substr(0, directory.size);
+
+    const RawDebugDirectory *entry;
+    for (size_t offset = 0;
+            (entry = rawView<RawDebugDirectory>(data.data(), data.size(), offset));
+            offset += sizeof(*entry)) {
+        Extent mask;
+        mask.rva = directory.virtualAddress + static_cast<uint32_t>(offset + offsetof(RawDebugDirectory, timeDateStamp));
+        mask.size = sizeof(uint32_t);
+        image.masks.push_back(mask);
+
+        // CodeView information identifies the PDB by a GUID (or, in the
+        // older format, a timestamp) and an age
+        uint32_t rva = entry->addressOfRawData.value();
+        boost::string_ref info = rvaData(file, rva).substr(0, entry->sizeOfData.value());
+        if (entry->type.value() != CodeViewType || info.size() < 3 * sizeof(uint32_t)) {
+            continue;
+        }
+        uint32_t signature = readLittle<uint32_t>(info.data());
+        if (signature == RSDSSignature && info.size() >= 24) {
+            mask.rva = rva + 4;
+            mask.size = 20;
+            image.masks.push_back(mask);
+        } else if (signature == NB10Signature && info.size() >= 16) {
+            mask.rva = rva + 8;
+            mask.size = 8;
+            image.masks.push_back(mask);
+        }
+    }
+}
+
+const char *BuildComparatorPrivate::chunk(const Image &image, uint32_t base, uint32_t length, std::vector<char> &buffer) const
+{
+    const File &file = *image.file;
+    uint64_t end = static_cast<uint64_t>(base) + length;
+
+    auto mask = std::lower_bound(image.masks.begin(), image.masks.end(), base, [](const Extent &range, uint32_t rva) {
+        return static_cast<uint64_t>(range.rva) + range.size <= rva;
+    });
+    bool masked = mask != image.masks.end() && (*mask).rva < end;
+
+    // Refer to the section's data directly where possible
+    SectionRef section = file.rvaToSectionRef(base);
+    if (!masked && base >= image.headers.size() && !section.isNull() &&
+            end <= static_cast<uint64_t>(section.virtualAddress()) + mappedSize(section)) {
+        return section.data().data() + (base - section.virtualAddress());
+    }
+
+    // Otherwise assemble the chunk from the headers and every section that
+    // overlaps it, then clear the masked ranges
+    buffer.assign(length, '\0');
+    auto copy = [&](uint32_t rva, const char *data, uint32_t size) {
+        uint64_t first = std::max<uint64_t>(base, rva);
+        uint64_t last = std::min<uint64_t>(end, static_cast<uint64_t>(rva) + size);
+        if (first < last) {
+            memcpy(buffer.data() + (first - base), data + (first - rva), static_cast<size_t>(last - first));
+        }
+    };
+    copy(0, image.headers.data(), static_cast<uint32_t>(image.headers.size()));
+    for (const SectionRef &ref : file.sectionRefs()) {
+        copy(ref.virtualAddress(), ref.data().data(), mappedSize(ref));
+    }
+    for (; mask != image.masks.end() && (*mask).rva < end; ++mask) {
+        uint64_t first = std::max<uint64_t>(base, (*mask).rva);
+        uint64_t last = std::min<uint64_t>(end, static_cast<uint64_t>((*mask).rva) + (*mask).size);
+        memset(buffer.data() + (first - base), 0, static_cast<size_t>(last - first));
+    }
+    return buffer.data();
+}
+
+void BuildComparatorPrivate::addDifference(uint32_t rva, uint32_t size)
+{
+    // Extend the previous range if this one follows it directly
+    if (!mDifferences.empty() &&
+            static_cast<uint64_t>(mDifferences.back().rva) + mDifferences.back().size == rva) {
+        mDifferences.back().size += size;
+        return;
+    }
+    Extent range;
+    range.rva = rva;
+    range.size = size;
+    mDifferences.push_back(range);
+}
+
+BuildComparator::BuildComparator()
+    : d(new BuildComparatorPrivate)
+{
+}
+
+BuildComparator::BuildComparator(const BuildComparator &other)
+    : d(new BuildComparatorPrivate(*other.d))
+{
+}
+
+BuildComparator::~BuildComparator()
+{
+    delete d;
+}
+
+BuildComparator &BuildComparator::operator=(const BuildComparator &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+void BuildComparator::setChunkSize(uint32_t size)
+{
+    d->mChunkSize = size ? size : DefaultChunkSize;
+}
+
+uint32_t BuildComparator::chunkSize() const
+{
+    return d->mChunkSize;
+}
+
+bool BuildComparator::compare(const File &file, const File &other)
+{
+    d->mDifferences.clear();
+    d->mErrorString.clear();
+
+    if (!file.d->mImageClass || !other.d->mImageClass) {
+        d->mErrorString = "file is not loaded";
+        return false;
+    }
+
+    // The headers are serialized from the parsed values and then normalized
+    // - they are small enough that copying them costs nothing
+    BuildComparatorPrivate::Image images[2];
+    const File *files[2] = {&file, &other};
+    for (int i = 0; i < 2; ++i) {
+        BuildComparatorPrivate::Image &image = images[i];
+        image.file = files[i];
+        files[i]->d->writeHeaders(image.headers);
+        image.headers.append(files[i]->d->mHeaderSlack);
+        image.headers.resize(std::min<size_t>(image.headers.size(), files[i]->optionalHeader().sizeOfHeaders()));
+
+        uint32_t peOffset = static_cast<uint32_t>(files[i]->d->mDOSHeader.size());
+        zero(image.headers, peOffset + TimeDateStampOffset, sizeof(uint32_t));
+        zero(image.headers, peOffset + CheckSumOffset, sizeof(uint32_t));
+        d->normalizeRichHeader(image.headers, peOffset);
+
+        d->prepare(image);
+    }
+
+    // Compare a chunk at a time, narrowing chunks that differ down to the
+    // individual bytes
+    std::vector<char> buffers[2];
+    uint32_t size = std::max(images[0].size, images[1].size);
+    for (uint32_t base = 0; base < size; ) {
+        uint32_t length = std::min(d->mChunkSize, size - base);
+        const char *a = d->chunk(images[0], base, length, buffers[0]);
+        const char *b = d->chunk(images[1], base, length, buffers[1]);
+        if (memcmp(a, b, length)) {
+            for (uint32_t i = 0; i < length; ) {
+                if (a[i] == b[i]) {
+                    ++i;
+                    continue;
+                }
+                uint32_t first = i;
+                while (i < length && a[i] != b[i]) {
+                    ++i;
+                }
+                d->addDifference(base + first, i - first);
+            }
+        }
+        base += length;
+    }
+
+    return true;
+}
+
+const std::vector<BuildComparator::Difference> &BuildComparator::differences() const
+{
+    return d->mDifferences;
+}
+
+std::string BuildComparator::errorString() const
+{
+    return d->mErrorString;
+}
@@ -0,0 +1,71 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_BUILDCOMPARATOR_P_H
+#define WIN32PE_BUILDCOMPARATOR_P_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <win32pe/buildcomparator.h>
+
+namespace win32pe
+{
+
+class File;
+
+class BuildComparatorPrivate
+{
+public:
+
+    // A file prepared for comparison: normalized headers and the ranges
+    // within the sections to treat as zero (in the same form as differences),
+    // ordered by RVA
+
+    struct Image
+    {
+        const File *file;
+        std::string headers;
+        std::vector<BuildComparator::Difference> masks;
+        uint32_t size;
+    };
+
+    BuildComparatorPrivate();
+
+    void prepare(Image &image) const;
+    void normalizeRichHeader(std::string &headers, uint32_t peOffset) const;
+    void addDebugMasks(Image &image) const;
+    const char *chunk(const Image &image, uint32_t base, uint32_t length, std::vector<char> &buffer) const;
+    void addDifference(uint32_t rva, uint32_t size);
+
+    uint32_t mChunkSize;
+    std::vector<BuildComparator::Difference> mDifferences;
+
+    std::string mErrorString;
+};
+
+}
+
+#endif // WIN32PE_BUILDCOMPARATOR_P_H
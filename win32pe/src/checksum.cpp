@@ -0,0 +1,108 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include <boost/endian/conversion.hpp>
+
+#include "checksum_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+uint16_t fold(uint64_t sum)
+{
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(sum);
+}
+
+}
+
+Checksum::Checksum()
+    : mSum(0)
+{
+}
+
+void Checksum::add(uint64_t offset, const char *data, size_t size)
+{
+    mSum = fold(mSum + wordSum(offset, data, size));
+}
+
+void Checksum::remove(uint64_t offset, const char *data, size_t size)
+{
+    // Subtraction in ones' complement is addition of the complement; the sum
+    // of a file with any non-zero byte is never zero, so a zero result is the
+    // other representation of zero
+    mSum = fold(mSum + static_cast<uint16_t>(~fold(wordSum(offset, data, size))));
+    if (!mSum) {
+        mSum = 0xffff;
+    }
+}
+
+uint16_t Checksum::sum() const
+{
+    return static_cast<uint16_t>(mSum);
+}
+
+void Checksum::setSum(uint16_t sum)
+{
+    mSum = sum;
+}
+
+uint32_t Checksum::value(uint64_t fileSize) const
+{
+    return static_cast<uint32_t>(mSum + fileSize);
+}
+
+uint64_t Checksum::wordSum(uint64_t offset, const char *data, size_t size)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>(data);
+    uint64_t sum = 0;
+
+    // A byte at an odd offset is the high byte of its word
+    if (size && (offset & 1)) {
+        sum += static_cast<uint64_t>(*bytes) << 8;
+        ++bytes;
+        --size;
+    }
+
+    // Accumulate without folding - 64 bits cannot overflow for any file that
+    // fits in memory - which lets the compiler vectorize the loop
+    size_t words = size / 2;
+    for (size_t i = 0; i < words; ++i) {
+        uint16_t word;
+        memcpy(&word, bytes + i * 2, sizeof(word));
+        sum += boost::endian::little_to_native(word);
+    }
+
+    if (size & 1) {
+        sum += bytes[size - 1];
+    }
+
+    return sum;
+}
@@ -0,0 +1,86 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_CHECKSUM_P_H
+#define WIN32PE_CHECKSUM_P_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace win32pe
+{
+
+/**
+ * @brief PE image checksum
+ *
+ * The checksum is the ones' complement sum of the file's little-endian 16-bit
+ * words (with the CheckSum field itself taken as zero) plus the file size.
+ * Because the sum is associative, the contribution of any range of bytes can
+ * be removed and replaced, allowing the checksum to be updated after a patch
+ * without reading the rest of the file.
+ */
+class Checksum
+{
+public:
+
+    Checksum();
+
+    /**
+     * @brief Add a range of bytes to the sum
+     * @param offset file offset of the first byte (only the parity matters)
+     * @param data pointer to the bytes
+     * @param size number of bytes
+     */
+    void add(uint64_t offset, const char *data, size_t size);
+
+    /**
+     * @brief Remove a range of bytes previously included in the sum
+     */
+    void remove(uint64_t offset, const char *data, size_t size);
+
+    /**
+     * @brief Retrieve the folded 16-bit sum
+     */
+    uint16_t sum() const;
+
+    /**
+     * @brief Set the folded 16-bit sum (to resume from a stored checksum)
+     */
+    void setSum(uint16_t sum);
+
+    /**
+     * @brief Compute the checksum for a file of the specified size
+     */
+    uint32_t value(uint64_t fileSize) const;
+
+private:
+
+    static uint64_t wordSum(uint64_t offset, const char *data, size_t size);
+
+    uint64_t mSum;
+};
+
+}
+
+#endif // WIN32PE_CHECKSUM_P_H
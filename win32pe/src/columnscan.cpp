@@ -0,0 +1,195 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+#include "columnscan_p.h"
+#include "endian_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+const size_t BlockRows = 64;
+
+// Clear the bits for rows in [first, last) that fail a predicate; this is
+// used for partial blocks and when SSE2 is unavailable
+
+template<typename T, typename Predicate>
+void scanScalar(const char *column, size_t first, size_t last, uint64_t *bitmap, Predicate predicate)
+{
+    for (size_t row = first; row < last; ++row) {
+        if (!predicate(readLittle<T>(column + row * sizeof(T)))) {
+            bitmap[row / BlockRows] &= ~(static_cast<uint64_t>(1) << (row % BlockRows));
+        }
+    }
+}
+
+#ifdef __SSE2__
+
+inline __m128i load(const char *data)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+// Narrow the results of comparing 16 rows (two vectors of 16-bit or four
+// vectors of 32-bit lanes, each lane all ones or all zeroes) to 16 bits
+
+inline uint64_t narrow16(__m128i a, __m128i b)
+{
+    return static_cast<uint16_t>(_mm_movemask_epi8(_mm_packs_epi16(a, b)));
+}
+
+inline uint64_t narrow32(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+    return narrow16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+}
+
+#endif
+
+}
+
+void win32pe::scanMasked16(const char *column, size_t rows, uint16_t mask, uint16_t value, uint64_t *bitmap)
+{
+    size_t row = 0;
+
+#ifdef __SSE2__
+    const __m128i m = _mm_set1_epi16(static_cast<short>(mask));
+    const __m128i v = _mm_set1_epi16(static_cast<short>(value));
+    for (; row + BlockRows <= rows; row += BlockRows) {
+        const char *block = column + row * sizeof(uint16_t);
+        uint64_t match = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i a = _mm_cmpeq_epi16(_mm_and_si128(load(block + i * 32), m), v);
+            __m128i b = _mm_cmpeq_epi16(_mm_and_si128(load(block + i * 32 + 16), m), v);
+            match |= narrow16(a, b) << (i * 16);
+        }
+        bitmap[row / BlockRows] &= match;
+    }
+#endif
+
+    scanScalar<uint16_t>(column, row, rows, bitmap, [mask, value](uint16_t x) {
+        return (x & mask) == value;
+    });
+}
+
+void win32pe::scanRange16(const char *column, size_t rows, uint16_t min, uint16_t max, uint64_t *bitmap)
+{
+    size_t row = 0;
+
+#ifdef __SSE2__
+    // There are no unsigned comparisons, so values are biased into the
+    // signed range first
+    const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+    const __m128i lo = _mm_xor_si128(_mm_set1_epi16(static_cast<short>(min)), bias);
+    const __m128i hi = _mm_xor_si128(_mm_set1_epi16(static_cast<short>(max)), bias);
+    for (; row + BlockRows <= rows; row += BlockRows) {
+        const char *block = column + row * sizeof(uint16_t);
+        uint64_t outside = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i a = _mm_xor_si128(load(block + i * 32), bias);
+            __m128i b = _mm_xor_si128(load(block + i * 32 + 16), bias);
+            outside |= narrow16(
+                _mm_or_si128(_mm_cmplt_epi16(a, lo), _mm_cmpgt_epi16(a, hi)),
+                _mm_or_si128(_mm_cmplt_epi16(b, lo), _mm_cmpgt_epi16(b, hi))
+            ) << (i * 16);
+        }
+        bitmap[row / BlockRows] &= ~outside;
+    }
+#endif
+
+    scanScalar<uint16_t>(column, row, rows, bitmap, [min, max](uint16_t x) {
+        return x >= min && x <= max;
+    });
+}
+
+void win32pe::scanRange32(const char *column, size_t rows, uint32_t min, uint32_t max, uint64_t *bitmap)
+{
+    size_t row = 0;
+
+#ifdef __SSE2__
+    const __m128i bias = _mm_set1_epi32(static_cast<int>(0x80000000));
+    const __m128i lo = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(min)), bias);
+    const __m128i hi = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(max)), bias);
+    for (; row + BlockRows <= rows; row += BlockRows) {
+        const char *block = column + row * sizeof(uint32_t);
+        uint64_t outside = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i o[4];
+            for (int j = 0; j < 4; ++j) {
+                __m128i x = _mm_xor_si128(load(block + i * 64 + j * 16), bias);
+                o[j] = _mm_or_si128(_mm_cmplt_epi32(x, lo), _mm_cmpgt_epi32(x, hi));
+            }
+            outside |= narrow32(o[0], o[1], o[2], o[3]) << (i * 16);
+        }
+        bitmap[row / BlockRows] &= ~outside;
+    }
+#endif
+
+    scanScalar<uint32_t>(column, row, rows, bitmap, [min, max](uint32_t x) {
+        return x >= min && x <= max;
+    });
+}
+
+void win32pe::scanRange64(const char *column, size_t rows, uint64_t min, uint64_t max, uint64_t *bitmap)
+{
+    // SSE2 has no 64-bit comparisons; the scalar loop is auto-vectorized
+    // where wider instruction sets are enabled
+    scanScalar<uint64_t>(column, 0, rows, bitmap, [min, max](uint64_t x) {
+        return x >= min && x <= max;
+    });
+}
+
+void win32pe::scanRangeFloat(const char *column, size_t rows, float min, float max, uint64_t *bitmap)
+{
+    size_t row = 0;
+
+#ifdef __SSE2__
+    // Ordered comparisons are used so that NaN never matches
+    const __m128 lo = _mm_set1_ps(min);
+    const __m128 hi = _mm_set1_ps(max);
+    for (; row + BlockRows <= rows; row += BlockRows) {
+        const char *block = column + row * sizeof(float);
+        uint64_t match = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i m[4];
+            for (int j = 0; j < 4; ++j) {
+                __m128 x = _mm_castsi128_ps(load(block + i * 64 + j * 16));
+                m[j] = _mm_castps_si128(_mm_and_ps(_mm_cmpge_ps(x, lo), _mm_cmple_ps(x, hi)));
+            }
+            match |= narrow32(m[0], m[1], m[2], m[3]) << (i * 16);
+        }
+        bitmap[row / BlockRows] &= match;
+    }
+#endif
+
+    scanScalar<uint32_t>(column, row, rows, bitmap, [min, max](uint32_t bits) {
+        float x;
+        memcpy(&x, &bits, sizeof(x));
+        return x >= min && x <= max;
+    });
+}
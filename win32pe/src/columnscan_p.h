@@ -0,0 +1,46 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_COLUMNSCAN_P_H
+#define WIN32PE_COLUMNSCAN_P_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace win32pe
+{
+
+// Each scan clears the bits of rows that do not match in a bitmap holding
+// one bit per row (64 rows per word); columns hold little-endian values and
+// need not be aligned or padded
+
+void scanMasked16(const char *column, size_t rows, uint16_t mask, uint16_t value, uint64_t *bitmap);
+void scanRange16(const char *column, size_t rows, uint16_t min, uint16_t max, uint64_t *bitmap);
+void scanRange32(const char *column, size_t rows, uint32_t min, uint32_t max, uint64_t *bitmap);
+void scanRange64(const char *column, size_t rows, uint64_t min, uint64_t max, uint64_t *bitmap);
+void scanRangeFloat(const char *column, size_t rows, float min, float max, uint64_t *bitmap);
+
+}
+
+#endif // WIN32PE_COLUMNSCAN_P_H
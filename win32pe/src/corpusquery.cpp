@@ -0,0 +1,229 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <win32pe/corpusquery.h>
+#include <win32pe/corpusstore.h>
+
+#include "bits_p.h"
+#include "columnscan_p.h"
+#include "corpusquery_p.h"
+#include "corpusstore_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+// Evaluate the conditions of a query, producing a bitmap of matching rows
+
+std::vector<uint64_t> evaluate(const CorpusQueryPrivate *q, const CorpusStorePrivate *s)
+{
+    size_t rows = s->mRows;
+    std::vector<uint64_t> bitmap((rows + 63) / 64, ~static_cast<uint64_t>(0));
+    if (rows % 64) {
+        bitmap.back() = (static_cast<uint64_t>(1) << (rows % 64)) - 1;
+    }
+
+    if (q->mConditions & CorpusQueryPrivate::Machine) {
+        scanMasked16(s->column(CorpusStore::Machine), rows, 0xffff, q->mMachine, bitmap.data());
+    }
+    if (q->mConditions & CorpusQueryPrivate::Subsystem) {
+        scanMasked16(s->column(CorpusStore::Subsystem), rows, 0xffff, q->mSubsystem, bitmap.data());
+    }
+
+    // Required and excluded flags are checked together: the masked value
+    // must equal the required flags
+    if (q->mConditions & CorpusQueryPrivate::Characteristics) {
+        scanMasked16(s->column(CorpusStore::Characteristics), rows,
+                     q->mRequiredCharacteristics | q->mExcludedCharacteristics,
+                     q->mRequiredCharacteristics & ~q->mExcludedCharacteristics,
+                     bitmap.data());
+    }
+    if (q->mConditions & CorpusQueryPrivate::DllCharacteristics) {
+        scanMasked16(s->column(CorpusStore::DllCharacteristics), rows,
+                     q->mRequiredDllCharacteristics | q->mExcludedDllCharacteristics,
+                     q->mRequiredDllCharacteristics & ~q->mExcludedDllCharacteristics,
+                     bitmap.data());
+    }
+
+    if (q->mConditions & CorpusQueryPrivate::TimeDateStamp) {
+        scanRange32(s->column(CorpusStore::TimeDateStamp), rows,
+                    q->mMinTimeDateStamp, q->mMaxTimeDateStamp, bitmap.data());
+    }
+    if (q->mConditions & CorpusQueryPrivate::NumberOfSections) {
+        scanRange16(s->column(CorpusStore::NumberOfSections), rows,
+                    q->mMinSections, q->mMaxSections, bitmap.data());
+    }
+    if (q->mConditions & CorpusQueryPrivate::Entropy) {
+        scanRangeFloat(s->column(CorpusStore::Entropy), rows,
+                       q->mMinEntropy, q->mMaxEntropy, bitmap.data());
+    }
+    if (q->mConditions & CorpusQueryPrivate::FileSize) {
+        scanRange64(s->column(CorpusStore::FileSize), rows,
+                    q->mMinFileSize, q->mMaxFileSize, bitmap.data());
+    }
+    if (q->mConditions & CorpusQueryPrivate::ImportHash) {
+        scanRange64(s->column(CorpusStore::ImportHash), rows,
+                    q->mImportHash, q->mImportHash, bitmap.data());
+    }
+
+    return bitmap;
+}
+
+}
+
+CorpusQueryPrivate::CorpusQueryPrivate()
+    : mConditions(0),
+      mMachine(0),
+      mSubsystem(0),
+      mRequiredCharacteristics(0),
+      mExcludedCharacteristics(0),
+      mRequiredDllCharacteristics(0),
+      mExcludedDllCharacteristics(0),
+      mMinTimeDateStamp(0),
+      mMaxTimeDateStamp(0),
+      mMinSections(0),
+      mMaxSections(0),
+      mMinEntropy(0),
+      mMaxEntropy(0),
+      mMinFileSize(0),
+      mMaxFileSize(0),
+      mImportHash(0)
+{
+}
+
+CorpusQuery::CorpusQuery()
+    : d(new CorpusQueryPrivate)
+{
+}
+
+CorpusQuery::CorpusQuery(const CorpusQuery &other)
+    : d(new CorpusQueryPrivate(*other.d))
+{
+}
+
+CorpusQuery::~CorpusQuery()
+{
+    delete d;
+}
+
+CorpusQuery &CorpusQuery::operator=(const CorpusQuery &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+void CorpusQuery::setMachine(uint16_t machine)
+{
+    d->mConditions |= CorpusQueryPrivate::Machine;
+    d->mMachine = machine;
+}
+
+void CorpusQuery::setSubsystem(uint16_t subsystem)
+{
+    d->mConditions |= CorpusQueryPrivate::Subsystem;
+    d->mSubsystem = subsystem;
+}
+
+void CorpusQuery::requireCharacteristics(uint16_t flags)
+{
+    d->mConditions |= CorpusQueryPrivate::Characteristics;
+    d->mRequiredCharacteristics |= flags;
+}
+
+void CorpusQuery::excludeCharacteristics(uint16_t flags)
+{
+    d->mConditions |= CorpusQueryPrivate::Characteristics;
+    d->mExcludedCharacteristics |= flags;
+}
+
+void CorpusQuery::requireDllCharacteristics(uint16_t flags)
+{
+    d->mConditions |= CorpusQueryPrivate::DllCharacteristics;
+    d->mRequiredDllCharacteristics |= flags;
+}
+
+void CorpusQuery::excludeDllCharacteristics(uint16_t flags)
+{
+    d->mConditions |= CorpusQueryPrivate::DllCharacteristics;
+    d->mExcludedDllCharacteristics |= flags;
+}
+
+void CorpusQuery::setTimeDateStampRange(uint32_t min, uint32_t max)
+{
+    d->mConditions |= CorpusQueryPrivate::TimeDateStamp;
+    d->mMinTimeDateStamp = min;
+    d->mMaxTimeDateStamp = max;
+}
+
+void CorpusQuery::setSectionCountRange(uint16_t min, uint16_t max)
+{
+    d->mConditions |= CorpusQueryPrivate::NumberOfSections;
+    d->mMinSections = min;
+    d->mMaxSections = max;
+}
+
+void CorpusQuery::setEntropyRange(float min, float max)
+{
+    d->mConditions |= CorpusQueryPrivate::Entropy;
+    d->mMinEntropy = min;
+    d->mMaxEntropy = max;
+}
+
+void CorpusQuery::setFileSizeRange(uint64_t min, uint64_t max)
+{
+    d->mConditions |= CorpusQueryPrivate::FileSize;
+    d->mMinFileSize = min;
+    d->mMaxFileSize = max;
+}
+
+void CorpusQuery::setImportHash(uint64_t hash)
+{
+    d->mConditions |= CorpusQueryPrivate::ImportHash;
+    d->mImportHash = hash;
+}
+
+std::vector<uint32_t> CorpusQuery::run(const CorpusStore &store) const
+{
+    std::vector<uint64_t> bitmap = evaluate(d, store.d);
+
+    std::vector<uint32_t> rows;
+    for (size_t i = 0; i < bitmap.size(); ++i) {
+        for (uint64_t word = bitmap[i]; word; word &= word - 1) {
+            rows.push_back(static_cast<uint32_t>(i * 64 + countTrailingZeros(word)));
+        }
+    }
+    return rows;
+}
+
+size_t CorpusQuery::count(const CorpusStore &store) const
+{
+    std::vector<uint64_t> bitmap = evaluate(d, store.d);
+
+    size_t count = 0;
+    for (size_t i = 0; i < bitmap.size(); ++i) {
+        count += popCount(bitmap[i]);
+    }
+    return count;
+}
@@ -0,0 +1,76 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_CORPUSQUERY_P_H
+#define WIN32PE_CORPUSQUERY_P_H
+
+#include <cstdint>
+
+namespace win32pe
+{
+
+class CorpusQueryPrivate
+{
+public:
+
+    // Conditions that have been set
+    enum {
+        Machine               = 0x001,
+        Subsystem             = 0x002,
+        Characteristics       = 0x004,
+        DllCharacteristics    = 0x008,
+        TimeDateStamp         = 0x010,
+        NumberOfSections      = 0x020,
+        Entropy               = 0x040,
+        FileSize              = 0x080,
+        ImportHash            = 0x100
+    };
+
+    CorpusQueryPrivate();
+
+    int mConditions;
+
+    uint16_t mMachine;
+    uint16_t mSubsystem;
+
+    uint16_t mRequiredCharacteristics;
+    uint16_t mExcludedCharacteristics;
+    uint16_t mRequiredDllCharacteristics;
+    uint16_t mExcludedDllCharacteristics;
+
+    uint32_t mMinTimeDateStamp;
+    uint32_t mMaxTimeDateStamp;
+    uint16_t mMinSections;
+    uint16_t mMaxSections;
+    float mMinEntropy;
+    float mMaxEntropy;
+    uint64_t mMinFileSize;
+    uint64_t mMaxFileSize;
+
+    uint64_t mImportHash;
+};
+
+}
+
+#endif // WIN32PE_CORPUSQUERY_P_H
@@ -0,0 +1,351 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <boost/interprocess/file_mapping.hpp>
+
+#include <win32pe/corpusstore.h>
+#include <win32pe/file.h>
+#include <win32pe/fileheader.h>
+#include <win32pe/importtable.h>
+#include <win32pe/optionalheader.h>
+#include <win32pe/sectionref.h>
+
+#include "align_p.h"
+#include "corpusstore_p.h"
+#include "endian_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+// The store begins with a signature (which includes the format version), the
+// number of files and columns, the offset of each column and the offset and
+// size of the path data; columns are aligned for the benefit of SIMD loads
+
+const char Signature[] = "W32PECS2";
+const size_t SignatureSize = 8;
+const uint32_t ColumnAlignment = 64;
+
+const uint64_t FNVOffsetBasis = 0xcbf29ce484222325ULL;
+const uint64_t FNVPrime = 0x100000001b3ULL;
+
+float sectionEntropy(const File &file)
+{
+    uint64_t counts[256] = {};
+    uint64_t total = 0;
+    for (size_t i = 0; i < file.sectionCount(); ++i) {
+        boost::string_ref data = file.section(i).data();
+        for (size_t j = 0; j < data.size(); ++j) {
+            ++counts[static_cast<unsigned char>(data[j])];
+        }
+        total += data.size();
+    }
+
+    double value = 0;
+    for (int i = 0; i < 256; ++i) {
+        if (counts[i]) {
+            double p = static_cast<double>(counts[i]) / total;
+            value -= p * std::log2(p);
+        }
+    }
+    return static_cast<float>(value);
+}
+
+}
+
+const size_t CorpusStorePrivate::Widths[StoredColumnCount] = {
+    sizeof(uint16_t),  // Machine
+    sizeof(uint16_t),  // Characteristics
+    sizeof(uint16_t),  // Subsystem
+    sizeof(uint16_t),  // DllCharacteristics
+    sizeof(uint32_t),  // TimeDateStamp
+    sizeof(uint16_t),  // NumberOfSections
+    sizeof(float),     // Entropy
+    sizeof(uint64_t),  // ImportHash
+    sizeof(uint64_t),  // FileSize
+    sizeof(uint64_t)   // PathEnd
+};
+
+CorpusStorePrivate::CorpusStorePrivate()
+    : mRows(0),
+      mMappedPaths(nullptr),
+      mMappedPathsSize(0)
+{
+    memset(mMappedColumns, 0, sizeof(mMappedColumns));
+}
+
+const char *CorpusStorePrivate::column(int column) const
+{
+    return mRegion ? mMappedColumns[column] : mColumns[column].data();
+}
+
+void CorpusStorePrivate::makeWritable()
+{
+    if (!mRegion) {
+        return;
+    }
+    for (int i = 0; i < StoredColumnCount; ++i) {
+        mColumns[i].assign(mMappedColumns[i], mRows * Widths[i]);
+    }
+    mPaths.assign(mMappedPaths, static_cast<size_t>(mMappedPathsSize));
+    mRegion.reset();
+}
+
+void CorpusStorePrivate::close()
+{
+    mRegion.reset();
+    mRows = 0;
+    for (int i = 0; i < StoredColumnCount; ++i) {
+        mColumns[i].clear();
+    }
+    mPaths.clear();
+}
+
+CorpusStore::CorpusStore()
+    : d(new CorpusStorePrivate)
+{
+}
+
+CorpusStore::~CorpusStore()
+{
+    delete d;
+}
+
+void CorpusStore::add(const std::string &path, const File &file)
+{
+    d->makeWritable();
+
+    appendLittle(d->mColumns[Machine], file.fileHeader().machine());
+    appendLittle(d->mColumns[Characteristics], file.fileHeader().characteristics());
+    appendLittle(d->mColumns[Subsystem], file.optionalHeader().subsystem());
+    appendLittle(d->mColumns[DllCharacteristics], file.optionalHeader().dllCharacteristics());
+    appendLittle(d->mColumns[TimeDateStamp], file.fileHeader().timeDateStamp());
+    appendLittle(d->mColumns[NumberOfSections], static_cast<uint16_t>(file.sectionCount()));
+
+    float value = sectionEntropy(file);
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    appendLittle(d->mColumns[Entropy], bits);
+
+    appendLittle(d->mColumns[ImportHash], importHash(file));
+    appendLittle(d->mColumns[FileSize], file.fileSize());
+
+    d->mPaths.append(path);
+    appendLittle(d->mColumns[CorpusStorePrivate::PathEnd], static_cast<uint64_t>(d->mPaths.size()));
+
+    ++d->mRows;
+}
+
+bool CorpusStore::save(const std::string &filename)
+{
+    const int count = CorpusStorePrivate::StoredColumnCount;
+
+    std::string header(Signature, SignatureSize);
+    appendLittle(header, static_cast<uint32_t>(d->mRows));
+    appendLittle(header, static_cast<uint32_t>(count));
+
+    uint64_t offsets[count];
+    uint64_t offset = alignUp(header.size() + (count + 2) * sizeof(uint64_t), ColumnAlignment);
+    for (int i = 0; i < count; ++i) {
+        offsets[i] = offset;
+        appendLittle(header, offset);
+        offset = alignUp(offset + d->mRows * CorpusStorePrivate::Widths[i], ColumnAlignment);
+    }
+    uint64_t pathsSize = d->mRegion ? d->mMappedPathsSize : d->mPaths.size();
+    appendLittle(header, offset);
+    appendLittle(header, pathsSize);
+
+    // Write to a temporary file first since the store may be mapped
+    std::string tempFilename = filename + ".tmp";
+    {
+        std::ofstream ofstream(tempFilename, std::ios::binary | std::ios::trunc);
+        ofstream.write(header.data(), header.size());
+        uint64_t pos = header.size();
+        for (int i = 0; i < count; ++i) {
+            std::string padding(static_cast<size_t>(offsets[i] - pos), '\0');
+            ofstream.write(padding.data(), padding.size());
+            size_t size = d->mRows * CorpusStorePrivate::Widths[i];
+            ofstream.write(d->column(i), size);
+            pos = offsets[i] + size;
+        }
+        std::string padding(static_cast<size_t>(offset - pos), '\0');
+        ofstream.write(padding.data(), padding.size());
+        ofstream.write(d->mRegion ? d->mMappedPaths : d->mPaths.data(), pathsSize);
+        if (!ofstream.flush()) {
+            d->mErrorString = "unable to write store";
+            std::remove(tempFilename.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tempFilename.c_str(), filename.c_str())) {
+        d->mErrorString = "unable to replace store";
+        std::remove(tempFilename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool CorpusStore::open(const std::string &filename)
+{
+    const int count = CorpusStorePrivate::StoredColumnCount;
+
+    d->close();
+
+    std::unique_ptr<boost::interprocess::mapped_region> region;
+    try {
+        boost::interprocess::file_mapping file(filename.c_str(), boost::interprocess::read_only);
+        region.reset(new boost::interprocess::mapped_region(file, boost::interprocess::read_only));
+    } catch (const boost::interprocess::interprocess_exception &) {
+        d->mErrorString = "unable to map store";
+        return false;
+    }
+
+    const char *data = static_cast<const char*>(region->get_address());
+    uint64_t size = region->get_size();
+    uint64_t headerSize = SignatureSize + 2 * sizeof(uint32_t) + (count + 2) * sizeof(uint64_t);
+    if (size < headerSize || memcmp(data, Signature, SignatureSize) ||
+            readLittle<uint32_t>(data + SignatureSize + sizeof(uint32_t)) != count) {
+        d->mErrorString = "store is invalid or from another version";
+        return false;
+    }
+
+    // Every column and the path data must lie within the file
+    uint64_t rows = readLittle<uint32_t>(data + SignatureSize);
+    const char *offsets = data + SignatureSize + 2 * sizeof(uint32_t);
+    for (int i = 0; i < count; ++i) {
+        uint64_t offset = readLittle<uint64_t>(offsets + i * sizeof(uint64_t));
+        if (offset > size || rows * CorpusStorePrivate::Widths[i] > size - offset) {
+            d->mErrorString = "store is corrupt";
+            return false;
+        }
+        d->mMappedColumns[i] = data + offset;
+    }
+    uint64_t pathsOffset = readLittle<uint64_t>(offsets + count * sizeof(uint64_t));
+    uint64_t pathsSize = readLittle<uint64_t>(offsets + (count + 1) * sizeof(uint64_t));
+    if (pathsOffset > size || pathsSize > size - pathsOffset) {
+        d->mErrorString = "store is corrupt";
+        return false;
+    }
+
+    d->mMappedPaths = data + pathsOffset;
+    d->mMappedPathsSize = pathsSize;
+    d->mRows = static_cast<size_t>(rows);
+    d->mRegion = std::move(region);
+
+    return true;
+}
+
+size_t CorpusStore::size() const
+{
+    return d->mRows;
+}
+
+boost::string_ref CorpusStore::path(size_t row) const
+{
+    if (row >= d->mRows) {
+        return boost::string_ref();
+    }
+
+    const char *ends = d->column(CorpusStorePrivate::PathEnd);
+    uint64_t end = readLittle<uint64_t>(ends + row * sizeof(uint64_t));
+    uint64_t start = row ? readLittle<uint64_t>(ends + (row - 1) * sizeof(uint64_t)) : 0;
+
+    const char *paths = d->mRegion ? d->mMappedPaths : d->mPaths.data();
+    uint64_t size = d->mRegion ? d->mMappedPathsSize : d->mPaths.size();
+    if (start > end || end > size) {
+        return boost::string_ref();
+    }
+    return boost::string_ref(paths + start, static_cast<size_t>(end - start));
+}
+
+uint64_t CorpusStore::value(Column column, size_t row) const
+{
+    if (column < 0 || column >= ColumnCount || row >= d->mRows) {
+        return 0;
+    }
+
+    const char *data = d->column(column) + row * CorpusStorePrivate::Widths[column];
+    switch (CorpusStorePrivate::Widths[column]) {
+    case sizeof(uint16_t):
+        return readLittle<uint16_t>(data);
+    case sizeof(uint32_t):
+        return readLittle<uint32_t>(data);
+    default:
+        return readLittle<uint64_t>(data);
+    }
+}
+
+float CorpusStore::entropy(size_t row) const
+{
+    uint32_t bits = static_cast<uint32_t>(value(Entropy, row));
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint64_t CorpusStore::importHash(const File &file)
+{
+    // Each function is hashed as "dll.function" (or "dll.#ordinal") followed
+    // by a comma; DLL names are lower-cased since the loader treats them
+    // case-insensitively, but function names are matched exactly
+    uint64_t hash = FNVOffsetBasis;
+    auto mix = [&hash](boost::string_ref value) {
+        for (size_t i = 0; i < value.size(); ++i) {
+            hash = (hash ^ static_cast<unsigned char>(value[i])) * FNVPrime;
+        }
+    };
+    for (const ImportTable::Item &item : file.importDescriptors()) {
+        std::string name = file.string(item.name);
+        for (size_t i = 0; i < name.size(); ++i) {
+            if (name[i] >= 'A' && name[i] <= 'Z') {
+                name[i] = name[i] - 'A' + 'a';
+            }
+        }
+        for (const ImportTable::FunctionRef &function : file.importedFunctionRefs(item)) {
+            mix(name);
+            mix(".");
+            if (function.byOrdinal) {
+                mix("#" + std::to_string(function.ordinal));
+            } else {
+                mix(function.name);
+            }
+            mix(",");
+        }
+    }
+    return hash;
+}
+
+std::string CorpusStore::errorString() const
+{
+    return d->mErrorString;
+}
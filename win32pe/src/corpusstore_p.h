@@ -0,0 +1,78 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_CORPUSSTORE_P_H
+#define WIN32PE_CORPUSSTORE_P_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <win32pe/corpusstore.h>
+
+namespace win32pe
+{
+
+class CorpusStorePrivate
+{
+public:
+
+    // The end offset of each path in the path data is stored as an extra
+    // column after the public ones
+    enum {
+        PathEnd = CorpusStore::ColumnCount,
+
+        StoredColumnCount
+    };
+
+    // Size in bytes of a value in each column
+    static const size_t Widths[StoredColumnCount];
+
+    CorpusStorePrivate();
+
+    const char *column(int column) const;
+    void makeWritable();
+    void close();
+
+    std::string mErrorString;
+
+    size_t mRows;
+
+    // Columns of files added in memory (little-endian values)
+    std::string mColumns[StoredColumnCount];
+    std::string mPaths;
+
+    // Columns of a mapped store
+    std::unique_ptr<boost::interprocess::mapped_region> mRegion;
+    const char *mMappedColumns[StoredColumnCount];
+    const char *mMappedPaths;
+    uint64_t mMappedPathsSize;
+};
+
+}
+
+#endif // WIN32PE_CORPUSSTORE_P_H
@@ -0,0 +1,340 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+
+#include <win32pe/dependencyresolver.h>
+#include <win32pe/ranges.h>
+
+#include "dependencyresolver_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+// Forwarder chains longer than this are assumed to be cycles
+const int MaxForwarderDepth = 16;
+
+std::string lower(const std::string &value)
+{
+    std::string result(value);
+    for (size_t i = 0; i < result.size(); ++i) {
+        result[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(result[i])));
+    }
+    return result;
+}
+
+std::string baseName(const std::string &path)
+{
+    size_t separator = path.find_last_of("/\\");
+    return separator == std::string::npos ? path : path.substr(separator + 1);
+}
+
+}
+
+ParsedModule::ParsedModule()
+    : mLoaded(false)
+{
+}
+
+bool ParsedModule::load(const std::string &path)
+{
+    File file;
+    if (!file.map(path)) {
+        mErrorString = file.errorString();
+        return false;
+    }
+
+    for (const ImportTable::Item &item : file.importDescriptors()) {
+        Dependency dependency;
+        dependency.name = file.string(item.name);
+        for (const ImportTable::FunctionRef &function : file.importedFunctionRefs(item)) {
+            ImportTable::Function copy;
+            copy.byOrdinal = function.byOrdinal;
+            copy.ordinal = function.ordinal;
+            copy.hint = function.hint;
+            copy.name = function.name.to_string();
+            dependency.functions.push_back(copy);
+        }
+        mDependencies.push_back(dependency);
+    }
+
+    // Where a name or ordinal appears more than once, the first wins
+    mExports = file.exports();
+    for (size_t i = 0; i < mExports.size(); ++i) {
+        if (!mExports[i].name.empty()) {
+            mNames.insert(std::make_pair(mExports[i].name, i));
+        }
+        mOrdinals.insert(std::make_pair(mExports[i].ordinal, i));
+    }
+
+    mLoaded = true;
+    mPath = path;
+    return true;
+}
+
+const File::Export *ParsedModule::find(const std::string &name) const
+{
+    auto it = mNames.find(name);
+    return it == mNames.end() ? nullptr : &mExports[it->second];
+}
+
+const File::Export *ParsedModule::find(uint16_t ordinal) const
+{
+    auto it = mOrdinals.find(ordinal);
+    return it == mOrdinals.end() ? nullptr : &mExports[it->second];
+}
+
+DependencyResolverPrivate::DependencyResolverPrivate()
+    : mThreadCount(0)
+{
+}
+
+std::string DependencyResolverPrivate::locate(const std::string &name) const
+{
+    // Try the name as imported and then in lower case since the search
+    // directories may be on a case-sensitive filesystem
+    std::string candidates[] = {name, lower(name)};
+    for (auto it = mSearchDirectories.begin(); it != mSearchDirectories.end(); ++it) {
+        std::string prefix(*it);
+        if (!prefix.empty() && prefix.back() != '/' && prefix.back() != '\\') {
+            prefix.push_back('/');
+        }
+        for (const std::string &candidate : candidates) {
+            std::string path = prefix + candidate;
+            if (std::ifstream(path, std::ios::binary).is_open()) {
+                return path;
+            }
+        }
+    }
+    return std::string();
+}
+
+std::shared_ptr<ParsedModule> DependencyResolverPrivate::module(const std::string &name)
+{
+    std::shared_ptr<ParsedModule> module;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::shared_ptr<ParsedModule> &entry = mCache[lower(name)];
+        if (!entry) {
+            entry = std::make_shared<ParsedModule>();
+        }
+        module = entry;
+    }
+
+    // Parsing happens outside of the lock so that different DLLs can be
+    // parsed concurrently; other threads wanting this one wait here
+    std::call_once(module->mFlag, [this, &name, &module]() {
+        std::string path = locate(name);
+        if (!path.empty()) {
+            module->load(path);
+        }
+    });
+    return module;
+}
+
+bool DependencyResolverPrivate::bind(const std::string &module, const ImportTable::Function &function,
+                                     DependencyResolver::Import &import, std::vector<std::string> &forwarded)
+{
+    std::string name(module);
+    bool byOrdinal = function.byOrdinal;
+    uint16_t ordinal = function.ordinal;
+    std::string symbol(function.name);
+
+    for (int depth = 0; depth < MaxForwarderDepth; ++depth) {
+        std::shared_ptr<ParsedModule> parsed = this->module(name);
+        if (!parsed->mLoaded) {
+            return false;
+        }
+        const File::Export *item = byOrdinal ? parsed->find(ordinal) : parsed->find(symbol);
+        if (!item) {
+            return false;
+        }
+        if (item->forwarder.empty()) {
+            import.provider = name;
+            import.rva = item->rva;
+            return true;
+        }
+
+        // Forwarders name the DLL without its extension
+        size_t dot = item->forwarder.find('.');
+        if (dot == std::string::npos) {
+            return false;
+        }
+        name = item->forwarder.substr(0, dot) + ".dll";
+        symbol = item->forwarder.substr(dot + 1);
+        byOrdinal = !symbol.empty() && symbol[0] == '#';
+        if (byOrdinal) {
+            ordinal = static_cast<uint16_t>(std::strtoul(symbol.c_str() + 1, nullptr, 10));
+        }
+        forwarded.push_back(name);
+    }
+
+    return false;
+}
+
+DependencyResolver::DependencyResolver()
+    : d(new DependencyResolverPrivate)
+{
+}
+
+DependencyResolver::~DependencyResolver()
+{
+    delete d;
+}
+
+void DependencyResolver::addSearchDirectory(const std::string &directory)
+{
+    d->mSearchDirectories.push_back(directory);
+}
+
+std::vector<std::string> DependencyResolver::searchDirectories() const
+{
+    return d->mSearchDirectories;
+}
+
+void DependencyResolver::setThreadCount(size_t threads)
+{
+    d->mThreadCount = threads;
+}
+
+size_t DependencyResolver::threadCount() const
+{
+    return d->mThreadCount;
+}
+
+bool DependencyResolver::resolve(const std::string &filename, Result &result)
+{
+    result = Result();
+
+    std::shared_ptr<ParsedModule> root = std::make_shared<ParsedModule>();
+    if (!root->load(filename)) {
+        std::lock_guard<std::mutex> lock(d->mMutex);
+        d->mErrorString = root->mErrorString;
+        return false;
+    }
+
+    // Modules are identified by their lower-case name; the parsed modules
+    // are kept alongside the graph in case the cache is cleared
+    std::vector<std::shared_ptr<ParsedModule>> parsed;
+    std::unordered_map<std::string, size_t> indices;
+    auto add = [&result, &parsed, &indices](const std::string &name) {
+        if (indices.insert(std::make_pair(lower(name), result.modules.size())).second) {
+            Module module;
+            module.name = name;
+            result.modules.push_back(module);
+            parsed.push_back(nullptr);
+        }
+    };
+
+    add(baseName(filename));
+    result.modules[0].name = filename;
+    parsed[0] = root;
+
+    size_t first = 0;
+    size_t bound = 0;
+    while (first < result.modules.size()) {
+
+        // Parse each level of the graph in parallel, then add the DLLs it
+        // imports as the next level
+        while (first < result.modules.size()) {
+            size_t last = result.modules.size();
+            d->mPool.run(last - first, d->mThreadCount, [this, &result, &parsed, first](size_t i) {
+                if (!parsed[first + i]) {
+                    parsed[first + i] = d->module(result.modules[first + i].name);
+                }
+            });
+            for (size_t i = first; i < last; ++i) {
+                if (!parsed[i]->mLoaded) {
+                    result.missingModules.push_back(result.modules[i].name);
+                    continue;
+                }
+                result.modules[i].path = parsed[i]->mPath;
+                for (auto it = parsed[i]->mDependencies.begin(); it != parsed[i]->mDependencies.end(); ++it) {
+                    result.modules[i].dependencies.push_back((*it).name);
+                    add((*it).name);
+                }
+            }
+            first = last;
+        }
+
+        // Bind the imports of the new modules; DLLs reached only through
+        // forwarders are loaded too, so they join the graph afterwards
+        size_t count = result.modules.size();
+        std::vector<std::vector<std::string>> forwarded(count - bound);
+        d->mPool.run(count - bound, d->mThreadCount, [this, &result, &parsed, &forwarded, bound](size_t i) {
+            Module &module = result.modules[bound + i];
+            const std::vector<ParsedModule::Dependency> &dependencies = parsed[bound + i]->mDependencies;
+            for (auto it = dependencies.begin(); it != dependencies.end(); ++it) {
+                for (auto function = (*it).functions.begin(); function != (*it).functions.end(); ++function) {
+                    Import import;
+                    import.importer = module.name;
+                    import.module = (*it).name;
+                    import.byOrdinal = (*function).byOrdinal;
+                    import.ordinal = (*function).ordinal;
+                    import.name = (*function).name;
+                    import.rva = 0;
+                    d->bind((*it).name, *function, import, forwarded[i]);
+                    module.imports.push_back(import);
+                }
+            }
+        });
+
+        for (size_t i = bound; i < count; ++i) {
+            const std::vector<Import> &imports = result.modules[i].imports;
+            for (auto it = imports.begin(); it != imports.end(); ++it) {
+                if ((*it).provider.empty() && parsed[indices[lower((*it).module)]]->mLoaded) {
+                    result.missingFunctions.push_back(*it);
+                }
+            }
+            for (auto it = forwarded[i - bound].begin(); it != forwarded[i - bound].end(); ++it) {
+                add(*it);
+            }
+        }
+        bound = count;
+    }
+
+    return true;
+}
+
+void DependencyResolver::clearCache()
+{
+    std::lock_guard<std::mutex> lock(d->mMutex);
+    d->mCache.clear();
+}
+
+size_t DependencyResolver::cacheSize() const
+{
+    std::lock_guard<std::mutex> lock(d->mMutex);
+    return d->mCache.size();
+}
+
+std::string DependencyResolver::errorString() const
+{
+    std::lock_guard<std::mutex> lock(d->mMutex);
+    return d->mErrorString;
+}
@@ -0,0 +1,103 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_DEPENDENCYRESOLVER_P_H
+#define WIN32PE_DEPENDENCYRESOLVER_P_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <win32pe/dependencyresolver.h>
+#include <win32pe/file.h>
+#include <win32pe/importtable.h>
+
+#include "parallel_p.h"
+
+namespace win32pe
+{
+
+/**
+ * @brief Imports and exports of a parsed module
+ *
+ * Only what resolution needs is kept - the File itself is discarded once
+ * parsed so that caching hundreds of DLLs costs little memory.
+ */
+struct ParsedModule
+{
+    struct Dependency
+    {
+        std::string name;
+        std::vector<ImportTable::Function> functions;
+    };
+
+    ParsedModule();
+
+    bool load(const std::string &path);
+
+    const File::Export *find(const std::string &name) const;
+    const File::Export *find(uint16_t ordinal) const;
+
+    std::once_flag mFlag;
+
+    bool mLoaded;
+    std::string mPath;
+    std::string mErrorString;
+    std::vector<Dependency> mDependencies;
+    std::vector<File::Export> mExports;
+    std::unordered_map<std::string, size_t> mNames;
+    std::unordered_map<uint16_t, size_t> mOrdinals;
+};
+
+class DependencyResolverPrivate
+{
+public:
+
+    DependencyResolverPrivate();
+
+    std::string locate(const std::string &name) const;
+    std::shared_ptr<ParsedModule> module(const std::string &name);
+
+    bool bind(const std::string &module, const ImportTable::Function &function,
+              DependencyResolver::Import &import, std::vector<std::string> &forwarded);
+
+    std::vector<std::string> mSearchDirectories;
+    size_t mThreadCount;
+
+    // Workers shared by every level of every resolve() call
+    ThreadPool mPool;
+
+    // Guards the cache and the error string
+    mutable std::mutex mMutex;
+    std::unordered_map<std::string, std::shared_ptr<ParsedModule>> mCache;
+    std::string mErrorString;
+};
+
+}
+
+#endif // WIN32PE_DEPENDENCYRESOLVER_P_H
@@ -0,0 +1,449 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "digest_p.h"
+#include "endian_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+inline uint32_t rotl32(uint32_t value, int count)
+{
+    return (value << count) | (value >> (32 - count));
+}
+
+inline uint32_t rotr32(uint32_t value, int count)
+{
+    return (value >> count) | (value << (32 - count));
+}
+
+inline uint64_t rotl64(uint64_t value, int count)
+{
+    return (value << count) | (value >> (64 - count));
+}
+
+inline uint32_t readBig32(const unsigned char *data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+           (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+void appendBig(std::string &digest, const uint32_t *words, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            digest.push_back(static_cast<char>(words[i] >> shift));
+        }
+    }
+}
+
+// MD5 per-round shift amounts and constants (RFC 1321)
+
+const int Md5Shifts[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+const uint32_t Md5Constants[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+// SHA-256 round constants (FIPS 180-4)
+
+const uint32_t Sha256Constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// xxHash primes
+
+const uint64_t Prime1 = 0x9e3779b185ebca87ULL;
+const uint64_t Prime2 = 0xc2b2ae3d27d4eb4fULL;
+const uint64_t Prime3 = 0x165667b19e3779f9ULL;
+const uint64_t Prime4 = 0x85ebca77c2b2ae63ULL;
+const uint64_t Prime5 = 0x27d4eb2f165667c5ULL;
+
+inline uint64_t xxhRound(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * Prime2;
+    return rotl64(accumulator, 31) * Prime1;
+}
+
+inline uint64_t xxhMerge(uint64_t hash, uint64_t accumulator)
+{
+    hash ^= xxhRound(0, accumulator);
+    return hash * Prime1 + Prime4;
+}
+
+}
+
+Digests Digests::compute(const char *data, size_t size, int algorithms)
+{
+    Digester digester(algorithms);
+    digester.update(data, size);
+
+    Digests digests;
+    digester.finish(digests);
+    return digests;
+}
+
+std::string Digests::toHex(const std::string &digest)
+{
+    static const char Digits[] = "0123456789abcdef";
+
+    std::string hex;
+    hex.reserve(digest.size() * 2);
+    for (size_t i = 0; i < digest.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(digest[i]);
+        hex.push_back(Digits[c >> 4]);
+        hex.push_back(Digits[c & 0xf]);
+    }
+    return hex;
+}
+
+Md5::Md5()
+{
+    mState[0] = 0x67452301;
+    mState[1] = 0xefcdab89;
+    mState[2] = 0x98badcfe;
+    mState[3] = 0x10325476;
+}
+
+void Md5::block(const unsigned char *data)
+{
+    uint32_t words[16];
+    for (int i = 0; i < 16; ++i) {
+        words[i] = readLittle<uint32_t>(reinterpret_cast<const char*>(data) + i * 4);
+    }
+
+    uint32_t a = mState[0], b = mState[1], c = mState[2], d = mState[3];
+    for (int i = 0; i < 64; ++i) {
+        uint32_t f;
+        int g;
+        switch (i / 16) {
+        case 0:
+            f = (b & c) | (~b & d);
+            g = i;
+            break;
+        case 1:
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) % 16;
+            break;
+        case 2:
+            f = b ^ c ^ d;
+            g = (3 * i + 5) % 16;
+            break;
+        default:
+            f = c ^ (b | ~d);
+            g = (7 * i) % 16;
+            break;
+        }
+        uint32_t temp = d;
+        d = c;
+        c = b;
+        b = b + rotl32(a + f + Md5Constants[i] + words[g], Md5Shifts[i]);
+        a = temp;
+    }
+
+    mState[0] += a;
+    mState[1] += b;
+    mState[2] += c;
+    mState[3] += d;
+}
+
+void Md5::finish(std::string &digest)
+{
+    pad(false);
+    digest.clear();
+    for (int i = 0; i < 4; ++i) {
+        appendLittle(digest, mState[i]);
+    }
+}
+
+Sha1::Sha1()
+{
+    mState[0] = 0x67452301;
+    mState[1] = 0xefcdab89;
+    mState[2] = 0x98badcfe;
+    mState[3] = 0x10325476;
+    mState[4] = 0xc3d2e1f0;
+}
+
+void Sha1::block(const unsigned char *data)
+{
+    uint32_t words[80];
+    for (int i = 0; i < 16; ++i) {
+        words[i] = readBig32(data + i * 4);
+    }
+    for (int i = 16; i < 80; ++i) {
+        words[i] = rotl32(words[i - 3] ^ words[i - 8] ^ words[i - 14] ^ words[i - 16], 1);
+    }
+
+    uint32_t a = mState[0], b = mState[1], c = mState[2], d = mState[3], e = mState[4];
+    for (int i = 0; i < 80; ++i) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+        uint32_t temp = rotl32(a, 5) + f + e + k + words[i];
+        e = d;
+        d = c;
+        c = rotl32(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    mState[0] += a;
+    mState[1] += b;
+    mState[2] += c;
+    mState[3] += d;
+    mState[4] += e;
+}
+
+void Sha1::finish(std::string &digest)
+{
+    pad(true);
+    digest.clear();
+    appendBig(digest, mState, 5);
+}
+
+Sha256::Sha256()
+{
+    mState[0] = 0x6a09e667;
+    mState[1] = 0xbb67ae85;
+    mState[2] = 0x3c6ef372;
+    mState[3] = 0xa54ff53a;
+    mState[4] = 0x510e527f;
+    mState[5] = 0x9b05688c;
+    mState[6] = 0x1f83d9ab;
+    mState[7] = 0x5be0cd19;
+}
+
+void Sha256::block(const unsigned char *data)
+{
+    uint32_t words[64];
+    for (int i = 0; i < 16; ++i) {
+        words[i] = readBig32(data + i * 4);
+    }
+    for (int i = 16; i < 64; ++i) {
+        uint32_t s0 = rotr32(words[i - 15], 7) ^ rotr32(words[i - 15], 18) ^ (words[i - 15] >> 3);
+        uint32_t s1 = rotr32(words[i - 2], 17) ^ rotr32(words[i - 2], 19) ^ (words[i - 2] >> 10);
+        words[i] = words[i - 16] + s0 + words[i - 7] + s1;
+    }
+
+    uint32_t a = mState[0], b = mState[1], c = mState[2], d = mState[3];
+    uint32_t e = mState[4], f = mState[5], g = mState[6], h = mState[7];
+    for (int i = 0; i < 64; ++i) {
+        uint32_t s1 = rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t temp1 = h + s1 + ch + Sha256Constants[i] + words[i];
+        uint32_t s0 = rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t temp2 = s0 + maj;
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    mState[0] += a;
+    mState[1] += b;
+    mState[2] += c;
+    mState[3] += d;
+    mState[4] += e;
+    mState[5] += f;
+    mState[6] += g;
+    mState[7] += h;
+}
+
+void Sha256::finish(std::string &digest)
+{
+    pad(true);
+    digest.clear();
+    appendBig(digest, mState, 8);
+}
+
+XxHash64::XxHash64(uint64_t seed)
+    : mSeed(seed),
+      mBuffered(0),
+      mLength(0)
+{
+    mAccumulators[0] = seed + Prime1 + Prime2;
+    mAccumulators[1] = seed + Prime2;
+    mAccumulators[2] = seed;
+    mAccumulators[3] = seed - Prime1;
+}
+
+void XxHash64::stripe(const unsigned char *data)
+{
+    for (int i = 0; i < 4; ++i) {
+        mAccumulators[i] = xxhRound(
+            mAccumulators[i],
+            readLittle<uint64_t>(reinterpret_cast<const char*>(data) + i * 8)
+        );
+    }
+}
+
+void XxHash64::update(const char *data, size_t size)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>(data);
+    mLength += size;
+
+    if (mBuffered) {
+        size_t count = std::min(size, sizeof(mBuffer) - mBuffered);
+        memcpy(mBuffer + mBuffered, bytes, count);
+        mBuffered += count;
+        bytes += count;
+        size -= count;
+        if (mBuffered < sizeof(mBuffer)) {
+            return;
+        }
+        stripe(mBuffer);
+        mBuffered = 0;
+    }
+
+    for (; size >= sizeof(mBuffer); bytes += sizeof(mBuffer), size -= sizeof(mBuffer)) {
+        stripe(bytes);
+    }
+
+    memcpy(mBuffer, bytes, size);
+    mBuffered = size;
+}
+
+uint64_t XxHash64::value() const
+{
+    uint64_t hash;
+    if (mLength >= sizeof(mBuffer)) {
+        hash = rotl64(mAccumulators[0], 1) + rotl64(mAccumulators[1], 7) +
+               rotl64(mAccumulators[2], 12) + rotl64(mAccumulators[3], 18);
+        for (int i = 0; i < 4; ++i) {
+            hash = xxhMerge(hash, mAccumulators[i]);
+        }
+    } else {
+        hash = mSeed + Prime5;
+    }
+    hash += mLength;
+
+    // Consume whatever did not fill a stripe
+    const char *data = reinterpret_cast<const char*>(mBuffer);
+    size_t i = 0;
+    for (; i + 8 <= mBuffered; i += 8) {
+        hash ^= xxhRound(0, readLittle<uint64_t>(data + i));
+        hash = rotl64(hash, 27) * Prime1 + Prime4;
+    }
+    if (i + 4 <= mBuffered) {
+        hash ^= static_cast<uint64_t>(readLittle<uint32_t>(data + i)) * Prime1;
+        hash = rotl64(hash, 23) * Prime2 + Prime3;
+        i += 4;
+    }
+    for (; i < mBuffered; ++i) {
+        hash ^= mBuffer[i] * Prime5;
+        hash = rotl64(hash, 11) * Prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= Prime2;
+    hash ^= hash >> 29;
+    hash *= Prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+void XxHash64::finish(std::string &digest)
+{
+    uint64_t hash = value();
+    digest.clear();
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        digest.push_back(static_cast<char>(hash >> shift));
+    }
+}
+
+Digester::Digester(int algorithms)
+    : mAlgorithms(algorithms)
+{
+}
+
+void Digester::update(const char *data, size_t size)
+{
+    if (mAlgorithms & Digests::MD5) {
+        mMd5.update(data, size);
+    }
+    if (mAlgorithms & Digests::SHA1) {
+        mSha1.update(data, size);
+    }
+    if (mAlgorithms & Digests::SHA256) {
+        mSha256.update(data, size);
+    }
+    if (mAlgorithms & Digests::XXH64) {
+        mXxHash64.update(data, size);
+    }
+}
+
+void Digester::finish(Digests &digests)
+{
+    digests = Digests();
+    if (mAlgorithms & Digests::MD5) {
+        mMd5.finish(digests.md5);
+    }
+    if (mAlgorithms & Digests::SHA1) {
+        mSha1.finish(digests.sha1);
+    }
+    if (mAlgorithms & Digests::SHA256) {
+        mSha256.finish(digests.sha256);
+    }
+    if (mAlgorithms & Digests::XXH64) {
+        mXxHash64.finish(digests.xxh64);
+    }
+}
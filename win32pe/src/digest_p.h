@@ -0,0 +1,200 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_DIGEST_P_H
+#define WIN32PE_DIGEST_P_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <win32pe/digests.h>
+
+namespace win32pe
+{
+
+/**
+ * @brief Input buffering and padding shared by MD5 and the SHA family
+ *
+ * Data is processed in 64-byte blocks by Hash::block(); the final block is
+ * padded with a one bit, zeroes and the message length in bits.
+ */
+template<typename Hash>
+class BlockHash
+{
+public:
+
+    BlockHash() : mBuffered(0), mLength(0) {}
+
+    void update(const char *data, size_t size);
+
+protected:
+
+    void pad(bool bigEndian);
+
+    unsigned char mBuffer[64];
+    size_t mBuffered;
+    uint64_t mLength;
+};
+
+template<typename Hash>
+void BlockHash<Hash>::update(const char *data, size_t size)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>(data);
+    mLength += size;
+
+    if (mBuffered) {
+        size_t count = std::min(size, sizeof(mBuffer) - mBuffered);
+        memcpy(mBuffer + mBuffered, bytes, count);
+        mBuffered += count;
+        bytes += count;
+        size -= count;
+        if (mBuffered < sizeof(mBuffer)) {
+            return;
+        }
+        static_cast<Hash*>(this)->block(mBuffer);
+        mBuffered = 0;
+    }
+
+    // Whole blocks are processed in place
+    for (; size >= sizeof(mBuffer); bytes += sizeof(mBuffer), size -= sizeof(mBuffer)) {
+        static_cast<Hash*>(this)->block(bytes);
+    }
+
+    memcpy(mBuffer, bytes, size);
+    mBuffered = size;
+}
+
+template<typename Hash>
+void BlockHash<Hash>::pad(bool bigEndian)
+{
+    uint64_t bits = mLength * 8;
+
+    mBuffer[mBuffered++] = 0x80;
+    if (mBuffered > sizeof(mBuffer) - sizeof(bits)) {
+        memset(mBuffer + mBuffered, 0, sizeof(mBuffer) - mBuffered);
+        static_cast<Hash*>(this)->block(mBuffer);
+        mBuffered = 0;
+    }
+    memset(mBuffer + mBuffered, 0, sizeof(mBuffer) - sizeof(bits) - mBuffered);
+    for (size_t i = 0; i < sizeof(bits); ++i) {
+        int shift = bigEndian ? 56 - 8 * i : 8 * i;
+        mBuffer[sizeof(mBuffer) - sizeof(bits) + i] = static_cast<unsigned char>(bits >> shift);
+    }
+    static_cast<Hash*>(this)->block(mBuffer);
+    mBuffered = 0;
+}
+
+class Md5 : public BlockHash<Md5>
+{
+public:
+
+    Md5();
+
+    void block(const unsigned char *data);
+    void finish(std::string &digest);
+
+private:
+
+    uint32_t mState[4];
+};
+
+class Sha1 : public BlockHash<Sha1>
+{
+public:
+
+    Sha1();
+
+    void block(const unsigned char *data);
+    void finish(std::string &digest);
+
+private:
+
+    uint32_t mState[5];
+};
+
+class Sha256 : public BlockHash<Sha256>
+{
+public:
+
+    Sha256();
+
+    void block(const unsigned char *data);
+    void finish(std::string &digest);
+
+private:
+
+    uint32_t mState[8];
+};
+
+/**
+ * @brief Streaming 64-bit xxHash
+ */
+class XxHash64
+{
+public:
+
+    explicit XxHash64(uint64_t seed = 0);
+
+    void update(const char *data, size_t size);
+    uint64_t value() const;
+    void finish(std::string &digest);
+
+private:
+
+    void stripe(const unsigned char *data);
+
+    uint64_t mSeed;
+    uint64_t mAccumulators[4];
+    unsigned char mBuffer[32];
+    size_t mBuffered;
+    uint64_t mLength;
+};
+
+/**
+ * @brief Compute a selection of digests in one pass
+ */
+class Digester
+{
+public:
+
+    explicit Digester(int algorithms = 0);
+
+    void update(const char *data, size_t size);
+    void finish(Digests &digests);
+
+private:
+
+    int mAlgorithms;
+    Md5 mMd5;
+    Sha1 mSha1;
+    Sha256 mSha256;
+    XxHash64 mXxHash64;
+};
+
+}
+
+#endif // WIN32PE_DIGEST_P_H
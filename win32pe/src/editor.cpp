@@ -0,0 +1,357 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstring>
+
+#include <boost/interprocess/file_mapping.hpp>
+
+#include <win32pe/editor.h>
+#include <win32pe/optionalheader.h>
+
+#include "editor_p.h"
+#include "endian_p.h"
+#include "structs_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+const uint64_t PEOffsetOffset = 0x3c;
+const uint32_t PESignature = 0x4550;
+const uint64_t FileHeaderSize = sizeof(RawFileHeader);
+const uint64_t SectionHeaderSize = sizeof(RawSectionHeader);
+
+// Offsets of fields within the file header
+const uint64_t NumberOfSectionsOffset = offsetof(RawFileHeader, numberOfSections);
+const uint64_t TimeDateStampOffset = offsetof(RawFileHeader, timeDateStamp);
+const uint64_t SizeOfOptionalHeaderOffset = offsetof(RawFileHeader, sizeOfOptionalHeader);
+
+// Offsets of fields within the optional header (the same for PE32 and PE32+)
+const uint64_t MajorSubsystemVersionOffset = offsetof(RawOptionalHeader32, majorSubsystemVersion);
+const uint64_t MinorSubsystemVersionOffset = offsetof(RawOptionalHeader32, minorSubsystemVersion);
+const uint64_t CheckSumOffset = offsetof(RawOptionalHeader32, checkSum);
+const uint64_t DllCharacteristicsOffset = offsetof(RawOptionalHeader32, dllCharacteristics);
+
+// Offsets of fields within a section header
+const uint64_t VirtualSizeOffset = offsetof(RawSectionHeader, virtualSize);
+const uint64_t VirtualAddressOffset = offsetof(RawSectionHeader, virtualAddress);
+const uint64_t SizeOfRawDataOffset = offsetof(RawSectionHeader, sizeOfRawData);
+const uint64_t PointerToRawDataOffset = offsetof(RawSectionHeader, pointerToRawData);
+
+}
+
+EditorPrivate::EditorPrivate()
+    : mData(nullptr),
+      mSize(0),
+      mFileHeaderOffset(0),
+      mOptionalHeaderOffset(0),
+      mMagic(0),
+      mNumberOfSections(0),
+      mSizeOfOptionalHeader(0),
+      mNumberOfRvaAndSizes(0)
+{
+}
+
+bool EditorPrivate::parseHeaders()
+{
+    if (mSize < PEOffsetOffset + sizeof(uint32_t)) {
+        mErrorString = "unable to read DOS header";
+        return false;
+    }
+
+    if (mData[0] != 'M' || mData[1] != 'Z') {
+        mErrorString = "file is missing MZ signature";
+        return false;
+    }
+
+    uint64_t peOffset = readLittle<uint32_t>(mData + PEOffsetOffset);
+    if (peOffset + sizeof(uint32_t) + FileHeaderSize > mSize ||
+            readLittle<uint32_t>(mData + peOffset) != PESignature) {
+        mErrorString = "file is missing PE signature";
+        return false;
+    }
+
+    mFileHeaderOffset = peOffset + sizeof(uint32_t);
+    mOptionalHeaderOffset = mFileHeaderOffset + FileHeaderSize;
+    mNumberOfSections = readLittle<uint16_t>(mData + mFileHeaderOffset + NumberOfSectionsOffset);
+    mSizeOfOptionalHeader = readLittle<uint16_t>(mData + mFileHeaderOffset + SizeOfOptionalHeaderOffset);
+
+    // The optional header must at least contain the fields that can be
+    // patched along with the count of data directory entries
+    if (mOptionalHeaderOffset + sizeof(uint16_t) > mSize) {
+        mErrorString = "unable to read optional header";
+        return false;
+    }
+    mMagic = readLittle<uint16_t>(mData + mOptionalHeaderOffset);
+    if (mMagic != OptionalHeader::Win32 && mMagic != OptionalHeader::Win64) {
+        mErrorString = "unrecognized optional header magic";
+        return false;
+    }
+    uint64_t numberOfRvaAndSizesOffset = mMagic == OptionalHeader::Win32 ?
+        offsetof(RawOptionalHeader32, numberOfRvaAndSizes) :
+        offsetof(RawOptionalHeader64, numberOfRvaAndSizes);
+    if (mSizeOfOptionalHeader < numberOfRvaAndSizesOffset + sizeof(uint32_t) ||
+            mOptionalHeaderOffset + mSizeOfOptionalHeader > mSize) {
+        mErrorString = "unable to read optional header";
+        return false;
+    }
+    mNumberOfRvaAndSizes = readLittle<uint32_t>(
+        mData + mOptionalHeaderOffset + numberOfRvaAndSizesOffset
+    );
+
+    if (sectionHeaderOffset(mNumberOfSections) > mSize) {
+        mErrorString = "unable to read sections";
+        return false;
+    }
+
+    return true;
+}
+
+bool EditorPrivate::write(uint64_t offset, const char *data, size_t size)
+{
+    if (!mData) {
+        mErrorString = "no file is open";
+        return false;
+    }
+
+    if (offset > mSize || size > mSize - offset) {
+        mErrorString = "patch extends past the end of the file";
+        return false;
+    }
+
+    uint64_t checkSum = checkSumOffset();
+    if (offset < checkSum + sizeof(uint32_t) && checkSum < offset + size) {
+        mErrorString = "patch overlaps the CheckSum field";
+        return false;
+    }
+
+    // Swap the contribution of the old bytes for that of the new ones
+    mChecksum.remove(offset, mData + offset, size);
+    memcpy(mData + offset, data, size);
+    mChecksum.add(offset, mData + offset, size);
+
+    uint32_t value = mChecksum.value(mSize);
+    boost::endian::native_to_little_inplace(value);
+    memcpy(mData + checkSum, &value, sizeof(value));
+
+    return true;
+}
+
+uint64_t EditorPrivate::checkSumOffset() const
+{
+    return mOptionalHeaderOffset + CheckSumOffset;
+}
+
+uint64_t EditorPrivate::sectionHeaderOffset(size_t index) const
+{
+    return mOptionalHeaderOffset + mSizeOfOptionalHeader + index * SectionHeaderSize;
+}
+
+Editor::Editor()
+    : d(new EditorPrivate)
+{
+}
+
+Editor::~Editor()
+{
+    close();
+    delete d;
+}
+
+bool Editor::open(const std::string &filename)
+{
+    close();
+
+    try {
+        boost::interprocess::file_mapping file(filename.c_str(), boost::interprocess::read_write);
+        d->mRegion.reset(new boost::interprocess::mapped_region(
+            file,
+            boost::interprocess::read_write
+        ));
+    } catch (const boost::interprocess::interprocess_exception &) {
+        d->mErrorString = "unable to map file";
+        return false;
+    }
+
+    d->mData = static_cast<char*>(d->mRegion->get_address());
+    d->mSize = d->mRegion->get_size();
+
+    if (!d->parseHeaders()) {
+        d->mRegion.reset();
+        d->mData = nullptr;
+        d->mSize = 0;
+        return false;
+    }
+
+    // Resume from the stored checksum if there is one
+    uint32_t stored = checkSum();
+    if (stored && stored >= d->mSize && stored - d->mSize <= 0xffff) {
+        d->mChecksum.setSum(static_cast<uint16_t>(stored - d->mSize));
+    } else {
+        recomputeChecksum();
+    }
+
+    return true;
+}
+
+bool Editor::close()
+{
+    bool flushed = true;
+    if (d->mRegion) {
+        flushed = flush();
+        d->mRegion.reset();
+    }
+    d->mData = nullptr;
+    d->mSize = 0;
+    return flushed;
+}
+
+bool Editor::flush()
+{
+    if (!d->mRegion || !d->mRegion->flush()) {
+        d->mErrorString = "unable to flush changes";
+        return false;
+    }
+    return true;
+}
+
+uint64_t Editor::fileSize() const
+{
+    return d->mSize;
+}
+
+size_t Editor::sectionCount() const
+{
+    return d->mNumberOfSections;
+}
+
+bool Editor::setTimeDateStamp(uint32_t timeDateStamp)
+{
+    return d->writeField(d->mFileHeaderOffset + TimeDateStampOffset, timeDateStamp);
+}
+
+bool Editor::setDllCharacteristics(uint16_t dllCharacteristics)
+{
+    return d->writeField(d->mOptionalHeaderOffset + DllCharacteristicsOffset, dllCharacteristics);
+}
+
+bool Editor::setSubsystemVersion(uint16_t major, uint16_t minor)
+{
+    return d->writeField(d->mOptionalHeaderOffset + MajorSubsystemVersionOffset, major) &&
+           d->writeField(d->mOptionalHeaderOffset + MinorSubsystemVersionOffset, minor);
+}
+
+bool Editor::setDataDirectory(int index, uint32_t virtualAddress, uint32_t size)
+{
+    if (index < 0 || static_cast<uint32_t>(index) >= d->mNumberOfRvaAndSizes ||
+            index >= OptionalHeader::DataDirectoryCount) {
+        d->mErrorString = "invalid data directory index";
+        return false;
+    }
+
+    uint64_t offset = d->mOptionalHeaderOffset +
+        (d->mMagic == OptionalHeader::Win32 ? sizeof(RawOptionalHeader32) : sizeof(RawOptionalHeader64)) +
+        index * sizeof(RawDataDirectory);
+    if (offset + sizeof(RawDataDirectory) >
+            d->mOptionalHeaderOffset + d->mSizeOfOptionalHeader) {
+        d->mErrorString = "invalid data directory index";
+        return false;
+    }
+
+    return d->writeField(offset, virtualAddress) &&
+           d->writeField(offset + sizeof(uint32_t), size);
+}
+
+bool Editor::patch(uint64_t offset, const char *data, size_t size)
+{
+    return d->write(offset, data, size);
+}
+
+bool Editor::patchSection(size_t index, uint32_t offset, const char *data, size_t size)
+{
+    if (!d->mData || index >= d->mNumberOfSections) {
+        d->mErrorString = "invalid section index";
+        return false;
+    }
+
+    const char *header = d->mData + d->sectionHeaderOffset(index);
+    uint32_t sizeOfRawData = readLittle<uint32_t>(header + SizeOfRawDataOffset);
+    uint32_t pointerToRawData = readLittle<uint32_t>(header + PointerToRawDataOffset);
+    if (offset > sizeOfRawData || size > sizeOfRawData - offset) {
+        d->mErrorString = "patch extends past the end of the section";
+        return false;
+    }
+
+    return d->write(static_cast<uint64_t>(pointerToRawData) + offset, data, size);
+}
+
+bool Editor::patchRVA(uint32_t rva, const char *data, size_t size)
+{
+    for (size_t i = 0; d->mData && i < d->mNumberOfSections; ++i) {
+        const char *header = d->mData + d->sectionHeaderOffset(i);
+        uint32_t virtualSize = readLittle<uint32_t>(header + VirtualSizeOffset);
+        uint32_t virtualAddress = readLittle<uint32_t>(header + VirtualAddressOffset);
+        if (virtualAddress <= rva && rva - virtualAddress < virtualSize) {
+            return patchSection(i, rva - virtualAddress, data, size);
+        }
+    }
+
+    d->mErrorString = "RVA is not within a section";
+    return false;
+}
+
+uint32_t Editor::checkSum() const
+{
+    if (!d->mData) {
+        return 0;
+    }
+    return readLittle<uint32_t>(d->mData + d->checkSumOffset());
+}
+
+uint32_t Editor::recomputeChecksum()
+{
+    if (!d->mData) {
+        return 0;
+    }
+
+    uint64_t checkSum = d->checkSumOffset();
+    Checksum checksum;
+    checksum.add(0, d->mData, static_cast<size_t>(checkSum));
+    checksum.add(checkSum + sizeof(uint32_t), d->mData + checkSum + sizeof(uint32_t),
+                 static_cast<size_t>(d->mSize - checkSum - sizeof(uint32_t)));
+    d->mChecksum = checksum;
+
+    uint32_t value = checksum.value(d->mSize);
+    boost::endian::native_to_little_inplace(value);
+    memcpy(d->mData + checkSum, &value, sizeof(value));
+
+    return checksum.value(d->mSize);
+}
+
+std::string Editor::errorString() const
+{
+    return d->mErrorString;
+}
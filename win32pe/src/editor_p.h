@@ -0,0 +1,77 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_EDITOR_P_H
+#define WIN32PE_EDITOR_P_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <boost/endian/conversion.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "checksum_p.h"
+
+namespace win32pe
+{
+
+class EditorPrivate
+{
+public:
+
+    EditorPrivate();
+
+    bool parseHeaders();
+    bool write(uint64_t offset, const char *data, size_t size);
+
+    template<typename T>
+    bool writeField(uint64_t offset, T value)
+    {
+        boost::endian::native_to_little_inplace(value);
+        return write(offset, reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    uint64_t checkSumOffset() const;
+    uint64_t sectionHeaderOffset(size_t index) const;
+
+    std::string mErrorString;
+
+    std::unique_ptr<boost::interprocess::mapped_region> mRegion;
+    char *mData;
+    uint64_t mSize;
+
+    uint64_t mFileHeaderOffset;
+    uint64_t mOptionalHeaderOffset;
+    uint16_t mMagic;
+    uint16_t mNumberOfSections;
+    uint16_t mSizeOfOptionalHeader;
+    uint32_t mNumberOfRvaAndSizes;
+
+    Checksum mChecksum;
+};
+
+}
+
+#endif // WIN32PE_EDITOR_P_H
@@ -0,0 +1,380 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <win32pe/corpusstore.h>
+#include <win32pe/emitter.h>
+#include <win32pe/file.h>
+#include <win32pe/fileheader.h>
+#include <win32pe/importtable.h>
+#include <win32pe/optionalheader.h>
+#include <win32pe/sectionref.h>
+
+#include "emitter_p.h"
+#include "format_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+// Find a NUL-terminated string at an RVA without copying it where possible;
+// files restored from the metadata cache have no section data so the copy
+// made by File::string() is used instead
+
+boost::string_ref stringAt(const File &file, uint32_t rva, std::string &scratch)
+{
+    SectionRef section = file.rvaToSectionRef(rva);
+    if (!section.isNull() && !section.data().empty()) {
+        boost::string_ref data = section.data();
+        size_t offset = section.rvaToOffset(rva);
+        if (offset >= data.size()) {
+            return boost::string_ref();
+        }
+        data = data.substr(offset);
+        size_t end = data.find('\0');
+        return end == boost::string_ref::npos ? data : data.substr(0, end);
+    }
+    scratch = file.string(rva);
+    return scratch;
+}
+
+// Bytes outside of printable ASCII are escaped (as if they were Latin-1)
+// so that the output is always valid UTF-8
+
+void appendJSONString(std::string &buffer, boost::string_ref value)
+{
+    static const char Digits[] = "0123456789abcdef";
+
+    buffer.push_back('"');
+    size_t start = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\') {
+            continue;
+        }
+        buffer.append(value.data() + start, i - start);
+        start = i + 1;
+        if (c == '"' || c == '\\') {
+            buffer.push_back('\\');
+            buffer.push_back(static_cast<char>(c));
+        } else {
+            char escape[] = {'\\', 'u', '0', '0', Digits[c >> 4], Digits[c & 0xf]};
+            buffer.append(escape, sizeof(escape));
+        }
+    }
+    buffer.append(value.data() + start, value.size() - start);
+    buffer.push_back('"');
+}
+
+// Fields containing separators, quotes or line breaks are quoted with any
+// quotes doubled
+
+void appendCSVField(std::string &buffer, boost::string_ref value)
+{
+    if (value.find_first_of(",\"\r\n") == boost::string_ref::npos) {
+        buffer.append(value.data(), value.size());
+        return;
+    }
+    buffer.push_back('"');
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '"') {
+            buffer.push_back('"');
+        }
+        buffer.push_back(value[i]);
+    }
+    buffer.push_back('"');
+}
+
+// Functions imported by ordinal are identified as "#<ordinal>"
+
+void appendFunction(std::string &buffer, const ImportTable::FunctionRef &function)
+{
+    if (function.byOrdinal) {
+        buffer.push_back('#');
+        appendDecimal(buffer, function.ordinal);
+    } else {
+        buffer.append(function.name.data(), function.name.size());
+    }
+}
+
+void appendKey(std::string &buffer, const char *key)
+{
+    buffer.append(",\"");
+    buffer.append(key);
+    buffer.append("\":");
+}
+
+void appendHexString(std::string &buffer, uint64_t value)
+{
+    buffer.push_back('"');
+    appendHex(buffer, value);
+    buffer.push_back('"');
+}
+
+}
+
+EmitterPrivate::EmitterPrivate()
+    : mFormat(Emitter::NDJSON),
+      mFields(Emitter::All)
+{
+}
+
+void EmitterPrivate::emitJSON(std::string &buffer, boost::string_ref path, const File &file) const
+{
+    std::string scratch;
+
+    buffer.append("{\"path\":");
+    appendJSONString(buffer, path);
+
+    if (mFields & Emitter::Headers) {
+        appendKey(buffer, "machine");
+        appendHexString(buffer, file.fileHeader().machine());
+        appendKey(buffer, "timeDateStamp");
+        appendDecimal(buffer, file.fileHeader().timeDateStamp());
+        appendKey(buffer, "characteristics");
+        appendHexString(buffer, file.fileHeader().characteristics());
+        appendKey(buffer, "magic");
+        appendHexString(buffer, file.optionalHeader().magic());
+        appendKey(buffer, "subsystem");
+        appendDecimal(buffer, file.optionalHeader().subsystem());
+        appendKey(buffer, "dllCharacteristics");
+        appendHexString(buffer, file.optionalHeader().dllCharacteristics());
+    }
+
+    if (mFields & Emitter::Sections) {
+        appendKey(buffer, "sections");
+        buffer.push_back('[');
+        bool first = true;
+        for (size_t i = 0; i < file.sectionCount(); ++i) {
+            SectionRef section = file.section(i);
+            buffer.append(first ? "{\"name\":" : ",{\"name\":");
+            first = false;
+            appendJSONString(buffer, section.name());
+            appendKey(buffer, "virtualAddress");
+            appendHexString(buffer, section.virtualAddress());
+            appendKey(buffer, "virtualSize");
+            appendDecimal(buffer, section.virtualSize());
+            appendKey(buffer, "pointerToRawData");
+            appendHexString(buffer, section.pointerToRawData());
+            appendKey(buffer, "sizeOfRawData");
+            appendDecimal(buffer, section.sizeOfRawData());
+            appendKey(buffer, "characteristics");
+            appendHexString(buffer, section.characteristics());
+            buffer.push_back('}');
+        }
+        buffer.push_back(']');
+    }
+
+    if (mFields & Emitter::Imports) {
+        appendKey(buffer, "imports");
+        buffer.push_back('[');
+        bool first = true;
+        std::string function;
+        for (const ImportTable::Item &item : file.importTable().items()) {
+            buffer.append(first ? "{\"name\":" : ",{\"name\":");
+            first = false;
+            appendJSONString(buffer, stringAt(file, item.name, scratch));
+            appendKey(buffer, "timeDateStamp");
+            appendDecimal(buffer, item.timeDateStamp);
+            appendKey(buffer, "firstThunk");
+            appendHexString(buffer, item.firstThunk);
+            appendKey(buffer, "functions");
+            buffer.push_back('[');
+            bool firstFunction = true;
+            for (const ImportTable::FunctionRef &ref : file.importedFunctionRefs(item)) {
+                if (!firstFunction) {
+                    buffer.push_back(',');
+                }
+                firstFunction = false;
+                function.clear();
+                appendFunction(function, ref);
+                appendJSONString(buffer, function);
+            }
+            buffer.append("]}");
+        }
+        buffer.push_back(']');
+    }
+
+    if (mFields & Emitter::Derived) {
+        appendKey(buffer, "fileSize");
+        appendDecimal(buffer, file.fileSize());
+        appendKey(buffer, "overlayOffset");
+        appendHexString(buffer, file.overlayOffset());
+        appendKey(buffer, "overlaySize");
+        appendDecimal(buffer, file.overlaySize());
+        appendKey(buffer, "importHash");
+        appendHexString(buffer, CorpusStore::importHash(file));
+    }
+
+    buffer.append("}\n");
+}
+
+void EmitterPrivate::emitCSV(std::string &buffer, boost::string_ref path, const File &file) const
+{
+    std::string scratch;
+
+    appendCSVField(buffer, path);
+
+    if (mFields & Emitter::Headers) {
+        buffer.push_back(',');
+        appendHex(buffer, file.fileHeader().machine());
+        buffer.push_back(',');
+        appendDecimal(buffer, file.fileHeader().timeDateStamp());
+        buffer.push_back(',');
+        appendHex(buffer, file.fileHeader().characteristics());
+        buffer.push_back(',');
+        appendHex(buffer, file.optionalHeader().magic());
+        buffer.push_back(',');
+        appendDecimal(buffer, file.optionalHeader().subsystem());
+        buffer.push_back(',');
+        appendHex(buffer, file.optionalHeader().dllCharacteristics());
+    }
+
+    // Lists are joined into a single field before being quoted
+    std::string list;
+
+    if (mFields & Emitter::Sections) {
+        buffer.push_back(',');
+        appendDecimal(buffer, file.sectionCount());
+        for (size_t i = 0; i < file.sectionCount(); ++i) {
+            if (!list.empty()) {
+                list.push_back(';');
+            }
+            boost::string_ref name = file.section(i).name();
+            list.append(name.data(), name.size());
+        }
+        buffer.push_back(',');
+        appendCSVField(buffer, list);
+    }
+
+    if (mFields & Emitter::Imports) {
+        // Functions are qualified by their DLL as "<dll>!<function>"
+        list.clear();
+        std::string functions;
+        for (const ImportTable::Item &item : file.importTable().items()) {
+            if (!list.empty()) {
+                list.push_back(';');
+            }
+            boost::string_ref name = stringAt(file, item.name, scratch);
+            list.append(name.data(), name.size());
+            for (const ImportTable::FunctionRef &ref : file.importedFunctionRefs(item)) {
+                if (!functions.empty()) {
+                    functions.push_back(';');
+                }
+                functions.append(name.data(), name.size());
+                functions.push_back('!');
+                appendFunction(functions, ref);
+            }
+        }
+        buffer.push_back(',');
+        appendCSVField(buffer, list);
+        buffer.push_back(',');
+        appendCSVField(buffer, functions);
+    }
+
+    if (mFields & Emitter::Derived) {
+        buffer.push_back(',');
+        appendDecimal(buffer, file.fileSize());
+        buffer.push_back(',');
+        appendHex(buffer, file.overlayOffset());
+        buffer.push_back(',');
+        appendDecimal(buffer, file.overlaySize());
+        buffer.push_back(',');
+        appendHex(buffer, CorpusStore::importHash(file));
+    }
+
+    buffer.push_back('\n');
+}
+
+Emitter::Emitter()
+    : d(new EmitterPrivate)
+{
+}
+
+Emitter::Emitter(const Emitter &other)
+    : d(new EmitterPrivate(*other.d))
+{
+}
+
+Emitter::~Emitter()
+{
+    delete d;
+}
+
+Emitter &Emitter::operator=(const Emitter &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+void Emitter::setFormat(Format format)
+{
+    d->mFormat = format;
+}
+
+Emitter::Format Emitter::format() const
+{
+    return d->mFormat;
+}
+
+void Emitter::setFields(int fields)
+{
+    d->mFields = fields;
+}
+
+int Emitter::fields() const
+{
+    return d->mFields;
+}
+
+void Emitter::header(std::string &buffer) const
+{
+    if (d->mFormat != CSV) {
+        return;
+    }
+
+    buffer.append("path");
+    if (d->mFields & Headers) {
+        buffer.append(",machine,timeDateStamp,characteristics,magic,subsystem,dllCharacteristics");
+    }
+    if (d->mFields & Sections) {
+        buffer.append(",numberOfSections,sections");
+    }
+    if (d->mFields & Imports) {
+        buffer.append(",imports,importedFunctions");
+    }
+    if (d->mFields & Derived) {
+        buffer.append(",fileSize,overlayOffset,overlaySize,importHash");
+    }
+    buffer.push_back('\n');
+}
+
+void Emitter::emit(std::string &buffer, boost::string_ref path, const File &file) const
+{
+    if (d->mFormat == CSV) {
+        d->emitCSV(buffer, path, file);
+    } else {
+        d->emitJSON(buffer, path, file);
+    }
+}
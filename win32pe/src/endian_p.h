@@ -0,0 +1,59 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_ENDIAN_P_H
+#define WIN32PE_ENDIAN_P_H
+
+#include <cstring>
+#include <string>
+
+#include <boost/endian/conversion.hpp>
+
+namespace win32pe
+{
+
+/**
+ * @brief Read a little-endian value from a (possibly unaligned) location
+ */
+template<typename T>
+T readLittle(const char *data)
+{
+    T value;
+    memcpy(&value, data, sizeof(value));
+    return boost::endian::little_to_native(value);
+}
+
+/**
+ * @brief Append a value to a buffer in little-endian byte order
+ */
+template<typename T>
+void appendLittle(std::string &buffer, T value)
+{
+    boost::endian::native_to_little_inplace(value);
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}
+
+#endif // WIN32PE_ENDIAN_P_H
@@ -22,26 +22,147 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <utility>
 
-#include <boost/endian/conversion.hpp>
+#include <boost/interprocess/file_mapping.hpp>
 
 #include <win32pe/file.h>
 #include <win32pe/section.h>
+#include <win32pe/symboltable.h>
 
+#include "endian_p.h"
 #include "file_p.h"
+#include "align_p.h"
+#include "digest_p.h"
 #include "fileheader_p.h"
+#include "imageclass_p.h"
+#include "instrumentation_p.h"
+#include "limits_p.h"
+#include "layout_p.h"
+#include "memorystreambuf_p.h"
 #include "optionalheader_p.h"
 #include "section_p.h"
+#include "structs_p.h"
+#include "writer_p.h"
 
 using namespace win32pe;
 
-const int DOSHeaderSize = 0x40;
-const int PEOffsetOffset = 0x3c;
-const int PESignature = 0x4550;
+namespace
+{
+
+// Digests are computed in chunks small enough to stay in cache
+const uint64_t DigestChunkSize = 64 * 1024;
+
+// IMAGE_REL_BASED_HIGHADJ
+const uint16_t HighAdjRelocation = 4;
+
+// Strings in cache records are preceded by their length and imported
+// functions by their count
+
+void appendString(std::string &record, const std::string &value)
+{
+    appendLittle(record, static_cast<uint32_t>(value.size()));
+    record.append(value);
+}
+
+bool readString(const char *data, size_t size, size_t &pos, std::string &value)
+{
+    if (size - pos < sizeof(uint32_t)) {
+        return false;
+    }
+    uint32_t length = readLittle<uint32_t>(data + pos);
+    pos += sizeof(uint32_t);
+    if (length > size - pos) {
+        return false;
+    }
+    value.assign(data + pos, length);
+    pos += length;
+    return true;
+}
+
+void appendFunctions(std::string &record, const File &file, const ImportTable::Item &item)
+{
+    std::string functions;
+    uint32_t count = 0;
+    for (const ImportTable::FunctionRef &function : file.importedFunctionRefs(item)) {
+        functions.push_back(function.byOrdinal ? 1 : 0);
+        appendLittle(functions, function.ordinal);
+        appendLittle(functions, function.hint);
+        appendString(functions, function.name.to_string());
+        ++count;
+    }
+    appendLittle(record, count);
+    record.append(functions);
+}
+
+bool readFunctions(const char *data, size_t size, size_t &pos, std::vector<ImportTable::Function> &functions)
+{
+    const size_t MinimumSize = 1 + 2 * sizeof(uint16_t) + sizeof(uint32_t);
+
+    if (size - pos < sizeof(uint32_t)) {
+        return false;
+    }
+    uint32_t count = readLittle<uint32_t>(data + pos);
+    pos += sizeof(uint32_t);
+    if (count > (size - pos) / MinimumSize) {
+        return false;
+    }
+    functions.resize(count);
+    for (auto it = functions.begin(); it != functions.end(); ++it) {
+        if (size - pos < 1 + 2 * sizeof(uint16_t)) {
+            return false;
+        }
+        (*it).byOrdinal = data[pos] != 0;
+        (*it).ordinal = readLittle<uint16_t>(data + pos + 1);
+        (*it).hint = readLittle<uint16_t>(data + pos + 1 + sizeof(uint16_t));
+        pos += 1 + 2 * sizeof(uint16_t);
+        if (!readString(data, size, pos, (*it).name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void appendDigests(std::string &record, const Digests &digests)
+{
+    appendString(record, digests.md5);
+    appendString(record, digests.sha1);
+    appendString(record, digests.sha256);
+    appendString(record, digests.xxh64);
+}
+
+bool readDigests(const char *data, size_t size, size_t &pos, Digests &digests)
+{
+    return readString(data, size, pos, digests.md5) &&
+           readString(data, size, pos, digests.sha1) &&
+           readString(data, size, pos, digests.sha256) &&
+           readString(data, size, pos, digests.xxh64);
+}
+
+}
 
 FilePrivate::FilePrivate(File *file)
-    : q(file)
+    : q(file),
+      mImageClass(nullptr),
+      mCache(new Cache),
+      mHeaderSlackOffset(0),
+      mSymbolTableOffset(0),
+      mSymbolTableSize(0),
+      mStringTableSize(0),
+      mFileSize(0),
+      mOverlaySourceOffset(0),
+      mOverlayOffset(0),
+      mOverlaySize(0),
+      mImageLayout(false),
+      mHasFileKey(false),
+      mFileKey(),
+      mMetadataOnly(false),
+      mDigestAlgorithms(0),
+      mInstrumentation(nullptr),
+      mLoadedSize(0)
 {
 }
 
@@ -53,20 +174,388 @@ FilePrivate &FilePrivate::operator=(const FilePrivate &other)
     mDOSHeader = other.mDOSHeader;
     mFileHeader = other.mFileHeader;
     mOptionalHeader = other.mOptionalHeader;
-    mSections = other.mSections;
+    mImageClass = other.mImageClass;
+    mSectionTable = other.mSectionTable;
+    mCache.reset(new Cache);
+    mHeaderSlackOffset = other.mHeaderSlackOffset;
+    mHeaderSlack = other.mHeaderSlack;
     mImportTable = other.mImportTable;
+    mSymbolTableOffset = other.mSymbolTableOffset;
+    mSymbolTableSize = other.mSymbolTableSize;
+    mStringTableSize = other.mStringTableSize;
+    mSymbolData = other.mSymbolData;
+    mFileSize = other.mFileSize;
+    mOverlaySourceOffset = other.mOverlaySourceOffset;
+    mOverlayOffset = other.mOverlayOffset;
+    mOverlaySize = other.mOverlaySize;
+    mView = other.mView;
+    mMapping = other.mMapping;
+    mBuffer = other.mBuffer;
+    mImageLayout = other.mImageLayout;
+    mHasFileKey = other.mHasFileKey;
+    mFileKey = other.mFileKey;
+    mMetadataOnly = other.mMetadataOnly;
+    mImportDescriptors = other.mImportDescriptors;
+    mStrings = other.mStrings;
+    mImportFunctions = other.mImportFunctions;
+    mExports = other.mExports;
+    mDigestAlgorithms = other.mDigestAlgorithms;
+    mFileDigests = other.mFileDigests;
+    mOverlayDigests = other.mOverlayDigests;
+    mSectionDigests = other.mSectionDigests;
+    mInstrumentation = other.mInstrumentation;
+    mLimits = other.mLimits;
 
     return *this;
 }
 
+bool FilePrivate::load(std::istream &istream)
+{
+#ifdef WIN32PE_INSTRUMENTATION
+    if (mInstrumentation) {
+        mInstrumentation->d->add(Instrumentation::Loads, 1);
+
+        // Reads and seeks are counted by routing the stream through another
+        // stream buffer rather than adding hooks to each reader
+        CountingStreamBuf streambuf(istream.rdbuf(), mInstrumentation->d);
+        std::istream counted(&streambuf);
+        bool loaded = loadPhases(counted);
+        istream.setstate(counted.rdstate());
+        return loaded;
+    }
+#endif
+    return loadPhases(istream);
+}
+
+bool FilePrivate::loadView(const char *data, size_t size, bool imageLayout)
+{
+    MemoryStreamBuf streambuf(data, size);
+    std::istream istream(&streambuf);
+
+    // The view is set before loading so that the loader can refer to the
+    // data instead of copying it
+    mView = boost::string_ref(data, size);
+    mImageLayout = imageLayout;
+
+    return load(istream);
+}
+
+bool FilePrivate::loadPhases(std::istream &istream)
+{
+    mHasFileKey = false;
+    mMetadataOnly = false;
+    mExports.clear();
+    mImportDescriptors.clear();
+    mStrings.clear();
+    mImportFunctions.clear();
+    clearDigests();
+    mLoadedSize = 0;
+    if (mLimits.d->mTimeBudget) {
+        mDeadline = std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(mLimits.d->mTimeBudget);
+    }
+
+    return readFileSize(istream) &&
+           readDOSHeader(istream) &&
+           readPEHeaders(istream) &&
+           readSections(istream) &&
+           readImportTable() &&
+           readSymbolTable(istream) &&
+           detectOverlay() &&
+           computeDigests(istream);
+}
+
+void FilePrivate::writeHeaders(std::string &buffer) const
+{
+    buffer.append(mDOSHeader);
+    appendLittle(buffer, PESignature);
+    mFileHeader.d->write(buffer);
+    mOptionalHeader.d->write(buffer);
+    for (size_t i = 0; i < mSectionTable.mEntries.size(); ++i) {
+        const SectionEntry &entry = mSectionTable.mEntries[i];
+        mSectionTable.writeHeader(buffer, i, entry.sizeOfRawData, entry.pointerToRawData);
+    }
+}
+
+void FilePrivate::writeMetadata(std::string &record) const
+{
+    // The headers are stored as they appear in the file (with the original
+    // section offsets) so that they can be restored with the usual readers
+
+    std::string headers;
+    writeHeaders(headers);
+
+    appendLittle(record, mFileSize);
+    appendLittle(record, mOverlayOffset);
+    appendLittle(record, mOverlaySize);
+    appendLittle(record, static_cast<uint32_t>(headers.size()));
+    record.append(headers);
+
+    const std::vector<ImportTable::Item> &items = mImportTable.items();
+    appendLittle(record, static_cast<uint32_t>(items.size()));
+    for (auto it = items.begin(); it != items.end(); ++it) {
+        appendLittle(record, (*it).characteristics);
+        appendLittle(record, (*it).timeDateStamp);
+        appendLittle(record, (*it).forwarderChain);
+        appendLittle(record, (*it).name);
+        appendLittle(record, (*it).firstThunk);
+    }
+
+    appendLittle(record, static_cast<uint32_t>(items.size()));
+    for (auto it = items.begin(); it != items.end(); ++it) {
+        appendLittle(record, (*it).name);
+        appendString(record, q->string((*it).name));
+    }
+
+    for (auto it = items.begin(); it != items.end(); ++it) {
+        appendFunctions(record, *q, *it);
+    }
+
+    std::vector<File::Export> exports = q->exports();
+    appendLittle(record, static_cast<uint32_t>(exports.size()));
+    for (auto it = exports.begin(); it != exports.end(); ++it) {
+        appendLittle(record, (*it).ordinal);
+        appendLittle(record, (*it).rva);
+        appendString(record, (*it).name);
+        appendString(record, (*it).forwarder);
+    }
+
+    appendDigests(record, mFileDigests);
+    appendDigests(record, mOverlayDigests);
+    appendLittle(record, static_cast<uint32_t>(mSectionDigests.size()));
+    for (auto it = mSectionDigests.begin(); it != mSectionDigests.end(); ++it) {
+        appendDigests(record, *it);
+    }
+}
+
+bool FilePrivate::readMetadata(const char *data, size_t size)
+{
+    const size_t ItemSize = sizeof(ImportTable::Item);
+
+    mErrorString = "cache record is corrupt";
+
+    // Nothing from a previous load may survive, even if the record turns out
+    // to be corrupt
+    mHasFileKey = false;
+    mMetadataOnly = true;
+    mImportDescriptors.clear();
+    mImportFunctions.clear();
+    mExports.clear();
+    clearDigests();
+
+    if (size < 3 * sizeof(uint64_t) + sizeof(uint32_t)) {
+        return false;
+    }
+    mFileSize = readLittle<uint64_t>(data);
+    mOverlayOffset = readLittle<uint64_t>(data + 8);
+    mOverlaySourceOffset = mOverlayOffset;
+    mOverlaySize = readLittle<uint64_t>(data + 16);
+    uint32_t headersSize = readLittle<uint32_t>(data + 24);
+    size_t pos = 28;
+    if (headersSize > size - pos) {
+        return false;
+    }
+
+    // Parse the headers with the regular readers; the limits are checked
+    // against the size of the headers rather than the original file
+    MemoryStreamBuf streambuf(data + pos, headersSize);
+    std::istream istream(&streambuf);
+    uint64_t fileSize = mFileSize;
+    mFileSize = headersSize;
+    mLoadedSize = 0;
+    if (!readDOSHeader(istream) || !readPEHeaders(istream)) {
+        return false;
+    }
+    invalidateCache();
+    mSectionTable.clear();
+    mSectionTable.mEntries.resize(mFileHeader.d->mNumberOfSections);
+    for (auto it = mSectionTable.mEntries.begin(); it != mSectionTable.mEntries.end(); ++it) {
+        RawSectionHeader raw;
+        if (!istream.read(reinterpret_cast<char*>(&raw), sizeof(raw))) {
+            mErrorString = "cache record is corrupt";
+            return false;
+        }
+        SectionTable::decode(raw, *it);
+    }
+    mFileSize = fileSize;
+    mErrorString = "cache record is corrupt";
+    pos += headersSize;
+
+    // Restore the import table
+    if (size - pos < sizeof(uint32_t)) {
+        return false;
+    }
+    uint32_t count = readLittle<uint32_t>(data + pos);
+    pos += sizeof(uint32_t);
+    if (count > (size - pos) / ItemSize) {
+        return false;
+    }
+    std::string items(data + pos, count * ItemSize);
+    items.append(ItemSize, '\0');
+    mImportTable = ImportTable();
+    if (!mImportTable.load(items)) {
+        return false;
+    }
+    mImportDescriptors.swap(items);
+    pos += count * ItemSize;
+
+    // Restore the strings referenced by the import table
+    mStrings.clear();
+    if (size - pos < sizeof(uint32_t)) {
+        return false;
+    }
+    count = readLittle<uint32_t>(data + pos);
+    pos += sizeof(uint32_t);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (size - pos < sizeof(uint32_t)) {
+            return false;
+        }
+        uint32_t rva = readLittle<uint32_t>(data + pos);
+        pos += sizeof(uint32_t);
+        if (!readString(data, size, pos, mStrings[rva])) {
+            return false;
+        }
+    }
+
+    // Restore the functions imported by each descriptor
+    const std::vector<ImportTable::Item> &importItems = mImportTable.items();
+    for (auto it = importItems.begin(); it != importItems.end(); ++it) {
+        uint32_t rva = (*it).characteristics ? (*it).characteristics : (*it).firstThunk;
+        if (!readFunctions(data, size, pos, mImportFunctions[rva])) {
+            return false;
+        }
+    }
+
+    // Restore the exports, which are decoded from section data that is not
+    // available once restored
+    if (size - pos < sizeof(uint32_t)) {
+        return false;
+    }
+    count = readLittle<uint32_t>(data + pos);
+    pos += sizeof(uint32_t);
+    if (count > (size - pos) / (sizeof(uint16_t) + 3 * sizeof(uint32_t))) {
+        return false;
+    }
+    mExports.resize(count);
+    for (auto it = mExports.begin(); it != mExports.end(); ++it) {
+        if (size - pos < sizeof(uint16_t) + sizeof(uint32_t)) {
+            return false;
+        }
+        (*it).ordinal = readLittle<uint16_t>(data + pos);
+        (*it).rva = readLittle<uint32_t>(data + pos + sizeof(uint16_t));
+        pos += sizeof(uint16_t) + sizeof(uint32_t);
+        if (!readString(data, size, pos, (*it).name) ||
+                !readString(data, size, pos, (*it).forwarder)) {
+            return false;
+        }
+    }
+
+    // Restore the digests computed when the file was loaded
+    if (!readDigests(data, size, pos, mFileDigests) ||
+            !readDigests(data, size, pos, mOverlayDigests) ||
+            size - pos < sizeof(uint32_t)) {
+        return false;
+    }
+    count = readLittle<uint32_t>(data + pos);
+    pos += sizeof(uint32_t);
+    if (count > mSectionTable.mEntries.size()) {
+        return false;
+    }
+    mSectionDigests.resize(count);
+    for (auto it = mSectionDigests.begin(); it != mSectionDigests.end(); ++it) {
+        if (!readDigests(data, size, pos, *it)) {
+            return false;
+        }
+    }
+
+    mHeaderSlack.clear();
+    mHeaderSlackOffset = 0;
+    mSymbolTableOffset = 0;
+    mSymbolTableSize = 0;
+    mStringTableSize = 0;
+    mSymbolData.clear();
+    mView = boost::string_ref();
+    mMapping.reset();
+    mBuffer.reset();
+    mImageLayout = false;
+    mErrorString.clear();
+
+    return true;
+}
+
+uint64_t FilePrivate::headersSize() const
+{
+    return mDOSHeader.size() + sizeof(PESignature) + sizeof(FileHeaderPrivate) +
+        mOptionalHeader.d->size() + mSectionTable.mEntries.size() * sizeof(RawSectionHeader);
+}
+
+boost::string_ref FilePrivate::rvaData(uint32_t rva) const
+{
+    const SectionEntry *entry = findSection(rva);
+    if (!entry) {
+        return boost::string_ref();
+    }
+
+    // The virtual size may exceed the raw data, in which case the remainder
+    // is zero-filled and has no bytes in the file
+    uint32_t offset = rva - entry->virtualAddress;
+    boost::string_ref data = mSectionTable.data(entry - mSectionTable.mEntries.data());
+    if (offset >= data.size()) {
+        return boost::string_ref();
+    }
+    return data.substr(offset);
+}
+
+bool FilePrivate::reserve(uint64_t size)
+{
+    if (size > mLimits.d->mMaxTotalSize - std::min(mLoadedSize, mLimits.d->mMaxTotalSize)) {
+        mErrorString = "file data exceeds size limit";
+        return false;
+    }
+    mLoadedSize += size;
+    return true;
+}
+
+bool FilePrivate::checkTime()
+{
+    if (mLimits.d->mTimeBudget && std::chrono::steady_clock::now() > mDeadline) {
+        mErrorString = "time budget exceeded";
+        return false;
+    }
+    return true;
+}
+
+bool FilePrivate::readFileSize(std::istream &istream)
+{
+    // Sizes in the headers are checked against the size of the file before
+    // anything is allocated, so it must be known up front
+
+    std::streamoff start = istream.tellg();
+    if (start < 0 || !istream.seekg(0, std::ios::end)) {
+        mErrorString = "unable to determine file size";
+        return false;
+    }
+    std::streamoff size = istream.tellg();
+    if (size < 0 || !istream.seekg(start)) {
+        mErrorString = "unable to determine file size";
+        return false;
+    }
+
+    mFileSize = static_cast<uint64_t>(size);
+    return true;
+}
+
 bool FilePrivate::readDOSHeader(std::istream &istream)
 {
     // The DOS header is 64 bytes and contains the signature and offset to the
     // PE headers; keep all of the data in the DOS header up to the offset so
     // that it can be written back to the file later if necessary
 
+    WIN32PE_PHASE(mInstrumentation, DOSHeader);
+
     // Read the header
     mDOSHeader.resize(DOSHeaderSize);
+    WIN32PE_BUFFER(mInstrumentation, DOSHeaderSize);
     if (!istream.read(&mDOSHeader[0], DOSHeaderSize)) {
         mErrorString = "unable to read DOS header";
         return false;
@@ -79,11 +568,22 @@ bool FilePrivate::readDOSHeader(std::istream &istream)
     }
 
     // Determine the offset
-    uint32_t peOffset = *reinterpret_cast<uint32_t*>(&mDOSHeader[0] + PEOffsetOffset);
-    boost::endian::little_to_native_inplace(peOffset);
+    uint32_t peOffset = readLittle<uint32_t>(mDOSHeader.data() + PEOffsetOffset);
+
+    // The PE headers must follow the DOS header and lie within the file
+    if (peOffset < DOSHeaderSize ||
+            peOffset > mLimits.d->mMaxHeaderSize ||
+            peOffset > mFileSize) {
+        mErrorString = "PE header offset is out of range";
+        return false;
+    }
+    if (!reserve(peOffset)) {
+        return false;
+    }
 
     // Read the rest of the data up to the PE headers
     mDOSHeader.resize(peOffset);
+    WIN32PE_BUFFER(mInstrumentation, peOffset);
     if (!istream.read(&mDOSHeader[DOSHeaderSize], peOffset - DOSHeaderSize)) {
         mErrorString = "unable to read to PE headers";
         return false;
@@ -98,16 +598,17 @@ bool FilePrivate::readPEHeaders(std::istream &istream)
     // header; the optional header has different sizes depending on the machine
     // type
 
+    WIN32PE_PHASE(mInstrumentation, PEHeaders);
+
     // Read the signature
-    uint32_t peSignature;
-    if (!istream.read(reinterpret_cast<char*>(&peSignature), sizeof(peSignature))) {
+    char peSignature[sizeof(uint32_t)];
+    if (!istream.read(peSignature, sizeof(peSignature))) {
         mErrorString = "unable to read PE signature";
         return false;
     }
 
     // Verify the signature
-    boost::endian::little_to_native_inplace(peSignature);
-    if (peSignature != PESignature) {
+    if (readLittle<uint32_t>(peSignature) != PESignature) {
         mErrorString = "file is missing PE signature";
         return false;
     }
@@ -123,119 +624,1210 @@ bool FilePrivate::readPEHeaders(std::istream &istream)
         mErrorString = "unable to read optional header";
         return false;
     }
+    mImageClass = imageClass(mOptionalHeader.d->mMagic);
 
     return true;
 }
 
 bool FilePrivate::readSections(std::istream &istream)
 {
-    // Read the sections
-    mSections.resize(mFileHeader.d->mNumberOfSections);
-    for (auto it = mSections.begin(); it != mSections.end(); ++it) {
-        if (!(*it).d->read(istream)) {
+    WIN32PE_PHASE(mInstrumentation, Sections);
+
+    // Validate the size of the section table before allocating it
+    uint32_t numberOfSections = mFileHeader.d->mNumberOfSections;
+    if (numberOfSections > mLimits.d->mMaxSections) {
+        mErrorString = "too many sections";
+        return false;
+    }
+    std::streamoff tableStart = istream.tellg();
+    uint64_t tableEnd = static_cast<uint64_t>(tableStart) +
+        static_cast<uint64_t>(numberOfSections) * sizeof(RawSectionHeader);
+    if (tableStart < 0 || tableEnd > mFileSize || tableEnd > mLimits.d->mMaxHeaderSize) {
+        mErrorString = "section table is out of range";
+        return false;
+    }
+
+    // Read the section headers
+    invalidateCache();
+    mSectionTable.clear();
+    mSectionTable.mEntries.resize(numberOfSections);
+    WIN32PE_BUFFER(mInstrumentation, numberOfSections * sizeof(SectionEntry));
+    for (auto it = mSectionTable.mEntries.begin(); it != mSectionTable.mEntries.end(); ++it) {
+        RawSectionHeader raw;
+        if (!istream.read(reinterpret_cast<char*>(&raw), sizeof(raw))) {
             mErrorString = "unable to read sections";
             return false;
         }
+        SectionTable::decode(raw, *it);
     }
 
-    // Read the import table if present
-    const Section *section = q->rvaToSection(
-        mOptionalHeader.dataDirectory()[OptionalHeader::ImportTable].virtualAddress
+    // Keep the rest of the headers; this is not essential so failure to read
+    // them (or headers that exceed the limits) is not an error
+    mHeaderSlack.clear();
+    mHeaderSlackOffset = static_cast<uint32_t>(tableEnd);
+    uint64_t headersEnd = std::min<uint64_t>(
+        mOptionalHeader.d->mSizeOfHeaders,
+        std::min<uint64_t>(mFileSize, mLimits.d->mMaxHeaderSize)
     );
-    if (section && !mImportTable.load(section->data())) {
-        mErrorString = "unable to read import table";
-        return false;
+    if (tableEnd < headersEnd) {
+        if (reserve(headersEnd - tableEnd)) {
+            mHeaderSlack.resize(static_cast<size_t>(headersEnd - tableEnd));
+            WIN32PE_BUFFER(mInstrumentation, mHeaderSlack.size());
+            if (!istream.read(&mHeaderSlack[0], mHeaderSlack.size())) {
+                mHeaderSlack.clear();
+                istream.clear();
+            }
+        } else {
+            mErrorString.clear();
+        }
     }
 
-    return true;
-}
+    // Validate the bounds of every section before any data is read
+    uint64_t dataSize = 0;
+    for (auto it = mSectionTable.mEntries.begin(); it != mSectionTable.mEntries.end(); ++it) {
+        if (!checkTime()) {
+            return false;
+        }
+        if ((*it).sizeOfRawData > mLimits.d->mMaxSectionSize) {
+            mErrorString = "section exceeds size limit";
+            return false;
+        }
+        if (!mImageLayout &&
+                static_cast<uint64_t>((*it).pointerToRawData) + (*it).sizeOfRawData > mFileSize) {
+            mErrorString = "section data is out of range";
+            return false;
+        }
+        dataSize += (*it).sizeOfRawData;
+    }
 
-File::File()
-    : d(new FilePrivate(this))
-{
-}
+    // In a loaded image the data is at each section's RVA, but only the raw
+    // data came from the file (the rest of the section is zero-filled or
+    // written at run time)
+    if (mImageLayout) {
+        mSectionTable.mView = mView;
+        for (auto it = mSectionTable.mEntries.begin(); it != mSectionTable.mEntries.end(); ++it) {
+            (*it).dataOffset = (*it).virtualAddress;
+            (*it).dataSize = static_cast<uint32_t>(std::min<uint64_t>(
+                (*it).sizeOfRawData,
+                mFileSize - std::min<uint64_t>((*it).virtualAddress, mFileSize)
+            ));
+        }
+        return true;
+    }
 
-File::File(const File &other)
-    : d(new FilePrivate(this))
-{
-    *this = other;
-}
+    // When the file was loaded from memory the data is referred to in place
+    if (!mView.empty()) {
+        mSectionTable.mView = mView;
+        for (auto it = mSectionTable.mEntries.begin(); it != mSectionTable.mEntries.end(); ++it) {
+            (*it).dataOffset = (*it).pointerToRawData;
+            (*it).dataSize = (*it).sizeOfRawData;
+        }
+        return true;
+    }
 
-File::~File()
-{
-    delete d;
-}
+    // Otherwise the data for all of the sections is read into one buffer,
+    // and each section is hashed as soon as it has been read
+    if (!reserve(dataSize)) {
+        return false;
+    }
+    mSectionTable.mData.resize(static_cast<size_t>(dataSize));
+    WIN32PE_BUFFER(mInstrumentation, dataSize);
+    if (mDigestAlgorithms) {
+        mSectionDigests.resize(mSectionTable.mEntries.size());
+    }
+    std::streamoff pos = istream.tellg();
+    uint64_t offset = 0;
+    for (size_t i = 0; i < mSectionTable.mEntries.size(); ++i) {
+        SectionEntry &entry = mSectionTable.mEntries[i];
+        char *data = &mSectionTable.mData[0] + offset;
+        entry.dataOffset = offset;
+        entry.dataSize = entry.sizeOfRawData;
+        if (entry.sizeOfRawData) {
+            if (!checkTime()) {
+                return false;
+            }
+            if (!istream.seekg(entry.pointerToRawData) || !istream.read(data, entry.sizeOfRawData)) {
+                mErrorString = "unable to read sections";
+                return false;
+            }
+            offset += entry.sizeOfRawData;
+        }
+        if (mDigestAlgorithms) {
+            Digester digester(mDigestAlgorithms);
+            digester.update(data, entry.sizeOfRawData);
+            digester.finish(mSectionDigests[i]);
+        }
+    }
 
-File &File::operator=(const File &other)
-{
-    *d = *other.d;
-    return *this;
-}
+    // Return to the end of the headers for the readers that follow
+    if (!istream.seekg(pos)) {
+        mErrorString = "unable to read sections";
+        return false;
+    }
 
-bool File::load(std::istream &istream)
-{
-    return d->readDOSHeader(istream) &&
-           d->readPEHeaders(istream) &&
-           d->readSections(istream);
+    return true;
 }
 
-bool File::load(const std::string &filename)
+bool FilePrivate::readImportTable()
 {
-    std::ifstream ifstream(filename, std::ios::binary);
-    if (ifstream.bad()) {
-        d->mErrorString = "unable to open file";
+    WIN32PE_PHASE(mInstrumentation, ImportTable);
+
+    if (!checkTime()) {
         return false;
     }
 
-    return load(ifstream);
-}
+    // Read the import table if present
+    uint32_t rva = mOptionalHeader.dataDirectory()[OptionalHeader::ImportTable].virtualAddress;
+    const SectionEntry *entry = findSection(rva);
+    boost::string_ref data;
+    if (entry) {
+        data = rvaData(rva);
+    }
+    if (entry && !mImportTable.load(data.data(), data.size(), mLimits.d->mMaxImportDescriptors)) {
+        mErrorString = "unable to read import table";
+        return false;
+    }
 
-const FileHeader &File::fileHeader() const
-{
-    return d->mFileHeader;
+    return true;
 }
 
-const OptionalHeader &File::optionalHeader() const
+bool FilePrivate::readSymbolTable(std::istream &istream)
 {
-    return d->mOptionalHeader;
-}
+    // The symbol table is deprecated for images and the pointer to it is
+    // frequently stale, so a table that cannot be read is simply treated as
+    // absent rather than failing the load
 
-const std::vector<Section> &File::sections() const
-{
-    return d->mSections;
-}
+    WIN32PE_PHASE(mInstrumentation, SymbolTable);
 
-const ImportTable &File::importTable() const
-{
-    return d->mImportTable;
-}
+    if (!checkTime()) {
+        return false;
+    }
 
-const Section *File::rvaToSection(uint32_t rva) const
-{
-    for (auto it = d->mSections.begin(); it != d->mSections.end(); ++it) {
-        if ((*it).containsRVA(rva)) {
-            return &(*it);
-        }
+    mSymbolTableOffset = mFileHeader.d->mPointerToSymbolTable;
+    mSymbolTableSize = 0;
+    mStringTableSize = 0;
+    mSymbolData.clear();
+
+    if (!mSymbolTableOffset || !mFileHeader.d->mNumberOfSymbols || mImageLayout) {
+        return true;
     }
 
-    return nullptr;
-}
+    uint64_t symbolsSize = static_cast<uint64_t>(mFileHeader.d->mNumberOfSymbols) *
+        SymbolTable::RecordSize;
 
-std::string File::string(uint32_t rva) const
+    // The string table immediately follows the symbols and begins with its
+    // own size (including the size field)
+
+    uint32_t stringTableSize = 0;
+
+    if (!mView.empty()) {
+        if (mSymbolTableOffset + symbolsSize > mView.size()) {
+            return true;
+        }
+        uint64_t stringTableOffset = mSymbolTableOffset + symbolsSize;
+        if (stringTableOffset + sizeof(stringTableSize) <= mView.size()) {
+            stringTableSize = readLittle<uint32_t>(mView.data() + stringTableOffset);
+            stringTableSize = static_cast<uint32_t>(
+                std::min<uint64_t>(stringTableSize, mView.size() - stringTableOffset)
+            );
+        }
+    } else {
+        // Both tables are copied, so they must lie within the file and fit
+        // in what remains of the size limit
+        if (mSymbolTableOffset + symbolsSize > mFileSize || !reserve(symbolsSize)) {
+            mErrorString.clear();
+            return true;
+        }
+        if (!istream.seekg(mSymbolTableOffset)) {
+            istream.clear();
+            return true;
+        }
+        mSymbolData.resize(static_cast<size_t>(symbolsSize));
+        WIN32PE_BUFFER(mInstrumentation, mSymbolData.size());
+        if (!istream.read(&mSymbolData[0], mSymbolData.size())) {
+            mSymbolData.clear();
+            istream.clear();
+            return true;
+        }
+        char rawSize[sizeof(stringTableSize)];
+        if (istream.read(rawSize, sizeof(rawSize))) {
+            stringTableSize = readLittle<uint32_t>(rawSize);
+            uint64_t stringTableOffset = mSymbolTableOffset + symbolsSize;
+            stringTableSize = static_cast<uint32_t>(
+                std::min<uint64_t>(stringTableSize, mFileSize - stringTableOffset)
+            );
+            if (stringTableSize > sizeof(stringTableSize) && !reserve(stringTableSize)) {
+                mErrorString.clear();
+                stringTableSize = 0;
+            }
+            if (stringTableSize > sizeof(stringTableSize)) {
+                appendLittle(mSymbolData, stringTableSize);
+                mSymbolData.resize(mSymbolData.size() + stringTableSize - sizeof(stringTableSize));
+                WIN32PE_BUFFER(mInstrumentation, stringTableSize - sizeof(stringTableSize));
+                istream.read(&mSymbolData[symbolsSize + sizeof(stringTableSize)],
+                             stringTableSize - sizeof(stringTableSize));
+                stringTableSize = static_cast<uint32_t>(
+                    sizeof(stringTableSize) + istream.gcount()
+                );
+                mSymbolData.resize(symbolsSize + stringTableSize);
+            }
+        }
+        istream.clear();
+    }
+
+    mSymbolTableSize = static_cast<uint32_t>(symbolsSize);
+    mStringTableSize = stringTableSize > sizeof(stringTableSize) ? stringTableSize : 0;
+
+    return true;
+}
+
+bool FilePrivate::detectOverlay()
+{
+    // Anything past the end of the last section's raw data is overlay - the
+    // headers are included in case there are no sections with data
+
+    WIN32PE_PHASE(mInstrumentation, Overlay);
+
+    if (mImageLayout) {
+        mOverlaySourceOffset = mFileSize;
+        mOverlayOffset = mFileSize;
+        mOverlaySize = 0;
+        return true;
+    }
+
+    uint64_t end = mOptionalHeader.d->mSizeOfHeaders;
+    for (auto it = mSectionTable.mEntries.begin(); it != mSectionTable.mEntries.end(); ++it) {
+        if ((*it).sizeOfRawData) {
+            end = std::max<uint64_t>(
+                end,
+                static_cast<uint64_t>((*it).pointerToRawData) + (*it).sizeOfRawData
+            );
+        }
+    }
+
+    mOverlaySourceOffset = std::min(end, mFileSize);
+    mOverlayOffset = mOverlaySourceOffset;
+    mOverlaySize = mFileSize - mOverlaySourceOffset;
+
+    return true;
+}
+
+bool FilePrivate::computeDigests(std::istream &istream)
+{
+    // Each chunk of the file is passed to every digest of every range that
+    // covers it while it is still in cache, so the file is only read once
+
+    WIN32PE_PHASE(mInstrumentation, Digests);
+
+    if (!mDigestAlgorithms) {
+        return true;
+    }
+
+    const std::vector<SectionEntry> &entries = mSectionTable.mEntries;
+    Digester file(mDigestAlgorithms);
+    Digester overlay(mDigestAlgorithms);
+
+    auto updateOverlay = [&](uint64_t offset, const char *data, size_t size) {
+        uint64_t end = offset + size;
+        if (end > mOverlaySourceOffset) {
+            uint64_t first = std::max(offset, mOverlaySourceOffset);
+            overlay.update(data + (first - offset), static_cast<size_t>(end - first));
+        }
+    };
+
+    if (!mView.empty()) {
+        std::vector<Digester> sections(entries.size(), Digester(mDigestAlgorithms));
+        for (uint64_t offset = 0; offset < mFileSize; offset += DigestChunkSize) {
+            if (!checkTime()) {
+                return false;
+            }
+            const char *data = mView.data() + offset;
+            uint64_t end = std::min(offset + DigestChunkSize, mFileSize);
+            file.update(data, static_cast<size_t>(end - offset));
+            for (size_t i = 0; i < entries.size(); ++i) {
+                // A loaded image has each section's data at its RVA
+                uint64_t start = mImageLayout ? entries[i].dataOffset : entries[i].pointerToRawData;
+                uint64_t first = std::max<uint64_t>(offset, start);
+                uint64_t last = std::min<uint64_t>(
+                    end,
+                    start + (mImageLayout ? entries[i].dataSize : entries[i].sizeOfRawData)
+                );
+                if (first < last) {
+                    sections[i].update(data + (first - offset), static_cast<size_t>(last - first));
+                }
+            }
+            updateOverlay(offset, data, static_cast<size_t>(end - offset));
+        }
+        mSectionDigests.resize(sections.size());
+        for (size_t i = 0; i < sections.size(); ++i) {
+            sections[i].finish(mSectionDigests[i]);
+        }
+    } else {
+        // The sections were hashed as they were read and their data is still
+        // in memory, so only the rest of the file (the headers, any gaps
+        // between sections and the overlay) is read again
+
+        std::vector<size_t> order;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].dataSize) {
+                order.push_back(i);
+            }
+        }
+        std::stable_sort(order.begin(), order.end(), [&entries](size_t a, size_t b) {
+            return entries[a].pointerToRawData < entries[b].pointerToRawData;
+        });
+
+        std::string buffer;
+        uint64_t offset = 0;
+        auto readTo = [&](uint64_t end) {
+            if (offset >= end) {
+                return true;
+            }
+            istream.clear();
+            if (!istream.seekg(offset)) {
+                mErrorString = "unable to read file";
+                return false;
+            }
+            if (buffer.empty()) {
+                buffer.resize(static_cast<size_t>(std::min(DigestChunkSize, mFileSize)));
+                WIN32PE_BUFFER(mInstrumentation, buffer.size());
+            }
+            while (offset < end) {
+                if (!checkTime()) {
+                    return false;
+                }
+                size_t size = static_cast<size_t>(std::min(DigestChunkSize, end - offset));
+                if (!istream.read(&buffer[0], size)) {
+                    mErrorString = "unable to read file";
+                    return false;
+                }
+                file.update(buffer.data(), size);
+                updateOverlay(offset, buffer.data(), size);
+                offset += size;
+            }
+            return true;
+        };
+
+        for (auto it = order.begin(); it != order.end(); ++it) {
+            const SectionEntry &entry = entries[*it];
+            uint64_t start = entry.pointerToRawData;
+            uint64_t end = start + entry.dataSize;
+            if (end <= offset) {
+                continue;
+            }
+            if (!readTo(start)) {
+                return false;
+            }
+            boost::string_ref data = mSectionTable.data(*it);
+            file.update(data.data() + (offset - start), static_cast<size_t>(end - offset));
+            updateOverlay(offset, data.data() + (offset - start), static_cast<size_t>(end - offset));
+            offset = end;
+        }
+        if (!readTo(mFileSize)) {
+            return false;
+        }
+    }
+
+    file.finish(mFileDigests);
+    overlay.finish(mOverlayDigests);
+
+    return true;
+}
+
+void FilePrivate::clearDigests()
+{
+    mFileDigests = Digests();
+    mOverlayDigests = Digests();
+    mSectionDigests.clear();
+}
+
+bool FilePrivate::addSection(const std::string &name, uint32_t characteristics, const std::string &data)
+{
+    if (name.size() > SECTION_NAME_SIZE) {
+        mErrorString = "section name is too long";
+        return false;
+    }
+
+    SectionEntry entry = {};
+    memcpy(entry.name, name.data(), name.size());
+    entry.characteristics = characteristics;
+    entry.virtualSize = static_cast<uint32_t>(data.size());
+    if (!mSectionTable.mEntries.empty()) {
+        // Place it after the end of the last section; the layout will align it
+        const SectionEntry &last = mSectionTable.mEntries.back();
+        entry.virtualAddress = last.virtualAddress + std::max(last.virtualSize, last.sizeOfRawData);
+    }
+    mSectionTable.append(entry, std::string());
+
+    return setSectionData(mSectionTable.mEntries.size() - 1, data);
+}
+
+bool FilePrivate::removeSection(size_t index)
+{
+    std::vector<SectionEntry> &entries = mSectionTable.mEntries;
+    if (index >= entries.size()) {
+        mErrorString = "invalid section index";
+        return false;
+    }
+    invalidateCache();
+
+    // The digests describe the file as it was loaded, and the section indices
+    // would no longer match it
+    clearDigests();
+
+    // Clear any directory entries referring to the section
+    const SectionEntry &section = entries[index];
+    OptionalHeader::DataDirectoryItem *dataDirectory = mOptionalHeader.d->mDataDirectory;
+    for (int i = 0; i < OptionalHeader::DataDirectoryCount; ++i) {
+        uint32_t rva = dataDirectory[i].virtualAddress;
+        if (i != OptionalHeader::CertificateTable && rva &&
+                section.virtualAddress <= rva && rva < section.virtualAddress + section.virtualSize) {
+            dataDirectory[i].virtualAddress = 0;
+            dataDirectory[i].size = 0;
+        }
+    }
+
+    // Close the hole in memory using the previous section - or, for the
+    // first section, the headers (which then push the section data along in
+    // the file, since the headers must be as large in the file as in memory)
+    if (index + 1 < entries.size()) {
+        if (index > 0) {
+            SectionEntry &previous = entries[index - 1];
+            previous.virtualSize = entries[index + 1].virtualAddress - previous.virtualAddress;
+        } else {
+            mOptionalHeader.d->mSizeOfHeaders = entries[index + 1].virtualAddress;
+        }
+    }
+
+    mSectionTable.erase(index);
+
+    Layout layout(this);
+    if (!layout.update(index)) {
+        mErrorString = layout.mErrorString;
+        return false;
+    }
+    layoutChanged();
+    return true;
+}
+
+bool FilePrivate::resizeSection(size_t index, uint32_t size)
+{
+    if (index >= mSectionTable.mEntries.size()) {
+        mErrorString = "invalid section index";
+        return false;
+    }
+
+    boost::string_ref current = mSectionTable.data(index);
+    std::string data(current.data(), current.size());
+    data.resize(size);
+    return setSectionData(index, data);
+}
+
+bool FilePrivate::setSectionData(size_t index, const std::string &data)
+{
+    if (index >= mSectionTable.mEntries.size()) {
+        mErrorString = "invalid section index";
+        return false;
+    }
+    invalidateCache();
+    clearDigests();
+
+    uint32_t fileAlignment = mOptionalHeader.d->mFileAlignment;
+    if (!isPowerOfTwo(fileAlignment)) {
+        mErrorString = "invalid file or section alignment";
+        return false;
+    }
+
+    // The raw data is always padded to the file alignment
+    size_t size = static_cast<size_t>(alignUp(data.size(), fileAlignment));
+    std::string padded;
+    padded.reserve(size);
+    padded.assign(data);
+    padded.resize(size);
+    mSectionTable.setData(index, std::move(padded));
+    SectionEntry &section = mSectionTable.mEntries[index];
+    section.sizeOfRawData = section.dataSize;
+    section.virtualSize = std::max(section.virtualSize, static_cast<uint32_t>(data.size()));
+
+    Layout layout(this);
+    if (!layout.update(index)) {
+        mErrorString = layout.mErrorString;
+        return false;
+    }
+    layoutChanged();
+    return true;
+}
+
+void FilePrivate::layoutChanged()
+{
+    // The import table is parsed again from the current data; one that can
+    // no longer be read is dropped rather than failing the edit
+    mImportTable = ImportTable();
+    uint32_t rva = mOptionalHeader.dataDirectory()[OptionalHeader::ImportTable].virtualAddress;
+    if (findSection(rva)) {
+        boost::string_ref data = rvaData(rva);
+        if (!mImportTable.load(data.data(), data.size(), mLimits.d->mMaxImportDescriptors)) {
+            mImportTable = ImportTable();
+        }
+    }
+
+    if (mImageLayout) {
+        return;
+    }
+
+    // The overlay will be written after the last section's data, as padded
+    // by the writer, and file offsets in the headers that point into it
+    // move along with it
+    uint32_t fileAlignment = mOptionalHeader.d->mFileAlignment;
+    uint64_t end = mOptionalHeader.d->mSizeOfHeaders;
+    for (auto it = mSectionTable.mEntries.begin(); it != mSectionTable.mEntries.end(); ++it) {
+        if ((*it).sizeOfRawData) {
+            end = std::max<uint64_t>(
+                end,
+                (*it).pointerToRawData + alignUp((*it).sizeOfRawData, fileAlignment)
+            );
+        }
+    }
+    if (mOverlaySize) {
+        OptionalHeader::DataDirectoryItem &certificateTable =
+            mOptionalHeader.d->mDataDirectory[OptionalHeader::CertificateTable];
+        if (certificateTable.virtualAddress >= mOverlayOffset) {
+            certificateTable.virtualAddress = static_cast<uint32_t>(
+                certificateTable.virtualAddress - mOverlayOffset + end
+            );
+        }
+        uint32_t &pointerToSymbolTable = mFileHeader.d->mPointerToSymbolTable;
+        if (pointerToSymbolTable >= mOverlayOffset) {
+            pointerToSymbolTable = static_cast<uint32_t>(pointerToSymbolTable - mOverlayOffset + end);
+        }
+    }
+    mOverlayOffset = end;
+}
+
+FilePrivate::Cache::Cache()
+    : mOverlapping(false)
+{
+}
+
+const std::vector<Section> &FilePrivate::sections() const
+{
+    Cache *cache = mCache.get();
+    std::call_once(cache->mSectionsFlag, [this, cache]() {
+        cache->mSections.resize(mSectionTable.mEntries.size());
+        for (size_t i = 0; i < cache->mSections.size(); ++i) {
+            const SectionEntry &entry = mSectionTable.mEntries[i];
+            SectionPrivate *section = cache->mSections[i].d;
+            memcpy(section->mName, entry.name, SECTION_NAME_SIZE);
+            section->mPhysicalAddressVirtualSize = entry.virtualSize;
+            section->mVirtualAddress = entry.virtualAddress;
+            section->mSizeOfRawData = entry.sizeOfRawData;
+            section->mPointerToRawData = entry.pointerToRawData;
+            section->mPointerToRelocations = entry.pointerToRelocations;
+            section->mPointerToLinenumbers = entry.pointerToLinenumbers;
+            section->mNumberOfRelocations = entry.numberOfRelocations;
+            section->mNumberOfLinenumbers = entry.numberOfLinenumbers;
+            section->mCharacteristics = entry.characteristics;
+            boost::string_ref data = mSectionTable.data(i);
+            section->mData.assign(data.data(), data.size());
+        }
+    });
+
+    return cache->mSections;
+}
+
+const SectionEntry *FilePrivate::findSection(uint32_t rva) const
 {
-    const Section *section = rvaToSection(rva);
-    std::string value;
+    const std::vector<SectionEntry> &entries = mSectionTable.mEntries;
 
-    if (section) {
-        for (uint32_t i = section->rvaToOffset(rva); i < section->data().size(); ++i) {
-            if (section->data()[i] == '\0') {
+    Cache *cache = mCache.get();
+    std::call_once(cache->mRvaIndexFlag, [&entries, cache]() {
+        cache->mRvaIndex.resize(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            cache->mRvaIndex[i] = static_cast<uint32_t>(i);
+        }
+        std::stable_sort(cache->mRvaIndex.begin(), cache->mRvaIndex.end(), [&entries](uint32_t a, uint32_t b) {
+            return entries[a].virtualAddress < entries[b].virtualAddress;
+        });
+        for (size_t i = 1; i < cache->mRvaIndex.size(); ++i) {
+            const SectionEntry &previous = entries[cache->mRvaIndex[i - 1]];
+            if (static_cast<uint64_t>(previous.virtualAddress) + previous.virtualSize >
+                    entries[cache->mRvaIndex[i]].virtualAddress) {
+                cache->mOverlapping = true;
                 break;
             }
-            value.append(1, section->data()[i]);
         }
+    });
+
+    if (cache->mOverlapping) {
+        return mSectionTable.find(rva);
+    }
+
+    // Find the last section starting at or before the RVA
+    auto it = std::upper_bound(cache->mRvaIndex.begin(), cache->mRvaIndex.end(), rva, [&entries](uint32_t rva, uint32_t index) {
+        return rva < entries[index].virtualAddress;
+    });
+    if (it == cache->mRvaIndex.begin()) {
+        return nullptr;
+    }
+    const SectionEntry &entry = entries[*(it - 1)];
+    return rva - entry.virtualAddress < entry.virtualSize ? &entry : nullptr;
+}
+
+void FilePrivate::invalidateCache()
+{
+    mCache.reset(new Cache);
+}
+
+File::File()
+    : d(new FilePrivate(this))
+{
+}
+
+File::File(const File &other)
+    : d(new FilePrivate(this))
+{
+    *this = other;
+}
+
+File::~File()
+{
+    delete d;
+}
+
+File &File::operator=(const File &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+bool File::load(std::istream &istream)
+{
+    d->mView = boost::string_ref();
+    d->mMapping.reset();
+    d->mBuffer.reset();
+    d->mImageLayout = false;
+
+    return d->load(istream);
+}
+
+bool File::load(const std::string &filename)
+{
+    // The identity is read first so that a change made while loading is
+    // noticed by the metadata cache
+    FileKey key;
+    bool hasKey = FileKey::read(filename, key);
+
+    std::ifstream ifstream(filename, std::ios::binary);
+    if (ifstream.bad()) {
+        d->mErrorString = "unable to open file";
+        return false;
+    }
+
+    if (!load(ifstream)) {
+        return false;
+    }
+    d->mHasFileKey = hasKey;
+    d->mFileKey = key;
+    return true;
+}
+
+bool File::load(const char *data, size_t size)
+{
+    // The caller's data is copied once so that it may be released as soon as
+    // this returns; the copy is shared between copies of the File
+    std::shared_ptr<const std::string> buffer = std::make_shared<std::string>(data, size);
+    d->mMapping.reset();
+    d->mBuffer = buffer;
+
+    return d->loadView(buffer->data(), buffer->size(), false);
+}
+
+bool File::map(const std::string &filename)
+{
+    FileKey key;
+    bool hasKey = FileKey::read(filename, key);
+
+    std::shared_ptr<boost::interprocess::mapped_region> mapping;
+    try {
+        boost::interprocess::file_mapping file(filename.c_str(), boost::interprocess::read_only);
+        mapping = std::make_shared<boost::interprocess::mapped_region>(
+            file,
+            boost::interprocess::read_only
+        );
+    } catch (const boost::interprocess::interprocess_exception &) {
+        d->mErrorString = "unable to map file";
+        return false;
+    }
+
+    d->mMapping = mapping;
+    d->mBuffer.reset();
+
+    if (!d->loadView(static_cast<const char*>(mapping->get_address()), mapping->get_size(), false)) {
+        return false;
+    }
+    d->mHasFileKey = hasKey;
+    d->mFileKey = key;
+    return true;
+}
+
+bool File::loadImage(const char *data, size_t size)
+{
+    d->mMapping.reset();
+    d->mBuffer.reset();
+
+    return d->loadView(data, size, true);
+}
+
+bool File::isImage() const
+{
+    return d->mImageLayout;
+}
+
+void File::setInstrumentation(Instrumentation *instrumentation)
+{
+    d->mInstrumentation = instrumentation;
+}
+
+Instrumentation *File::instrumentation() const
+{
+    return d->mInstrumentation;
+}
+
+void File::setLimits(const Limits &limits)
+{
+    d->mLimits = limits;
+}
+
+const Limits &File::limits() const
+{
+    return d->mLimits;
+}
+
+void File::setDigestAlgorithms(int algorithms)
+{
+    d->mDigestAlgorithms = algorithms;
+}
+
+int File::digestAlgorithms() const
+{
+    return d->mDigestAlgorithms;
+}
+
+bool File::save(std::ostream &ostream) const
+{
+    Writer writer(d);
+    if (!writer.prepare()) {
+        d->mErrorString = writer.mErrorString;
+        return false;
+    }
+
+    if (!writer.write(ostream)) {
+        d->mErrorString = "unable to write file";
+        return false;
+    }
+
+    return true;
+}
+
+bool File::save(const std::string &filename) const
+{
+    Writer writer(d);
+    if (!writer.prepare()) {
+        d->mErrorString = writer.mErrorString;
+        return false;
+    }
+
+    if (!writer.write(filename)) {
+        d->mErrorString = "unable to write file";
+        return false;
+    }
+
+    return true;
+}
+
+bool File::addSection(const std::string &name, uint32_t characteristics, const std::string &data)
+{
+    return d->addSection(name, characteristics, data);
+}
+
+bool File::removeSection(size_t index)
+{
+    return d->removeSection(index);
+}
+
+bool File::resizeSection(size_t index, uint32_t size)
+{
+    return d->resizeSection(index, size);
+}
+
+bool File::setSectionData(size_t index, const std::string &data)
+{
+    return d->setSectionData(index, data);
+}
+
+const FileHeader &File::fileHeader() const
+{
+    return d->mFileHeader;
+}
+
+const OptionalHeader &File::optionalHeader() const
+{
+    return d->mOptionalHeader;
+}
+
+const std::vector<Section> &File::sections() const
+{
+    return d->sections();
+}
+
+size_t File::sectionCount() const
+{
+    return d->mSectionTable.mEntries.size();
+}
+
+SectionRef File::section(size_t index) const
+{
+    return SectionRef(&d->mSectionTable, &d->mSectionTable.mEntries[index]);
+}
+
+Range<SectionIterator> File::sectionRefs() const
+{
+    return Range<SectionIterator>(
+        SectionIterator(&d->mSectionTable, 0),
+        SectionIterator(&d->mSectionTable, d->mSectionTable.mEntries.size())
+    );
+}
+
+const Digests &File::fileDigests() const
+{
+    return d->mFileDigests;
+}
+
+const Digests &File::sectionDigests(size_t index) const
+{
+    static const Digests Empty;
+    return index < d->mSectionDigests.size() ? d->mSectionDigests[index] : Empty;
+}
+
+const Digests &File::overlayDigests() const
+{
+    return d->mOverlayDigests;
+}
+
+const ImportTable &File::importTable() const
+{
+    return d->mImportTable;
+}
+
+std::vector<ImportTable::Function> File::importedFunctions(const ImportTable::Item &item) const
+{
+    std::vector<ImportTable::Function> functions;
+    if (d->mMetadataOnly) {
+        auto it = d->mImportFunctions.find(item.characteristics ? item.characteristics : item.firstThunk);
+        if (it != d->mImportFunctions.end()) {
+            functions = it->second;
+        }
+        return functions;
+    }
+    if (!d->mImageClass) {
+        return functions;
+    }
+
+    boost::string_ref data = d->rvaData(item.characteristics ? item.characteristics : item.firstThunk);
+    std::vector<Thunk> thunks;
+    d->mImageClass->readThunks(data.data(), data.size(), thunks);
+
+    functions.resize(thunks.size());
+    for (size_t i = 0; i < thunks.size(); ++i) {
+        ImportTable::Function &function = functions[i];
+        function.byOrdinal = thunks[i].byOrdinal != 0;
+        function.ordinal = function.byOrdinal ? static_cast<uint16_t>(thunks[i].value) : 0;
+        function.hint = 0;
+        if (!function.byOrdinal) {
+            // The hint/name entry is a 16-bit hint followed by the name
+            boost::string_ref entry = d->rvaData(thunks[i].value);
+            if (entry.size() >= sizeof(uint16_t)) {
+                function.hint = readLittle<uint16_t>(entry.data());
+                function.name = string(thunks[i].value + sizeof(uint16_t));
+            }
+        }
+    }
+
+    return functions;
+}
+
+Range<ImportDescriptorIterator> File::importDescriptors() const
+{
+    boost::string_ref data = d->mMetadataOnly ? boost::string_ref(d->mImportDescriptors) : d->rvaData(
+        d->mOptionalHeader.dataDirectory()[OptionalHeader::ImportTable].virtualAddress
+    );
+    if (data.empty()) {
+        return Range<ImportDescriptorIterator>(ImportDescriptorIterator(), ImportDescriptorIterator());
+    }
+    return Range<ImportDescriptorIterator>(
+        ImportDescriptorIterator(data.data(), data.size()),
+        ImportDescriptorIterator()
+    );
+}
+
+Range<ImportFunctionIterator> File::importedFunctionRefs(const ImportTable::Item &item) const
+{
+    if (d->mMetadataOnly) {
+        auto it = d->mImportFunctions.find(item.characteristics ? item.characteristics : item.firstThunk);
+        if (it == d->mImportFunctions.end() || it->second.empty()) {
+            return Range<ImportFunctionIterator>(ImportFunctionIterator(), ImportFunctionIterator());
+        }
+        return Range<ImportFunctionIterator>(
+            ImportFunctionIterator(it->second.data(), it->second.size()),
+            ImportFunctionIterator()
+        );
+    }
+
+    boost::string_ref data;
+    if (d->mImageClass) {
+        data = d->rvaData(item.characteristics ? item.characteristics : item.firstThunk);
+    }
+    if (data.empty()) {
+        return Range<ImportFunctionIterator>(ImportFunctionIterator(), ImportFunctionIterator());
+    }
+    return Range<ImportFunctionIterator>(
+        ImportFunctionIterator(this, d->mImageClass, data.data(), data.size()),
+        ImportFunctionIterator()
+    );
+}
+
+std::vector<File::Relocation> File::relocations() const
+{
+    std::vector<Relocation> relocations;
+
+    const OptionalHeader::DataDirectoryItem &directory =
+        d->mOptionalHeader.dataDirectory()[OptionalHeader::BaseRelocationTable];
+    boost::string_ref data = d->rvaData(directory.virtualAddress);
+    data = data.substr(0, directory.size);
+
+    // The table is a sequence of blocks, each covering a 4 KB page with a
+    // 16-bit entry per fixup - the type in the top four bits and the offset
+    // within the page in the rest. A HIGHADJ fixup takes the following slot
+    // as its parameter (the low half of the adjusted value), which is not an
+    // entry of its own
+    const RawBaseRelocationBlock *block;
+    for (size_t offset = 0;
+            (block = rawView<RawBaseRelocationBlock>(data.data(), data.size(), offset));
+            offset += block->sizeOfBlock.value()) {
+        uint32_t sizeOfBlock = block->sizeOfBlock.value();
+        if (sizeOfBlock < sizeof(*block) || sizeOfBlock > data.size() - offset) {
+            break;
+        }
+
+        uint32_t page = block->virtualAddress.value();
+        const le16 *entries = reinterpret_cast<const le16*>(block + 1);
+        size_t count = (sizeOfBlock - sizeof(*block)) / sizeof(le16);
+        for (size_t i = 0; i < count; ++i) {
+            uint16_t entry = entries[i].value();
+            if (entry >> 12) {
+                Relocation relocation;
+                relocation.rva = page + (entry & 0xfff);
+                relocation.type = entry >> 12;
+                relocations.push_back(relocation);
+                if (relocation.type == HighAdjRelocation) {
+                    ++i;
+                }
+            }
+        }
+    }
+
+    return relocations;
+}
+
+std::vector<File::Export> File::exports() const
+{
+    if (d->mMetadataOnly) {
+        return d->mExports;
+    }
+
+    std::vector<Export> exports;
+
+    const OptionalHeader::DataDirectoryItem &directory =
+        d->mOptionalHeader.dataDirectory()[OptionalHeader::ExportTable];
+    boost::string_ref data = d->rvaData(directory.virtualAddress);
+    const RawExportDirectory *raw = rawView<RawExportDirectory>(data.data(), data.size());
+    if (!raw) {
+        return exports;
+    }
+
+    // Each array is clamped to the data available so that corrupt counts
+    // cannot cause reads past the end of a section
+    boost::string_ref functions = d->rvaData(raw->addressOfFunctions.value());
+    boost::string_ref names = d->rvaData(raw->addressOfNames.value());
+    boost::string_ref ordinals = d->rvaData(raw->addressOfNameOrdinals.value());
+    size_t functionCount = std::min<size_t>(raw->numberOfFunctions.value(), functions.size() / sizeof(uint32_t));
+    size_t nameCount = std::min<size_t>(raw->numberOfNames.value(), std::min(
+        names.size() / sizeof(uint32_t),
+        ordinals.size() / sizeof(uint16_t)
+    ));
+
+    // Names refer to entries in the export address table by index
+    std::vector<std::vector<uint32_t>> entryNames(functionCount);
+    for (size_t i = 0; i < nameCount; ++i) {
+        uint16_t index = readLittle<uint16_t>(ordinals.data() + i * sizeof(uint16_t));
+        if (index < functionCount) {
+            entryNames[index].push_back(readLittle<uint32_t>(names.data() + i * sizeof(uint32_t)));
+        }
+    }
+
+    // An RVA inside the export directory points to a forwarder string
+    uint32_t base = raw->base.value();
+    for (size_t i = 0; i < functionCount; ++i) {
+        uint32_t rva = readLittle<uint32_t>(functions.data() + i * sizeof(uint32_t));
+        if (!rva) {
+            continue;
+        }
+
+        Export item;
+        item.ordinal = static_cast<uint16_t>(base + i);
+        item.rva = rva;
+        if (rva - directory.virtualAddress < directory.size) {
+            item.rva = 0;
+            item.forwarder = string(rva);
+        }
+        if (entryNames[i].empty()) {
+            exports.push_back(item);
+        }
+        for (auto it = entryNames[i].begin(); it != entryNames[i].end(); ++it) {
+            item.name = string(*it);
+            exports.push_back(item);
+        }
+    }
+
+    return exports;
+}
+
+SymbolTable File::symbolTable() const
+{
+    if (!d->mSymbolTableSize) {
+        return SymbolTable();
     }
 
-    return value;
+    boost::string_ref data = d->mView.empty() ?
+        boost::string_ref(d->mSymbolData) :
+        d->mView.substr(static_cast<size_t>(d->mSymbolTableOffset));
+
+    return SymbolTable(
+        data.substr(0, d->mSymbolTableSize),
+        data.substr(d->mSymbolTableSize, d->mStringTableSize)
+    );
+}
+
+const Section *File::rvaToSection(uint32_t rva) const
+{
+    const SectionEntry *entry = d->findSection(rva);
+    if (!entry) {
+        return nullptr;
+    }
+    return &d->sections()[entry - d->mSectionTable.mEntries.data()];
+}
+
+SectionRef File::rvaToSectionRef(uint32_t rva) const
+{
+    const SectionEntry *entry = d->findSection(rva);
+    if (!entry) {
+        return SectionRef();
+    }
+    return SectionRef(&d->mSectionTable, entry);
+}
+
+std::string File::string(uint32_t rva) const
+{
+    if (!d->mStrings.empty()) {
+        auto it = d->mStrings.find(rva);
+        if (it != d->mStrings.end()) {
+            return it->second;
+        }
+    }
+
+    boost::string_ref data = d->rvaData(rva);
+    const char *end = static_cast<const char*>(memchr(data.data(), '\0', data.size()));
+    return std::string(data.data(), end ? end - data.data() : data.size());
+}
+
+uint64_t File::fileSize() const
+{
+    return d->mFileSize;
+}
+
+uint64_t File::overlayOffset() const
+{
+    return d->mOverlayOffset;
+}
+
+uint64_t File::overlaySize() const
+{
+    return d->mOverlaySize;
+}
+
+bool File::overlayOverlapsCertificateTable() const
+{
+    // The "virtual address" of the certificate table is actually a file offset
+    const OptionalHeader::DataDirectoryItem &item =
+        d->mOptionalHeader.dataDirectory()[OptionalHeader::CertificateTable];
+
+    if (!d->mOverlaySize || !item.virtualAddress || !item.size) {
+        return false;
+    }
+
+    uint64_t begin = item.virtualAddress;
+    uint64_t end = begin + item.size;
+    return begin < d->mOverlayOffset + d->mOverlaySize && d->mOverlayOffset < end;
+}
+
+boost::string_ref File::overlay() const
+{
+    if (d->mView.empty()) {
+        return boost::string_ref();
+    }
+    return d->mView.substr(
+        static_cast<size_t>(d->mOverlaySourceOffset),
+        static_cast<size_t>(d->mOverlaySize)
+    );
+}
+
+bool File::readOverlay(const ChunkCallback &callback, size_t chunkSize) const
+{
+    if (!chunkSize || (d->mOverlaySize && d->mView.empty())) {
+        return false;
+    }
+
+    boost::string_ref overlay = this->overlay();
+    for (size_t i = 0; i < overlay.size(); i += chunkSize) {
+        if (!callback(d->mOverlayOffset + i, overlay.substr(i, chunkSize))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool File::readOverlay(std::istream &istream, const ChunkCallback &callback, size_t chunkSize) const
+{
+    if (!chunkSize) {
+        return false;
+    }
+
+    istream.clear();
+    if (!istream.seekg(d->mOverlaySourceOffset)) {
+        return false;
+    }
+
+    std::vector<char> buffer(static_cast<size_t>(std::min<uint64_t>(chunkSize, d->mOverlaySize)));
+    for (uint64_t i = 0; i < d->mOverlaySize; i += buffer.size()) {
+        size_t size = static_cast<size_t>(std::min<uint64_t>(buffer.size(), d->mOverlaySize - i));
+        if (!istream.read(&buffer[0], size) ||
+                !callback(d->mOverlayOffset + i, boost::string_ref(&buffer[0], size))) {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 std::string File::errorString() const
@@ -25,18 +25,38 @@
 #ifndef WIN32PE_FILE_P_H
 #define WIN32PE_FILE_P_H
 
+#include <chrono>
+#include <cstdint>
 #include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include <win32pe/digests.h>
 #include <win32pe/file.h>
 #include <win32pe/fileheader.h>
 #include <win32pe/importtable.h>
+#include <win32pe/limits.h>
 #include <win32pe/optionalheader.h>
+#include <win32pe/section.h>
+
+#include "filekey_p.h"
+#include "sectiontable_p.h"
 
 namespace win32pe
 {
 
-class Section;
+const int DOSHeaderSize = 0x40;
+const int PEOffsetOffset = 0x3c;
+const uint32_t PESignature = 0x4550;
+
+struct ImageClass;
+class Instrumentation;
 
 class FilePrivate
 {
@@ -46,9 +66,46 @@ public:
 
     FilePrivate &operator=(const FilePrivate &other);
 
+    bool load(std::istream &istream);
+    bool loadView(const char *data, size_t size, bool imageLayout);
+    bool loadPhases(std::istream &istream);
+
+    bool readFileSize(std::istream &istream);
     bool readDOSHeader(std::istream &istream);
     bool readPEHeaders(std::istream &istream);
     bool readSections(std::istream &istream);
+    bool readImportTable();
+    bool readSymbolTable(std::istream &istream);
+    bool detectOverlay();
+    bool computeDigests(std::istream &istream);
+    void clearDigests();
+
+    // Account for data copied from the file and check the time budget
+    bool reserve(uint64_t size);
+    bool checkTime();
+
+    bool addSection(const std::string &name, uint32_t characteristics, const std::string &data);
+    bool removeSection(size_t index);
+    bool resizeSection(size_t index, uint32_t size);
+    bool setSectionData(size_t index, const std::string &data);
+
+    // Bring everything derived from the layout (the import table and the
+    // position of the overlay) up to date after the sections have changed
+    void layoutChanged();
+
+    // Serialize the parsed headers as they appear in the file
+    void writeHeaders(std::string &buffer) const;
+
+    // Serialize the parsed headers and import table (including the strings
+    // it refers to) for the metadata cache and restore them
+    void writeMetadata(std::string &record) const;
+    bool readMetadata(const char *data, size_t size);
+
+    // Size of the headers up to the end of the section table
+    uint64_t headersSize() const;
+
+    // Raw data from an RVA to the end of the section containing it
+    boost::string_ref rvaData(uint32_t rva) const;
 
     File *const q;
 
@@ -58,9 +115,99 @@ public:
     FileHeader mFileHeader;
     OptionalHeader mOptionalHeader;
 
-    std::vector<Section> mSections;
+    // Parsers for the image class, chosen once the optional header is read
+    const ImageClass *mImageClass;
+
+    SectionTable mSectionTable;
+
+    // Data derived from the section table on first use - each part is built
+    // under a once flag so that concurrent const access is safe, and the
+    // whole cache is replaced whenever the table changes
+
+    struct Cache
+    {
+        Cache();
+
+        std::once_flag mSectionsFlag;
+        std::vector<Section> mSections;
+
+        // Section indices ordered by address for binary search; sections that
+        // overlap in memory fall back to the table's linear search, which
+        // prefers the first match
+        std::once_flag mRvaIndexFlag;
+        std::vector<uint32_t> mRvaIndex;
+        bool mOverlapping;
+    };
+
+    const std::vector<Section> &sections() const;
+    const SectionEntry *findSection(uint32_t rva) const;
+    void invalidateCache();
+
+    std::unique_ptr<Cache> mCache;
+
+    // Anything following the section table within the headers (such as
+    // bound import descriptors) is kept so that it can be written back
+
+    uint32_t mHeaderSlackOffset;
+    std::string mHeaderSlack;
 
     ImportTable mImportTable;
+
+    // The symbol and string tables are only copied when the file was not
+    // loaded from memory
+
+    uint64_t mSymbolTableOffset;
+    uint32_t mSymbolTableSize;
+    uint32_t mStringTableSize;
+    std::string mSymbolData;
+
+    // The overlay is read from where it was in the data the file was loaded
+    // from, but starts at the end of the section data as currently laid out
+
+    uint64_t mFileSize;
+    uint64_t mOverlaySourceOffset;
+    uint64_t mOverlayOffset;
+    uint64_t mOverlaySize;
+
+    // Contents of the file when it was loaded from memory or mapped - the
+    // view refers to the mapping or to a copy of the caller's data (except
+    // for images, which are borrowed) and either owner is shared between
+    // copies of the File
+
+    boost::string_ref mView;
+    std::shared_ptr<boost::interprocess::mapped_region> mMapping;
+    std::shared_ptr<const std::string> mBuffer;
+
+    // Whether the view is a loaded image, with sections at their RVAs
+    bool mImageLayout;
+
+    // Identity of the file on disk, read before it was opened, when it was
+    // loaded or mapped from a path (or restored from the metadata cache)
+    bool mHasFileKey;
+    FileKey mFileKey;
+
+    // Whether the file was restored from the metadata cache, in which case
+    // there is no section data - the import descriptors (in their raw form),
+    // the strings they reference, the functions they import (keyed by the
+    // RVA of their thunks) and the exports are restored instead of being
+    // read from it
+
+    bool mMetadataOnly;
+    std::string mImportDescriptors;
+    std::map<uint32_t, std::string> mStrings;
+    std::map<uint32_t, std::vector<ImportTable::Function>> mImportFunctions;
+    std::vector<File::Export> mExports;
+
+    int mDigestAlgorithms;
+    Digests mFileDigests;
+    Digests mOverlayDigests;
+    std::vector<Digests> mSectionDigests;
+
+    Instrumentation *mInstrumentation;
+
+    Limits mLimits;
+    uint64_t mLoadedSize;
+    std::chrono::steady_clock::time_point mDeadline;
 };
 
 }
@@ -22,11 +22,10 @@
  * IN THE SOFTWARE.
  */
 
-#include <boost/endian/conversion.hpp>
-
 #include <win32pe/fileheader.h>
 
 #include "fileheader_p.h"
+#include "structs_p.h"
 
 using namespace win32pe;
 
@@ -43,21 +42,36 @@ FileHeaderPrivate::FileHeaderPrivate()
 
 bool FileHeaderPrivate::read(std::istream &istream)
 {
-    if (!istream.read(reinterpret_cast<char*>(this), sizeof(*this))) {
+    RawFileHeader raw;
+    if (!istream.read(reinterpret_cast<char*>(&raw), sizeof(raw))) {
         return false;
     }
 
-    boost::endian::little_to_native_inplace(mMachine);
-    boost::endian::little_to_native_inplace(mNumberOfSections);
-    boost::endian::little_to_native_inplace(mTimeDateStamp);
-    boost::endian::little_to_native_inplace(mPointerToSymbolTable);
-    boost::endian::little_to_native_inplace(mNumberOfSymbols);
-    boost::endian::little_to_native_inplace(mSizeOfOptionalHeader);
-    boost::endian::little_to_native_inplace(mCharacteristics);
+    mMachine = raw.machine.value();
+    mNumberOfSections = raw.numberOfSections.value();
+    mTimeDateStamp = raw.timeDateStamp.value();
+    mPointerToSymbolTable = raw.pointerToSymbolTable.value();
+    mNumberOfSymbols = raw.numberOfSymbols.value();
+    mSizeOfOptionalHeader = raw.sizeOfOptionalHeader.value();
+    mCharacteristics = raw.characteristics.value();
 
     return true;
 }
 
+void FileHeaderPrivate::write(std::string &buffer) const
+{
+    RawFileHeader raw;
+    raw.machine = mMachine;
+    raw.numberOfSections = mNumberOfSections;
+    raw.timeDateStamp = mTimeDateStamp;
+    raw.pointerToSymbolTable = mPointerToSymbolTable;
+    raw.numberOfSymbols = mNumberOfSymbols;
+    raw.sizeOfOptionalHeader = mSizeOfOptionalHeader;
+    raw.characteristics = mCharacteristics;
+
+    buffer.append(reinterpret_cast<const char*>(&raw), sizeof(raw));
+}
+
 FileHeader::FileHeader()
     : d(new FileHeaderPrivate)
 {
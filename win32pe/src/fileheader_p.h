@@ -27,6 +27,7 @@
 
 #include <cstdint>
 #include <istream>
+#include <string>
 
 namespace win32pe
 {
@@ -38,6 +39,7 @@ public:
     FileHeaderPrivate();
 
     bool read(std::istream &istream);
+    void write(std::string &buffer) const;
 
     uint16_t mMachine;
     uint16_t mNumberOfSections;
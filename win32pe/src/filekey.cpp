@@ -0,0 +1,111 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#endif
+
+#include "filekey_p.h"
+
+using namespace win32pe;
+
+bool FileKey::operator<(const FileKey &other) const
+{
+    if (device != other.device) {
+        return device < other.device;
+    }
+    if (inode != other.inode) {
+        return inode < other.inode;
+    }
+    if (size != other.size) {
+        return size < other.size;
+    }
+    return mtime < other.mtime;
+}
+
+bool FileKey::operator==(const FileKey &other) const
+{
+    return device == other.device &&
+           inode == other.inode &&
+           size == other.size &&
+           mtime == other.mtime;
+}
+
+bool FileKey::read(const std::string &path, FileKey &key)
+{
+#ifdef _WIN32
+    // Only the attributes are needed, which does not conflict with anyone
+    // else having the file open
+    HANDLE handle = CreateFileA(
+        path.c_str(),
+        FILE_READ_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS,
+        nullptr
+    );
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+    BOOL result = GetFileInformationByHandle(handle, &info);
+    CloseHandle(handle);
+    if (!result) {
+        return false;
+    }
+
+    // The modification time is in 100 ns intervals
+    key.device = info.dwVolumeSerialNumber;
+    key.inode = static_cast<uint64_t>(info.nFileIndexHigh) << 32 | info.nFileIndexLow;
+    key.size = static_cast<uint64_t>(info.nFileSizeHigh) << 32 | info.nFileSizeLow;
+    key.mtime = static_cast<int64_t>(
+        static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32 |
+        info.ftLastWriteTime.dwLowDateTime
+    ) * 100;
+#else
+    struct ::stat st;
+    if (::stat(path.c_str(), &st)) {
+        return false;
+    }
+#  if defined(__APPLE__)
+    int64_t nanoseconds = st.st_mtimespec.tv_nsec;
+#  else
+    int64_t nanoseconds = st.st_mtim.tv_nsec;
+#  endif
+
+    key.device = static_cast<uint64_t>(st.st_dev);
+    key.inode = static_cast<uint64_t>(st.st_ino);
+    key.size = static_cast<uint64_t>(st.st_size);
+    key.mtime = static_cast<int64_t>(st.st_mtime) * 1000000000 + nanoseconds;
+#endif
+
+    return true;
+}
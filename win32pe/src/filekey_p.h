@@ -0,0 +1,61 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_FILEKEY_P_H
+#define WIN32PE_FILEKEY_P_H
+
+#include <cstdint>
+#include <string>
+
+namespace win32pe
+{
+
+/**
+ * @brief Identity of a file on disk
+ *
+ * On Windows the device and inode are the volume serial number and file
+ * index, since _stat() reports no inode.
+ */
+struct FileKey
+{
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t mtime;
+
+    bool operator<(const FileKey &other) const;
+    bool operator==(const FileKey &other) const;
+
+    /**
+     * @brief Read the identity of a file
+     * @param path path to the file
+     * @param key key to fill in
+     * @return true if the file could be queried
+     */
+    static bool read(const std::string &path, FileKey &key);
+};
+
+}
+
+#endif // WIN32PE_FILEKEY_P_H
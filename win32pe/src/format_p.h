@@ -0,0 +1,91 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_FORMAT_P_H
+#define WIN32PE_FORMAT_P_H
+
+#include <cstdint>
+#include <string>
+
+namespace win32pe
+{
+
+// Integers are formatted directly into the output (two digits at a time for
+// decimal) rather than through streams or printf, which dominate the cost
+// of emitting records otherwise
+
+const char DigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+inline void appendDecimal(std::string &buffer, uint64_t value)
+{
+    char digits[20];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+    while (value >= 100) {
+        unsigned pair = static_cast<unsigned>(value % 100) * 2;
+        value /= 100;
+        *--p = DigitPairs[pair + 1];
+        *--p = DigitPairs[pair];
+    }
+    if (value >= 10) {
+        unsigned pair = static_cast<unsigned>(value) * 2;
+        *--p = DigitPairs[pair + 1];
+        *--p = DigitPairs[pair];
+    } else {
+        *--p = static_cast<char>('0' + value);
+    }
+    buffer.append(p, end - p);
+}
+
+/**
+ * @brief Append a value in lower-case hexadecimal with a 0x prefix
+ */
+inline void appendHex(std::string &buffer, uint64_t value)
+{
+    static const char Digits[] = "0123456789abcdef";
+    char digits[18];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+    do {
+        *--p = Digits[value & 0xf];
+        value >>= 4;
+    } while (value);
+    *--p = 'x';
+    *--p = '0';
+    buffer.append(p, end - p);
+}
+
+}
+
+#endif // WIN32PE_FORMAT_P_H
@@ -0,0 +1,86 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "imageclass_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+template<typename Image>
+bool readThunks(const char *data, size_t size, std::vector<Thunk> &thunks)
+{
+    const typename Image::RawWord *raw = reinterpret_cast<const typename Image::RawWord*>(data);
+    size_t count = size / sizeof(*raw);
+
+    size_t length = 0;
+    while (length < count && raw[length].value()) {
+        ++length;
+    }
+
+    // The ordinal flag is the top bit of the word; splitting it out with a
+    // shift keeps the loop free of branches
+    const int flagShift = sizeof(typename Image::Word) * 8 - 1;
+    thunks.resize(length);
+    for (size_t i = 0; i < length; ++i) {
+        typename Image::Word value = raw[i].value();
+        thunks[i].value = static_cast<uint32_t>(value);
+        thunks[i].byOrdinal = static_cast<uint32_t>(value >> flagShift);
+    }
+
+    return length < count;
+}
+
+template<typename Image>
+Thunk readThunk(const char *data)
+{
+    typename Image::Word value = reinterpret_cast<const typename Image::RawWord*>(data)->value();
+    Thunk thunk = {
+        static_cast<uint32_t>(value),
+        static_cast<uint32_t>(value >> (sizeof(typename Image::Word) * 8 - 1))
+    };
+    return thunk;
+}
+
+template<typename Image>
+const ImageClass *instance()
+{
+    static const ImageClass imageClass = {
+        Image::Magic,
+        sizeof(typename Image::Word),
+        &readThunks<Image>,
+        &readThunk<Image>
+    };
+    return &imageClass;
+}
+
+}
+
+const ImageClass *win32pe::imageClass(uint16_t magic)
+{
+    return magic == ImagePE32::Magic ?
+        instance<ImagePE32>() :
+        instance<ImagePE32Plus>();
+}
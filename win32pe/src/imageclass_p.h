@@ -0,0 +1,93 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_IMAGECLASS_P_H
+#define WIN32PE_IMAGECLASS_P_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "structs_p.h"
+
+namespace win32pe
+{
+
+// Properties of the two image classes - parsers of structures whose fields
+// are pointer-sized are templated on these so that the width is fixed at
+// compile time rather than tested for every element
+
+struct ImagePE32
+{
+    typedef uint32_t Word;
+    typedef le32 RawWord;
+    typedef RawOptionalHeader32 RawOptionalHeader;
+
+    static const uint16_t Magic = 0x10b;
+};
+
+struct ImagePE32Plus
+{
+    typedef uint64_t Word;
+    typedef le64 RawWord;
+    typedef RawOptionalHeader64 RawOptionalHeader;
+
+    static const uint16_t Magic = 0x20b;
+};
+
+// Import lookup table entry with the ordinal flag split out - value is the
+// ordinal or the RVA of the hint/name entry
+
+struct Thunk
+{
+    uint32_t value;
+    uint32_t byOrdinal;
+};
+
+// Width-dependent parsers for one image class, selected once per file after
+// the optional header has been read
+
+struct ImageClass
+{
+    uint16_t magic;
+    size_t pointerSize;
+
+    // Decode the thunks in a lookup table up to the null terminator, returning
+    // false if the data ends before it
+    bool (*readThunks)(const char *data, size_t size, std::vector<Thunk> &thunks);
+
+    // Decode a single thunk (pointerSize bytes)
+    Thunk (*readThunk)(const char *data);
+};
+
+/**
+ * @brief Find the parsers for an image
+ * @param magic optional header magic value
+ * @return parsers for PE32 or (for any other value) PE32+
+ */
+const ImageClass *imageClass(uint16_t magic);
+
+}
+
+#endif // WIN32PE_IMAGECLASS_P_H
@@ -0,0 +1,270 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include <win32pe/file.h>
+#include <win32pe/imagehash.h>
+#include <win32pe/optionalheader.h>
+#include <win32pe/sectionref.h>
+
+#include "digest_p.h"
+#include "file_p.h"
+#include "imagehash_p.h"
+#include "structs_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+// The image is assembled and hashed a chunk at a time; the size is a
+// multiple of the page size so that chunks start on page boundaries
+const uint32_t ChunkSize = 64 * 1024;
+
+typedef RawOptionalHeaderBase<le32, true> RawOptionalHeaderBase32;
+
+const uint32_t TimeDateStampOffset = sizeof(uint32_t) + offsetof(RawFileHeader, timeDateStamp);
+const uint32_t OptionalHeaderOffset = sizeof(uint32_t) + sizeof(RawFileHeader);
+const uint32_t CheckSumOffset = offsetof(RawOptionalHeader32, checkSum);
+const uint32_t ImageBase32Offset = offsetof(RawOptionalHeader32, base) +
+    offsetof(RawOptionalHeaderBase32, imageBase);
+const uint32_t ImageBase64Offset = offsetof(RawOptionalHeader64, base);
+
+// Number of bytes modified by each type of fixup
+uint32_t fixupSize(uint16_t type)
+{
+    switch (type) {
+    case 1:     // IMAGE_REL_BASED_HIGH
+    case 2:     // IMAGE_REL_BASED_LOW
+    case 4:     // IMAGE_REL_BASED_HIGHADJ
+        return 2;
+    case 5:     // IMAGE_REL_BASED_ARM_MOV32
+    case 7:     // IMAGE_REL_BASED_THUMB_MOV32
+    case 10:    // IMAGE_REL_BASED_DIR64
+        return 8;
+    default:    // IMAGE_REL_BASED_HIGHLOW and anything else
+        return 4;
+    }
+}
+
+// Copy the part of [rva, rva + size) that overlaps a chunk into it
+void copyRange(char *chunk, uint32_t base, uint32_t length, uint32_t rva, const char *data, uint32_t size)
+{
+    uint64_t first = std::max<uint64_t>(base, rva);
+    uint64_t last = std::min<uint64_t>(static_cast<uint64_t>(base) + length, static_cast<uint64_t>(rva) + size);
+    if (first < last) {
+        memcpy(chunk + (first - base), data + (first - rva), static_cast<size_t>(last - first));
+    }
+}
+
+}
+
+ImageHashPrivate::ImageHashPrivate()
+    : mAlgorithms(Digests::XXH64),
+      mImageSize(0)
+{
+}
+
+void ImageHashPrivate::addMask(uint32_t rva, uint32_t size)
+{
+    if (size) {
+        ImageHash::Mask mask;
+        mask.rva = rva;
+        mask.size = size;
+        mMasks.push_back(mask);
+    }
+}
+
+void ImageHashPrivate::collectMasks(const File &file, uint32_t peOffset)
+{
+    const OptionalHeader &optionalHeader = file.optionalHeader();
+    bool is64 = optionalHeader.magic() == OptionalHeader::Win64;
+
+    // Fields in the headers that the linker or loader rewrites
+    uint32_t optionalOffset = peOffset + OptionalHeaderOffset;
+    addMask(peOffset + TimeDateStampOffset, sizeof(uint32_t));
+    addMask(optionalOffset + CheckSumOffset, sizeof(uint32_t));
+    addMask(optionalOffset + (is64 ? ImageBase64Offset : ImageBase32Offset),
+            is64 ? sizeof(uint64_t) : sizeof(uint32_t));
+
+    // Every location the loader adjusts when rebasing
+    std::vector<File::Relocation> relocations = file.relocations();
+    for (auto it = relocations.begin(); it != relocations.end(); ++it) {
+        addMask((*it).rva, fixupSize((*it).type));
+    }
+
+    // The import address table is filled in by the loader - if there is no
+    // directory entry for it, each descriptor's thunks are masked instead
+    const OptionalHeader::DataDirectoryItem &iat =
+        optionalHeader.dataDirectory()[OptionalHeader::ImportAddressTable];
+    if (iat.virtualAddress && iat.size) {
+        addMask(iat.virtualAddress, iat.size);
+    } else {
+        uint32_t thunkSize = is64 ? sizeof(uint64_t) : sizeof(uint32_t);
+        for (const ImportTable::Item &item : file.importDescriptors()) {
+            Range<ImportFunctionIterator> functions = file.importedFunctionRefs(item);
+            uint32_t count = 0;
+            for (auto it = functions.begin(); it != functions.end(); ++it) {
+                ++count;
+            }
+            addMask(item.firstThunk, count * thunkSize);
+        }
+    }
+}
+
+void ImageHashPrivate::mergeMasks()
+{
+    std::sort(mMasks.begin(), mMasks.end(), [](const ImageHash::Mask &a, const ImageHash::Mask &b) {
+        return a.rva < b.rva;
+    });
+
+    std::vector<ImageHash::Mask> merged;
+    for (auto it = mMasks.begin(); it != mMasks.end(); ++it) {
+        uint64_t end = static_cast<uint64_t>((*it).rva) + (*it).size;
+        if (!merged.empty() && (*it).rva <= static_cast<uint64_t>(merged.back().rva) + merged.back().size) {
+            ImageHash::Mask &last = merged.back();
+            last.size = static_cast<uint32_t>(std::max<uint64_t>(last.rva + static_cast<uint64_t>(last.size), end) - last.rva);
+        } else {
+            merged.push_back(*it);
+        }
+    }
+    mMasks.swap(merged);
+}
+
+ImageHash::ImageHash()
+    : d(new ImageHashPrivate)
+{
+}
+
+ImageHash::ImageHash(const ImageHash &other)
+    : d(new ImageHashPrivate(*other.d))
+{
+}
+
+ImageHash::~ImageHash()
+{
+    delete d;
+}
+
+ImageHash &ImageHash::operator=(const ImageHash &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+void ImageHash::setAlgorithms(int algorithms)
+{
+    d->mAlgorithms = algorithms;
+}
+
+int ImageHash::algorithms() const
+{
+    return d->mAlgorithms;
+}
+
+bool ImageHash::compute(const File &file)
+{
+    d->mDigests = Digests();
+    d->mMasks.clear();
+    d->mImageSize = 0;
+    d->mErrorString.clear();
+
+    if (!file.d->mImageClass) {
+        d->mErrorString = "file is not loaded";
+        return false;
+    }
+
+    // The headers are serialized from the parsed values (rather than read
+    // from the file) so that files loaded from a stream can be hashed too
+    std::string headers;
+    file.d->writeHeaders(headers);
+    headers.append(file.d->mHeaderSlack);
+    uint32_t sizeOfHeaders = file.optionalHeader().sizeOfHeaders();
+    if (headers.size() > sizeOfHeaders) {
+        headers.resize(sizeOfHeaders);
+    }
+
+    d->collectMasks(file, static_cast<uint32_t>(file.d->mDOSHeader.size()));
+    d->mergeMasks();
+
+    // Assemble each chunk of the image - zeroes, then the headers and the
+    // section data, then the masks - and pass it on to the digests
+    Digester digester(d->mAlgorithms);
+    d->mImageSize = file.optionalHeader().sizeOfImage();
+    std::vector<char> chunk(std::min(ChunkSize, d->mImageSize));
+    auto mask = d->mMasks.begin();
+    for (uint32_t base = 0; base < d->mImageSize; base += std::min(ChunkSize, d->mImageSize - base)) {
+        uint32_t length = std::min(ChunkSize, d->mImageSize - base);
+        memset(chunk.data(), 0, length);
+
+        copyRange(chunk.data(), base, length, 0, headers.data(), static_cast<uint32_t>(headers.size()));
+        for (const SectionRef &section : file.sectionRefs()) {
+            // Only the part of the raw data within the virtual size is mapped
+            boost::string_ref data = section.data();
+            uint32_t size = static_cast<uint32_t>(data.size());
+            if (section.virtualSize()) {
+                size = std::min(size, section.virtualSize());
+            }
+            copyRange(chunk.data(), base, length, section.virtualAddress(), data.data(), size);
+        }
+
+        uint64_t end = static_cast<uint64_t>(base) + length;
+        while (mask != d->mMasks.end() && static_cast<uint64_t>((*mask).rva) + (*mask).size <= base) {
+            ++mask;
+        }
+        for (auto it = mask; it != d->mMasks.end() && (*it).rva < end; ++it) {
+            uint64_t first = std::max<uint64_t>(base, (*it).rva);
+            uint64_t last = std::min<uint64_t>(end, static_cast<uint64_t>((*it).rva) + (*it).size);
+            memset(chunk.data() + (first - base), 0, static_cast<size_t>(last - first));
+        }
+
+        digester.update(chunk.data(), length);
+    }
+    digester.finish(d->mDigests);
+
+    return true;
+}
+
+const Digests &ImageHash::digests() const
+{
+    return d->mDigests;
+}
+
+const std::vector<ImageHash::Mask> &ImageHash::masks() const
+{
+    return d->mMasks;
+}
+
+uint32_t ImageHash::imageSize() const
+{
+    return d->mImageSize;
+}
+
+std::string ImageHash::errorString() const
+{
+    return d->mErrorString;
+}
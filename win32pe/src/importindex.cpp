@@ -0,0 +1,424 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <boost/interprocess/file_mapping.hpp>
+
+#include <win32pe/file.h>
+#include <win32pe/importindex.h>
+#include <win32pe/ranges.h>
+
+#include "endian_p.h"
+#include "importindex_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+// The index begins with a signature (which includes the format version), the
+// number of files and terms and the offset of the term table; each entry in
+// the table gives the location of a key (the lower-case DLL name, a null
+// byte and the function) and of its posting list, and entries are sorted by
+// key. Posting lists are file IDs in ascending order, each stored as the
+// difference from the previous one in LEB128 form
+
+const char Signature[] = "W32PEII1";
+const size_t SignatureSize = 8;
+const size_t HeaderSize = SignatureSize + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+const size_t EntrySize = 2 * sizeof(uint64_t) + 4 * sizeof(uint32_t);
+
+void appendVarint(std::string &data, uint32_t value)
+{
+    while (value >= 0x80) {
+        data.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<char>(value));
+}
+
+// Decodes a posting list one ID at a time
+class PostingReader
+{
+public:
+
+    explicit PostingReader(boost::string_ref data)
+        : mPos(reinterpret_cast<const unsigned char*>(data.data())),
+          mEnd(mPos + data.size()),
+          mValue(0)
+    {
+    }
+
+    bool next(uint32_t &value)
+    {
+        uint32_t delta = 0;
+        for (int shift = 0; mPos != mEnd && shift < 32; shift += 7) {
+            unsigned char byte = *mPos++;
+            delta |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                value = mValue += delta;
+                return true;
+            }
+        }
+        mPos = mEnd;
+        return false;
+    }
+
+private:
+
+    const unsigned char *mPos;
+    const unsigned char *mEnd;
+    uint32_t mValue;
+};
+
+std::string lower(boost::string_ref value)
+{
+    std::string result(value.begin(), value.end());
+    for (size_t i = 0; i < result.size(); ++i) {
+        if (result[i] >= 'A' && result[i] <= 'Z') {
+            result[i] = result[i] - 'A' + 'a';
+        }
+    }
+    return result;
+}
+
+}
+
+ImportIndexPrivate::ImportIndexPrivate()
+    : mFileCount(0),
+      mMappedData(nullptr),
+      mMappedSize(0),
+      mMappedTerms(nullptr),
+      mMappedTermCount(0)
+{
+}
+
+std::string ImportIndexPrivate::key(const ImportIndex::Term &term)
+{
+    std::string key = lower(term.dll);
+    key.push_back('\0');
+    key.append(term.function);
+    return key;
+}
+
+void ImportIndexPrivate::entry(uint32_t index, boost::string_ref &key, boost::string_ref &data, uint32_t &count) const
+{
+    // Entries referring outside the file are treated as empty
+    const char *entry = mMappedTerms + index * EntrySize;
+    uint64_t keyOffset = readLittle<uint64_t>(entry);
+    uint64_t dataOffset = readLittle<uint64_t>(entry + sizeof(uint64_t));
+    uint32_t keySize = readLittle<uint32_t>(entry + 2 * sizeof(uint64_t));
+    uint32_t dataSize = readLittle<uint32_t>(entry + 2 * sizeof(uint64_t) + sizeof(uint32_t));
+    count = readLittle<uint32_t>(entry + 2 * sizeof(uint64_t) + 2 * sizeof(uint32_t));
+    key = keyOffset <= mMappedSize && keySize <= mMappedSize - keyOffset ?
+        boost::string_ref(mMappedData + keyOffset, keySize) : boost::string_ref();
+    data = dataOffset <= mMappedSize && dataSize <= mMappedSize - dataOffset ?
+        boost::string_ref(mMappedData + dataOffset, dataSize) : boost::string_ref();
+
+    // Every posting takes at least one byte, so a larger count is corrupt
+    if (count > data.size()) {
+        data = boost::string_ref();
+        count = 0;
+    }
+}
+
+bool ImportIndexPrivate::find(const std::string &key, boost::string_ref &data, uint32_t &count) const
+{
+    if (!mRegion) {
+        auto it = mTerms.find(key);
+        if (it == mTerms.end()) {
+            return false;
+        }
+        data = it->second.data;
+        count = it->second.count;
+        return true;
+    }
+
+    uint32_t first = 0;
+    uint32_t last = mMappedTermCount;
+    while (first < last) {
+        uint32_t middle = first + (last - first) / 2;
+        boost::string_ref middleKey;
+        entry(middle, middleKey, data, count);
+        int result = middleKey.compare(key);
+        if (!result) {
+            return true;
+        }
+        if (result < 0) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return false;
+}
+
+void ImportIndexPrivate::makeWritable()
+{
+    if (!mRegion) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < mMappedTermCount; ++i) {
+        boost::string_ref key;
+        boost::string_ref postings;
+        uint32_t count;
+        entry(i, key, postings, count);
+
+        // The last ID is needed to append deltas
+        Postings &term = mTerms[key.to_string()];
+        term.data = postings.to_string();
+        term.count = 0;
+        term.last = 0;
+        PostingReader reader(postings);
+        while (reader.next(term.last)) {
+            ++term.count;
+        }
+    }
+    mRegion.reset();
+}
+
+void ImportIndexPrivate::close()
+{
+    mRegion.reset();
+    mFileCount = 0;
+    mTerms.clear();
+}
+
+ImportIndex::ImportIndex()
+    : d(new ImportIndexPrivate)
+{
+}
+
+ImportIndex::~ImportIndex()
+{
+    delete d;
+}
+
+uint32_t ImportIndex::add(const File &file)
+{
+    d->makeWritable();
+
+    uint32_t id = d->mFileCount++;
+    for (const ImportTable::Item &item : file.importDescriptors()) {
+        std::string prefix = lower(file.string(item.name));
+        prefix.push_back('\0');
+        for (const ImportTable::FunctionRef &function : file.importedFunctionRefs(item)) {
+            std::string key(prefix);
+            if (function.byOrdinal) {
+                key.append("#" + std::to_string(function.ordinal));
+            } else {
+                key.append(function.name.begin(), function.name.end());
+            }
+
+            // A function imported twice by the same file is listed once
+            ImportIndexPrivate::Postings &postings = d->mTerms[key];
+            if (postings.count && postings.last == id) {
+                continue;
+            }
+            appendVarint(postings.data, postings.count ? id - postings.last : id);
+            postings.last = id;
+            ++postings.count;
+        }
+    }
+
+    return id;
+}
+
+bool ImportIndex::save(const std::string &filename)
+{
+    d->makeWritable();
+
+    typedef std::unordered_map<std::string, ImportIndexPrivate::Postings>::const_iterator Iterator;
+    std::vector<Iterator> terms;
+    terms.reserve(d->mTerms.size());
+    for (auto it = d->mTerms.cbegin(); it != d->mTerms.cend(); ++it) {
+        terms.push_back(it);
+    }
+    std::sort(terms.begin(), terms.end(), [](const Iterator &a, const Iterator &b) {
+        return a->first < b->first;
+    });
+
+    // Keys follow the term table and posting lists follow the keys
+    std::string header(Signature, SignatureSize);
+    appendLittle(header, d->mFileCount);
+    appendLittle(header, static_cast<uint32_t>(terms.size()));
+    appendLittle(header, static_cast<uint64_t>(HeaderSize));
+
+    uint64_t keyOffset = HeaderSize + terms.size() * EntrySize;
+    uint64_t postingsOffset = keyOffset;
+    for (auto it = terms.begin(); it != terms.end(); ++it) {
+        postingsOffset += (*it)->first.size();
+    }
+    for (auto it = terms.begin(); it != terms.end(); ++it) {
+        appendLittle(header, keyOffset);
+        appendLittle(header, postingsOffset);
+        appendLittle(header, static_cast<uint32_t>((*it)->first.size()));
+        appendLittle(header, static_cast<uint32_t>((*it)->second.data.size()));
+        appendLittle(header, (*it)->second.count);
+        appendLittle(header, static_cast<uint32_t>(0));
+        keyOffset += (*it)->first.size();
+        postingsOffset += (*it)->second.data.size();
+    }
+
+    // Write to a temporary file first since the index may be mapped
+    std::string tempFilename = filename + ".tmp";
+    {
+        std::ofstream ofstream(tempFilename, std::ios::binary | std::ios::trunc);
+        ofstream.write(header.data(), header.size());
+        for (auto it = terms.begin(); it != terms.end(); ++it) {
+            ofstream.write((*it)->first.data(), (*it)->first.size());
+        }
+        for (auto it = terms.begin(); it != terms.end(); ++it) {
+            ofstream.write((*it)->second.data.data(), (*it)->second.data.size());
+        }
+        if (!ofstream.flush()) {
+            d->mErrorString = "unable to write index";
+            std::remove(tempFilename.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tempFilename.c_str(), filename.c_str())) {
+        d->mErrorString = "unable to replace index";
+        std::remove(tempFilename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool ImportIndex::open(const std::string &filename)
+{
+    d->close();
+
+    std::unique_ptr<boost::interprocess::mapped_region> region;
+    try {
+        boost::interprocess::file_mapping file(filename.c_str(), boost::interprocess::read_only);
+        region.reset(new boost::interprocess::mapped_region(file, boost::interprocess::read_only));
+    } catch (const boost::interprocess::interprocess_exception &) {
+        d->mErrorString = "unable to map index";
+        return false;
+    }
+
+    const char *data = static_cast<const char*>(region->get_address());
+    uint64_t size = region->get_size();
+    if (size < HeaderSize || memcmp(data, Signature, SignatureSize)) {
+        d->mErrorString = "index is invalid or from another version";
+        return false;
+    }
+
+    // The term table must lie within the file; the keys and posting lists
+    // are checked as they are used
+    uint32_t termCount = readLittle<uint32_t>(data + SignatureSize + sizeof(uint32_t));
+    uint64_t termsOffset = readLittle<uint64_t>(data + SignatureSize + 2 * sizeof(uint32_t));
+    if (termsOffset > size || static_cast<uint64_t>(termCount) * EntrySize > size - termsOffset) {
+        d->mErrorString = "index is corrupt";
+        return false;
+    }
+
+    d->mFileCount = readLittle<uint32_t>(data + SignatureSize);
+    d->mMappedData = data;
+    d->mMappedSize = size;
+    d->mMappedTerms = data + termsOffset;
+    d->mMappedTermCount = termCount;
+    d->mRegion = std::move(region);
+
+    return true;
+}
+
+size_t ImportIndex::fileCount() const
+{
+    return d->mFileCount;
+}
+
+size_t ImportIndex::termCount() const
+{
+    return d->mRegion ? d->mMappedTermCount : d->mTerms.size();
+}
+
+size_t ImportIndex::frequency(const Term &term) const
+{
+    boost::string_ref data;
+    uint32_t count;
+    return d->find(ImportIndexPrivate::key(term), data, count) ? count : 0;
+}
+
+std::vector<uint32_t> ImportIndex::query(const std::vector<Term> &terms) const
+{
+    std::vector<uint32_t> ids;
+
+    std::vector<std::pair<uint32_t, boost::string_ref>> lists;
+    for (auto it = terms.begin(); it != terms.end(); ++it) {
+        boost::string_ref data;
+        uint32_t count;
+        if (!d->find(ImportIndexPrivate::key(*it), data, count)) {
+            return ids;
+        }
+        lists.push_back(std::make_pair(count, data));
+    }
+    if (lists.empty()) {
+        return ids;
+    }
+
+    // Start with the shortest list so that the candidates only shrink
+    std::sort(lists.begin(), lists.end(), [](const std::pair<uint32_t, boost::string_ref> &a,
+                                             const std::pair<uint32_t, boost::string_ref> &b) {
+        return a.first < b.first;
+    });
+
+    PostingReader reader(lists[0].second);
+    ids.reserve(lists[0].first);
+    for (uint32_t id; reader.next(id);) {
+        ids.push_back(id);
+    }
+
+    std::vector<uint32_t> matches;
+    for (size_t i = 1; i < lists.size() && !ids.empty(); ++i) {
+        PostingReader reader(lists[i].second);
+        uint32_t id;
+        bool more = reader.next(id);
+        matches.clear();
+        for (auto it = ids.begin(); it != ids.end() && more; ++it) {
+            while (more && id < *it) {
+                more = reader.next(id);
+            }
+            if (more && id == *it) {
+                matches.push_back(id);
+            }
+        }
+        ids.swap(matches);
+    }
+
+    return ids;
+}
+
+std::string ImportIndex::errorString() const
+{
+    return d->mErrorString;
+}
@@ -0,0 +1,80 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_IMPORTINDEX_P_H
+#define WIN32PE_IMPORTINDEX_P_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include <win32pe/importindex.h>
+
+namespace win32pe
+{
+
+class ImportIndexPrivate
+{
+public:
+
+    // Posting list of a term added in memory
+    struct Postings
+    {
+        uint32_t count;
+        uint32_t last;
+        std::string data;
+    };
+
+    ImportIndexPrivate();
+
+    static std::string key(const ImportIndex::Term &term);
+
+    void entry(uint32_t index, boost::string_ref &key, boost::string_ref &data, uint32_t &count) const;
+    bool find(const std::string &key, boost::string_ref &data, uint32_t &count) const;
+    void makeWritable();
+    void close();
+
+    std::string mErrorString;
+
+    uint32_t mFileCount;
+
+    // Terms of files added in memory
+    std::unordered_map<std::string, Postings> mTerms;
+
+    // Term table of a mapped index
+    std::unique_ptr<boost::interprocess::mapped_region> mRegion;
+    const char *mMappedData;
+    uint64_t mMappedSize;
+    const char *mMappedTerms;
+    uint32_t mMappedTermCount;
+};
+
+}
+
+#endif // WIN32PE_IMPORTINDEX_P_H
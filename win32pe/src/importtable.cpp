@@ -22,14 +22,27 @@
  * IN THE SOFTWARE.
  */
 
-#include <cstring>
-
 #include <win32pe/importtable.h>
 
 #include "importtable_p.h"
+#include "structs_p.h"
 
 using namespace win32pe;
 
+bool win32pe::decodeImportDescriptor(const RawImportDescriptor &raw, ImportTable::Item &item)
+{
+    item.characteristics = raw.originalFirstThunk.value();
+    item.timeDateStamp = raw.timeDateStamp.value();
+    item.forwarderChain = raw.forwarderChain.value();
+    item.name = raw.name.value();
+    item.firstThunk = raw.firstThunk.value();
+    return item.characteristics ||
+        item.timeDateStamp ||
+        item.forwarderChain ||
+        item.name ||
+        item.firstThunk;
+}
+
 ImportTablePrivate::ImportTablePrivate()
 {
 }
@@ -55,21 +68,27 @@ ImportTable &ImportTable::operator=(const ImportTable &other)
     return *this;
 }
 
-bool ImportTable::load(const std::string &data)
+bool ImportTable::load(const std::string &data, size_t maxItems)
+{
+    return load(data.data(), data.size(), maxItems);
+}
+
+bool ImportTable::load(const char *data, size_t size, size_t maxItems)
 {
     // Read Items until either one is found with all zeroes or the end of the
-    // data is reached (which is an error)
+    // data or maximum number of items is reached (which is an error)
 
-    for (size_t i = 0; i + sizeof(Item) <= data.size(); i += sizeof(Item)) {
+    d->mItems.clear();
+
+    const RawImportDescriptor *raw;
+    for (size_t i = 0; (raw = rawView<RawImportDescriptor>(data, size, i)); i += sizeof(*raw)) {
         Item item;
-        memcpy(&item, &data[0] + i, sizeof(Item));
-        if (!item.characteristics &&
-                !item.timeDateStamp &&
-                !item.forwarderChain &&
-                !item.name &&
-                !item.firstThunk) {
+        if (!decodeImportDescriptor(*raw, item)) {
             return true;
         }
+        if (d->mItems.size() >= maxItems) {
+            return false;
+        }
         d->mItems.push_back(item);
     }
 
@@ -29,9 +29,15 @@
 
 #include <win32pe/importtable.h>
 
+#include "structs_p.h"
+
 namespace win32pe
 {
 
+// Decode an import descriptor, returning false for the null descriptor that
+// terminates the table
+bool decodeImportDescriptor(const RawImportDescriptor &raw, ImportTable::Item &item);
+
 class ImportTablePrivate
 {
 public:
@@ -0,0 +1,238 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+
+#include <win32pe/instrumentation.h>
+
+#include "instrumentation_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+const char *PhaseNames[] = {
+    "dos-header",
+    "pe-headers",
+    "sections",
+    "import-table",
+    "symbol-table",
+    "overlay",
+    "digests"
+};
+
+const char *CounterNames[] = {
+    "loads",
+    "bytes-read",
+    "read-calls",
+    "seek-calls",
+    "loader-buffers",
+    "loader-buffer-bytes"
+};
+
+// Append formatted text to a string; the output of every caller here is
+// far shorter than the buffer
+template<typename... Args>
+void appendFormat(std::string &str, const char *format, Args... args)
+{
+    char buffer[256];
+    int n = std::snprintf(buffer, sizeof(buffer), format, args...);
+    if (n > 0) {
+        str.append(buffer, std::min<size_t>(static_cast<size_t>(n), sizeof(buffer) - 1));
+    }
+}
+
+unsigned long long ull(uint64_t value)
+{
+    return static_cast<unsigned long long>(value);
+}
+
+}
+
+InstrumentationPrivate::InstrumentationPrivate()
+    : mEpoch(std::chrono::steady_clock::now()),
+      mEventCapacity(0)
+{
+    for (int i = 0; i < Instrumentation::PhaseCount; ++i) {
+        mPhaseTimes[i] = 0;
+        mPhaseCounts[i] = 0;
+    }
+    for (int i = 0; i < Instrumentation::CounterCount; ++i) {
+        mCounters[i] = 0;
+    }
+}
+
+uint64_t InstrumentationPrivate::now() const
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - mEpoch
+        ).count()
+    );
+}
+
+void InstrumentationPrivate::addPhase(Instrumentation::Phase phase, uint64_t start, uint64_t end)
+{
+    mPhaseTimes[phase].fetch_add(end - start, std::memory_order_relaxed);
+    mPhaseCounts[phase].fetch_add(1, std::memory_order_relaxed);
+
+    if (!mEventCapacity.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mEvents.size() >= mEventCapacity.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Threads are numbered in the order they are first seen, which is far
+    // more readable in a trace viewer than a hashed thread ID
+    auto thread = mThreads.insert(
+        std::make_pair(std::this_thread::get_id(), static_cast<uint32_t>(mThreads.size() + 1))
+    ).first;
+
+    Event event = {phase, thread->second, start, end - start};
+    mEvents.push_back(event);
+}
+
+Instrumentation::Instrumentation()
+    : d(new InstrumentationPrivate)
+{
+}
+
+Instrumentation::~Instrumentation()
+{
+    delete d;
+}
+
+bool Instrumentation::isAvailable()
+{
+#ifdef WIN32PE_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Instrumentation::setEventCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(d->mMutex);
+    d->mEventCapacity = capacity;
+    if (d->mEvents.size() > capacity) {
+        d->mEvents.resize(capacity);
+    }
+    d->mEvents.reserve(capacity);
+}
+
+uint64_t Instrumentation::phaseTime(Phase phase) const
+{
+    return d->mPhaseTimes[phase].load(std::memory_order_relaxed);
+}
+
+uint64_t Instrumentation::phaseCount(Phase phase) const
+{
+    return d->mPhaseCounts[phase].load(std::memory_order_relaxed);
+}
+
+uint64_t Instrumentation::counter(Counter counter) const
+{
+    return d->mCounters[counter].load(std::memory_order_relaxed);
+}
+
+void Instrumentation::reset()
+{
+    std::lock_guard<std::mutex> lock(d->mMutex);
+    for (int i = 0; i < PhaseCount; ++i) {
+        d->mPhaseTimes[i] = 0;
+        d->mPhaseCounts[i] = 0;
+    }
+    for (int i = 0; i < CounterCount; ++i) {
+        d->mCounters[i] = 0;
+    }
+    d->mEvents.clear();
+    d->mThreads.clear();
+}
+
+std::string Instrumentation::summary() const
+{
+    std::string str;
+    appendFormat(str, "%-16s %12s %16s %12s\n", "phase", "calls", "total ns", "avg ns");
+    for (int i = 0; i < PhaseCount; ++i) {
+        uint64_t count = phaseCount(static_cast<Phase>(i));
+        uint64_t time = phaseTime(static_cast<Phase>(i));
+        appendFormat(str, "%-16s %12llu %16llu %12llu\n", PhaseNames[i],
+                     ull(count), ull(time), ull(count ? time / count : 0));
+    }
+    appendFormat(str, "\n%-16s %12s\n", "counter", "total");
+    for (int i = 0; i < CounterCount; ++i) {
+        appendFormat(str, "%-16s %12llu\n", CounterNames[i], ull(counter(static_cast<Counter>(i))));
+    }
+    return str;
+}
+
+std::string Instrumentation::chromeTrace() const
+{
+    // Timestamps in the trace event format are in microseconds but may be
+    // fractional, so nanosecond precision is kept with three decimals
+
+    std::string str("{\"traceEvents\":[");
+
+    std::lock_guard<std::mutex> lock(d->mMutex);
+    for (auto it = d->mEvents.begin(); it != d->mEvents.end(); ++it) {
+        appendFormat(str,
+            "{\"name\":\"%s\",\"cat\":\"win32pe\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+            "\"ts\":%llu.%03u,\"dur\":%llu.%03u},",
+            PhaseNames[(*it).phase],
+            (*it).thread,
+            ull((*it).start / 1000), static_cast<unsigned>((*it).start % 1000),
+            ull((*it).duration / 1000), static_cast<unsigned>((*it).duration % 1000)
+        );
+    }
+
+    // The totals are added as a single counter event at the end
+    uint64_t now = d->now();
+    appendFormat(str,
+        "{\"name\":\"counters\",\"cat\":\"win32pe\",\"ph\":\"C\",\"pid\":1,\"tid\":0,"
+        "\"ts\":%llu.%03u,\"args\":{",
+        ull(now / 1000), static_cast<unsigned>(now % 1000)
+    );
+    for (int i = 0; i < CounterCount; ++i) {
+        appendFormat(str, "%s\"%s\":%llu", i ? "," : "", CounterNames[i],
+                     ull(counter(static_cast<Counter>(i))));
+    }
+    str.append("}}]}");
+    return str;
+}
+
+const char *Instrumentation::phaseName(Phase phase)
+{
+    return phase >= 0 && phase < PhaseCount ? PhaseNames[phase] : "";
+}
+
+const char *Instrumentation::counterName(Counter counter)
+{
+    return counter >= 0 && counter < CounterCount ? CounterNames[counter] : "";
+}
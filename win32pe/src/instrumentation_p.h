@@ -0,0 +1,196 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_INSTRUMENTATION_P_H
+#define WIN32PE_INSTRUMENTATION_P_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+#include <win32pe/instrumentation.h>
+
+namespace win32pe
+{
+
+class InstrumentationPrivate
+{
+public:
+
+    struct Event
+    {
+        Instrumentation::Phase phase;
+        uint32_t thread;
+        uint64_t start;
+        uint64_t duration;
+    };
+
+    InstrumentationPrivate();
+
+    // Nanoseconds since the instance was created
+    uint64_t now() const;
+
+    void add(Instrumentation::Counter counter, uint64_t value)
+    {
+        mCounters[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void addPhase(Instrumentation::Phase phase, uint64_t start, uint64_t end);
+
+    std::chrono::steady_clock::time_point mEpoch;
+
+    // Totals are updated with relaxed atomics so that loads on different
+    // threads only contend on the cache line rather than a lock
+
+    std::atomic<uint64_t> mPhaseTimes[Instrumentation::PhaseCount];
+    std::atomic<uint64_t> mPhaseCounts[Instrumentation::PhaseCount];
+    std::atomic<uint64_t> mCounters[Instrumentation::CounterCount];
+
+    // Individual events are only kept (under the lock) when there is room
+
+    std::atomic<size_t> mEventCapacity;
+    mutable std::mutex mMutex;
+    std::vector<Event> mEvents;
+    std::map<std::thread::id, uint32_t> mThreads;
+};
+
+/**
+ * @brief Record the duration of a phase for the lifetime of the object
+ */
+class PhaseTimer
+{
+public:
+
+    PhaseTimer(Instrumentation *instrumentation, Instrumentation::Phase phase)
+        : mInstrumentation(instrumentation ? instrumentation->d : nullptr),
+          mPhase(phase),
+          mStart(mInstrumentation ? mInstrumentation->now() : 0)
+    {
+    }
+
+    ~PhaseTimer()
+    {
+        if (mInstrumentation) {
+            mInstrumentation->addPhase(mPhase, mStart, mInstrumentation->now());
+        }
+    }
+
+private:
+
+    PhaseTimer(const PhaseTimer &);
+    PhaseTimer &operator=(const PhaseTimer &);
+
+    InstrumentationPrivate *mInstrumentation;
+    Instrumentation::Phase mPhase;
+    uint64_t mStart;
+};
+
+/**
+ * @brief Stream buffer that counts reads and seeks on another stream buffer
+ *
+ * Nothing is buffered here so the position of the underlying buffer is
+ * always correct once loading finishes.
+ */
+class CountingStreamBuf : public std::streambuf
+{
+public:
+
+    CountingStreamBuf(std::streambuf *streambuf, InstrumentationPrivate *instrumentation)
+        : mStreamBuf(streambuf),
+          mInstrumentation(instrumentation)
+    {
+    }
+
+protected:
+
+    std::streamsize xsgetn(char *s, std::streamsize count) override
+    {
+        std::streamsize n = mStreamBuf->sgetn(s, count);
+        mInstrumentation->add(Instrumentation::ReadCalls, 1);
+        mInstrumentation->add(Instrumentation::BytesRead, static_cast<uint64_t>(n));
+        return n;
+    }
+
+    int_type underflow() override
+    {
+        return mStreamBuf->sgetc();
+    }
+
+    int_type uflow() override
+    {
+        int_type c = mStreamBuf->sbumpc();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            mInstrumentation->add(Instrumentation::ReadCalls, 1);
+            mInstrumentation->add(Instrumentation::BytesRead, 1);
+        }
+        return c;
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+    {
+        // tellg() is implemented as a relative seek of zero
+        if (off != 0 || dir != std::ios_base::cur) {
+            mInstrumentation->add(Instrumentation::SeekCalls, 1);
+        }
+        return mStreamBuf->pubseekoff(off, dir, which);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        mInstrumentation->add(Instrumentation::SeekCalls, 1);
+        return mStreamBuf->pubseekpos(pos, which);
+    }
+
+private:
+
+    std::streambuf *mStreamBuf;
+    InstrumentationPrivate *mInstrumentation;
+};
+
+}
+
+// The hooks in the loader expand to nothing unless instrumentation is built
+// in, so that there is no cost at all when it is disabled
+
+#ifdef WIN32PE_INSTRUMENTATION
+#  define WIN32PE_PHASE(instrumentation, phase) \
+    win32pe::PhaseTimer phaseTimer(instrumentation, win32pe::Instrumentation::phase)
+#  define WIN32PE_BUFFER(instrumentation, bytes) \
+    do { \
+        if (instrumentation) { \
+            (instrumentation)->d->add(win32pe::Instrumentation::LoaderBuffers, 1); \
+            (instrumentation)->d->add(win32pe::Instrumentation::LoaderBufferBytes, (bytes)); \
+        } \
+    } while (0)
+#else
+#  define WIN32PE_PHASE(instrumentation, phase) do {} while (0)
+#  define WIN32PE_BUFFER(instrumentation, bytes) do {} while (0)
+#endif
+
+#endif // WIN32PE_INSTRUMENTATION_P_H
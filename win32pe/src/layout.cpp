@@ -0,0 +1,174 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include <boost/endian/conversion.hpp>
+
+#include <win32pe/optionalheader.h>
+
+#include "align_p.h"
+#include "file_p.h"
+#include "fileheader_p.h"
+#include "layout_p.h"
+#include "optionalheader_p.h"
+#include "sectiontable_p.h"
+
+using namespace win32pe;
+
+Layout::Layout(FilePrivate *file)
+    : mFile(file)
+{
+}
+
+bool Layout::update(size_t first)
+{
+    OptionalHeaderPrivate *optionalHeader = mFile->mOptionalHeader.d;
+    uint32_t fileAlignment = optionalHeader->mFileAlignment;
+    uint32_t sectionAlignment = optionalHeader->mSectionAlignment;
+    if (!isPowerOfTwo(fileAlignment) || !isPowerOfTwo(sectionAlignment)) {
+        mErrorString = "invalid file or section alignment";
+        return false;
+    }
+
+    // If the section table has outgrown the headers, everything may move
+    uint64_t tableEnd = mFile->headersSize();
+    if (tableEnd > optionalHeader->mSizeOfHeaders) {
+        if (!makeHeaderRoom(tableEnd)) {
+            return false;
+        }
+        first = 0;
+    }
+
+    // Record the original range of every section (moved or not) so that
+    // RVAs in the headers can be attributed to the section that owns them
+
+    std::vector<Move> moves;
+    bool moved = false;
+
+    uint64_t fileEnd = optionalHeader->mSizeOfHeaders;
+    uint64_t virtualEnd = alignUp(optionalHeader->mSizeOfHeaders, sectionAlignment);
+    std::vector<SectionEntry> &entries = mFile->mSectionTable.mEntries;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        SectionEntry *section = &entries[i];
+        uint32_t virtualSize = std::max(section->virtualSize, section->sizeOfRawData);
+
+        Move move = {section->virtualAddress, section->virtualAddress + virtualSize, 0};
+        if (i >= first) {
+            if (section->virtualAddress < virtualEnd) {
+                move.delta = static_cast<uint32_t>(virtualEnd - section->virtualAddress);
+                section->virtualAddress = static_cast<uint32_t>(virtualEnd);
+                moved = true;
+            }
+            if (!section->sizeOfRawData) {
+                section->pointerToRawData = 0;
+            } else if (section->pointerToRawData < fileEnd ||
+                    section->pointerToRawData % fileAlignment) {
+                section->pointerToRawData = static_cast<uint32_t>(alignUp(fileEnd, fileAlignment));
+            }
+        }
+        moves.push_back(move);
+
+        virtualEnd = alignUp(static_cast<uint64_t>(section->virtualAddress) + virtualSize, sectionAlignment);
+        if (section->sizeOfRawData) {
+            fileEnd = std::max<uint64_t>(fileEnd,
+                static_cast<uint64_t>(section->pointerToRawData) + section->sizeOfRawData);
+        }
+        if (virtualEnd > UINT32_MAX || fileEnd > UINT32_MAX) {
+            mErrorString = "image is too large";
+            return false;
+        }
+    }
+
+    // Anything in the headers referring to a section that moved in memory
+    // moves with it (the certificate table is a file offset and is left to
+    // the writer); references within the section data are not rewritten
+
+    if (moved) {
+        for (int i = 0; i < OptionalHeader::DataDirectoryCount; ++i) {
+            if (i != OptionalHeader::CertificateTable) {
+                relocate(optionalHeader->mDataDirectory[i].virtualAddress, moves);
+            }
+        }
+        relocate(optionalHeader->mAddressOfEntryPoint, moves);
+        relocate(optionalHeader->mBaseOfCode, moves);
+        if (optionalHeader->mMagic == OptionalHeader::Win32) {
+            relocate(optionalHeader->mImageBaseLoBaseOfData, moves);
+        }
+    }
+
+    mFile->mFileHeader.d->mNumberOfSections = static_cast<uint16_t>(entries.size());
+    optionalHeader->mSizeOfImage = static_cast<uint32_t>(virtualEnd);
+
+    return true;
+}
+
+bool Layout::makeHeaderRoom(uint64_t tableEnd)
+{
+    OptionalHeaderPrivate *optionalHeader = mFile->mOptionalHeader.d;
+
+    // Prefer to grow the headers, which pushes the section data along in the
+    // file; this is only possible if the first section in memory starts late
+    // enough to leave room for the larger headers
+
+    uint64_t sizeOfHeaders = alignUp(tableEnd, optionalHeader->mFileAlignment);
+    uint64_t lowestAddress = UINT32_MAX;
+    const std::vector<SectionEntry> &entries = mFile->mSectionTable.mEntries;
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        lowestAddress = std::min<uint64_t>(lowestAddress, (*it).virtualAddress);
+    }
+    if (sizeOfHeaders <= lowestAddress) {
+        optionalHeader->mSizeOfHeaders = static_cast<uint32_t>(sizeOfHeaders);
+        return true;
+    }
+
+    // Otherwise move the PE headers (and therefore the section table) up into
+    // the space occupied by the DOS stub, which is discarded
+    uint64_t stubSize = mFile->mDOSHeader.size() - DOSHeaderSize;
+    if (tableEnd - stubSize <= optionalHeader->mSizeOfHeaders) {
+        mFile->mDOSHeader.resize(DOSHeaderSize);
+        uint32_t peOffset = boost::endian::native_to_little(static_cast<uint32_t>(DOSHeaderSize));
+        mFile->mDOSHeader.replace(PEOffsetOffset, sizeof(peOffset),
+                                  reinterpret_cast<const char*>(&peOffset), sizeof(peOffset));
+        return true;
+    }
+
+    mErrorString = "no room for the section table";
+    return false;
+}
+
+void Layout::relocate(uint32_t &rva, const std::vector<Move> &moves) const
+{
+    // Sections may have grown into the range of the next one, so the owner is
+    // the section with the latest start containing the RVA
+    const Move *owner = nullptr;
+    for (auto it = moves.begin(); it != moves.end(); ++it) {
+        if ((*it).begin <= rva && rva < (*it).end && (!owner || (*it).begin >= owner->begin)) {
+            owner = &(*it);
+        }
+    }
+    if (owner && rva) {
+        rva += owner->delta;
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_LAYOUT_P_H
+#define WIN32PE_LAYOUT_P_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace win32pe
+{
+
+class FilePrivate;
+
+/**
+ * @brief Recomputes section placement after sections are modified
+ *
+ * Only sections from the modified one onwards are considered and each is
+ * only moved if it now overlaps its predecessor (in the file or in memory),
+ * so the cost of a change is proportional to what actually has to move.
+ */
+class Layout
+{
+public:
+
+    Layout(FilePrivate *file);
+
+    bool update(size_t first);
+
+    std::string mErrorString;
+
+private:
+
+    struct Move
+    {
+        uint32_t begin;
+        uint32_t end;
+        uint32_t delta;
+    };
+
+    bool makeHeaderRoom(uint64_t tableEnd);
+    void relocate(uint32_t &rva, const std::vector<Move> &moves) const;
+
+    FilePrivate *const mFile;
+};
+
+}
+
+#endif // WIN32PE_LAYOUT_P_H
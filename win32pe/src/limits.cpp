@@ -0,0 +1,120 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <win32pe/limits.h>
+
+#include "limits_p.h"
+
+using namespace win32pe;
+
+LimitsPrivate::LimitsPrivate()
+    : mMaxHeaderSize(1 << 20),
+      mMaxSections(4096),
+      mMaxSectionSize(256 << 20),
+      mMaxTotalSize(1 << 30),
+      mMaxImportDescriptors(65536),
+      mTimeBudget(0)
+{
+}
+
+Limits::Limits()
+    : d(new LimitsPrivate)
+{
+}
+
+Limits::Limits(const Limits &other)
+    : d(new LimitsPrivate(*other.d))
+{
+}
+
+Limits::~Limits()
+{
+    delete d;
+}
+
+Limits &Limits::operator=(const Limits &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+void Limits::setMaxHeaderSize(uint32_t size)
+{
+    d->mMaxHeaderSize = size;
+}
+
+uint32_t Limits::maxHeaderSize() const
+{
+    return d->mMaxHeaderSize;
+}
+
+void Limits::setMaxSections(uint32_t count)
+{
+    d->mMaxSections = count;
+}
+
+uint32_t Limits::maxSections() const
+{
+    return d->mMaxSections;
+}
+
+void Limits::setMaxSectionSize(uint32_t size)
+{
+    d->mMaxSectionSize = size;
+}
+
+uint32_t Limits::maxSectionSize() const
+{
+    return d->mMaxSectionSize;
+}
+
+void Limits::setMaxTotalSize(uint64_t size)
+{
+    d->mMaxTotalSize = size;
+}
+
+uint64_t Limits::maxTotalSize() const
+{
+    return d->mMaxTotalSize;
+}
+
+void Limits::setMaxImportDescriptors(uint32_t count)
+{
+    d->mMaxImportDescriptors = count;
+}
+
+uint32_t Limits::maxImportDescriptors() const
+{
+    return d->mMaxImportDescriptors;
+}
+
+void Limits::setTimeBudget(uint32_t milliseconds)
+{
+    d->mTimeBudget = milliseconds;
+}
+
+uint32_t Limits::timeBudget() const
+{
+    return d->mTimeBudget;
+}
@@ -0,0 +1,72 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_MEMORYSTREAMBUF_P_H
+#define WIN32PE_MEMORYSTREAMBUF_P_H
+
+#include <cstddef>
+#include <streambuf>
+
+namespace win32pe
+{
+
+/**
+ * @brief Read-only stream buffer over a block of memory
+ *
+ * This allows the stream-based readers to be used for data that is already
+ * in memory without copying it.
+ */
+class MemoryStreamBuf : public std::streambuf
+{
+public:
+
+    MemoryStreamBuf(const char *data, size_t size)
+    {
+        char *begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+
+protected:
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) override
+    {
+        char *base = dir == std::ios_base::beg ? eback() :
+                     dir == std::ios_base::cur ? gptr() : egptr();
+        off_type pos = (base - eback()) + off;
+        if (pos < 0 || pos > egptr() - eback()) {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), eback() + pos, egptr());
+        return pos_type(pos);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+}
+
+#endif // WIN32PE_MEMORYSTREAMBUF_P_H
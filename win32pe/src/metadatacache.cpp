@@ -0,0 +1,317 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include <win32pe/file.h>
+#include <win32pe/metadatacache.h>
+
+#include "endian_p.h"
+#include "file_p.h"
+#include "metadatacache_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+// The cache begins with a signature (which includes the format version) and
+// the number of index entries
+
+const char Signature[] = "W32PEMC3";
+const size_t SignatureSize = 8;
+const size_t HeaderSize = SignatureSize + 2 * sizeof(uint32_t);
+
+// Each index entry holds the key followed by the offset and size of the record
+const size_t EntrySize = 48;
+
+}
+
+MetadataCachePrivate::MetadataCachePrivate()
+    : mData(nullptr),
+      mCount(0)
+{
+}
+
+bool MetadataCachePrivate::stat(const std::string &path, FileKey &key)
+{
+    if (!FileKey::read(path, key)) {
+        mErrorString = "unable to stat file";
+        return false;
+    }
+    return true;
+}
+
+bool MetadataCachePrivate::map()
+{
+    mRegion.reset();
+    mData = nullptr;
+    mCount = 0;
+    mUsed.clear();
+
+    // A missing cache is simply empty
+    std::ifstream ifstream(mFilename, std::ios::binary);
+    if (!ifstream) {
+        return true;
+    }
+    ifstream.close();
+
+    try {
+        boost::interprocess::file_mapping file(mFilename.c_str(), boost::interprocess::read_only);
+        mRegion.reset(new boost::interprocess::mapped_region(file, boost::interprocess::read_only));
+    } catch (const boost::interprocess::interprocess_exception &) {
+        // Mapping an empty file fails; treat it like a missing cache
+        mRegion.reset();
+        return true;
+    }
+
+    // Discard caches that are corrupt or from another version
+    const char *data = static_cast<const char*>(mRegion->get_address());
+    size_t size = mRegion->get_size();
+    if (size < HeaderSize || memcmp(data, Signature, SignatureSize)) {
+        mRegion.reset();
+        return true;
+    }
+    uint32_t count = readLittle<uint32_t>(data + SignatureSize);
+    if (count > (size - HeaderSize) / EntrySize) {
+        mRegion.reset();
+        return true;
+    }
+
+    mData = data;
+    mCount = count;
+    mUsed.assign(count, false);
+
+    return true;
+}
+
+bool MetadataCachePrivate::find(const FileKey &key, size_t &index) const
+{
+    size_t first = 0, last = mCount;
+    while (first < last) {
+        size_t middle = first + (last - first) / 2;
+        if (keyAt(middle) < key) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    if (first < mCount && keyAt(first) == key) {
+        index = first;
+        return true;
+    }
+    return false;
+}
+
+FileKey MetadataCachePrivate::keyAt(size_t index) const
+{
+    const char *entry = mData + HeaderSize + index * EntrySize;
+    FileKey key = {
+        readLittle<uint64_t>(entry),
+        readLittle<uint64_t>(entry + 8),
+        readLittle<uint64_t>(entry + 16),
+        readLittle<int64_t>(entry + 24)
+    };
+    return key;
+}
+
+MetadataCache::MetadataCache()
+    : d(new MetadataCachePrivate)
+{
+}
+
+MetadataCache::~MetadataCache()
+{
+    delete d;
+}
+
+bool MetadataCache::open(const std::string &filename)
+{
+    d->mFilename = filename;
+    d->mPending.clear();
+    return d->map();
+}
+
+bool MetadataCache::lookup(const std::string &path, File &file)
+{
+    FileKey key;
+    if (!d->stat(path, key)) {
+        return false;
+    }
+
+    auto it = d->mPending.find(key);
+    if (it != d->mPending.end()) {
+        if (!file.d->readMetadata(it->second.data(), it->second.size())) {
+            d->mErrorString = file.d->mErrorString;
+            return false;
+        }
+        file.d->mHasFileKey = true;
+        file.d->mFileKey = key;
+        return true;
+    }
+
+    size_t index;
+    if (!d->find(key, index)) {
+        d->mErrorString = "file is not in the cache";
+        return false;
+    }
+
+    const char *entry = d->mData + HeaderSize + index * EntrySize;
+    uint64_t offset = readLittle<uint64_t>(entry + 32);
+    uint32_t size = readLittle<uint32_t>(entry + 40);
+    if (offset > d->mRegion->get_size() || size > d->mRegion->get_size() - offset) {
+        d->mErrorString = "cache entry is corrupt";
+        return false;
+    }
+
+    d->mUsed[index] = true;
+    if (!file.d->readMetadata(d->mData + offset, size)) {
+        d->mErrorString = file.d->mErrorString;
+        return false;
+    }
+    file.d->mHasFileKey = true;
+    file.d->mFileKey = key;
+
+    return true;
+}
+
+bool MetadataCache::insert(const std::string &path, const File &file)
+{
+    FileKey key;
+    if (!d->stat(path, key)) {
+        return false;
+    }
+
+    // Caching a file that has changed since it was loaded would associate
+    // stale metadata with the new contents, so the file must still have the
+    // identity it had when it was loaded
+    if (!file.d->mHasFileKey) {
+        d->mErrorString = "file was not loaded from a path";
+        return false;
+    }
+    if (!(key == file.d->mFileKey)) {
+        d->mErrorString = "file has changed since it was loaded";
+        return false;
+    }
+
+    std::string &record = d->mPending[key];
+    record.clear();
+    file.d->writeMetadata(record);
+
+    return true;
+}
+
+bool MetadataCache::save(bool pruneUnused)
+{
+    // Merge the mapped entries with the pending ones (which take precedence)
+    std::map<FileKey, boost::string_ref> entries;
+    for (size_t i = 0; i < d->mCount; ++i) {
+        if (pruneUnused && !d->mUsed[i]) {
+            continue;
+        }
+        const char *entry = d->mData + HeaderSize + i * EntrySize;
+        uint64_t offset = readLittle<uint64_t>(entry + 32);
+        uint32_t size = readLittle<uint32_t>(entry + 40);
+        if (offset <= d->mRegion->get_size() && size <= d->mRegion->get_size() - offset) {
+            entries[d->keyAt(i)] = boost::string_ref(d->mData + offset, size);
+        }
+    }
+    for (auto it = d->mPending.begin(); it != d->mPending.end(); ++it) {
+        entries[it->first] = boost::string_ref(it->second);
+    }
+
+    std::string header(Signature, SignatureSize);
+    appendLittle(header, static_cast<uint32_t>(entries.size()));
+    appendLittle(header, static_cast<uint32_t>(0));
+
+    std::string index;
+    index.reserve(entries.size() * EntrySize);
+    uint64_t offset = HeaderSize + entries.size() * EntrySize;
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        appendLittle(index, it->first.device);
+        appendLittle(index, it->first.inode);
+        appendLittle(index, it->first.size);
+        appendLittle(index, it->first.mtime);
+        appendLittle(index, offset);
+        appendLittle(index, static_cast<uint32_t>(it->second.size()));
+        appendLittle(index, static_cast<uint32_t>(0));
+        offset += it->second.size();
+    }
+
+    std::string tempFilename = d->mFilename + ".tmp";
+    {
+        std::ofstream ofstream(tempFilename, std::ios::binary | std::ios::trunc);
+        ofstream.write(header.data(), header.size());
+        ofstream.write(index.data(), index.size());
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            ofstream.write(it->second.data(), it->second.size());
+        }
+        if (!ofstream.flush()) {
+            d->mErrorString = "unable to write cache";
+            std::remove(tempFilename.c_str());
+            return false;
+        }
+    }
+
+    // The records refer to the mapping so it must be released only after
+    // they have been written
+    entries.clear();
+    d->mRegion.reset();
+    d->mData = nullptr;
+    d->mCount = 0;
+
+    // Pending entries are kept if the cache could not be replaced
+    if (std::rename(tempFilename.c_str(), d->mFilename.c_str())) {
+        d->mErrorString = "unable to replace cache";
+        std::remove(tempFilename.c_str());
+        d->map();
+        return false;
+    }
+
+    d->mPending.clear();
+    return d->map();
+}
+
+size_t MetadataCache::size() const
+{
+    size_t size = d->mCount;
+    for (auto it = d->mPending.begin(); it != d->mPending.end(); ++it) {
+        size_t index;
+        if (!d->find(it->first, index)) {
+            ++size;
+        }
+    }
+    return size;
+}
+
+std::string MetadataCache::errorString() const
+{
+    return d->mErrorString;
+}
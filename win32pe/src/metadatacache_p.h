@@ -0,0 +1,71 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_METADATACACHE_P_H
+#define WIN32PE_METADATACACHE_P_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "filekey_p.h"
+
+namespace win32pe
+{
+
+class MetadataCachePrivate
+{
+public:
+
+    MetadataCachePrivate();
+
+    bool stat(const std::string &path, FileKey &key);
+    bool map();
+
+    // Find an entry in the mapped index
+    bool find(const FileKey &key, size_t &index) const;
+    FileKey keyAt(size_t index) const;
+
+    std::string mErrorString;
+    std::string mFilename;
+
+    // Mapped cache file - the index consists of fixed-size entries sorted
+    // by key followed by the records they refer to
+
+    std::unique_ptr<boost::interprocess::mapped_region> mRegion;
+    const char *mData;
+    size_t mCount;
+    std::vector<bool> mUsed;
+
+    // Entries added since the cache was opened
+    std::map<FileKey, std::string> mPending;
+};
+
+}
+
+#endif // WIN32PE_METADATACACHE_P_H
@@ -22,10 +22,9 @@
  * IN THE SOFTWARE.
  */
 
-#include <boost/endian/conversion.hpp>
-
 #include <win32pe/optionalheader.h>
 
+#include "imageclass_p.h"
 #include "optionalheader_p.h"
 
 using namespace win32pe;
@@ -65,73 +64,171 @@ OptionalHeaderPrivate::OptionalHeaderPrivate()
 {
 }
 
-bool OptionalHeaderPrivate::read(std::istream &istream)
+// PE32 stores BaseOfData and a 32-bit ImageBase where PE32+ stores a 64-bit
+// ImageBase - both occupy the same eight bytes
+
+static void decodeBase(OptionalHeaderPrivate *d, const RawOptionalHeaderBase<le32, true> &base)
 {
-    if (!istream.read(
-            reinterpret_cast<char*>(&mMagic),
-            reinterpret_cast<char*>(&mSizeOfStackReserve) - reinterpret_cast<char*>(&mMagic)
-        )) {
-        return false;
-    }
+    d->mImageBaseLoBaseOfData = base.baseOfData.value();
+    d->mImageBaseHi = base.imageBase.value();
+}
+
+static void decodeBase(OptionalHeaderPrivate *d, const RawOptionalHeaderBase<le64, false> &base)
+{
+    uint64_t imageBase = base.imageBase.value();
+    d->mImageBaseLoBaseOfData = static_cast<uint32_t>(imageBase);
+    d->mImageBaseHi = static_cast<uint32_t>(imageBase >> 32);
+}
 
-    boost::endian::little_to_native_inplace(mMagic);
-    boost::endian::little_to_native_inplace(mSizeOfCode);
-    boost::endian::little_to_native_inplace(mSizeOfInitializedData);
-    boost::endian::little_to_native_inplace(mSizeOfUninitializedData);
-    boost::endian::little_to_native_inplace(mAddressOfEntryPoint);
-    boost::endian::little_to_native_inplace(mBaseOfCode);
-    boost::endian::little_to_native_inplace(mImageBaseLoBaseOfData);
-    boost::endian::little_to_native_inplace(mImageBaseHi);
-    boost::endian::little_to_native_inplace(mSectionAlignment);
-    boost::endian::little_to_native_inplace(mFileAlignment);
-    boost::endian::little_to_native_inplace(mMajorOperatingSystemVersion);
-    boost::endian::little_to_native_inplace(mMinorOperatingSystemVersion);
-    boost::endian::little_to_native_inplace(mMajorImageVersion);
-    boost::endian::little_to_native_inplace(mMinorImageVersion);
-    boost::endian::little_to_native_inplace(mMajorSubsystemVersion);
-    boost::endian::little_to_native_inplace(mMinorSubsystemVersion);
-    boost::endian::little_to_native_inplace(mWin32VersionValue);
-    boost::endian::little_to_native_inplace(mSizeOfImage);
-    boost::endian::little_to_native_inplace(mSizeOfHeaders);
-    boost::endian::little_to_native_inplace(mCheckSum);
-    boost::endian::little_to_native_inplace(mSubsystem);
-    boost::endian::little_to_native_inplace(mDllCharacteristics);
-
-    std::streamsize size = mMagic == OptionalHeader::Win32 ? sizeof(uint32_t) : sizeof(uint64_t);
-    if (!istream.read(reinterpret_cast<char*>(&mSizeOfStackReserve), size) ||
-            !istream.read(reinterpret_cast<char*>(&mSizeOfStackCommit), size) ||
-            !istream.read(reinterpret_cast<char*>(&mSizeOfHeapReserve), size) ||
-            !istream.read(reinterpret_cast<char*>(&mSizeOfHeapCommit), size)) {
+static void encodeBase(const OptionalHeaderPrivate *d, RawOptionalHeaderBase<le32, true> &base)
+{
+    base.baseOfData = d->mImageBaseLoBaseOfData;
+    base.imageBase = d->mImageBaseHi;
+}
+
+static void encodeBase(const OptionalHeaderPrivate *d, RawOptionalHeaderBase<le64, false> &base)
+{
+    base.imageBase = static_cast<uint64_t>(d->mImageBaseHi) << 32 | d->mImageBaseLoBaseOfData;
+}
+
+template<typename Image>
+bool decode(OptionalHeaderPrivate *d, std::istream &istream, uint16_t magic)
+{
+    // The magic value has already been consumed, so read the remainder of
+    // the header into place behind it
+
+    typename Image::RawOptionalHeader raw;
+    raw.magic = magic;
+    if (!istream.read(reinterpret_cast<char*>(&raw) + sizeof(raw.magic), sizeof(raw) - sizeof(raw.magic))) {
         return false;
     }
 
-    boost::endian::little_to_native_inplace(mSizeOfStackReserve);
-    boost::endian::little_to_native_inplace(mSizeOfStackCommit);
-    boost::endian::little_to_native_inplace(mSizeOfHeapReserve);
-    boost::endian::little_to_native_inplace(mSizeOfHeapCommit);
+    d->mMagic = magic;
+    d->mMajorLinkerVersion = raw.majorLinkerVersion.value();
+    d->mMinorLinkerVersion = raw.minorLinkerVersion.value();
+    d->mSizeOfCode = raw.sizeOfCode.value();
+    d->mSizeOfInitializedData = raw.sizeOfInitializedData.value();
+    d->mSizeOfUninitializedData = raw.sizeOfUninitializedData.value();
+    d->mAddressOfEntryPoint = raw.addressOfEntryPoint.value();
+    d->mBaseOfCode = raw.baseOfCode.value();
+    decodeBase(d, raw.base);
+    d->mSectionAlignment = raw.sectionAlignment.value();
+    d->mFileAlignment = raw.fileAlignment.value();
+    d->mMajorOperatingSystemVersion = raw.majorOperatingSystemVersion.value();
+    d->mMinorOperatingSystemVersion = raw.minorOperatingSystemVersion.value();
+    d->mMajorImageVersion = raw.majorImageVersion.value();
+    d->mMinorImageVersion = raw.minorImageVersion.value();
+    d->mMajorSubsystemVersion = raw.majorSubsystemVersion.value();
+    d->mMinorSubsystemVersion = raw.minorSubsystemVersion.value();
+    d->mWin32VersionValue = raw.win32VersionValue.value();
+    d->mSizeOfImage = raw.sizeOfImage.value();
+    d->mSizeOfHeaders = raw.sizeOfHeaders.value();
+    d->mCheckSum = raw.checkSum.value();
+    d->mSubsystem = raw.subsystem.value();
+    d->mDllCharacteristics = raw.dllCharacteristics.value();
+    d->mSizeOfStackReserve = raw.sizeOfStackReserve.value();
+    d->mSizeOfStackCommit = raw.sizeOfStackCommit.value();
+    d->mSizeOfHeapReserve = raw.sizeOfHeapReserve.value();
+    d->mSizeOfHeapCommit = raw.sizeOfHeapCommit.value();
+    d->mLoaderFlags = raw.loaderFlags.value();
+    d->mNumberOfRvaAndSizes = raw.numberOfRvaAndSizes.value();
 
-    if (!istream.read(
-            reinterpret_cast<char*>(&mLoaderFlags),
-            reinterpret_cast<char*>(&mDataDirectory) - reinterpret_cast<char*>(&mLoaderFlags)
-        )) {
+    return true;
+}
+
+template<typename Image>
+void encode(const OptionalHeaderPrivate *d, std::string &buffer)
+{
+    typename Image::RawOptionalHeader raw;
+    raw.magic = d->mMagic;
+    raw.majorLinkerVersion = d->mMajorLinkerVersion;
+    raw.minorLinkerVersion = d->mMinorLinkerVersion;
+    raw.sizeOfCode = d->mSizeOfCode;
+    raw.sizeOfInitializedData = d->mSizeOfInitializedData;
+    raw.sizeOfUninitializedData = d->mSizeOfUninitializedData;
+    raw.addressOfEntryPoint = d->mAddressOfEntryPoint;
+    raw.baseOfCode = d->mBaseOfCode;
+    encodeBase(d, raw.base);
+    raw.sectionAlignment = d->mSectionAlignment;
+    raw.fileAlignment = d->mFileAlignment;
+    raw.majorOperatingSystemVersion = d->mMajorOperatingSystemVersion;
+    raw.minorOperatingSystemVersion = d->mMinorOperatingSystemVersion;
+    raw.majorImageVersion = d->mMajorImageVersion;
+    raw.minorImageVersion = d->mMinorImageVersion;
+    raw.majorSubsystemVersion = d->mMajorSubsystemVersion;
+    raw.minorSubsystemVersion = d->mMinorSubsystemVersion;
+    raw.win32VersionValue = d->mWin32VersionValue;
+    raw.sizeOfImage = d->mSizeOfImage;
+    raw.sizeOfHeaders = d->mSizeOfHeaders;
+    raw.checkSum = d->mCheckSum;
+    raw.subsystem = d->mSubsystem;
+    raw.dllCharacteristics = d->mDllCharacteristics;
+
+    // Truncated as necessary for 32-bit executables
+    raw.sizeOfStackReserve = d->mSizeOfStackReserve;
+    raw.sizeOfStackCommit = d->mSizeOfStackCommit;
+    raw.sizeOfHeapReserve = d->mSizeOfHeapReserve;
+    raw.sizeOfHeapCommit = d->mSizeOfHeapCommit;
+
+    raw.loaderFlags = d->mLoaderFlags;
+    raw.numberOfRvaAndSizes = d->mNumberOfRvaAndSizes;
+
+    buffer.append(reinterpret_cast<const char*>(&raw), sizeof(raw));
+}
+
+bool OptionalHeaderPrivate::read(std::istream &istream)
+{
+    // The magic value determines which layout follows
+    le16 magic;
+    if (!istream.read(reinterpret_cast<char*>(&magic), sizeof(magic))) {
         return false;
     }
 
-    boost::endian::little_to_native_inplace(mLoaderFlags);
-    boost::endian::little_to_native_inplace(mNumberOfRvaAndSizes);
+    bool ok = magic.value() == OptionalHeader::Win32 ?
+        decode<ImagePE32>(this, istream, magic.value()) :
+        decode<ImagePE32Plus>(this, istream, magic.value());
+    if (!ok) {
+        return false;
+    }
 
-    if (!istream.read(reinterpret_cast<char*>(mDataDirectory), sizeof(mDataDirectory))) {
+    RawDataDirectory raw[OptionalHeader::DataDirectoryCount];
+    if (!istream.read(reinterpret_cast<char*>(raw), sizeof(raw))) {
         return false;
     }
 
     for (int i = 0; i < OptionalHeader::DataDirectoryCount; ++i) {
-        boost::endian::little_to_native_inplace(mDataDirectory[i].virtualAddress);
-        boost::endian::little_to_native_inplace(mDataDirectory[i].size);
+        mDataDirectory[i].virtualAddress = raw[i].virtualAddress.value();
+        mDataDirectory[i].size = raw[i].size.value();
     }
 
     return true;
 }
 
+void OptionalHeaderPrivate::write(std::string &buffer) const
+{
+    if (mMagic == OptionalHeader::Win32) {
+        encode<ImagePE32>(this, buffer);
+    } else {
+        encode<ImagePE32Plus>(this, buffer);
+    }
+
+    RawDataDirectory raw[OptionalHeader::DataDirectoryCount];
+    for (int i = 0; i < OptionalHeader::DataDirectoryCount; ++i) {
+        raw[i].virtualAddress = mDataDirectory[i].virtualAddress;
+        raw[i].size = mDataDirectory[i].size;
+    }
+
+    buffer.append(reinterpret_cast<const char*>(raw), sizeof(raw));
+}
+
+uint16_t OptionalHeaderPrivate::size() const
+{
+    return (mMagic == OptionalHeader::Win32 ?
+            sizeof(ImagePE32::RawOptionalHeader) :
+            sizeof(ImagePE32Plus::RawOptionalHeader)) +
+        OptionalHeader::DataDirectoryCount * sizeof(RawDataDirectory);
+}
+
 OptionalHeader::OptionalHeader()
     : d(new OptionalHeaderPrivate)
 {
@@ -158,6 +255,14 @@ uint16_t OptionalHeader::magic() const
     return d->mMagic;
 }
 
+uint64_t OptionalHeader::imageBase() const
+{
+    if (d->mMagic == Win64) {
+        return static_cast<uint64_t>(d->mImageBaseHi) << 32 | d->mImageBaseLoBaseOfData;
+    }
+    return d->mImageBaseHi;
+}
+
 uint16_t OptionalHeader::majorOperatingSystemVersion() const
 {
     return d->mMajorOperatingSystemVersion;
@@ -168,6 +273,21 @@ uint16_t OptionalHeader::minorOperatingSystemVersion() const
     return d->mMinorOperatingSystemVersion;
 }
 
+uint32_t OptionalHeader::sizeOfImage() const
+{
+    return d->mSizeOfImage;
+}
+
+uint32_t OptionalHeader::sizeOfHeaders() const
+{
+    return d->mSizeOfHeaders;
+}
+
+uint32_t OptionalHeader::checkSum() const
+{
+    return d->mCheckSum;
+}
+
 uint16_t OptionalHeader::subsystem() const
 {
     return d->mSubsystem;
@@ -27,6 +27,7 @@
 
 #include <cstdint>
 #include <istream>
+#include <string>
 
 #include <win32pe/optionalheader.h>
 
@@ -40,6 +41,10 @@ public:
     OptionalHeaderPrivate();
 
     bool read(std::istream &istream);
+    void write(std::string &buffer) const;
+
+    // Size of the header when written, which depends on the magic value
+    uint16_t size() const;
 
     // Both 32 and 64-bit executables share the first few fields - the
     // exception being ImageBase, which has a different size and BaseOfData
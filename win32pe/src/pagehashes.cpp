@@ -0,0 +1,423 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <win32pe/file.h>
+#include <win32pe/optionalheader.h>
+#include <win32pe/pagehashes.h>
+
+#include "digest_p.h"
+#include "endian_p.h"
+#include "file_p.h"
+#include "pagehashes_p.h"
+#include "parallel_p.h"
+#include "structs_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+// The serialized form begins with a signature (which includes the format
+// version), the algorithm, the number of pages, the end offset and the
+// number of levels, followed by the pages and then every level of the tree
+
+const char Signature[] = "W32PEPH1";
+const size_t SignatureSize = 8;
+const size_t PageFields = 6;
+
+template<typename Hash>
+std::string hashPage(const char *data, const PageHashesPrivate::Page &page)
+{
+    static const char Zeroes[PageHashes::PageSize] = {};
+
+    Hash hash;
+    uint32_t pos = page.offset;
+    for (int i = 0; i < 2; ++i) {
+        if (page.excluded[i][0] < page.excluded[i][1]) {
+            hash.update(data + pos, page.excluded[i][0] - pos);
+            pos = page.excluded[i][1];
+        }
+    }
+    hash.update(data + pos, page.offset + page.size - pos);
+    if (page.size < PageHashes::PageSize) {
+        hash.update(Zeroes, PageHashes::PageSize - page.size);
+    }
+
+    std::string digest;
+    hash.finish(digest);
+    return digest;
+}
+
+template<typename Hash>
+std::string hashData(const char *data, size_t size)
+{
+    Hash hash;
+    hash.update(data, size);
+    std::string digest;
+    hash.finish(digest);
+    return digest;
+}
+
+bool samePages(const std::vector<PageHashesPrivate::Page> &a, const std::vector<PageHashesPrivate::Page> &b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+        [](const PageHashesPrivate::Page &a, const PageHashesPrivate::Page &b) {
+            return a.offset == b.offset && a.size == b.size &&
+                   !memcmp(a.excluded, b.excluded, sizeof(a.excluded));
+        });
+}
+
+}
+
+const uint32_t PageHashes::PageSize;
+
+PageHashesPrivate::PageHashesPrivate()
+    : mAlgorithm(PageHashes::SHA256),
+      mThreadCount(0),
+      mEnd(0)
+{
+}
+
+size_t PageHashesPrivate::digestSize() const
+{
+    return mAlgorithm == PageHashes::SHA1 ? 20 : 32;
+}
+
+std::string PageHashesPrivate::hash(const char *data, size_t size) const
+{
+    return mAlgorithm == PageHashes::SHA1 ? hashData<Sha1>(data, size) : hashData<Sha256>(data, size);
+}
+
+bool PageHashesPrivate::layout(const char *data, size_t size, std::vector<Page> &pages, uint32_t &end)
+{
+    // The loader reads the caller's data in place rather than copying it
+    FilePrivate file(nullptr);
+    if (!file.loadView(data, size, false)) {
+        mErrorString = file.mErrorString;
+        return false;
+    }
+
+    // The loader has already checked that the headers are present
+    uint64_t optionalOffset = readLittle<uint32_t>(data + PEOffsetOffset) + sizeof(uint32_t) + sizeof(RawFileHeader);
+    bool pe32Plus = file.mOptionalHeader.magic() == OptionalHeader::Win64;
+    uint32_t sizeOfHeaders = pe32Plus ?
+        rawView<RawOptionalHeader64>(data, size, optionalOffset)->sizeOfHeaders.value() :
+        rawView<RawOptionalHeader32>(data, size, optionalOffset)->sizeOfHeaders.value();
+    sizeOfHeaders = static_cast<uint32_t>(std::min<uint64_t>(sizeOfHeaders, size));
+
+    // The header page omits the CheckSum field and the certificate table
+    // entry since both change when a file is signed
+    uint64_t checkSumOffset = optionalOffset + offsetof(RawOptionalHeader32, checkSum);
+    uint64_t certificateOffset = optionalOffset +
+        (pe32Plus ? sizeof(RawOptionalHeader64) : sizeof(RawOptionalHeader32)) +
+        OptionalHeader::CertificateTable * sizeof(RawDataDirectory);
+    Page header = {0, sizeOfHeaders, {{0, 0}, {0, 0}}};
+    if (checkSumOffset + sizeof(uint32_t) <= sizeOfHeaders) {
+        header.excluded[0][0] = static_cast<uint32_t>(checkSumOffset);
+        header.excluded[0][1] = static_cast<uint32_t>(checkSumOffset + sizeof(uint32_t));
+    }
+    if (certificateOffset + sizeof(RawDataDirectory) <= sizeOfHeaders) {
+        header.excluded[1][0] = static_cast<uint32_t>(certificateOffset);
+        header.excluded[1][1] = static_cast<uint32_t>(certificateOffset + sizeof(RawDataDirectory));
+    }
+    pages.clear();
+    pages.push_back(header);
+    end = sizeOfHeaders;
+
+    // Sections with data follow in file order
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (auto it = file.mSectionTable.mEntries.begin(); it != file.mSectionTable.mEntries.end(); ++it) {
+        if ((*it).sizeOfRawData) {
+            ranges.push_back(std::make_pair((*it).pointerToRawData, (*it).sizeOfRawData));
+        }
+    }
+    std::stable_sort(ranges.begin(), ranges.end());
+    for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+        for (uint32_t offset = 0; offset < (*it).second; offset += PageHashes::PageSize) {
+            Page page = {(*it).first + offset, std::min(PageHashes::PageSize, (*it).second - offset), {{0, 0}, {0, 0}}};
+            pages.push_back(page);
+        }
+        end = (*it).first + (*it).second;
+    }
+
+    return true;
+}
+
+void PageHashesPrivate::hashPages(const char *data, const std::vector<size_t> &indices)
+{
+    // Each page's digest is written to its own slot, so no locking is needed
+    size_t size = digestSize();
+    std::string &leaves = mLevels[0];
+    parallelFor(indices.size(), mThreadCount, [this, data, &indices, size, &leaves](size_t i) {
+        const Page &page = mPages[indices[i]];
+        std::string digest = mAlgorithm == PageHashes::SHA1 ? hashPage<Sha1>(data, page) : hashPage<Sha256>(data, page);
+        memcpy(&leaves[indices[i] * size], digest.data(), size);
+    });
+}
+
+void PageHashesPrivate::buildTree()
+{
+    size_t size = digestSize();
+    mLevels.resize(1);
+    while (mLevels.back().size() > size) {
+        const std::string &level = mLevels.back();
+        size_t count = level.size() / size;
+        std::string parents;
+        for (size_t i = 0; i < count; i += 2) {
+            parents.append(i + 1 < count ? hash(level.data() + i * size, 2 * size) : level.substr(i * size, size));
+        }
+        mLevels.push_back(parents);
+    }
+}
+
+void PageHashesPrivate::updateTree(std::vector<size_t> changed)
+{
+    size_t size = digestSize();
+    for (size_t level = 1; level < mLevels.size(); ++level) {
+        const std::string &children = mLevels[level - 1];
+        size_t count = children.size() / size;
+
+        std::vector<size_t> parents;
+        for (auto it = changed.begin(); it != changed.end(); ++it) {
+            if (parents.empty() || parents.back() != *it / 2) {
+                parents.push_back(*it / 2);
+            }
+        }
+        for (auto it = parents.begin(); it != parents.end(); ++it) {
+            size_t child = *it * 2;
+            std::string node = child + 1 < count ?
+                hash(children.data() + child * size, 2 * size) : children.substr(child * size, size);
+            memcpy(&mLevels[level][*it * size], node.data(), size);
+        }
+        changed.swap(parents);
+    }
+}
+
+PageHashes::PageHashes()
+    : d(new PageHashesPrivate)
+{
+}
+
+PageHashes::PageHashes(const PageHashes &other)
+    : d(new PageHashesPrivate(*other.d))
+{
+}
+
+PageHashes::~PageHashes()
+{
+    delete d;
+}
+
+PageHashes &PageHashes::operator=(const PageHashes &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+void PageHashes::setAlgorithm(Algorithm algorithm)
+{
+    d->mAlgorithm = algorithm;
+}
+
+PageHashes::Algorithm PageHashes::algorithm() const
+{
+    return d->mAlgorithm;
+}
+
+void PageHashes::setThreadCount(size_t threads)
+{
+    d->mThreadCount = threads;
+}
+
+size_t PageHashes::threadCount() const
+{
+    return d->mThreadCount;
+}
+
+bool PageHashes::compute(const char *data, size_t size)
+{
+    std::vector<PageHashesPrivate::Page> pages;
+    uint32_t end;
+    if (!d->layout(data, size, pages, end)) {
+        return false;
+    }
+
+    d->mPages.swap(pages);
+    d->mEnd = end;
+    d->mLevels.assign(1, std::string(d->mPages.size() * d->digestSize(), '\0'));
+
+    std::vector<size_t> indices(d->mPages.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        indices[i] = i;
+    }
+    d->hashPages(data, indices);
+    d->buildTree();
+
+    return true;
+}
+
+bool PageHashes::update(const char *data, size_t size, uint64_t offset, uint64_t length)
+{
+    std::vector<PageHashesPrivate::Page> pages;
+    uint32_t end;
+    if (!d->layout(data, size, pages, end)) {
+        return false;
+    }
+    if (d->mLevels.empty() || !samePages(pages, d->mPages) || end != d->mEnd) {
+        return compute(data, size);
+    }
+
+    std::vector<size_t> changed;
+    for (size_t i = 0; i < d->mPages.size(); ++i) {
+        const PageHashesPrivate::Page &page = d->mPages[i];
+        if (offset < static_cast<uint64_t>(page.offset) + page.size && page.offset < offset + length) {
+            changed.push_back(i);
+        }
+    }
+    d->hashPages(data, changed);
+    d->updateTree(changed);
+
+    return true;
+}
+
+size_t PageHashes::pageCount() const
+{
+    return d->mPages.size();
+}
+
+uint32_t PageHashes::pageOffset(size_t index) const
+{
+    return index < d->mPages.size() ? d->mPages[index].offset : 0;
+}
+
+std::string PageHashes::pageHash(size_t index) const
+{
+    if (index >= d->mPages.size()) {
+        return std::string();
+    }
+    return d->mLevels[0].substr(index * d->digestSize(), d->digestSize());
+}
+
+std::string PageHashes::rootHash() const
+{
+    return d->mLevels.empty() ? std::string() : d->mLevels.back();
+}
+
+std::string PageHashes::authenticodeTable() const
+{
+    size_t size = d->digestSize();
+    std::string table;
+    table.reserve((d->mPages.size() + 1) * (sizeof(uint32_t) + size));
+    for (size_t i = 0; i < d->mPages.size(); ++i) {
+        appendLittle(table, d->mPages[i].offset);
+        table.append(d->mLevels[0], i * size, size);
+    }
+    appendLittle(table, d->mEnd);
+    table.append(size, '\0');
+    return table;
+}
+
+std::string PageHashes::save() const
+{
+    std::string data(Signature, SignatureSize);
+    appendLittle(data, static_cast<uint32_t>(d->mAlgorithm));
+    appendLittle(data, static_cast<uint32_t>(d->mPages.size()));
+    appendLittle(data, d->mEnd);
+    appendLittle(data, static_cast<uint32_t>(d->mLevels.size()));
+    for (auto it = d->mPages.begin(); it != d->mPages.end(); ++it) {
+        appendLittle(data, (*it).offset);
+        appendLittle(data, (*it).size);
+        for (int i = 0; i < 2; ++i) {
+            appendLittle(data, (*it).excluded[i][0]);
+            appendLittle(data, (*it).excluded[i][1]);
+        }
+    }
+    for (auto it = d->mLevels.begin(); it != d->mLevels.end(); ++it) {
+        data.append(*it);
+    }
+    return data;
+}
+
+bool PageHashes::load(const std::string &data)
+{
+    const size_t headerSize = SignatureSize + 4 * sizeof(uint32_t);
+    if (data.size() < headerSize || data.compare(0, SignatureSize, Signature, SignatureSize)) {
+        d->mErrorString = "page hashes are invalid or from another version";
+        return false;
+    }
+
+    uint32_t algorithm = readLittle<uint32_t>(&data[SignatureSize]);
+    uint32_t pageCount = readLittle<uint32_t>(&data[SignatureSize + sizeof(uint32_t)]);
+    uint32_t end = readLittle<uint32_t>(&data[SignatureSize + 2 * sizeof(uint32_t)]);
+    uint32_t levelCount = readLittle<uint32_t>(&data[SignatureSize + 3 * sizeof(uint32_t)]);
+    if (algorithm > SHA256 || !pageCount ||
+            pageCount > (data.size() - headerSize) / (PageFields * sizeof(uint32_t))) {
+        d->mErrorString = "page hashes are corrupt";
+        return false;
+    }
+
+    // The size of every level follows from the number of pages
+    PageHashesPrivate loaded;
+    loaded.mAlgorithm = static_cast<Algorithm>(algorithm);
+    loaded.mThreadCount = d->mThreadCount;
+    loaded.mEnd = end;
+    loaded.mPages.resize(pageCount);
+    size_t pos = headerSize;
+    for (auto it = loaded.mPages.begin(); it != loaded.mPages.end(); ++it) {
+        uint32_t fields[PageFields];
+        for (size_t i = 0; i < PageFields; ++i, pos += sizeof(uint32_t)) {
+            fields[i] = readLittle<uint32_t>(&data[pos]);
+        }
+        (*it).offset = fields[0];
+        (*it).size = fields[1];
+        memcpy((*it).excluded, fields + 2, sizeof((*it).excluded));
+    }
+
+    size_t digestSize = loaded.digestSize();
+    size_t count = pageCount;
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        if (count * digestSize > data.size() - pos || (i + 1 == levelCount) != (count == 1)) {
+            d->mErrorString = "page hashes are corrupt";
+            return false;
+        }
+        loaded.mLevels.push_back(data.substr(pos, count * digestSize));
+        pos += count * digestSize;
+        count = (count + 1) / 2;
+    }
+    if (loaded.mLevels.empty() || pos != data.size()) {
+        d->mErrorString = "page hashes are corrupt";
+        return false;
+    }
+
+    *d = loaded;
+    return true;
+}
+
+std::string PageHashes::errorString() const
+{
+    return d->mErrorString;
+}
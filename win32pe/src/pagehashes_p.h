@@ -0,0 +1,78 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_PAGEHASHES_P_H
+#define WIN32PE_PAGEHASHES_P_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <win32pe/pagehashes.h>
+
+namespace win32pe
+{
+
+class PageHashesPrivate
+{
+public:
+
+    // A page is a range of the file, hashed after removing up to two
+    // excluded ranges (only the header page has any) and padding with
+    // zeroes to the page size
+
+    struct Page
+    {
+        uint32_t offset;
+        uint32_t size;
+        uint32_t excluded[2][2];
+    };
+
+    PageHashesPrivate();
+
+    size_t digestSize() const;
+    std::string hash(const char *data, size_t size) const;
+
+    bool layout(const char *data, size_t size, std::vector<Page> &pages, uint32_t &end);
+    void hashPages(const char *data, const std::vector<size_t> &indices);
+    void buildTree();
+    void updateTree(std::vector<size_t> changed);
+
+    PageHashes::Algorithm mAlgorithm;
+    size_t mThreadCount;
+
+    std::vector<Page> mPages;
+    uint32_t mEnd;
+
+    // Each level of the tree as concatenated digests, starting with the
+    // page hashes and ending with the root
+    std::vector<std::string> mLevels;
+
+    std::string mErrorString;
+};
+
+}
+
+#endif // WIN32PE_PAGEHASHES_P_H
@@ -0,0 +1,149 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "parallel_p.h"
+
+using namespace win32pe;
+
+void win32pe::parallelFor(size_t count, size_t threads, const std::function<void(size_t)> &function)
+{
+    if (!threads) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, count);
+
+    std::atomic<size_t> next(0);
+    auto worker = [&next, count, &function]() {
+        for (size_t i; (i = next++) < count;) {
+            function(i);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto it = workers.begin(); it != workers.end(); ++it) {
+        (*it).join();
+    }
+}
+
+ThreadPool::ThreadPool()
+    : mStop(false),
+      mFunction(nullptr),
+      mCount(0),
+      mNext(0),
+      mGeneration(0),
+      mSlots(0),
+      mPending(0)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mWake.notify_all();
+    for (auto it = mWorkers.begin(); it != mWorkers.end(); ++it) {
+        (*it).join();
+    }
+}
+
+void ThreadPool::run(size_t count, size_t threads, const std::function<void(size_t)> &function)
+{
+    std::unique_lock<std::mutex> running(mRunMutex, std::try_to_lock);
+    if (!running) {
+        parallelFor(count, threads, function);
+        return;
+    }
+
+    if (!threads) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, count);
+    if (threads < 2) {
+        for (size_t i = 0; i < count; ++i) {
+            function(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        while (mWorkers.size() < threads - 1) {
+            mWorkers.emplace_back(&ThreadPool::work, this);
+        }
+        mFunction = &function;
+        mCount = count;
+        mNext = 0;
+        ++mGeneration;
+        mSlots = threads - 1;
+        mPending = threads - 1;
+    }
+    mWake.notify_all();
+
+    // The calling thread takes part, as with parallelFor()
+    for (size_t i; (i = mNext++) < count;) {
+        function(i);
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [this]() { return !mPending; });
+    mFunction = nullptr;
+}
+
+void ThreadPool::work()
+{
+    size_t generation = 0;
+    std::unique_lock<std::mutex> lock(mMutex);
+    for (;;) {
+        mWake.wait(lock, [this, generation]() {
+            return mStop || (mSlots && mGeneration != generation);
+        });
+        if (mStop) {
+            return;
+        }
+
+        // Each worker joins a loop at most once
+        generation = mGeneration;
+        --mSlots;
+        const std::function<void(size_t)> &function = *mFunction;
+        size_t count = mCount;
+
+        lock.unlock();
+        for (size_t i; (i = mNext++) < count;) {
+            function(i);
+        }
+        lock.lock();
+
+        if (!--mPending) {
+            mDone.notify_all();
+        }
+    }
+}
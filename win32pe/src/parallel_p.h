@@ -0,0 +1,97 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_PARALLEL_P_H
+#define WIN32PE_PARALLEL_P_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace win32pe
+{
+
+/**
+ * @brief Invoke a function for each index in [0, count) on worker threads
+ * @param count number of indices
+ * @param threads maximum number of threads (0 for one per core)
+ * @param function function to invoke
+ *
+ * Indices are handed out one at a time so that uneven work is balanced
+ * across threads. The calling thread takes part and the call returns once
+ * every index has been processed.
+ */
+void parallelFor(size_t count, size_t threads, const std::function<void(size_t)> &function);
+
+/**
+ * @brief Worker threads that are kept between calls to run()
+ *
+ * This behaves like parallelFor() but saves creating threads for every call
+ * when an owner runs many short loops. Workers are started as they are first
+ * needed and stopped when the pool is destroyed. One loop runs at a time;
+ * a call made while the pool is busy falls back to parallelFor().
+ */
+class ThreadPool
+{
+public:
+
+    ThreadPool();
+    ~ThreadPool();
+
+    void run(size_t count, size_t threads, const std::function<void(size_t)> &function);
+
+private:
+
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+    void work();
+
+    // Held for the duration of a loop
+    std::mutex mRunMutex;
+
+    // Guards everything below except mNext
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    std::vector<std::thread> mWorkers;
+    bool mStop;
+
+    // The current loop, identified by its generation; mSlots is the number
+    // of workers still to join it and mPending the number yet to finish
+    const std::function<void(size_t)> *mFunction;
+    size_t mCount;
+    std::atomic<size_t> mNext;
+    size_t mGeneration;
+    size_t mSlots;
+    size_t mPending;
+};
+
+}
+
+#endif // WIN32PE_PARALLEL_P_H
@@ -0,0 +1,182 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstddef>
+
+#include <win32pe/optionalheader.h>
+#include <win32pe/probe.h>
+
+#include "endian_p.h"
+#include "file_p.h"
+#include "structs_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+// Offsets within the PE headers, relative to the start of the signature
+const size_t MachineOffset = sizeof(uint32_t) + offsetof(RawFileHeader, machine);
+const size_t OptionalHeaderOffset = sizeof(uint32_t) + sizeof(RawFileHeader);
+
+// Offsets within the optional header
+const size_t SubsystemOffset = offsetof(RawOptionalHeader32, subsystem);
+const size_t NumberOfRvaAndSizesOffset32 = offsetof(RawOptionalHeader32, numberOfRvaAndSizes);
+const size_t NumberOfRvaAndSizesOffset64 = offsetof(RawOptionalHeader64, numberOfRvaAndSizes);
+
+const size_t DataDirectoryItemSize = sizeof(RawDataDirectory);
+
+}
+
+Probe::Probe()
+    : mFormat(NotMZ),
+      mDotNet(false),
+      mHeaderOffset(0),
+      mMachine(0),
+      mSubsystem(0)
+{
+}
+
+Probe Probe::probe(const char *data, size_t size)
+{
+    Probe probe;
+
+    if (size < 2 || data[0] != 'M' || data[1] != 'Z') {
+        return probe;
+    }
+    probe.mFormat = Truncated;
+    if (size < static_cast<size_t>(DOSHeaderSize)) {
+        return probe;
+    }
+
+    // Anything without a plausible extended header is a plain DOS program
+    uint32_t offset = readLittle<uint32_t>(data + PEOffsetOffset);
+    if (offset < static_cast<uint32_t>(DOSHeaderSize)) {
+        probe.mFormat = DOS;
+        return probe;
+    }
+    if (offset > size || size - offset < 2) {
+        return probe;
+    }
+    probe.mHeaderOffset = offset;
+
+    const char *header = data + offset;
+    if (header[0] == 'N' && header[1] == 'E') {
+        probe.mFormat = NE;
+        return probe;
+    }
+    if (header[0] == 'L' && (header[1] == 'E' || header[1] == 'X')) {
+        probe.mFormat = LE;
+        return probe;
+    }
+    if (header[0] != 'P' || header[1] != 'E') {
+        probe.mFormat = DOS;
+        probe.mHeaderOffset = 0;
+        return probe;
+    }
+
+    // The PE signature is followed by the file header and optional header;
+    // everything up to the number of data directories must be present
+    size_t available = size - offset;
+    if (available < OptionalHeaderOffset + 2) {
+        return probe;
+    }
+    if (readLittle<uint32_t>(header) != PESignature) {
+        probe.mFormat = DOS;
+        probe.mHeaderOffset = 0;
+        return probe;
+    }
+
+    const char *optionalHeader = header + OptionalHeaderOffset;
+    size_t numberOfRvaAndSizesOffset;
+    switch (readLittle<uint16_t>(optionalHeader)) {
+    case OptionalHeader::Win32:
+        numberOfRvaAndSizesOffset = NumberOfRvaAndSizesOffset32;
+        break;
+    case OptionalHeader::Win64:
+        numberOfRvaAndSizesOffset = NumberOfRvaAndSizesOffset64;
+        break;
+    default:
+        probe.mFormat = DOS;
+        probe.mHeaderOffset = 0;
+        return probe;
+    }
+    if (available < OptionalHeaderOffset + numberOfRvaAndSizesOffset + sizeof(uint32_t)) {
+        return probe;
+    }
+
+    // The CLR header is only present if the data directory is long enough
+    size_t clrOffset = OptionalHeaderOffset + numberOfRvaAndSizesOffset + sizeof(uint32_t) +
+        OptionalHeader::CLRHeader * DataDirectoryItemSize;
+    if (readLittle<uint32_t>(optionalHeader + numberOfRvaAndSizesOffset) > OptionalHeader::CLRHeader) {
+        if (available < clrOffset + DataDirectoryItemSize) {
+            return probe;
+        }
+        probe.mDotNet = readLittle<uint32_t>(header + clrOffset) &&
+            readLittle<uint32_t>(header + clrOffset + sizeof(uint32_t));
+    }
+
+    probe.mFormat = numberOfRvaAndSizesOffset == NumberOfRvaAndSizesOffset32 ? PE32 : PE32Plus;
+    probe.mMachine = readLittle<uint16_t>(header + MachineOffset);
+    probe.mSubsystem = readLittle<uint16_t>(optionalHeader + SubsystemOffset);
+
+    return probe;
+}
+
+Probe Probe::probe(std::istream &istream)
+{
+    char buffer[ProbeSize];
+    istream.read(buffer, ProbeSize);
+    return probe(buffer, static_cast<size_t>(istream.gcount()));
+}
+
+Probe::Format Probe::format() const
+{
+    return mFormat;
+}
+
+bool Probe::isPE() const
+{
+    return mFormat == PE32 || mFormat == PE32Plus;
+}
+
+bool Probe::isDotNet() const
+{
+    return mDotNet;
+}
+
+uint32_t Probe::headerOffset() const
+{
+    return mHeaderOffset;
+}
+
+uint16_t Probe::machine() const
+{
+    return mMachine;
+}
+
+uint16_t Probe::subsystem() const
+{
+    return mSubsystem;
+}
@@ -0,0 +1,253 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include <win32pe/file.h>
+#include <win32pe/ranges.h>
+
+#include "endian_p.h"
+#include "file_p.h"
+#include "imageclass_p.h"
+#include "importtable_p.h"
+#include "sectiontable_p.h"
+
+using namespace win32pe;
+
+SectionIterator::SectionIterator()
+    : mTable(nullptr),
+      mIndex(0)
+{
+}
+
+SectionIterator::SectionIterator(const SectionTable *table, size_t index)
+    : mTable(table),
+      mIndex(index)
+{
+}
+
+SectionRef SectionIterator::operator*() const
+{
+    return SectionRef(mTable, &mTable->mEntries[mIndex]);
+}
+
+SectionIterator &SectionIterator::operator++()
+{
+    ++mIndex;
+    return *this;
+}
+
+SectionIterator SectionIterator::operator++(int)
+{
+    SectionIterator previous(*this);
+    ++mIndex;
+    return previous;
+}
+
+bool SectionIterator::operator==(const SectionIterator &other) const
+{
+    return mTable == other.mTable && mIndex == other.mIndex;
+}
+
+bool SectionIterator::operator!=(const SectionIterator &other) const
+{
+    return !(*this == other);
+}
+
+ImportDescriptorIterator::ImportDescriptorIterator()
+    : mData(nullptr),
+      mSize(0),
+      mOffset(0),
+      mItem()
+{
+}
+
+ImportDescriptorIterator::ImportDescriptorIterator(const char *data, size_t size)
+    : mData(data),
+      mSize(size),
+      mOffset(0),
+      mItem()
+{
+    decode();
+}
+
+void ImportDescriptorIterator::decode()
+{
+    // The end iterator is represented by a null pointer
+    const RawImportDescriptor *raw = rawView<RawImportDescriptor>(mData, mSize, mOffset);
+    if (!raw || !decodeImportDescriptor(*raw, mItem)) {
+        mData = nullptr;
+        mSize = 0;
+        mOffset = 0;
+    }
+}
+
+const ImportTable::Item &ImportDescriptorIterator::operator*() const
+{
+    return mItem;
+}
+
+const ImportTable::Item *ImportDescriptorIterator::operator->() const
+{
+    return &mItem;
+}
+
+ImportDescriptorIterator &ImportDescriptorIterator::operator++()
+{
+    mOffset += sizeof(RawImportDescriptor);
+    decode();
+    return *this;
+}
+
+ImportDescriptorIterator ImportDescriptorIterator::operator++(int)
+{
+    ImportDescriptorIterator previous(*this);
+    ++(*this);
+    return previous;
+}
+
+bool ImportDescriptorIterator::operator==(const ImportDescriptorIterator &other) const
+{
+    return mData == other.mData && mOffset == other.mOffset;
+}
+
+bool ImportDescriptorIterator::operator!=(const ImportDescriptorIterator &other) const
+{
+    return !(*this == other);
+}
+
+ImportFunctionIterator::ImportFunctionIterator()
+    : mFile(nullptr),
+      mImage(nullptr),
+      mFunctions(nullptr),
+      mData(nullptr),
+      mSize(0),
+      mOffset(0),
+      mFunction()
+{
+}
+
+ImportFunctionIterator::ImportFunctionIterator(const File *file, const ImageClass *image, const char *data, size_t size)
+    : mFile(file),
+      mImage(image),
+      mFunctions(nullptr),
+      mData(data),
+      mSize(size),
+      mOffset(0),
+      mFunction()
+{
+    decode();
+}
+
+ImportFunctionIterator::ImportFunctionIterator(const ImportTable::Function *functions, size_t count)
+    : mFile(nullptr),
+      mImage(nullptr),
+      mFunctions(functions),
+      mData(reinterpret_cast<const char*>(functions)),
+      mSize(count),
+      mOffset(0),
+      mFunction()
+{
+    decode();
+}
+
+void ImportFunctionIterator::decode()
+{
+    static const char Zeroes[sizeof(uint64_t)] = {};
+
+    // Functions restored from the metadata cache are walked by index
+    if (mFunctions) {
+        if (mOffset >= mSize) {
+            mFunctions = nullptr;
+            mData = nullptr;
+            mSize = 0;
+            mOffset = 0;
+            return;
+        }
+        const ImportTable::Function &function = mFunctions[mOffset];
+        mFunction.byOrdinal = function.byOrdinal;
+        mFunction.ordinal = function.ordinal;
+        mFunction.hint = function.hint;
+        mFunction.name = function.name;
+        return;
+    }
+
+    if (!mData || mSize - mOffset < mImage->pointerSize ||
+            !memcmp(mData + mOffset, Zeroes, mImage->pointerSize)) {
+        mData = nullptr;
+        mSize = 0;
+        mOffset = 0;
+        return;
+    }
+
+    Thunk thunk = mImage->readThunk(mData + mOffset);
+    mFunction.byOrdinal = thunk.byOrdinal != 0;
+    mFunction.ordinal = mFunction.byOrdinal ? static_cast<uint16_t>(thunk.value) : 0;
+    mFunction.hint = 0;
+    mFunction.name = boost::string_ref();
+    if (!mFunction.byOrdinal) {
+        // The hint/name entry is a 16-bit hint followed by the name
+        boost::string_ref entry = mFile->d->rvaData(thunk.value);
+        if (entry.size() >= sizeof(uint16_t)) {
+            mFunction.hint = readLittle<uint16_t>(entry.data());
+            entry.remove_prefix(sizeof(uint16_t));
+            size_t end = entry.find('\0');
+            mFunction.name = end == boost::string_ref::npos ? entry : entry.substr(0, end);
+        }
+    }
+}
+
+const ImportTable::FunctionRef &ImportFunctionIterator::operator*() const
+{
+    return mFunction;
+}
+
+const ImportTable::FunctionRef *ImportFunctionIterator::operator->() const
+{
+    return &mFunction;
+}
+
+ImportFunctionIterator &ImportFunctionIterator::operator++()
+{
+    mOffset += mFunctions ? 1 : mImage->pointerSize;
+    decode();
+    return *this;
+}
+
+ImportFunctionIterator ImportFunctionIterator::operator++(int)
+{
+    ImportFunctionIterator previous(*this);
+    ++(*this);
+    return previous;
+}
+
+bool ImportFunctionIterator::operator==(const ImportFunctionIterator &other) const
+{
+    return mData == other.mData && mOffset == other.mOffset;
+}
+
+bool ImportFunctionIterator::operator!=(const ImportFunctionIterator &other) const
+{
+    return !(*this == other);
+}
@@ -24,8 +24,6 @@
 
 #include <cstring>
 
-#include <boost/endian/conversion.hpp>
-
 #include <win32pe/section.h>
 
 #include "section_p.h"
@@ -46,46 +44,6 @@ SectionPrivate::SectionPrivate()
 {
 }
 
-bool SectionPrivate::read(std::istream &istream)
-{
-    if (!istream.read(
-            mName,
-            reinterpret_cast<char*>(&mData) - mName
-        )) {
-        return false;
-    }
-
-    boost::endian::little_to_native_inplace(mPhysicalAddressVirtualSize);
-    boost::endian::little_to_native_inplace(mVirtualAddress);
-    boost::endian::little_to_native_inplace(mSizeOfRawData);
-    boost::endian::little_to_native_inplace(mPointerToRawData);
-    boost::endian::little_to_native_inplace(mPointerToRelocations);
-    boost::endian::little_to_native_inplace(mPointerToLinenumbers);
-    boost::endian::little_to_native_inplace(mNumberOfRelocations);
-    boost::endian::little_to_native_inplace(mNumberOfLinenumbers);
-    boost::endian::little_to_native_inplace(mCharacteristics);
-
-    // Quit early if the data is uninitialized
-    if (!mSizeOfRawData) {
-        return true;
-    }
-
-    // Go to the location in the file containing the section's data
-    auto pos = istream.tellg();
-    if (!istream.seekg(mPointerToRawData)) {
-        return false;
-    }
-
-    // Read the data for the section
-    mData.resize(mSizeOfRawData);
-    if (!istream.read(&mData[0], mSizeOfRawData)) {
-        return false;
-    }
-
-    // Seek back to the original location in the file
-    return static_cast<bool>(istream.seekg(pos));
-}
-
 Section::Section()
     : d(new SectionPrivate)
 {
@@ -118,6 +76,31 @@ std::string Section::name() const
     );
 }
 
+uint32_t Section::virtualSize() const
+{
+    return d->mPhysicalAddressVirtualSize;
+}
+
+uint32_t Section::virtualAddress() const
+{
+    return d->mVirtualAddress;
+}
+
+uint32_t Section::sizeOfRawData() const
+{
+    return d->mSizeOfRawData;
+}
+
+uint32_t Section::pointerToRawData() const
+{
+    return d->mPointerToRawData;
+}
+
+uint32_t Section::characteristics() const
+{
+    return d->mCharacteristics;
+}
+
 const std::string &Section::data() const
 {
     return d->mData;
@@ -26,7 +26,6 @@
 #define WIN32PE_SECTION_P_H
 
 #include <cstdint>
-#include <istream>
 #include <string>
 
 #define SECTION_NAME_SIZE 8
@@ -40,7 +39,8 @@ public:
 
     SectionPrivate();
 
-    bool read(std::istream &istream);
+    // Sections are stored in the file's section table - these are copies
+    // made on request for the Section API
 
     char mName[SECTION_NAME_SIZE];
 
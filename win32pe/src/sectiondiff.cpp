@@ -0,0 +1,364 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include <win32pe/file.h>
+#include <win32pe/sectiondiff.h>
+#include <win32pe/sectionref.h>
+
+#include "digest_p.h"
+#include "parallel_p.h"
+#include "sectiondiff_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+const uint32_t DefaultAverageChunkSize = 4096;
+const uint32_t MinimumAverageChunkSize = 64;
+
+// Random values for each byte used by the rolling (gear) hash - shifting the
+// hash left each byte means that its top bits depend on the last 64 bytes
+
+struct GearTable
+{
+    GearTable()
+    {
+        // splitmix64, so that the table (and therefore every chunk boundary)
+        // is the same in every build
+        uint64_t state = 0;
+        for (int i = 0; i < 256; ++i) {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            values[i] = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t values[256];
+};
+
+const GearTable &gearTable()
+{
+    static const GearTable table;
+    return table;
+}
+
+// Number of bytes of a section that are mapped from its raw data
+boost::string_ref mappedData(const SectionRef &section)
+{
+    boost::string_ref data = section.data();
+    return section.virtualSize() ? data.substr(0, section.virtualSize()) : data;
+}
+
+// Append a change, extending the previous one if it is of the same kind and
+// directly follows it
+void append(std::vector<SectionDiff::Change> &changes, const SectionDiff::Change &change)
+{
+    if (!changes.empty()) {
+        SectionDiff::Change &last = changes.back();
+        bool oldFollows = last.oldRva + last.size == change.oldRva;
+        bool newFollows = last.newRva + last.size == change.newRva;
+        if (last.kind == change.kind && last.section == change.section &&
+                ((change.kind == SectionDiff::Moved && oldFollows && newFollows) ||
+                 (change.kind == SectionDiff::Inserted && newFollows) ||
+                 (change.kind == SectionDiff::Deleted && oldFollows))) {
+            last.size += change.size;
+            return;
+        }
+    }
+    changes.push_back(change);
+}
+
+SectionDiff::Change makeChange(SectionDiff::Kind kind, boost::string_ref section,
+                               uint32_t oldRva, uint32_t newRva, uint32_t size)
+{
+    SectionDiff::Change change;
+    change.kind = kind;
+    change.section = section.to_string();
+    change.oldRva = oldRva;
+    change.newRva = newRva;
+    change.size = size;
+    return change;
+}
+
+}
+
+SectionDiffPrivate::SectionDiffPrivate()
+    : mAverageChunkSize(DefaultAverageChunkSize),
+      mThreadCount(0)
+{
+}
+
+void SectionDiffPrivate::split(const SectionRef &section, std::vector<SectionDiff::Chunk> &chunks) const
+{
+    const uint64_t *gear = gearTable().values;
+    boost::string_ref data = mappedData(section);
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>(data.data());
+
+    // A boundary follows any byte where the top bits of the hash are zero,
+    // which happens once every mAverageChunkSize bytes on average; the first
+    // quarter of each chunk is skipped as it can never contain a boundary
+    int bits = 0;
+    while ((1u << bits) < mAverageChunkSize) {
+        ++bits;
+    }
+    size_t minimum = mAverageChunkSize / 4;
+    size_t maximum = static_cast<size_t>(mAverageChunkSize) * 4;
+
+    chunks.clear();
+    chunks.reserve(data.size() / mAverageChunkSize + 1);
+    for (size_t start = 0; start < data.size(); ) {
+        size_t end = std::min(data.size(), start + maximum);
+        size_t pos = std::min(end, start + minimum);
+        uint64_t hash = 0;
+        for (; pos < end; ++pos) {
+            hash = (hash << 1) + gear[bytes[pos]];
+            if (!(hash >> (64 - bits))) {
+                ++pos;
+                break;
+            }
+        }
+
+        XxHash64 xxHash64;
+        xxHash64.update(data.data() + start, pos - start);
+
+        SectionDiff::Chunk chunk;
+        chunk.rva = section.virtualAddress() + static_cast<uint32_t>(start);
+        chunk.size = static_cast<uint32_t>(pos - start);
+        chunk.hash = xxHash64.value();
+        chunks.push_back(chunk);
+
+        start = pos;
+    }
+}
+
+void SectionDiffPrivate::diffPair(const SectionRef &oldSection, const SectionRef &newSection,
+                                  std::vector<SectionDiff::Change> &changes) const
+{
+    std::vector<SectionDiff::Chunk> oldChunks, newChunks;
+    split(oldSection, oldChunks);
+    split(newSection, newChunks);
+
+    // Old chunks with the same hash are listed in order of offset, with a
+    // cursor past those already matched, so that runs of identical chunks
+    // (such as padding) cost a constant number of comparisons each
+    struct Candidates
+    {
+        std::vector<size_t> chunks;
+        size_t next;
+    };
+    std::unordered_map<uint64_t, Candidates> index(oldChunks.size());
+    for (size_t i = 0; i < oldChunks.size(); ++i) {
+        index[oldChunks[i].hash].chunks.push_back(i);
+    }
+
+    boost::string_ref oldData = oldSection.data();
+    boost::string_ref newData = newSection.data();
+    uint32_t oldBase = oldSection.virtualAddress();
+    uint32_t newBase = newSection.virtualAddress();
+    std::vector<bool> used(oldChunks.size());
+
+    auto equal = [&](size_t i, const SectionDiff::Chunk &chunk, uint32_t newOffset) {
+        const SectionDiff::Chunk &oldChunk = oldChunks[i];
+        return oldChunk.hash == chunk.hash && oldChunk.size == chunk.size &&
+            !memcmp(oldData.data() + (oldChunk.rva - oldBase), newData.data() + newOffset, chunk.size);
+    };
+
+    for (auto it = newChunks.begin(); it != newChunks.end(); ++it) {
+        const SectionDiff::Chunk &chunk = *it;
+        uint32_t newOffset = chunk.rva - newBase;
+
+        // Of the chunks with the same content, prefer the one at the same
+        // offset (which is unchanged), then the first that has not been
+        // matched yet and finally the first of all
+        size_t match = oldChunks.size();
+        auto same = std::lower_bound(oldChunks.begin(), oldChunks.end(), newOffset,
+                                     [oldBase](const SectionDiff::Chunk &oldChunk, uint32_t offset) {
+            return oldChunk.rva - oldBase < offset;
+        });
+        if (same != oldChunks.end() && same->rva - oldBase == newOffset &&
+                equal(same - oldChunks.begin(), chunk, newOffset)) {
+            match = same - oldChunks.begin();
+        } else {
+            auto found = index.find(chunk.hash);
+            if (found != index.end()) {
+                Candidates &candidates = found->second;
+                while (candidates.next < candidates.chunks.size() && used[candidates.chunks[candidates.next]]) {
+                    ++candidates.next;
+                }
+                if (candidates.next < candidates.chunks.size() &&
+                        equal(candidates.chunks[candidates.next], chunk, newOffset)) {
+                    match = candidates.chunks[candidates.next];
+                } else if (equal(candidates.chunks.front(), chunk, newOffset)) {
+                    match = candidates.chunks.front();
+                }
+            }
+        }
+
+        if (match == oldChunks.size()) {
+            append(changes, makeChange(SectionDiff::Inserted, newSection.name(), 0, chunk.rva, chunk.size));
+            continue;
+        }
+        used[match] = true;
+        if (oldChunks[match].rva - oldBase != newOffset) {
+            append(changes, makeChange(SectionDiff::Moved, newSection.name(), oldChunks[match].rva, chunk.rva, chunk.size));
+        }
+    }
+
+    for (size_t i = 0; i < oldChunks.size(); ++i) {
+        if (!used[i]) {
+            append(changes, makeChange(SectionDiff::Deleted, oldSection.name(), oldChunks[i].rva, 0, oldChunks[i].size));
+        }
+    }
+}
+
+SectionDiff::SectionDiff()
+    : d(new SectionDiffPrivate)
+{
+}
+
+SectionDiff::SectionDiff(const SectionDiff &other)
+    : d(new SectionDiffPrivate(*other.d))
+{
+}
+
+SectionDiff::~SectionDiff()
+{
+    delete d;
+}
+
+SectionDiff &SectionDiff::operator=(const SectionDiff &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+void SectionDiff::setAverageChunkSize(uint32_t size)
+{
+    uint32_t power = MinimumAverageChunkSize;
+    while (power <= size / 2 && power < (1u << 30)) {
+        power *= 2;
+    }
+    d->mAverageChunkSize = power;
+}
+
+uint32_t SectionDiff::averageChunkSize() const
+{
+    return d->mAverageChunkSize;
+}
+
+void SectionDiff::setThreadCount(size_t threads)
+{
+    d->mThreadCount = threads;
+}
+
+size_t SectionDiff::threadCount() const
+{
+    return d->mThreadCount;
+}
+
+std::vector<SectionDiff::Chunk> SectionDiff::chunks(const SectionRef &section) const
+{
+    std::vector<Chunk> chunks;
+    if (!section.isNull()) {
+        d->split(section, chunks);
+    }
+    return chunks;
+}
+
+bool SectionDiff::diff(const File &oldFile, const File &newFile)
+{
+    d->mChanges.clear();
+    d->mErrorString.clear();
+
+    if (!oldFile.sectionCount() && !newFile.sectionCount()) {
+        d->mErrorString = "neither file has any sections";
+        return false;
+    }
+
+    // Pair each section of the new file with the first unpaired section of
+    // the old file with the same name and characteristics
+    std::vector<bool> paired(oldFile.sectionCount());
+    std::vector<size_t> partners(newFile.sectionCount(), oldFile.sectionCount());
+    for (size_t i = 0; i < newFile.sectionCount(); ++i) {
+        SectionRef section = newFile.section(i);
+        for (size_t j = 0; j < oldFile.sectionCount(); ++j) {
+            SectionRef candidate = oldFile.section(j);
+            if (!paired[j] && candidate.name() == section.name() &&
+                    candidate.characteristics() == section.characteristics()) {
+                paired[j] = true;
+                partners[i] = j;
+                break;
+            }
+        }
+    }
+
+    // Diff each pair in parallel; sections without a partner are inserted
+    // or deleted in their entirety
+    std::vector<size_t> unpaired;
+    for (size_t j = 0; j < oldFile.sectionCount(); ++j) {
+        if (!paired[j]) {
+            unpaired.push_back(j);
+        }
+    }
+    std::vector<std::vector<Change>> results(newFile.sectionCount() + unpaired.size());
+    parallelFor(results.size(), d->mThreadCount, [&](size_t i) {
+        if (i >= newFile.sectionCount()) {
+            SectionRef section = oldFile.section(unpaired[i - newFile.sectionCount()]);
+            uint32_t size = static_cast<uint32_t>(mappedData(section).size());
+            if (size) {
+                results[i].push_back(makeChange(Deleted, section.name(), section.virtualAddress(), 0, size));
+            }
+        } else if (partners[i] == oldFile.sectionCount()) {
+            SectionRef section = newFile.section(i);
+            uint32_t size = static_cast<uint32_t>(mappedData(section).size());
+            if (size) {
+                results[i].push_back(makeChange(Inserted, section.name(), 0, section.virtualAddress(), size));
+            }
+        } else {
+            d->diffPair(oldFile.section(partners[i]), newFile.section(i), results[i]);
+        }
+    });
+
+    for (auto it = results.begin(); it != results.end(); ++it) {
+        d->mChanges.insert(d->mChanges.end(), (*it).begin(), (*it).end());
+    }
+
+    return true;
+}
+
+const std::vector<SectionDiff::Change> &SectionDiff::changes() const
+{
+    return d->mChanges;
+}
+
+std::string SectionDiff::errorString() const
+{
+    return d->mErrorString;
+}
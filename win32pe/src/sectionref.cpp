@@ -0,0 +1,95 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include <win32pe/sectionref.h>
+
+#include "sectiontable_p.h"
+
+using namespace win32pe;
+
+SectionRef::SectionRef()
+    : mTable(nullptr),
+      mEntry(nullptr)
+{
+}
+
+SectionRef::SectionRef(const SectionTable *table, const SectionEntry *entry)
+    : mTable(table),
+      mEntry(entry)
+{
+}
+
+bool SectionRef::isNull() const
+{
+    return !mEntry;
+}
+
+boost::string_ref SectionRef::name() const
+{
+    const char *end = static_cast<const char*>(memchr(mEntry->name, '\0', SECTION_NAME_SIZE));
+    return boost::string_ref(mEntry->name, end ? end - mEntry->name : SECTION_NAME_SIZE);
+}
+
+uint32_t SectionRef::virtualSize() const
+{
+    return mEntry->virtualSize;
+}
+
+uint32_t SectionRef::virtualAddress() const
+{
+    return mEntry->virtualAddress;
+}
+
+uint32_t SectionRef::sizeOfRawData() const
+{
+    return mEntry->sizeOfRawData;
+}
+
+uint32_t SectionRef::pointerToRawData() const
+{
+    return mEntry->pointerToRawData;
+}
+
+uint32_t SectionRef::characteristics() const
+{
+    return mEntry->characteristics;
+}
+
+boost::string_ref SectionRef::data() const
+{
+    return mTable->data(mEntry - mTable->mEntries.data());
+}
+
+bool SectionRef::containsRVA(uint32_t rva) const
+{
+    return mEntry->virtualAddress <= rva &&
+        rva < mEntry->virtualAddress + mEntry->virtualSize;
+}
+
+uint32_t SectionRef::rvaToOffset(uint32_t rva) const
+{
+    return rva - mEntry->virtualAddress;
+}
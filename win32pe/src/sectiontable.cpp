@@ -0,0 +1,150 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <utility>
+
+#include "sectiontable_p.h"
+
+using namespace win32pe;
+
+void SectionTable::clear()
+{
+    mEntries.clear();
+    mData.clear();
+    mView = boost::string_ref();
+    mOwned.clear();
+}
+
+void SectionTable::decode(const RawSectionHeader &raw, SectionEntry &entry)
+{
+    memcpy(entry.name, raw.name, SECTION_NAME_SIZE);
+    entry.virtualSize = raw.virtualSize.value();
+    entry.virtualAddress = raw.virtualAddress.value();
+    entry.sizeOfRawData = raw.sizeOfRawData.value();
+    entry.pointerToRawData = raw.pointerToRawData.value();
+    entry.pointerToRelocations = raw.pointerToRelocations.value();
+    entry.pointerToLinenumbers = raw.pointerToLinenumbers.value();
+    entry.numberOfRelocations = raw.numberOfRelocations.value();
+    entry.numberOfLinenumbers = raw.numberOfLinenumbers.value();
+    entry.characteristics = raw.characteristics.value();
+    entry.dataOffset = 0;
+    entry.dataSize = 0;
+    entry.owned = false;
+}
+
+void SectionTable::writeHeader(std::string &buffer, size_t index, uint32_t sizeOfRawData, uint32_t pointerToRawData) const
+{
+    // The location of the data is supplied by the caller since it may change
+    // when the file is written
+
+    const SectionEntry &entry = mEntries[index];
+    RawSectionHeader raw;
+    memcpy(raw.name, entry.name, SECTION_NAME_SIZE);
+    raw.virtualSize = entry.virtualSize;
+    raw.virtualAddress = entry.virtualAddress;
+    raw.sizeOfRawData = sizeOfRawData;
+    raw.pointerToRawData = pointerToRawData;
+    raw.pointerToRelocations = entry.pointerToRelocations;
+    raw.pointerToLinenumbers = entry.pointerToLinenumbers;
+    raw.numberOfRelocations = entry.numberOfRelocations;
+    raw.numberOfLinenumbers = entry.numberOfLinenumbers;
+    raw.characteristics = entry.characteristics;
+
+    buffer.append(reinterpret_cast<const char*>(&raw), sizeof(raw));
+}
+
+boost::string_ref SectionTable::data(size_t index) const
+{
+    const SectionEntry &entry = mEntries[index];
+    if (!entry.dataSize) {
+        return boost::string_ref();
+    }
+    if (entry.owned) {
+        return mOwned[index];
+    }
+    const char *base = mView.empty() ? mData.data() : mView.data();
+    return boost::string_ref(base + entry.dataOffset, entry.dataSize);
+}
+
+const SectionEntry *SectionTable::find(uint32_t rva) const
+{
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+        if ((*it).virtualAddress <= rva && rva - (*it).virtualAddress < (*it).virtualSize) {
+            return &(*it);
+        }
+    }
+    return nullptr;
+}
+
+void SectionTable::append(const SectionEntry &entry, std::string data)
+{
+    mEntries.push_back(entry);
+    mEntries.back().dataSize = 0;
+    mEntries.back().owned = false;
+    setData(mEntries.size() - 1, std::move(data));
+}
+
+void SectionTable::erase(size_t index)
+{
+    mEntries.erase(mEntries.begin() + index);
+    if (index < mOwned.size()) {
+        mOwned.erase(mOwned.begin() + index);
+    }
+    releaseData();
+}
+
+void SectionTable::setData(size_t index, std::string data)
+{
+    // The section takes ownership of its new data; every other section keeps
+    // referring to the backing store
+
+    if (mOwned.size() <= index) {
+        mOwned.resize(index + 1);
+    }
+    mOwned[index].swap(data);
+
+    SectionEntry &entry = mEntries[index];
+    entry.dataOffset = 0;
+    entry.dataSize = static_cast<uint32_t>(mOwned[index].size());
+    entry.owned = true;
+
+    releaseData();
+}
+
+void SectionTable::releaseData()
+{
+    // The buffer read from a stream is freed once no section refers to it;
+    // until then, the data of removed or replaced sections stays in it
+
+    if (mData.empty()) {
+        return;
+    }
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+        if (!(*it).owned && (*it).dataSize) {
+            return;
+        }
+    }
+    std::string().swap(mData);
+}
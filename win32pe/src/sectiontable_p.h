@@ -0,0 +1,108 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_SECTIONTABLE_P_H
+#define WIN32PE_SECTIONTABLE_P_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/utility/string_ref.hpp>
+
+#include "section_p.h"
+#include "structs_p.h"
+
+namespace win32pe
+{
+
+// Section header with the fields converted to native values
+
+struct SectionEntry
+{
+    char name[SECTION_NAME_SIZE];
+    uint32_t virtualSize;
+    uint32_t virtualAddress;
+    uint32_t sizeOfRawData;
+    uint32_t pointerToRawData;
+    uint32_t pointerToRelocations;
+    uint32_t pointerToLinenumbers;
+    uint16_t numberOfRelocations;
+    uint16_t numberOfLinenumbers;
+    uint32_t characteristics;
+
+    // Location of the section's data within the backing store - this is
+    // normally SizeOfRawData bytes but is empty when the data was not loaded
+    uint64_t dataOffset;
+    uint32_t dataSize;
+
+    // Whether the data has been replaced and is held by the table instead
+    bool owned;
+};
+
+/**
+ * @brief Contiguous table of section headers and their data
+ *
+ * The headers are kept in a single array and the data of every section in a
+ * single backing store - either the file itself when it was loaded from
+ * memory or one buffer holding all of the sections - so that loading a file
+ * costs a fixed number of allocations regardless of the number of sections.
+ * Sections whose data is replaced get a buffer of their own, leaving the
+ * others in the backing store.
+ */
+class SectionTable
+{
+public:
+
+    void clear();
+
+    static void decode(const RawSectionHeader &raw, SectionEntry &entry);
+    void writeHeader(std::string &buffer, size_t index, uint32_t sizeOfRawData, uint32_t pointerToRawData) const;
+
+    boost::string_ref data(size_t index) const;
+    const SectionEntry *find(uint32_t rva) const;
+
+    // Only the data of the section being modified is copied
+    void append(const SectionEntry &entry, std::string data);
+    void erase(size_t index);
+    void setData(size_t index, std::string data);
+
+    std::vector<SectionEntry> mEntries;
+
+    std::string mData;
+    boost::string_ref mView;
+
+    // Data of replaced sections by index - this is only as long as the
+    // highest index replaced so far
+    std::vector<std::string> mOwned;
+
+private:
+
+    void releaseData();
+};
+
+}
+
+#endif // WIN32PE_SECTIONTABLE_P_H
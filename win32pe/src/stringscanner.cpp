@@ -0,0 +1,332 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+#include <win32pe/section.h>
+#include <win32pe/sectionref.h>
+#include <win32pe/stringscanner.h>
+
+#include "bits_p.h"
+#include "stringscanner_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+// Data is classified 64 bytes at a time so that each class fits in a single
+// 64-bit mask with one bit per byte
+
+const size_t BlockSize = 64;
+
+// Build masks of the printable (0x20-0x7e and tab) and NUL bytes in a block;
+// bits for bytes past the end of a partial block are left clear
+
+void classify(const unsigned char *data, size_t size, uint64_t &printable, uint64_t &zero)
+{
+    printable = 0;
+    zero = 0;
+
+#ifdef __SSE2__
+    if (size == BlockSize) {
+
+        // Adding 0x60 moves 0x20-0x7e to the bottom of the signed range, so a
+        // single signed comparison checks both bounds
+
+        const __m128i bias = _mm_set1_epi8(0x60);
+        const __m128i limit = _mm_set1_epi8(-33);
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i nul = _mm_setzero_si128();
+
+        for (int i = 0; i < 4; ++i) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16));
+            __m128i p = _mm_or_si128(
+                _mm_cmplt_epi8(_mm_add_epi8(v, bias), limit),
+                _mm_cmpeq_epi8(v, tab)
+            );
+            __m128i z = _mm_cmpeq_epi8(v, nul);
+            printable |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(p))) << (i * 16);
+            zero |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(z))) << (i * 16);
+        }
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char c = data[i];
+        if ((c >= 0x20 && c <= 0x7e) || c == '\t') {
+            printable |= static_cast<uint64_t>(1) << i;
+        } else if (!c) {
+            zero |= static_cast<uint64_t>(1) << i;
+        }
+    }
+}
+
+// Tracks a run of set bits across consecutive blocks and reports each run
+// once it ends as a [start, end) pair of byte positions
+
+class RunTracker
+{
+public:
+
+    RunTracker() : mActive(false), mStart(0) {}
+
+    template<typename Emit>
+    bool feed(uint64_t mask, size_t bits, uint64_t base, Emit emit)
+    {
+        size_t pos = 0;
+        while (pos < bits) {
+            if (mActive) {
+                uint64_t gaps = ~mask >> pos;
+                if (!gaps) {
+                    return true;
+                }
+                pos += countTrailingZeros(gaps);
+                mActive = false;
+                if (!emit(mStart, base + pos)) {
+                    return false;
+                }
+            } else {
+                uint64_t set = mask >> pos;
+                if (!set) {
+                    return true;
+                }
+                pos += countTrailingZeros(set);
+                mActive = true;
+                mStart = base + pos;
+            }
+        }
+        return true;
+    }
+
+    template<typename Emit>
+    bool flush(uint64_t end, Emit emit)
+    {
+        if (mActive) {
+            mActive = false;
+            return emit(mStart, end);
+        }
+        return true;
+    }
+
+private:
+
+    bool mActive;
+    uint64_t mStart;
+};
+
+}
+
+StringScannerPrivate::StringScannerPrivate()
+    : mMinimumLength(4),
+      mEncodings(StringScanner::ASCII | StringScanner::UTF16LE)
+{
+}
+
+bool StringScannerPrivate::scan(const char *data, size_t size, uint64_t offset, uint32_t rva,
+                                const StringScanner::Callback &callback) const
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>(data);
+    const size_t minimumLength = mMinimumLength ? mMinimumLength : 1;
+
+    auto emitASCII = [&](uint64_t start, uint64_t end) {
+        if (end - start < minimumLength) {
+            return true;
+        }
+        StringScanner::Item item = {
+            StringScanner::ASCII,
+            offset + start,
+            rva ? static_cast<uint32_t>(rva + start) : 0,
+            boost::string_ref(data + start, end - start)
+        };
+        return callback(item);
+    };
+
+    auto emitUTF16 = [&](uint64_t start, uint64_t end) {
+        if ((end - start) / 2 < minimumLength) {
+            return true;
+        }
+        StringScanner::Item item = {
+            StringScanner::UTF16LE,
+            offset + start,
+            rva ? static_cast<uint32_t>(rva + start) : 0,
+            boost::string_ref(data + start, end - start)
+        };
+        return callback(item);
+    };
+
+    // A UTF-16LE character is a printable byte followed by a NUL byte; runs
+    // starting at even and odd offsets are tracked separately and each
+    // character sets the bits for both of its bytes so that consecutive
+    // characters form a contiguous run
+
+    const uint64_t evenBits = 0x5555555555555555ULL;
+    const uint64_t oddBits = 0xaaaaaaaaaaaaaaaaULL;
+
+    RunTracker ascii, utf16Even, utf16Odd;
+    uint64_t oddCarry = 0;
+
+    uint64_t printable, zero;
+    classify(bytes, size < BlockSize ? size : BlockSize, printable, zero);
+
+    for (size_t base = 0; base < size; base += BlockSize) {
+        size_t bits = size - base < BlockSize ? size - base : BlockSize;
+
+        // Classify the next block ahead of time - the NUL byte following the
+        // last character of this block may be the first byte of the next
+
+        uint64_t nextPrintable = 0, nextZero = 0;
+        if (base + BlockSize < size) {
+            size_t nextSize = size - base - BlockSize;
+            classify(bytes + base + BlockSize, nextSize < BlockSize ? nextSize : BlockSize,
+                     nextPrintable, nextZero);
+        }
+
+        if (mEncodings & StringScanner::ASCII) {
+            if (!ascii.feed(printable, bits, base, emitASCII)) {
+                return false;
+            }
+        }
+
+        if (mEncodings & StringScanner::UTF16LE) {
+            uint64_t units = printable & ((zero >> 1) | (nextZero << 63));
+            uint64_t even = units & evenBits;
+            uint64_t odd = units & oddBits;
+            if (!utf16Even.feed(even | (even << 1), bits, base, emitUTF16) ||
+                    !utf16Odd.feed(odd | (odd << 1) | oddCarry, bits, base, emitUTF16)) {
+                return false;
+            }
+            oddCarry = odd >> 63;
+        }
+
+        printable = nextPrintable;
+        zero = nextZero;
+    }
+
+    return ascii.flush(size, emitASCII) &&
+           utf16Even.flush(size, emitUTF16) &&
+           utf16Odd.flush(size, emitUTF16);
+}
+
+StringScanner::StringScanner()
+    : d(new StringScannerPrivate)
+{
+}
+
+StringScanner::StringScanner(const StringScanner &other)
+    : d(new StringScannerPrivate(*other.d))
+{
+}
+
+StringScanner::~StringScanner()
+{
+    delete d;
+}
+
+StringScanner &StringScanner::operator=(const StringScanner &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+void StringScanner::setMinimumLength(size_t length)
+{
+    d->mMinimumLength = length;
+}
+
+size_t StringScanner::minimumLength() const
+{
+    return d->mMinimumLength;
+}
+
+void StringScanner::setEncodings(int encodings)
+{
+    d->mEncodings = encodings;
+}
+
+int StringScanner::encodings() const
+{
+    return d->mEncodings;
+}
+
+bool StringScanner::scan(const char *data, size_t size, uint64_t offset, const Callback &callback) const
+{
+    return d->scan(data, size, offset, 0, callback);
+}
+
+bool StringScanner::scan(const Section &section, const Callback &callback) const
+{
+    return d->scan(
+        section.data().data(),
+        section.data().size(),
+        section.pointerToRawData(),
+        section.virtualAddress(),
+        callback
+    );
+}
+
+bool StringScanner::scan(const SectionRef &section, const Callback &callback) const
+{
+    boost::string_ref data = section.data();
+    return d->scan(
+        data.data(),
+        data.size(),
+        section.pointerToRawData(),
+        section.virtualAddress(),
+        callback
+    );
+}
+
+std::vector<StringScanner::Item> StringScanner::scan(const char *data, size_t size) const
+{
+    std::vector<Item> items;
+    scan(data, size, 0, [&items](const Item &item) {
+        items.push_back(item);
+        return true;
+    });
+    return items;
+}
+
+std::vector<StringScanner::Item> StringScanner::scan(const Section &section) const
+{
+    std::vector<Item> items;
+    scan(section, [&items](const Item &item) {
+        items.push_back(item);
+        return true;
+    });
+    return items;
+}
+
+std::vector<StringScanner::Item> StringScanner::scan(const SectionRef &section) const
+{
+    std::vector<Item> items;
+    scan(section, [&items](const Item &item) {
+        items.push_back(item);
+        return true;
+    });
+    return items;
+}
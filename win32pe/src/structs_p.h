@@ -0,0 +1,214 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_STRUCTS_P_H
+#define WIN32PE_STRUCTS_P_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <boost/endian/buffers.hpp>
+
+namespace win32pe
+{
+
+// On-disk layouts of the PE structures
+//
+// Every field is an unaligned little-endian buffer, so the structures have
+// no padding and can be laid directly over file data; value() compiles to a
+// plain load on little-endian hosts and a load plus byte swap elsewhere.
+// Field names follow the PE specification.
+
+typedef boost::endian::little_uint8_buf_t  le8;
+typedef boost::endian::little_uint16_buf_t le16;
+typedef boost::endian::little_uint32_buf_t le32;
+typedef boost::endian::little_uint64_buf_t le64;
+
+struct RawDataDirectory
+{
+    le32 virtualAddress;
+    le32 size;
+};
+
+struct RawFileHeader
+{
+    le16 machine;
+    le16 numberOfSections;
+    le32 timeDateStamp;
+    le32 pointerToSymbolTable;
+    le32 numberOfSymbols;
+    le16 sizeOfOptionalHeader;
+    le16 characteristics;
+};
+
+// The PE32 and PE32+ optional headers differ only in the size of ImageBase
+// and the four stack and heap fields, and PE32+ lacks BaseOfData
+
+template<typename Word, bool HasBaseOfData>
+struct RawOptionalHeaderBase;
+
+template<typename Word>
+struct RawOptionalHeaderBase<Word, true>
+{
+    le32 baseOfData;
+    Word imageBase;
+};
+
+template<typename Word>
+struct RawOptionalHeaderBase<Word, false>
+{
+    Word imageBase;
+};
+
+template<typename Word, bool HasBaseOfData>
+struct RawOptionalHeader
+{
+    le16 magic;
+    le8  majorLinkerVersion;
+    le8  minorLinkerVersion;
+    le32 sizeOfCode;
+    le32 sizeOfInitializedData;
+    le32 sizeOfUninitializedData;
+    le32 addressOfEntryPoint;
+    le32 baseOfCode;
+    RawOptionalHeaderBase<Word, HasBaseOfData> base;
+    le32 sectionAlignment;
+    le32 fileAlignment;
+    le16 majorOperatingSystemVersion;
+    le16 minorOperatingSystemVersion;
+    le16 majorImageVersion;
+    le16 minorImageVersion;
+    le16 majorSubsystemVersion;
+    le16 minorSubsystemVersion;
+    le32 win32VersionValue;
+    le32 sizeOfImage;
+    le32 sizeOfHeaders;
+    le32 checkSum;
+    le16 subsystem;
+    le16 dllCharacteristics;
+    Word sizeOfStackReserve;
+    Word sizeOfStackCommit;
+    Word sizeOfHeapReserve;
+    Word sizeOfHeapCommit;
+    le32 loaderFlags;
+    le32 numberOfRvaAndSizes;
+};
+
+typedef RawOptionalHeader<le32, true> RawOptionalHeader32;
+typedef RawOptionalHeader<le64, false> RawOptionalHeader64;
+
+struct RawSectionHeader
+{
+    char name[8];
+    le32 virtualSize;
+    le32 virtualAddress;
+    le32 sizeOfRawData;
+    le32 pointerToRawData;
+    le32 pointerToRelocations;
+    le32 pointerToLinenumbers;
+    le16 numberOfRelocations;
+    le16 numberOfLinenumbers;
+    le32 characteristics;
+};
+
+struct RawImportDescriptor
+{
+    le32 originalFirstThunk;
+    le32 timeDateStamp;
+    le32 forwarderChain;
+    le32 name;
+    le32 firstThunk;
+};
+
+struct RawExportDirectory
+{
+    le32 characteristics;
+    le32 timeDateStamp;
+    le16 majorVersion;
+    le16 minorVersion;
+    le32 name;
+    le32 base;
+    le32 numberOfFunctions;
+    le32 numberOfNames;
+    le32 addressOfFunctions;
+    le32 addressOfNames;
+    le32 addressOfNameOrdinals;
+};
+
+struct RawBaseRelocationBlock
+{
+    le32 virtualAddress;
+    le32 sizeOfBlock;
+};
+
+struct RawDebugDirectory
+{
+    le32 characteristics;
+    le32 timeDateStamp;
+    le16 majorVersion;
+    le16 minorVersion;
+    le32 type;
+    le32 sizeOfData;
+    le32 addressOfRawData;
+    le32 pointerToRawData;
+};
+
+#define WIN32PE_CHECK_LAYOUT(type, size) \
+    static_assert(sizeof(type) == size, #type " has the wrong size"); \
+    static_assert(std::alignment_of<type>::value == 1, #type " must not require alignment")
+
+WIN32PE_CHECK_LAYOUT(RawDataDirectory, 8);
+WIN32PE_CHECK_LAYOUT(RawFileHeader, 20);
+WIN32PE_CHECK_LAYOUT(RawOptionalHeader32, 96);
+WIN32PE_CHECK_LAYOUT(RawOptionalHeader64, 112);
+WIN32PE_CHECK_LAYOUT(RawSectionHeader, 40);
+WIN32PE_CHECK_LAYOUT(RawImportDescriptor, 20);
+WIN32PE_CHECK_LAYOUT(RawExportDirectory, 40);
+WIN32PE_CHECK_LAYOUT(RawBaseRelocationBlock, 8);
+WIN32PE_CHECK_LAYOUT(RawDebugDirectory, 28);
+
+#undef WIN32PE_CHECK_LAYOUT
+
+// Fields between ImageBase and the stack sizes are shared by both layouts
+static_assert(offsetof(RawOptionalHeader32, sectionAlignment) == offsetof(RawOptionalHeader64, sectionAlignment) &&
+              offsetof(RawOptionalHeader32, dllCharacteristics) == offsetof(RawOptionalHeader64, dllCharacteristics),
+              "optional header layouts diverge before the stack sizes");
+
+/**
+ * @brief View a structure in a buffer after checking that it fits
+ * @return pointer to the structure or nullptr if it would overrun the buffer
+ */
+template<typename T>
+const T *rawView(const char *data, size_t size, size_t offset = 0)
+{
+    if (offset > size || size - offset < sizeof(T)) {
+        return nullptr;
+    }
+    return reinterpret_cast<const T*>(data + offset);
+}
+
+}
+
+#endif // WIN32PE_STRUCTS_P_H
@@ -0,0 +1,110 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include <win32pe/file.h>
+#include <win32pe/sectionref.h>
+#include <win32pe/symbolindex.h>
+
+#include "symbolindex_p.h"
+
+using namespace win32pe;
+
+SymbolIndex::SymbolIndex()
+    : d(new SymbolIndexPrivate)
+{
+}
+
+SymbolIndex::SymbolIndex(const SymbolIndex &other)
+    : d(new SymbolIndexPrivate(*other.d))
+{
+}
+
+SymbolIndex::~SymbolIndex()
+{
+    delete d;
+}
+
+SymbolIndex &SymbolIndex::operator=(const SymbolIndex &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+void SymbolIndex::build(const File &file)
+{
+    d->mSymbolTable = file.symbolTable();
+    d->mEntries.clear();
+    d->mEntries.reserve(d->mSymbolTable.size());
+
+    // Symbol values are offsets into the section they belong to (numbered
+    // from one); symbols that are undefined, absolute or describe the file
+    // itself have no address
+
+    for (auto it = d->mSymbolTable.begin(); it != d->mSymbolTable.end(); ++it) {
+        int16_t sectionNumber = it->sectionNumber();
+        if (sectionNumber < 1 || static_cast<size_t>(sectionNumber) > file.sectionCount() ||
+                it->storageClass() == SymbolTable::FileName) {
+            continue;
+        }
+        SymbolIndexPrivate::Entry entry = {
+            file.section(sectionNumber - 1).virtualAddress() + it->value(),
+            it->index()
+        };
+        d->mEntries.push_back(entry);
+    }
+
+    // Where several symbols share an address, external symbols are placed
+    // last so that they are preferred by lookup()
+    std::stable_sort(d->mEntries.begin(), d->mEntries.end(), [this](
+            const SymbolIndexPrivate::Entry &a, const SymbolIndexPrivate::Entry &b) {
+        if (a.rva != b.rva) {
+            return a.rva < b.rva;
+        }
+        return d->mSymbolTable.at(a.index).storageClass() != SymbolTable::External &&
+               d->mSymbolTable.at(b.index).storageClass() == SymbolTable::External;
+    });
+}
+
+size_t SymbolIndex::size() const
+{
+    return d->mEntries.size();
+}
+
+bool SymbolIndex::lookup(uint32_t rva, SymbolTable::Symbol &symbol, uint32_t &displacement) const
+{
+    auto it = std::upper_bound(d->mEntries.begin(), d->mEntries.end(), rva, [](
+            uint32_t rva, const SymbolIndexPrivate::Entry &entry) {
+        return rva < entry.rva;
+    });
+    if (it == d->mEntries.begin()) {
+        return false;
+    }
+
+    --it;
+    symbol = d->mSymbolTable.at(it->index);
+    displacement = rva - it->rva;
+    return true;
+}
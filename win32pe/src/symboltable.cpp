@@ -0,0 +1,256 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <win32pe/symboltable.h>
+
+#include "endian_p.h"
+#include "structs_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+const size_t ShortNameSize = 8;
+const size_t ValueOffset = 8;
+const size_t SectionNumberOffset = 12;
+const size_t TypeOffset = 14;
+const size_t StorageClassOffset = 16;
+const size_t NumberOfAuxSymbolsOffset = 17;
+
+// Import libraries and /bigobj objects begin with a machine of zero and
+// 0xffff in place of the number of sections
+const uint16_t AnonymousSignature = 0xffff;
+
+}
+
+SymbolTable::Symbol::Symbol()
+    : mRecord(nullptr),
+      mIndex(0)
+{
+}
+
+SymbolTable::Symbol::Symbol(const char *record, boost::string_ref strings, uint32_t index)
+    : mRecord(record),
+      mStrings(strings),
+      mIndex(index)
+{
+}
+
+boost::string_ref SymbolTable::Symbol::name() const
+{
+    // If the first four bytes are zero, the last four bytes are an offset into
+    // the string table; otherwise the name is stored inline and is only NUL
+    // terminated if it is shorter than eight characters
+
+    if (readLittle<uint32_t>(mRecord)) {
+        const char *end = static_cast<const char*>(memchr(mRecord, '\0', ShortNameSize));
+        return boost::string_ref(mRecord, end ? end - mRecord : ShortNameSize);
+    }
+
+    uint32_t offset = readLittle<uint32_t>(mRecord + 4);
+    if (offset >= mStrings.size()) {
+        return boost::string_ref();
+    }
+
+    const char *begin = mStrings.data() + offset;
+    const char *end = static_cast<const char*>(memchr(begin, '\0', mStrings.size() - offset));
+    return boost::string_ref(begin, end ? end - begin : mStrings.size() - offset);
+}
+
+uint32_t SymbolTable::Symbol::value() const
+{
+    return readLittle<uint32_t>(mRecord + ValueOffset);
+}
+
+int16_t SymbolTable::Symbol::sectionNumber() const
+{
+    return readLittle<int16_t>(mRecord + SectionNumberOffset);
+}
+
+uint16_t SymbolTable::Symbol::type() const
+{
+    return readLittle<uint16_t>(mRecord + TypeOffset);
+}
+
+uint8_t SymbolTable::Symbol::storageClass() const
+{
+    return static_cast<uint8_t>(mRecord[StorageClassOffset]);
+}
+
+uint8_t SymbolTable::Symbol::numberOfAuxSymbols() const
+{
+    return static_cast<uint8_t>(mRecord[NumberOfAuxSymbolsOffset]);
+}
+
+boost::string_ref SymbolTable::Symbol::auxRecord(uint8_t i) const
+{
+    return boost::string_ref(mRecord + (i + 1) * RecordSize, RecordSize);
+}
+
+uint32_t SymbolTable::Symbol::index() const
+{
+    return mIndex;
+}
+
+SymbolTable::const_iterator::const_iterator()
+    : mIndex(0)
+{
+}
+
+SymbolTable::const_iterator::const_iterator(boost::string_ref symbols, boost::string_ref strings, uint32_t index)
+    : mSymbols(symbols),
+      mStrings(strings),
+      mIndex(index)
+{
+    decode();
+}
+
+SymbolTable::const_iterator::reference SymbolTable::const_iterator::operator*() const
+{
+    return mSymbol;
+}
+
+SymbolTable::const_iterator::pointer SymbolTable::const_iterator::operator->() const
+{
+    return &mSymbol;
+}
+
+SymbolTable::const_iterator &SymbolTable::const_iterator::operator++()
+{
+    mIndex += 1 + mSymbol.numberOfAuxSymbols();
+    decode();
+    return *this;
+}
+
+SymbolTable::const_iterator SymbolTable::const_iterator::operator++(int)
+{
+    const_iterator it(*this);
+    ++*this;
+    return it;
+}
+
+bool SymbolTable::const_iterator::operator==(const const_iterator &other) const
+{
+    return mIndex == other.mIndex;
+}
+
+bool SymbolTable::const_iterator::operator!=(const const_iterator &other) const
+{
+    return mIndex != other.mIndex;
+}
+
+void SymbolTable::const_iterator::decode()
+{
+    uint32_t count = static_cast<uint32_t>(mSymbols.size() / RecordSize);
+
+    // Clamp the index to the end so that a symbol claiming more auxiliary
+    // records than remain in the table compares equal to end()
+    if (mIndex >= count) {
+        mIndex = count;
+        mSymbol = Symbol();
+        return;
+    }
+
+    const char *record = mSymbols.data() + mIndex * RecordSize;
+    if (mIndex + 1 + static_cast<uint8_t>(record[NumberOfAuxSymbolsOffset]) > count) {
+        mIndex = count;
+        mSymbol = Symbol();
+        return;
+    }
+
+    mSymbol = Symbol(record, mStrings, mIndex);
+}
+
+SymbolTable::SymbolTable()
+{
+}
+
+SymbolTable::SymbolTable(boost::string_ref symbols, boost::string_ref strings)
+    : mSymbols(symbols.substr(0, symbols.size() - symbols.size() % RecordSize)),
+      mStrings(strings)
+{
+}
+
+uint32_t SymbolTable::size() const
+{
+    return static_cast<uint32_t>(mSymbols.size() / RecordSize);
+}
+
+bool SymbolTable::empty() const
+{
+    return mSymbols.empty();
+}
+
+SymbolTable::Symbol SymbolTable::at(uint32_t index) const
+{
+    return Symbol(mSymbols.data() + index * RecordSize, mStrings, index);
+}
+
+SymbolTable::const_iterator SymbolTable::begin() const
+{
+    return const_iterator(mSymbols, mStrings, 0);
+}
+
+SymbolTable::const_iterator SymbolTable::end() const
+{
+    return const_iterator(mSymbols, mStrings, size());
+}
+
+boost::string_ref SymbolTable::strings() const
+{
+    return mStrings;
+}
+
+bool SymbolTable::fromObject(boost::string_ref data, SymbolTable &table)
+{
+    const RawFileHeader *header = rawView<RawFileHeader>(data.data(), data.size(), 0);
+    if (!header || (!header->machine.value() &&
+            header->numberOfSections.value() == AnonymousSignature)) {
+        return false;
+    }
+
+    // As with images, the string table immediately follows the symbols and
+    // begins with its own size, which is clamped to the data
+    uint64_t offset = header->pointerToSymbolTable.value();
+    uint64_t symbolsSize = static_cast<uint64_t>(header->numberOfSymbols.value()) * RecordSize;
+    if (!offset || offset + symbolsSize > data.size()) {
+        return false;
+    }
+    boost::string_ref strings;
+    uint64_t stringTableOffset = offset + symbolsSize;
+    if (stringTableOffset + sizeof(uint32_t) <= data.size()) {
+        uint64_t stringTableSize = std::min<uint64_t>(
+            readLittle<uint32_t>(data.data() + stringTableOffset),
+            data.size() - stringTableOffset
+        );
+        strings = data.substr(static_cast<size_t>(stringTableOffset), static_cast<size_t>(stringTableSize));
+    }
+
+    table = SymbolTable(data.substr(static_cast<size_t>(offset), static_cast<size_t>(symbolsSize)), strings);
+    return true;
+}
@@ -0,0 +1,356 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <climits>
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <sys/uio.h>
+#  include <unistd.h>
+#endif
+
+#include <win32pe/optionalheader.h>
+
+#include "align_p.h"
+#include "file_p.h"
+#include "endian_p.h"
+#include "fileheader_p.h"
+#include "optionalheader_p.h"
+#include "sectiontable_p.h"
+#include "writer_p.h"
+
+using namespace win32pe;
+
+namespace
+{
+
+
+// Padding is emitted as references to a block of zeroes
+const char Zeroes[4096] = {};
+
+}
+
+Writer::Writer(const FilePrivate *file)
+    : mFile(file)
+{
+}
+
+bool Writer::prepare()
+{
+    const SectionTable &table = mFile->mSectionTable;
+    const std::vector<SectionEntry> &sections = table.mEntries;
+
+    // Work on copies of the headers so that the file is unchanged
+    FileHeaderPrivate fileHeader(*mFile->mFileHeader.d);
+    OptionalHeaderPrivate optionalHeader(*mFile->mOptionalHeader.d);
+
+    uint32_t fileAlignment = optionalHeader.mFileAlignment;
+    uint32_t sectionAlignment = optionalHeader.mSectionAlignment;
+    if (!isPowerOfTwo(fileAlignment) || !isPowerOfTwo(sectionAlignment)) {
+        mErrorString = "invalid file or section alignment";
+        return false;
+    }
+
+    if (mFile->mDOSHeader.empty()) {
+        mErrorString = "no file loaded";
+        return false;
+    }
+    if (mFile->mMetadataOnly) {
+        mErrorString = "file was restored without its section data";
+        return false;
+    }
+
+    // Headers are padded to the file alignment, or to their current size if
+    // they were enlarged to reach the first section in memory
+    uint64_t tableEnd = mFile->headersSize();
+    uint64_t sizeOfHeaders = alignUp(tableEnd, fileAlignment);
+    if (!sections.empty()) {
+        uint64_t lowestAddress = UINT32_MAX;
+        for (auto it = sections.begin(); it != sections.end(); ++it) {
+            lowestAddress = std::min<uint64_t>(lowestAddress, (*it).virtualAddress);
+        }
+        if (optionalHeader.mSizeOfHeaders > sizeOfHeaders && optionalHeader.mSizeOfHeaders <= lowestAddress) {
+            sizeOfHeaders = alignUp(optionalHeader.mSizeOfHeaders, fileAlignment);
+        }
+    }
+
+    // Sections keep their original offset where possible so that anything
+    // referring to file offsets within them remains valid; otherwise they are
+    // placed immediately after the preceding section
+
+    std::vector<uint32_t> pointers, sizes;
+    uint64_t cursor = sizeOfHeaders;
+    uint64_t sizeOfImage = sizeOfHeaders;
+    for (auto it = sections.begin(); it != sections.end(); ++it) {
+        const SectionEntry *section = &(*it);
+        uint64_t size = alignUp(section->dataSize, fileAlignment);
+        uint64_t pointer = 0;
+        if (size) {
+            pointer = section->pointerToRawData >= cursor &&
+                      !(section->pointerToRawData % fileAlignment) ?
+                section->pointerToRawData : cursor;
+            cursor = pointer + size;
+        }
+        if (cursor > UINT32_MAX) {
+            mErrorString = "file is too large";
+            return false;
+        }
+        pointers.push_back(static_cast<uint32_t>(pointer));
+        sizes.push_back(static_cast<uint32_t>(size));
+
+        uint64_t virtualSize = section->virtualSize ?
+            section->virtualSize : size;
+        sizeOfImage = std::max(sizeOfImage, section->virtualAddress + virtualSize);
+    }
+
+    fileHeader.mNumberOfSections = static_cast<uint16_t>(sections.size());
+    fileHeader.mSizeOfOptionalHeader = optionalHeader.size();
+    optionalHeader.mSizeOfHeaders = static_cast<uint32_t>(sizeOfHeaders);
+    optionalHeader.mSizeOfImage = static_cast<uint32_t>(alignUp(sizeOfImage, sectionAlignment));
+
+    // The overlay follows the last section and anything pointing into it
+    // moves along with it. A file loaded from a stream only has the symbol
+    // and string tables in memory, so its overlay can only be written if it
+    // holds nothing else - rather than drop the rest (such as the
+    // certificates of a signed file), saving fails
+
+    boost::string_ref overlay;
+    if (!mFile->mView.empty()) {
+        overlay = mFile->mView.substr(
+            static_cast<size_t>(mFile->mOverlaySourceOffset),
+            static_cast<size_t>(mFile->mOverlaySize)
+        );
+    } else if (mFile->mOverlaySize) {
+        if (mFile->mSymbolTableOffset != mFile->mOverlaySourceOffset ||
+                mFile->mSymbolData.size() != mFile->mOverlaySize) {
+            mErrorString = "overlay is not in memory";
+            return false;
+        }
+        overlay = mFile->mSymbolData;
+    }
+
+    OptionalHeader::DataDirectoryItem &certificateTable =
+        optionalHeader.mDataDirectory[OptionalHeader::CertificateTable];
+    if (mFile->mOverlaySize && certificateTable.virtualAddress >= mFile->mOverlayOffset) {
+        certificateTable.virtualAddress = static_cast<uint32_t>(
+            certificateTable.virtualAddress - mFile->mOverlayOffset + cursor
+        );
+    }
+    if (mFile->mOverlaySize && fileHeader.mPointerToSymbolTable >= mFile->mOverlayOffset) {
+        fileHeader.mPointerToSymbolTable = static_cast<uint32_t>(
+            fileHeader.mPointerToSymbolTable - mFile->mOverlayOffset + cursor
+        );
+    }
+
+    // Whatever followed the section table is written back at its original
+    // offset if the table has not grown into it - otherwise the bound import
+    // descriptors that usually live there are discarded and the loader will
+    // simply bind the imports itself
+
+    bool keepSlack = !mFile->mHeaderSlack.empty() && tableEnd <= mFile->mHeaderSlackOffset &&
+        mFile->mHeaderSlackOffset < sizeOfHeaders;
+    if (!keepSlack) {
+        OptionalHeader::DataDirectoryItem &boundImportTable =
+            optionalHeader.mDataDirectory[OptionalHeader::BoundImportTable];
+        if (boundImportTable.virtualAddress && boundImportTable.virtualAddress < sizeOfHeaders) {
+            boundImportTable.virtualAddress = 0;
+            boundImportTable.size = 0;
+        }
+    }
+
+    // Build the headers
+    mHeaders.clear();
+    mHeaders.reserve(static_cast<size_t>(sizeOfHeaders));
+    mHeaders.append(mFile->mDOSHeader);
+    appendLittle(mHeaders, PESignature);
+    fileHeader.write(mHeaders);
+    optionalHeader.write(mHeaders);
+    for (size_t i = 0; i < sections.size(); ++i) {
+        table.writeHeader(mHeaders, i, sizes[i], pointers[i]);
+    }
+    if (keepSlack) {
+        mHeaders.resize(mFile->mHeaderSlackOffset, '\0');
+        mHeaders.append(mFile->mHeaderSlack, 0, static_cast<size_t>(sizeOfHeaders - mFile->mHeaderSlackOffset));
+    }
+    mHeaders.resize(static_cast<size_t>(sizeOfHeaders), '\0');
+
+    // Build the list of chunks
+    mChunks.clear();
+    mChunks.push_back(mHeaders);
+    uint64_t offset = sizeOfHeaders;
+    for (size_t i = 0; i < sections.size(); ++i) {
+        if (!sizes[i]) {
+            continue;
+        }
+        boost::string_ref data = table.data(i);
+        appendPadding(pointers[i] - offset);
+        mChunks.push_back(data);
+        appendPadding(sizes[i] - data.size());
+        offset = pointers[i] + sizes[i];
+    }
+    if (!overlay.empty()) {
+        mChunks.push_back(overlay);
+    }
+
+    return true;
+}
+
+bool Writer::write(std::ostream &ostream) const
+{
+    for (auto it = mChunks.begin(); it != mChunks.end(); ++it) {
+        if (!ostream.write((*it).data(), (*it).size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Writer::write(const std::string &filename) const
+{
+    // The file is written to a temporary file in the same directory and
+    // renamed into place so that a file can be saved over the one it was
+    // mapped from and is never left partially written
+
+#ifdef _WIN32
+    size_t separator = filename.find_last_of("/\\");
+    std::string directory = separator == std::string::npos ?
+        std::string(".") : filename.substr(0, separator + 1);
+    char temporary[MAX_PATH];
+    if (!::GetTempFileNameA(directory.c_str(), "pe", 0, temporary)) {
+        return false;
+    }
+    {
+        std::ofstream ofstream(temporary, std::ios::binary | std::ios::trunc);
+        if (!ofstream || !write(ofstream) || !ofstream.flush()) {
+            ofstream.close();
+            ::DeleteFileA(temporary);
+            return false;
+        }
+    }
+    if (!::MoveFileExA(temporary, filename.c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        ::DeleteFileA(temporary);
+        return false;
+    }
+    return true;
+#else
+    // mkstemp() creates the temporary file private to the user, so it is
+    // given the mode of the file it replaces; a new file is created first to
+    // learn the mode the umask gives it
+    struct stat st;
+    bool created = false;
+    if (::stat(filename.c_str(), &st)) {
+        int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+        if (fd < 0) {
+            return false;
+        }
+        int result = ::fstat(fd, &st);
+        ::close(fd);
+        if (result) {
+            ::unlink(filename.c_str());
+            return false;
+        }
+        created = true;
+    }
+
+    std::string temporary = filename + ".XXXXXX";
+    int fd = ::mkstemp(&temporary[0]);
+    if (fd < 0) {
+        if (created) {
+            ::unlink(filename.c_str());
+        }
+        return false;
+    }
+
+#ifdef IOV_MAX
+    const size_t maxChunks = IOV_MAX;
+#else
+    const size_t maxChunks = 1024;
+#endif
+
+    std::vector<struct iovec> iov;
+    iov.reserve(mChunks.size());
+    for (auto it = mChunks.begin(); it != mChunks.end(); ++it) {
+        if ((*it).size()) {
+            struct iovec vec = {const_cast<char*>((*it).data()), (*it).size()};
+            iov.push_back(vec);
+        }
+    }
+
+    bool ok = !::fchmod(fd, st.st_mode & 07777);
+
+    // Write as many chunks as possible at a time, resuming after partial
+    // writes
+    size_t i = 0;
+    while (ok && i < iov.size()) {
+        ssize_t written = ::writev(fd, &iov[i], static_cast<int>(std::min(iov.size() - i, maxChunks)));
+        if (written < 0) {
+            if (errno != EINTR) {
+                ok = false;
+            }
+            continue;
+        }
+        size_t remaining = static_cast<size_t>(written);
+        while (remaining && remaining >= iov[i].iov_len) {
+            remaining -= iov[i].iov_len;
+            ++i;
+        }
+        if (remaining) {
+            iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + remaining;
+            iov[i].iov_len -= remaining;
+        }
+    }
+
+    // The data must reach the disk before the rename does, or a crash could
+    // leave an empty file in place of the original
+    ok = ok && !::fsync(fd);
+    ok = !::close(fd) && ok;
+    if (!ok || ::rename(temporary.c_str(), filename.c_str())) {
+        ::unlink(temporary.c_str());
+        if (created) {
+            ::unlink(filename.c_str());
+        }
+        return false;
+    }
+    return true;
+#endif
+}
+
+void Writer::appendPadding(uint64_t size)
+{
+    while (size) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, sizeof(Zeroes)));
+        mChunks.push_back(boost::string_ref(Zeroes, chunk));
+        size -= chunk;
+    }
+}
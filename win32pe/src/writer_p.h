@@ -0,0 +1,72 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WIN32PE_WRITER_P_H
+#define WIN32PE_WRITER_P_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/utility/string_ref.hpp>
+
+namespace win32pe
+{
+
+class FilePrivate;
+
+/**
+ * @brief Serializes a file as a list of chunks
+ *
+ * Only the headers are built in a new buffer; section bodies and the overlay
+ * are referenced where they already are in memory so that they can be handed
+ * to the operating system for a gathered write without being copied again.
+ */
+class Writer
+{
+public:
+
+    Writer(const FilePrivate *file);
+
+    bool prepare();
+
+    bool write(std::ostream &ostream) const;
+    bool write(const std::string &filename) const;
+
+    std::string mErrorString;
+
+private:
+
+    void appendPadding(uint64_t size);
+
+    const FilePrivate *const mFile;
+
+    std::string mHeaders;
+    std::vector<boost::string_ref> mChunks;
+};
+
+}
+
+#endif // WIN32PE_WRITER_P_H